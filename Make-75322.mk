@@ -15,4 +15,4 @@ INCLUDE_COMPONENTS += driver_docs
 COMPONENT_FLAGS =
 COMPONENT_FLAGS += $(addsuffix '=1', $(DEBUG_FLAGS))
 # List of linker full libraries that will be used during the link-time (with option `-l`)
-COMPONENT_LIBS = pthread
+COMPONENT_LIBS = pthread m rt
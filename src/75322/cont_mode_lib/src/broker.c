@@ -0,0 +1,557 @@
+/**
+ * @file
+ * @brief Continuous mode broker
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_cont_broker
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include "cont_mode_lib.h"
+#include "broker.h"
+#include "scene_shm.h"
+#include "spi_drv_sync_com.h"
+
+/** The clients waiting for the same request at most, after coalescing */
+#define BROKER_MAX_WAITERS 8u
+
+/** The request's state in the queue */
+typedef enum {
+    BROKER_REQ_FREE = 0,        /**< The queue's entry is not used */
+    BROKER_REQ_QUEUED,          /**< Waits to be run */
+    BROKER_REQ_RUNNING,         /**< Is being run on the bus */
+    BROKER_REQ_DONE,            /**< Run, the reply is not sent yet */
+} BrokerReqState_e;
+
+/** The client waiting for the request's reply */
+typedef struct {
+    uint16_t client;            /**< Client's slot */
+    uint32_t gen;               /**< Client slot's generation, tells the client is still the same */
+    uint32_t id;                /**< Client's request identifier */
+} BrokerWaiter_t;
+
+/** The request queued */
+typedef struct {
+    BrokerReqState_e state;     /**< Request's state */
+    uint32_t order;             /**< Request's order in the queue */
+    uint64_t queuedNs;          /**< Time the request was queued */
+    BrokerRequest_t request;    /**< Request */
+    BrokerReply_t reply;        /**< Reply, when run */
+    BrokerWaiter_t waiters[BROKER_MAX_WAITERS]; /**< Clients waiting for the reply */
+    uint16_t waitersCount;      /**< Clients count in BrokerPending_t::waiters */
+} BrokerPending_t;
+
+/** The client's connection */
+typedef struct {
+    int fd;                     /**< Client's socket. Negative value - the slot is free */
+    uint32_t gen;               /**< Slot's generation, incremented when the client disconnects */
+} BrokerClient_t;
+
+static pthread_t brokerThread;
+static bool brokerRunning = false;
+static bool brokerExit = false;
+static int brokerListenFd = -1;
+static int brokerEventFd = -1;
+static char brokerSocketPath[sizeof(((struct sockaddr_un*)NULL)->sun_path)];
+static char brokerShmName[BROKER_NAME_LEN];
+static uint32_t brokerSocketMode = BROKER_SOCKET_MODE;
+static BrokerClient_t brokerClients[BROKER_MAX_CLIENTS];
+
+/** Guards the queue and the statistics */
+static pthread_mutex_t brokerLock = PTHREAD_MUTEX_INITIALIZER;
+/** Owned by the acquisition step, or by the broker's thread running the requests */
+static pthread_mutex_t brokerBusLock = PTHREAD_MUTEX_INITIALIZER;
+static BrokerPending_t brokerPending[BROKER_MAX_PENDING];
+static uint32_t brokerOrder = 0u;
+static BrokerStats_t brokerStats;
+/** Driver's instance the broker is started for, the requests are run on */
+static uint16_t brokerInstance = SPI_DRV_DEFAULT_INSTANCE;
+/** Set for the threads owning the bus through the whole step: the acquisition's and the broker's ones */
+static __thread bool brokerStepThread = false;
+/** Nesting of the bus entry points the thread is in */
+static __thread uint16_t brokerBusDepth = 0u;
+/** The thread took the bus at its outer entry point */
+static __thread bool brokerBusTaken = false;
+
+
+static uint64_t BrokerNowNs(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+
+/** Tells whether the requests access the same target (variable or layer) */
+static bool BrokerSameTarget(const BrokerRequest_t* const a, const BrokerRequest_t* const b)
+{
+    bool res = false;
+    if (((a->cmd == BROKER_CMD_GET) || (a->cmd == BROKER_CMD_SET)) &&
+        ((b->cmd == BROKER_CMD_GET) || (b->cmd == BROKER_CMD_SET))) {
+        res = (a->icId == b->icId) && (strcmp(a->varName, b->varName) == 0) &&
+              (strcmp(a->bitFieldName, b->bitFieldName) == 0);
+    } else if ((a->cmd == BROKER_CMD_GET_LAYER) && (b->cmd == BROKER_CMD_GET_LAYER)) {
+        res = (a->icId == b->icId) && (a->layerIdx == b->layerIdx);
+    } else if ((a->cmd == BROKER_CMD_SET_LAYER) && (b->cmd == BROKER_CMD_SET_LAYER)) {
+        res = (a->layer.ic_id == b->layer.ic_id) && (a->layer.layer_nth == b->layer.layer_nth);
+    } else {
+        /* Reading and writing the layers are not coalesced */
+    }
+    return res;
+}
+
+
+static void BrokerSendReply(const uint16_t client, const BrokerReply_t* const reply)
+{
+    if ((brokerClients[client].fd >= 0) &&
+        (send(brokerClients[client].fd, reply, sizeof(BrokerReply_t), MSG_DONTWAIT | MSG_NOSIGNAL) < 0)) {
+        CONT_PRINT("Broker: reply to client %u is not sent\n", client);
+    }
+}
+
+
+/** Tells whether the client waits for the request's reply */
+static bool BrokerClientWaits(const BrokerPending_t* const pending, const uint16_t client)
+{
+    bool res = false;
+    for (uint16_t ind = 0u; ind < pending->waitersCount; ind++) {
+        if ((pending->waiters[ind].client == client) && (pending->waiters[ind].gen == brokerClients[client].gen)) {
+            res = true;
+        }
+    }
+    return res;
+}
+
+
+/** Queues the client's request, coalescing it with the last request queued for the same target. The request is only
+ * coalesced when the client has nothing queued after that one, so the client's requests keep their order */
+static void BrokerQueue(const uint16_t client, const BrokerRequest_t* const request)
+{
+    BrokerPending_t* last = NULL;
+    BrokerPending_t* entry = NULL;
+    BrokerPending_t* clientLast = NULL;
+    pthread_mutex_lock(&brokerLock);
+    brokerStats.requests++;
+    for (uint16_t ind = 0u; ind < BROKER_MAX_PENDING; ind++) {
+        BrokerPending_t* pending = &brokerPending[ind];
+        if ((pending->state == BROKER_REQ_QUEUED) || (pending->state == BROKER_REQ_RUNNING)) {
+            if (BrokerSameTarget(&pending->request, request) && ((last == NULL) || (pending->order > last->order))) {
+                last = pending;
+            }
+            if (BrokerClientWaits(pending, client) && ((clientLast == NULL) || (pending->order > clientLast->order))) {
+                clientLast = pending;
+            }
+        } else if ((pending->state == BROKER_REQ_FREE) && (entry == NULL)) {
+            entry = pending;
+        } else {
+            /* The reply is not sent yet */
+        }
+    }
+    if ((last != NULL) && (last->state == BROKER_REQ_QUEUED) && (last->request.cmd == request->cmd) &&
+        (last->waitersCount < BROKER_MAX_WAITERS) && ((clientLast == NULL) || (clientLast->order <= last->order))) {
+        /* The writes keep the last value */
+        last->request.value = request->value;
+        last->request.layer = request->layer;
+        entry = last;
+        brokerStats.coalesced++;
+    } else if (entry != NULL) {
+        memset(entry, 0, sizeof(BrokerPending_t));
+        entry->state = BROKER_REQ_QUEUED;
+        entry->order = brokerOrder++;
+        entry->queuedNs = BrokerNowNs();
+        entry->request = *request;
+    } else {
+        brokerStats.rejected++;
+    }
+    if (entry != NULL) {
+        entry->waiters[entry->waitersCount].client = client;
+        entry->waiters[entry->waitersCount].gen = brokerClients[client].gen;
+        entry->waiters[entry->waitersCount].id = request->id;
+        entry->waitersCount++;
+    }
+    pthread_mutex_unlock(&brokerLock);
+    if (entry == NULL) {
+        const BrokerReply_t reply = {.id = request->id, .result = (int32_t)SPI_DRV_FUNC_RES_FAIL};
+        BrokerSendReply(client, &reply);
+    }
+}
+
+
+/** Runs the request on the bus */
+static FuncResult_e BrokerExecute(const BrokerRequest_t* const request, BrokerReply_t* const reply)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    const SpiDriver_FldName_t* const bitFieldName = (request->bitFieldName[0] != '\0') ? request->bitFieldName : NULL;
+    switch (request->cmd) {
+        case BROKER_CMD_GET:
+            if (request->icId < IC_ID_BROADCAST) {
+                res = spiDriver_GetMultiByName(request->icId, request->varName, &reply->value, bitFieldName);
+            } else {
+                res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+            }
+            break;
+        case BROKER_CMD_SET:
+            res = spiDriver_SetMultiByName(request->icId, request->varName, request->value, bitFieldName);
+            break;
+        case BROKER_CMD_GET_LAYER:
+            res = spiDriver_ReadLayerConfig(request->icId, request->layerIdx, &reply->layer);
+            break;
+        case BROKER_CMD_SET_LAYER:
+            res = spiDriver_SetLayerConfig(&request->layer);
+            break;
+        default:
+            res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+            break;
+    }
+    return res;
+}
+
+
+/** Runs the oldest requests queued. The caller owns the bus */
+static void BrokerRun(const uint16_t budget, const bool byStep)
+{
+    uint16_t count = 0u;
+    bool running = true;
+    while (running && (count < budget)) {
+        BrokerPending_t* entry = NULL;
+        BrokerRequest_t request;
+        BrokerReply_t reply;
+        pthread_mutex_lock(&brokerLock);
+        for (uint16_t ind = 0u; ind < BROKER_MAX_PENDING; ind++) {
+            if ((brokerPending[ind].state == BROKER_REQ_QUEUED) &&
+                ((entry == NULL) || ((int32_t)(brokerPending[ind].order - entry->order) < 0))) {
+                entry = &brokerPending[ind];
+            }
+        }
+        if (entry != NULL) {
+            entry->state = BROKER_REQ_RUNNING;
+            request = entry->request;
+        }
+        pthread_mutex_unlock(&brokerLock);
+        if (entry != NULL) {
+            memset(&reply, 0, sizeof(reply));
+            reply.result = (int32_t)BrokerExecute(&request, &reply);
+            pthread_mutex_lock(&brokerLock);
+            if (entry->state == BROKER_REQ_RUNNING) {
+                entry->reply = reply;
+                entry->state = BROKER_REQ_DONE;
+            }
+            if (byStep) {
+                brokerStats.runByStep++;
+            } else {
+                brokerStats.runByBroker++;
+            }
+            pthread_mutex_unlock(&brokerLock);
+            count++;
+        } else {
+            running = false;
+        }
+    }
+    if ((count > 0u) && byStep) {
+        const uint64_t one = 1u;
+        if (write(brokerEventFd, &one, sizeof(one)) != (ssize_t)sizeof(one)) {
+            CONT_PRINT("Broker: replies are not signalled\n");
+        }
+    }
+}
+
+
+/** Sends the replies of the requests run */
+static void BrokerReplies(void)
+{
+    pthread_mutex_lock(&brokerLock);
+    for (uint16_t ind = 0u; ind < BROKER_MAX_PENDING; ind++) {
+        BrokerPending_t* entry = &brokerPending[ind];
+        if (entry->state == BROKER_REQ_DONE) {
+            for (uint16_t waiter = 0u; waiter < entry->waitersCount; waiter++) {
+                const uint16_t client = entry->waiters[waiter].client;
+                if (brokerClients[client].gen == entry->waiters[waiter].gen) {
+                    entry->reply.id = entry->waiters[waiter].id;
+                    BrokerSendReply(client, &entry->reply);
+                }
+            }
+            entry->state = BROKER_REQ_FREE;
+        }
+    }
+    pthread_mutex_unlock(&brokerLock);
+}
+
+
+/** Tells whether a request waits for the acquisition step too long */
+static bool BrokerIdle(void)
+{
+    bool res = false;
+    const uint64_t now = BrokerNowNs();
+    pthread_mutex_lock(&brokerLock);
+    for (uint16_t ind = 0u; (ind < BROKER_MAX_PENDING) && !res; ind++) {
+        res = (brokerPending[ind].state == BROKER_REQ_QUEUED) &&
+              ((now - brokerPending[ind].queuedNs) >= ((uint64_t)BROKER_IDLE_MS * 1000000ull));
+    }
+    pthread_mutex_unlock(&brokerLock);
+    return res;
+}
+
+
+static void BrokerCloseClient(const uint16_t client)
+{
+    pthread_mutex_lock(&brokerLock);
+    (void)close(brokerClients[client].fd);
+    brokerClients[client].fd = -1;
+    brokerClients[client].gen++;
+    pthread_mutex_unlock(&brokerLock);
+}
+
+
+static void BrokerReceive(const uint16_t client)
+{
+    BrokerRequest_t request;
+    const ssize_t size = recv(brokerClients[client].fd, &request, sizeof(request), MSG_DONTWAIT);
+    if (size == (ssize_t)sizeof(request)) {
+        request.varName[BROKER_NAME_LEN - 1u] = '\0';
+        request.bitFieldName[BROKER_NAME_LEN - 1u] = '\0';
+        if (request.cmd == BROKER_CMD_DATA) {
+            BrokerReply_t reply;
+            memset(&reply, 0, sizeof(reply));
+            reply.id = request.id;
+            reply.result = (int32_t)SPI_DRV_FUNC_RES_OK;
+            strcpy(reply.name, brokerShmName);
+            BrokerSendReply(client, &reply);
+        } else {
+            BrokerQueue(client, &request);
+        }
+    } else if (size >= 0) {
+        /* Disconnected, or the message is not a request */
+        BrokerCloseClient(client);
+    } else {
+        /* Nothing to receive */
+    }
+}
+
+
+/* Broker's thread function */
+static void* BrokerExecuteThread(void* temp)
+{
+    struct pollfd fds[BROKER_MAX_CLIENTS + 2u];
+    (void)temp;
+    spiDriver_instanceIdx = brokerInstance;
+    brokerStepThread = true;
+    while (!__atomic_load_n(&brokerExit, __ATOMIC_ACQUIRE)) {
+        nfds_t count = 2u;
+        fds[0].fd = brokerListenFd;
+        fds[0].events = POLLIN;
+        fds[1].fd = brokerEventFd;
+        fds[1].events = POLLIN;
+        for (uint16_t client = 0u; client < BROKER_MAX_CLIENTS; client++) {
+            fds[count].fd = brokerClients[client].fd;
+            fds[count].events = POLLIN;
+            count++;
+        }
+        if (poll(fds, count, (int)BROKER_IDLE_MS) > 0) {
+            if ((fds[0].revents & POLLIN) != 0) {
+                const int fd = accept4(brokerListenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                uint16_t client = 0u;
+                while ((client < BROKER_MAX_CLIENTS) && (brokerClients[client].fd >= 0)) {
+                    client++;
+                }
+                if (client < BROKER_MAX_CLIENTS) {
+                    brokerClients[client].fd = fd;
+                } else if (fd >= 0) {
+                    CONT_PRINT("Broker: too many clients\n");
+                    (void)close(fd);
+                } else {
+                    /* Not accepted */
+                }
+            }
+            if ((fds[1].revents & POLLIN) != 0) {
+                uint64_t events;
+                (void)read(brokerEventFd, &events, sizeof(events));
+            }
+            for (uint16_t client = 0u; client < BROKER_MAX_CLIENTS; client++) {
+                if ((fds[client + 2u].fd >= 0) && ((fds[client + 2u].revents & (POLLIN | POLLHUP | POLLERR)) != 0)) {
+                    BrokerReceive(client);
+                }
+            }
+        }
+        if (BrokerIdle()) {
+            /* No acquisition steps run the requests, run them here */
+            pthread_mutex_lock(&brokerBusLock);
+            BrokerRun(BROKER_REQUESTS_PER_STEP, false);
+            pthread_mutex_unlock(&brokerBusLock);
+        }
+        BrokerReplies();
+    }
+    for (uint16_t client = 0u; client < BROKER_MAX_CLIENTS; client++) {
+        if (brokerClients[client].fd >= 0) {
+            BrokerCloseClient(client);
+        }
+    }
+    return NULL;
+}
+
+
+FuncResult_e spiDriver_StartBroker(const char* const socketPath,
+                                   const char* const shmName,
+                                   const uint32_t slotSize,
+                                   const uint16_t slotCount)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    struct sockaddr_un addr;
+    if ((socketPath == NULL) || (strlen(socketPath) >= sizeof(addr.sun_path)) ||
+        ((shmName != NULL) && (strlen(shmName) >= BROKER_NAME_LEN)) || brokerRunning) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+    } else {
+        memset(brokerPending, 0, sizeof(brokerPending));
+        memset(&brokerStats, 0, sizeof(brokerStats));
+        brokerInstance = SPI_DRV_INSTANCE;
+        for (uint16_t client = 0u; client < BROKER_MAX_CLIENTS; client++) {
+            brokerClients[client].fd = -1;
+        }
+        brokerShmName[0] = '\0';
+        if (shmName != NULL) {
+            res = spiDriver_OpenSceneShm(shmName, slotSize, slotCount);
+            strcpy(brokerShmName, shmName);
+        }
+    }
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, socketPath);
+        strcpy(brokerSocketPath, socketPath);
+        (void)unlink(socketPath);
+        /* The messages keep their boundaries */
+        brokerListenFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        brokerEventFd = eventfd(0u, EFD_NONBLOCK | EFD_CLOEXEC);
+        brokerExit = false;
+        if ((brokerListenFd < 0) || (brokerEventFd < 0) ||
+            (bind(brokerListenFd, (const struct sockaddr*)&addr, sizeof(addr)) != 0) ||
+            /* The socket is created with umask's permissions, nobody connects to it before listen() */
+            (chmod(socketPath, (mode_t)brokerSocketMode) != 0) ||
+            (listen(brokerListenFd, (int)BROKER_MAX_CLIENTS) != 0) ||
+            (pthread_create(&brokerThread, NULL, &BrokerExecuteThread, NULL) != 0)) {
+            CONT_PRINT("Broker: can't be started on %s\n", socketPath);
+            if (brokerListenFd >= 0) {
+                (void)close(brokerListenFd);
+                (void)unlink(socketPath);
+            }
+            if (brokerEventFd >= 0) {
+                (void)close(brokerEventFd);
+            }
+            brokerListenFd = -1;
+            brokerEventFd = -1;
+            spiDriver_CloseSceneShm();
+            res = SPI_DRV_FUNC_RES_FAIL;
+        } else {
+            __atomic_store_n(&brokerRunning, true, __ATOMIC_RELEASE);
+            CONT_PRINT("Broker: started on %s\n", socketPath);
+        }
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_SetBrokerSocketMode(const uint32_t mode)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    if ((mode & ~0777u) != 0u) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+    } else {
+        brokerSocketMode = mode;
+    }
+    return res;
+}
+
+
+void spiDriver_StopBroker(void)
+{
+    if (brokerRunning) {
+        const uint64_t one = 1u;
+        __atomic_store_n(&brokerRunning, false, __ATOMIC_RELEASE);
+        __atomic_store_n(&brokerExit, true, __ATOMIC_RELEASE);
+        (void)write(brokerEventFd, &one, sizeof(one));
+        pthread_join(brokerThread, NULL);
+        /* The acquisition step running the requests signals the event, wait for it */
+        pthread_mutex_lock(&brokerBusLock);
+        pthread_mutex_lock(&brokerLock);
+        memset(brokerPending, 0, sizeof(brokerPending));
+        pthread_mutex_unlock(&brokerLock);
+        (void)close(brokerListenFd);
+        (void)close(brokerEventFd);
+        brokerListenFd = -1;
+        brokerEventFd = -1;
+        pthread_mutex_unlock(&brokerBusLock);
+        (void)unlink(brokerSocketPath);
+        spiDriver_CloseSceneShm();
+    }
+}
+
+
+void spiDriver_BrokerStepBegin(void)
+{
+    pthread_mutex_lock(&brokerBusLock);
+}
+
+
+void spiDriver_BrokerStepEnd(void)
+{
+    if (__atomic_load_n(&brokerRunning, __ATOMIC_ACQUIRE)) {
+        BrokerRun(BROKER_REQUESTS_PER_STEP, true);
+    }
+    pthread_mutex_unlock(&brokerBusLock);
+}
+
+
+void spiDriver_BrokerStepThread(void)
+{
+    brokerStepThread = true;
+}
+
+
+void spiDriver_BrokerBusEnter(void)
+{
+    if ((!brokerStepThread) && (brokerBusDepth++ == 0u) && __atomic_load_n(&brokerRunning, __ATOMIC_ACQUIRE)) {
+        pthread_mutex_lock(&brokerBusLock);
+        brokerBusTaken = true;
+    }
+}
+
+
+void spiDriver_BrokerBusLeave(void)
+{
+    if ((!brokerStepThread) && (--brokerBusDepth == 0u) && brokerBusTaken) {
+        brokerBusTaken = false;
+        pthread_mutex_unlock(&brokerBusLock);
+    }
+}
+
+
+void spiDriver_GetBrokerStats(BrokerStats_t* const stats)
+{
+    pthread_mutex_lock(&brokerLock);
+    *stats = brokerStats;
+    pthread_mutex_unlock(&brokerLock);
+}
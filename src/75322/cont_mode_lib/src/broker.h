@@ -0,0 +1,166 @@
+/**
+ * @file
+ * @brief SPI driver for MLX75322 Continuous mode support
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_cont_broker SPI driver broker
+ * @ingroup spi_cont_mode
+ *
+ * @details lets several local processes share the sensor owned by one process (the broker). The broker serves its
+ *      clients over a Unix socket (control plane: registers and layers' configuration, see @ref spi_cont_broker_client)
+ *      and exports the continuous mode data through the shared memory (data plane, see @ref spi_cont_shm).
+ *
+ *      The clients' requests are queued and run on the bus between the acquisition steps: the trigger thread runs up
+ *      to ::BROKER_REQUESTS_PER_STEP requests after each step, so the clients can't starve the acquisition. When the
+ *      acquisition is not running, the broker's thread runs the requests itself. The requests queued for the same
+ *      target are coalesced: the reads share a single transaction, the last value of the writes is written.
+ *
+ *      While the broker runs, the owning application's own calls share the bus with the clients' requests: every
+ *      bus transaction of the driver, and the read-modify-write calls (like ::spiDriver_SetByName), take the bus
+ *      for their duration. So a client's request never runs in the middle of the application's call.
+ */
+
+#ifndef BROKER_H
+#define BROKER_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "spi_drv_trace.h"
+
+/** The names' length in the broker's messages */
+#define BROKER_NAME_LEN 64u
+/** The requests run by the trigger thread after each acquisition step at most */
+#define BROKER_REQUESTS_PER_STEP 4u
+/** Time in milliseconds a request waits for the acquisition step, then the broker's thread runs it */
+#define BROKER_IDLE_MS 20u
+/** The clients served at once at most */
+#define BROKER_MAX_CLIENTS 16u
+/** The requests queued at most, after coalescing */
+#define BROKER_MAX_PENDING 64u
+/** Default access permissions of the broker's socket: the owner's user only */
+#define BROKER_SOCKET_MODE 0600u
+
+/** Broker's request commands */
+typedef enum {
+    BROKER_CMD_GET = 0,         /**< Reads the variable. See BrokerRequest_t::varName */
+    BROKER_CMD_SET,             /**< Writes the variable. See BrokerRequest_t::varName and BrokerRequest_t::value */
+    BROKER_CMD_GET_LAYER,       /**< Reads the layer's configuration. See BrokerRequest_t::layerIdx */
+    BROKER_CMD_SET_LAYER,       /**< Writes the layer's configuration. See BrokerRequest_t::layer */
+    BROKER_CMD_DATA,            /**< Gets the data plane's shared memory name, see BrokerReply_t::name */
+} BrokerCmd_e;
+
+/** Broker's request message */
+typedef struct {
+    uint32_t id;                /**< Request's identifier, returned in the reply */
+    uint16_t cmd;               /**< Request's command, see ::BrokerCmd_e */
+    uint16_t icId;              /**< IC's identifier, see ::spiDriver_SetMultiByName. The IC's index for
+                                     ::BROKER_CMD_GET_LAYER */
+    uint16_t layerIdx;          /**< Layer's index for ::BROKER_CMD_GET_LAYER */
+    uint16_t reserved;          /**< Reserved */
+    uint32_t value;             /**< Value to write */
+    char varName[BROKER_NAME_LEN];      /**< Variable's name */
+    char bitFieldName[BROKER_NAME_LEN]; /**< Variable's bit-field name, empty for the whole variable */
+    spiDriver_LayerConfig_t layer;      /**< Layer's configuration to write */
+} BrokerRequest_t;
+
+/** Broker's reply message */
+typedef struct {
+    uint32_t id;                /**< Request's identifier */
+    int32_t result;             /**< Request's result, see ::FuncResult_e */
+    uint32_t value;             /**< Value read */
+    spiDriver_LayerConfig_t layer;  /**< Layer's configuration read */
+    char name[BROKER_NAME_LEN];     /**< Data plane's shared memory name, empty if there is no data plane */
+} BrokerReply_t;
+
+/** Broker's statistics */
+typedef struct {
+    uint32_t requests;          /**< Requests received */
+    uint32_t coalesced;         /**< Requests coalesced with the requests queued before */
+    uint32_t runByStep;         /**< Requests run after the acquisition steps */
+    uint32_t runByBroker;       /**< Requests run by the broker's thread, while no acquisition was running */
+    uint32_t rejected;          /**< Requests rejected since the queue was full */
+} BrokerStats_t;
+
+/** Sets the access permissions of the broker's socket, applied by the next ::spiDriver_StartBroker
+ * Any local process able to connect to the socket can read and write the sensor's registers. So the socket is
+ * created with ::BROKER_SOCKET_MODE (the owner's user only) by default. To let a group of users in, set 0660 and put
+ * the socket into a directory of that group with the set-group-ID bit, so the socket gets the directory's group.
+ * @param[in]   mode    permissions' bits, like for chmod(2). Only the bits of 0777 are allowed
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     wrong permissions' bits
+ */
+FuncResult_e spiDriver_SetBrokerSocketMode(const uint32_t mode);
+
+/** Starts the broker
+ * The socket is created with the permissions set by ::spiDriver_SetBrokerSocketMode (::BROKER_SOCKET_MODE by default)
+ * @param[in]   socketPath  Unix socket's path the clients connect to
+ * @param[in]   shmName     data plane's shared memory name, see ::spiDriver_OpenSceneShm. NULL - no data plane
+ * @param[in]   slotSize    data plane's slot size, in bytes
+ * @param[in]   slotCount   data plane's slots count
+ * @retval  SPI_DRV_FUNC_RES_OK                 the broker is started
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     wrong parameters, or the broker is already started
+ * @retval  SPI_DRV_FUNC_RES_FAIL               the socket or the broker's thread can't be created
+ * @return  other results of ::spiDriver_OpenSceneShm
+ */
+FuncResult_e spiDriver_StartBroker(const char* const socketPath,
+                                   const char* const shmName,
+                                   const uint32_t slotSize,
+                                   const uint16_t slotCount);
+
+/** Stops the broker, disconnecting its clients and removing the data plane */
+void spiDriver_StopBroker(void);
+
+/** Takes the bus before the acquisition step
+ * @note    This function is normally driven from the trigger thread
+ */
+void spiDriver_BrokerStepBegin(void);
+
+/** Runs the clients' requests queued and releases the bus after the acquisition step
+ * @note    This function is normally driven from the trigger thread
+ */
+void spiDriver_BrokerStepEnd(void);
+
+/** Marks the calling thread as the one owning the bus through the acquisition step, so its bus calls don't take
+ * the bus again
+ * @note    This function is normally driven from the trigger thread and the bus workers
+ */
+void spiDriver_BrokerStepThread(void);
+
+/** Takes the bus, while the broker runs, for the caller's bus transaction. The calls can be nested
+ * @note    This function is called by the driver's bus entry points
+ */
+void spiDriver_BrokerBusEnter(void);
+
+/** Releases the bus taken by ::spiDriver_BrokerBusEnter */
+void spiDriver_BrokerBusLeave(void);
+
+/** Gets the broker's statistics
+ * @param[out]  stats   statistics' output
+ */
+void spiDriver_GetBrokerStats(BrokerStats_t* const stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* BROKER_H */
@@ -0,0 +1,172 @@
+/**
+ * @file
+ * @brief Continuous mode broker client
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_cont_broker_client
+ */
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "broker.h"
+#include "broker_client.h"
+
+static __thread uint32_t brokerClientId = 0u;
+
+
+/** Sends the request and waits for its reply */
+static FuncResult_e BrokerCall(const int conn, BrokerRequest_t* const request, BrokerReply_t* const reply)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_FAIL_COMM;
+    request->id = ++brokerClientId;
+    if (send(conn, request, sizeof(BrokerRequest_t), MSG_NOSIGNAL) == (ssize_t)sizeof(BrokerRequest_t)) {
+        bool waiting = true;
+        while (waiting) {
+            if (recv(conn, reply, sizeof(BrokerReply_t), 0) != (ssize_t)sizeof(BrokerReply_t)) {
+                waiting = false;
+            } else if (reply->id == request->id) {
+                res = (FuncResult_e)reply->result;
+                waiting = false;
+            } else {
+                /* The reply of an older request, given up by the caller */
+            }
+        }
+    }
+    return res;
+}
+
+
+static void BrokerCopyName(char* const dst, const SpiDriver_FldName_t* const src)
+{
+    if (src != NULL) {
+        strncpy(dst, src, BROKER_NAME_LEN - 1u);
+    }
+}
+
+
+int spiDriver_BrokerConnect(const char* const socketPath)
+{
+    int conn = -1;
+    struct sockaddr_un addr;
+    if ((socketPath != NULL) && (strlen(socketPath) < sizeof(addr.sun_path))) {
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, socketPath);
+        conn = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if ((conn >= 0) && (connect(conn, (const struct sockaddr*)&addr, sizeof(addr)) != 0)) {
+            (void)close(conn);
+            conn = -1;
+        }
+    }
+    return conn;
+}
+
+
+void spiDriver_BrokerDisconnect(const int conn)
+{
+    (void)close(conn);
+}
+
+
+FuncResult_e spiDriver_BrokerGet(const int conn,
+                                 const uint16_t id,
+                                 const SpiDriver_FldName_t* const varName,
+                                 uint32_t* const value,
+                                 const SpiDriver_FldName_t* const bitFieldName)
+{
+    BrokerRequest_t request;
+    BrokerReply_t reply;
+    FuncResult_e res;
+    memset(&request, 0, sizeof(request));
+    request.cmd = BROKER_CMD_GET;
+    request.icId = id;
+    BrokerCopyName(request.varName, varName);
+    BrokerCopyName(request.bitFieldName, bitFieldName);
+    res = BrokerCall(conn, &request, &reply);
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        *value = reply.value;
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_BrokerSet(const int conn,
+                                 const uint16_t id,
+                                 const SpiDriver_FldName_t* const varName,
+                                 const uint32_t value,
+                                 const SpiDriver_FldName_t* const bitFieldName)
+{
+    BrokerRequest_t request;
+    BrokerReply_t reply;
+    memset(&request, 0, sizeof(request));
+    request.cmd = BROKER_CMD_SET;
+    request.icId = id;
+    request.value = value;
+    BrokerCopyName(request.varName, varName);
+    BrokerCopyName(request.bitFieldName, bitFieldName);
+    return BrokerCall(conn, &request, &reply);
+}
+
+
+FuncResult_e spiDriver_BrokerGetLayer(const int conn,
+                                      const uint16_t icIdx,
+                                      const uint16_t layerIdx,
+                                      spiDriver_LayerConfig_t* const layerCfg)
+{
+    BrokerRequest_t request;
+    BrokerReply_t reply;
+    FuncResult_e res;
+    memset(&request, 0, sizeof(request));
+    request.cmd = BROKER_CMD_GET_LAYER;
+    request.icId = icIdx;
+    request.layerIdx = layerIdx;
+    res = BrokerCall(conn, &request, &reply);
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        *layerCfg = reply.layer;
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_BrokerSetLayer(const int conn, const spiDriver_LayerConfig_t* const layerCfg)
+{
+    BrokerRequest_t request;
+    BrokerReply_t reply;
+    memset(&request, 0, sizeof(request));
+    request.cmd = BROKER_CMD_SET_LAYER;
+    request.layer = *layerCfg;
+    return BrokerCall(conn, &request, &reply);
+}
+
+
+FuncResult_e spiDriver_BrokerDataName(const int conn, char* const name, const size_t size)
+{
+    BrokerRequest_t request;
+    BrokerReply_t reply;
+    FuncResult_e res;
+    memset(&request, 0, sizeof(request));
+    request.cmd = BROKER_CMD_DATA;
+    res = BrokerCall(conn, &request, &reply);
+    if ((res == SPI_DRV_FUNC_RES_OK) && (size > 0u)) {
+        strncpy(name, reply.name, size - 1u);
+        name[size - 1u] = '\0';
+    }
+    return res;
+}
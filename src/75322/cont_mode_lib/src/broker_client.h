@@ -0,0 +1,116 @@
+/**
+ * @file
+ * @brief SPI driver for MLX75322 Continuous mode support
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_cont_broker_client SPI driver broker client
+ * @ingroup spi_cont_broker
+ *
+ * @details accesses the sensor owned by the broker (see @ref spi_cont_broker) from another process. The calls are
+ *      synchronous, a call returns when the broker has run the request between the acquisition steps. The data is
+ *      read from the shared memory named by ::spiDriver_BrokerDataName, see @ref spi_cont_shm_reader.
+ */
+
+#ifndef BROKER_CLIENT_H
+#define BROKER_CLIENT_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include "broker.h"
+
+/** Connects to the broker
+ * @param[in]   socketPath  broker's Unix socket path, see ::spiDriver_StartBroker
+ * @return  connection's descriptor. Negative value is returned if the broker is not reachable
+ */
+int spiDriver_BrokerConnect(const char* const socketPath);
+
+/** Disconnects from the broker
+ * @param[in]   conn    connection's descriptor
+ */
+void spiDriver_BrokerDisconnect(const int conn);
+
+/** Reads the variable, see ::spiDriver_GetMultiByName
+ * @param[in]   conn            connection's descriptor
+ * @param[in]   id              IC's identifier, broadcast is not supported
+ * @param[in]   varName         variable's name
+ * @param[out]  value           value read
+ * @param[in]   bitFieldName    bit-field's name. Can be NULL
+ * @retval  SPI_DRV_FUNC_RES_FAIL_COMM  the broker is not reachable
+ * @return  other results of an operation. See ::FuncResult_e for details
+ */
+FuncResult_e spiDriver_BrokerGet(const int conn,
+                                 const uint16_t id,
+                                 const SpiDriver_FldName_t* const varName,
+                                 uint32_t* const value,
+                                 const SpiDriver_FldName_t* const bitFieldName);
+
+/** Writes the variable, see ::spiDriver_SetMultiByName
+ * @param[in]   conn            connection's descriptor
+ * @param[in]   id              IC's identifier
+ * @param[in]   varName         variable's name
+ * @param[in]   value           value to write
+ * @param[in]   bitFieldName    bit-field's name. Can be NULL
+ * @retval  SPI_DRV_FUNC_RES_FAIL_COMM  the broker is not reachable
+ * @return  other results of an operation. See ::FuncResult_e for details
+ */
+FuncResult_e spiDriver_BrokerSet(const int conn,
+                                 const uint16_t id,
+                                 const SpiDriver_FldName_t* const varName,
+                                 const uint32_t value,
+                                 const SpiDriver_FldName_t* const bitFieldName);
+
+/** Reads the layer's configuration, see ::spiDriver_ReadLayerConfig
+ * @param[in]   conn        connection's descriptor
+ * @param[in]   icIdx       IC's index
+ * @param[in]   layerIdx    layer's index
+ * @param[out]  layerCfg    layer's configuration read
+ * @retval  SPI_DRV_FUNC_RES_FAIL_COMM  the broker is not reachable
+ * @return  other results of an operation. See ::FuncResult_e for details
+ */
+FuncResult_e spiDriver_BrokerGetLayer(const int conn,
+                                      const uint16_t icIdx,
+                                      const uint16_t layerIdx,
+                                      spiDriver_LayerConfig_t* const layerCfg);
+
+/** Writes the layer's configuration, see ::spiDriver_SetLayerConfig
+ * @param[in]   conn        connection's descriptor
+ * @param[in]   layerCfg    layer's configuration
+ * @retval  SPI_DRV_FUNC_RES_FAIL_COMM  the broker is not reachable
+ * @return  other results of an operation. See ::FuncResult_e for details
+ */
+FuncResult_e spiDriver_BrokerSetLayer(const int conn, const spiDriver_LayerConfig_t* const layerCfg);
+
+/** Gets the data plane's shared memory name
+ * @param[in]   conn    connection's descriptor
+ * @param[out]  name    the name, empty if the broker has no data plane
+ * @param[in]   size    `name` buffer's size
+ * @retval  SPI_DRV_FUNC_RES_FAIL_COMM  the broker is not reachable
+ * @return  result of an operation. See ::FuncResult_e for details
+ */
+FuncResult_e spiDriver_BrokerDataName(const int conn, char* const name, const size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* BROKER_CLIENT_H */
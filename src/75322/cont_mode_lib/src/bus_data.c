@@ -0,0 +1,223 @@
+/**
+ * @file
+ * @brief Continuous mode per-bus acquisition threads
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_cont_bus
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "cont_mode_lib.h"
+#include "bus_data.h"
+#include "cont_mode_rt.h"
+#include "broker.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_sync_mode.h"
+#include "spi_drv_instance_priv.h"
+
+/** The acquisition thread of a bus */
+typedef struct {
+    pthread_t thread;           /**< Thread's handle */
+    uint16_t bus;               /**< Bus identifier, see ContModeCfg_t::icBus */
+    uint32_t icMask;            /**< ICs read by the thread, bit per IC's index */
+} BusWorker_t;
+
+static BusWorker_t busWorkers[MAX_IC_ID_NUMBER];
+static uint16_t busWorkersCount = 0u;
+
+static pthread_mutex_t busLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t busCond = PTHREAD_COND_INITIALIZER;
+static uint32_t busStep = 0u;       /**< The step requested */
+static uint32_t busSyncStep = 0u;   /**< The step which synchronization is done */
+static uint16_t busDone = 0u;       /**< Threads finished the step requested */
+static bool busExit = false;        /**< The threads are requested to exit */
+
+/* The step's output, per IC. Each IC is written by its bus's thread only */
+static spiDriver_ChipData_t* busIcData[MAX_IC_ID_NUMBER];
+static uint16_t busIcDataSize[MAX_IC_ID_NUMBER];
+static FuncResult_e busIcRes[MAX_IC_ID_NUMBER];
+
+extern FuncResult_e spiDriver_getSingleSyncStepIcs(const uint32_t icMask,
+                                                   spiDriver_ChipData_t** spiDriver_chipDataTmp,
+                                                   uint16_t* spiDriver_chipDataSizeTmp);
+
+extern void spiDriver_ContModeAdoptInstance(void);
+
+
+/** Marks the current step's synchronization as done, so other buses can be read */
+static void BusSyncDone(void)
+{
+    pthread_mutex_lock(&busLock);
+    busSyncStep = busStep;
+    pthread_cond_broadcast(&busCond);
+    pthread_mutex_unlock(&busLock);
+}
+
+
+/* Per-bus acquisition thread function */
+static void* BusDataExecute(void* temp)
+{
+    const BusWorker_t* worker = (const BusWorker_t*)temp;
+    const bool syncing = (worker->icMask & 1u) != 0u;   /* The first IC synchronizes all ICs */
+    uint32_t step = 0u;
+    bool looping = true;
+    spiDriver_ContModeAdoptInstance();
+    spiDriver_BrokerStepThread();
+    /* The bus threads acquire with the trigger thread's priority, but are not bound to its CPU */
+    const ContModeThreadCfg_t rtThread = {.priority = contModeCfg.rt.trigThread.priority, .cpu = -1};
+    spiDriver_ContModeRtThread(&contModeCfg.rt, &rtThread);
+    while (looping) {
+        pthread_mutex_lock(&busLock);
+        while ((busStep == step) && !busExit) {
+            pthread_cond_wait(&busCond, &busLock);
+        }
+        if (busExit) {
+            looping = false;
+        } else {
+            step = busStep;
+            while (!syncing && (busSyncStep != step)) {
+                pthread_cond_wait(&busCond, &busLock);
+            }
+        }
+        pthread_mutex_unlock(&busLock);
+        if (looping) {
+            spiDriver_ContModeRtWorkerBegin();
+            for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
+                if ((worker->icMask & (1ul << ic)) != 0u) {
+                    busIcRes[ic] = spiDriver_getSingleSyncStepIcs(1ul << ic, &busIcData[ic], &busIcDataSize[ic]);
+                    if (ic == 0u) {
+                        /* The first IC may skip the synchronization, when it's not working */
+                        BusSyncDone();
+                    }
+                }
+            }
+            spiDriver_ContModeRtWorkerEnd();
+            pthread_mutex_lock(&busLock);
+            busDone++;
+            pthread_cond_broadcast(&busCond);
+            pthread_mutex_unlock(&busLock);
+        }
+    }
+    return NULL;
+}
+
+
+void spiDriver_InitBusData(void)
+{
+    if ((busWorkersCount == 0u) && contModeCfg.useAsyncSequence && (contModeCfg.icBus != NULL)) {
+        uint16_t count = 0u;
+        for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
+            uint16_t ind = 0u;
+            while ((ind < count) && (busWorkers[ind].bus != contModeCfg.icBus[ic])) {
+                ind++;
+            }
+            if (ind == count) {
+                busWorkers[ind].bus = contModeCfg.icBus[ic];
+                busWorkers[ind].icMask = 0u;
+                count++;
+            }
+            busWorkers[ind].icMask |= 1ul << ic;
+        }
+        if (count > 1u) {
+            busStep = 0u;
+            busSyncStep = 0u;
+            busExit = false;
+            spiDriver_AssignSyncDone(BusSyncDone);
+            for (uint16_t ind = 0u; ind < count; ind++) {
+                if (pthread_create(&busWorkers[ind].thread, NULL, &BusDataExecute, &busWorkers[ind]) == 0) {
+                    busWorkersCount++;
+                } else {
+                    CONT_PRINT("Bus thread %u is not created\n", busWorkers[ind].bus);
+                    break;
+                }
+            }
+            if (busWorkersCount != count) {
+                /* All ICs should be covered, fall back to the single thread */
+                spiDriver_ExitBusData();
+            } else {
+                CONT_PRINT("%u bus threads created\n", busWorkersCount);
+            }
+        }
+    }
+}
+
+
+bool spiDriver_BusDataActive(void)
+{
+    return busWorkersCount > 0u;
+}
+
+
+FuncResult_e spiDriver_GetBusSyncStep(spiDriver_ChipData_t** chipData, uint16_t* chipDataSize)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    uint16_t total = 0u;
+    for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
+        busIcData[ic] = NULL;
+        busIcDataSize[ic] = 0u;
+        busIcRes[ic] = SPI_DRV_FUNC_RES_OK;
+    }
+    pthread_mutex_lock(&busLock);
+    busDone = 0u;
+    busStep++;
+    pthread_cond_broadcast(&busCond);
+    while (busDone < busWorkersCount) {
+        pthread_cond_wait(&busCond, &busLock);
+    }
+    pthread_mutex_unlock(&busLock);
+
+    /* Merge the ICs' records in the ICs' order */
+    for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
+        res |= busIcRes[ic];
+        total += busIcDataSize[ic];
+    }
+    *chipData = NULL;
+    *chipDataSize = 0u;
+    if (total > 0u) {
+        *chipData = malloc(total * sizeof(spiDriver_ChipData_t));
+        if (*chipData == NULL) {
+            res |= SPI_DRV_FUNC_RES_FAIL_MEMORY;
+        }
+    }
+    for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
+        if (*chipData != NULL) {
+            memcpy(&(*chipData)[*chipDataSize], busIcData[ic], busIcDataSize[ic] * sizeof(spiDriver_ChipData_t));
+            *chipDataSize += busIcDataSize[ic];
+        } else {
+            spiDriver_CleanChipData(busIcData[ic], &busIcDataSize[ic]);
+        }
+        free(busIcData[ic]);
+        busIcData[ic] = NULL;
+    }
+    return res;
+}
+
+
+void spiDriver_ExitBusData(void)
+{
+    pthread_mutex_lock(&busLock);
+    busExit = true;
+    pthread_cond_broadcast(&busCond);
+    pthread_mutex_unlock(&busLock);
+    for (uint16_t ind = 0u; ind < busWorkersCount; ind++) {
+        pthread_join(busWorkers[ind].thread, NULL);
+    }
+    busWorkersCount = 0u;
+    spiDriver_AssignSyncDone(NULL);
+}
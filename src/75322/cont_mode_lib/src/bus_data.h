@@ -0,0 +1,74 @@
+/**
+ * @file
+ * @brief SPI driver for MLX75322 Continuous mode support
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_cont_bus SPI driver continuous mode per-bus acquisition threads
+ * @ingroup spi_cont_mode
+ *
+ * @details provides the acquisition threads for the asynchronous multi-IC sequence (see
+ *      ContModeCfg_t::useAsyncSequence). The ICs are grouped by their buses (see ContModeCfg_t::icBus), each group is
+ *      read by its own thread with its own communication context, so the buses are used at once. The trigger thread
+ *      starts all groups for each step and merges their data in the ICs' order, so the data stream is the same as
+ *      with the single thread.
+ *
+ *      The first IC's tick synchronizes all ICs, other groups wait for this before reading.
+ */
+
+#ifndef BUS_DATA_H
+#define BUS_DATA_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "spi_drv_trace.h"
+
+/** Initiates the per-bus acquisition threads
+ * The threads are created when the asynchronous sequence is used and the ICs are on more than one bus
+ * @note    This function is normally driven from the continuous mode library
+ */
+void spiDriver_InitBusData(void);
+
+/** Checks whether the per-bus acquisition threads are used
+ * @retval  true    the steps are read by ::spiDriver_GetBusSyncStep
+ * @retval  false   no per-bus threads are running
+ */
+bool spiDriver_BusDataActive(void);
+
+/** Makes a single synchro step of all ICs, reading the buses at once
+ * The result is the same as the one of spiDriver_getSingleSyncStep
+ * @param[out]  chipData        the records of the step, allocated
+ * @param[out]  chipDataSize    items count in `chipData` array
+ * @return  result of an operation. See ::FuncResult_e for details
+ */
+FuncResult_e spiDriver_GetBusSyncStep(spiDriver_ChipData_t** chipData, uint16_t* chipDataSize);
+
+/** Exits the per-bus acquisition threads
+ * @note    This function is normally driven from the continuous mode library
+ */
+void spiDriver_ExitBusData(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* BUS_DATA_H */
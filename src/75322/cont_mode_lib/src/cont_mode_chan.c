@@ -0,0 +1,231 @@
+/**
+ * @file
+ * @brief Continuous mode inter-thread channels
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_cont_chan
+ */
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "cont_mode_lib.h"
+#include "cont_mode_chan.h"
+
+/** Size of the cache line, used to place the producer's and consumer's positions apart */
+#define CONT_MODE_CHAN_LINE 64u
+
+/** The channel's slot */
+typedef struct {
+    uint32_t seq;               /**< Slot's sequence, tells whether it's free or filled for the position */
+    uint64_t stampNs;           /**< Time the message was sent */
+    contModeInterface_t msg;    /**< Message */
+} ContModeChanCell_t;
+
+/** The channel: a bounded ring with per-slot sequences (multiple producers, multiple consumers) */
+typedef struct {
+    uint32_t tail;                                      /**< Position to send the next message to */
+    uint8_t tailPad[CONT_MODE_CHAN_LINE - sizeof(uint32_t)];
+    uint32_t head;                                      /**< Position to receive the next message from */
+    uint8_t headPad[CONT_MODE_CHAN_LINE - sizeof(uint32_t)];
+    int32_t events;                                     /**< Futex word, incremented on each message sent */
+    uint32_t waiters;                                   /**< Amount of receivers sleeping on the futex */
+    ContModeChanStats_t stats;                          /**< Statistics */
+    ContModeChanCell_t cells[CONT_MODE_CHAN_SIZE];      /**< Slots */
+} ContModeChan_t;
+
+static ContModeChan_t contModeChannels[CONT_MODE_CHAN_COUNT];
+
+
+static uint64_t spiDriver_ChanNowNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000ull) + (uint64_t)now.tv_nsec;
+}
+
+
+static void spiDriver_ChanFutexWait(int32_t* const addr, const int32_t value)
+{
+    (void)syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+}
+
+
+static void spiDriver_ChanFutexWake(int32_t* const addr)
+{
+    (void)syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+
+/** Puts the message into the ring. Returns false when the ring is full */
+static bool spiDriver_ChanPush(ContModeChan_t* const chan, const contModeInterface_t* const msg)
+{
+    bool res = false;
+    bool done = false;
+    uint32_t pos = __atomic_load_n(&chan->tail, __ATOMIC_RELAXED);
+    ContModeChanCell_t* cell = NULL;
+    while (!done) {
+        int32_t dif;
+        cell = &chan->cells[pos & (CONT_MODE_CHAN_SIZE - 1u)];
+        dif = (int32_t)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - pos);
+        if (dif == 0) {
+            /* The slot is free, try to take it */
+            res = __atomic_compare_exchange_n(&chan->tail, &pos, pos + 1u, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+            done = res;
+        } else if (dif < 0) {
+            /* The ring is full */
+            done = true;
+        } else {
+            pos = __atomic_load_n(&chan->tail, __ATOMIC_RELAXED);
+        }
+    }
+    if (res) {
+        cell->msg = *msg;
+        cell->stampNs = spiDriver_ChanNowNs();
+        __atomic_store_n(&cell->seq, pos + 1u, __ATOMIC_RELEASE);
+    }
+    return res;
+}
+
+
+/** Takes the message from the ring. Returns false when the ring is empty */
+static bool spiDriver_ChanPop(ContModeChan_t* const chan, contModeInterface_t* const msg)
+{
+    bool res = false;
+    bool done = false;
+    uint32_t pos = __atomic_load_n(&chan->head, __ATOMIC_RELAXED);
+    ContModeChanCell_t* cell = NULL;
+    while (!done) {
+        int32_t dif;
+        cell = &chan->cells[pos & (CONT_MODE_CHAN_SIZE - 1u)];
+        dif = (int32_t)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - (pos + 1u));
+        if (dif == 0) {
+            /* The slot is filled, try to take it */
+            res = __atomic_compare_exchange_n(&chan->head, &pos, pos + 1u, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+            done = res;
+        } else if (dif < 0) {
+            /* The ring is empty */
+            done = true;
+        } else {
+            pos = __atomic_load_n(&chan->head, __ATOMIC_RELAXED);
+        }
+    }
+    if (res) {
+        const uint64_t latency = spiDriver_ChanNowNs() - cell->stampNs;
+        const uint32_t latency32 = (latency < UINT32_MAX) ? (uint32_t)latency : UINT32_MAX;
+        uint32_t latencyMax;
+        *msg = cell->msg;
+        __atomic_store_n(&cell->seq, pos + CONT_MODE_CHAN_SIZE, __ATOMIC_RELEASE);
+        __atomic_add_fetch(&chan->stats.received, 1u, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&chan->stats.latencyNsSum, latency, __ATOMIC_RELAXED);
+        /* Several receivers may update the maximum at once */
+        latencyMax = __atomic_load_n(&chan->stats.latencyNsMax, __ATOMIC_RELAXED);
+        while ((latency32 > latencyMax) &&
+               !__atomic_compare_exchange_n(&chan->stats.latencyNsMax, &latencyMax, latency32, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            ;
+        }
+    }
+    return res;
+}
+
+
+void spiDriver_ContModeChanInit(void)
+{
+    for (uint16_t type = 0u; type < CONT_MODE_CHAN_COUNT; type++) {
+        ContModeChan_t* chan = &contModeChannels[type];
+        memset(chan, 0, sizeof(*chan));
+        for (uint32_t ind = 0u; ind < CONT_MODE_CHAN_SIZE; ind++) {
+            chan->cells[ind].seq = ind;
+        }
+    }
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+
+void spiDriver_ContModeSend(const contModeInterface_t* const msg)
+{
+    if ((msg->mtype >= 0) && (msg->mtype < (long)CONT_MODE_CHAN_COUNT)) {
+        ContModeChan_t* chan = &contModeChannels[msg->mtype];
+        while (!spiDriver_ChanPush(chan, msg)) {
+            __atomic_add_fetch(&chan->stats.fullRetries, 1u, __ATOMIC_RELAXED);
+            sched_yield();
+        }
+        __atomic_add_fetch(&chan->stats.sent, 1u, __ATOMIC_RELAXED);
+        /* The counter's change and the waiters' check are ordered against the receiver's ones (SEQ_CST) */
+        __atomic_add_fetch(&chan->events, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&chan->waiters, __ATOMIC_SEQ_CST) != 0u) {
+            __atomic_add_fetch(&chan->stats.wakeups, 1u, __ATOMIC_RELAXED);
+            spiDriver_ChanFutexWake(&chan->events);
+        }
+    }
+}
+
+
+bool spiDriver_ContModeReceive(const ContMessageType_e type, contModeInterface_t* const msg, const bool wait)
+{
+    bool res = false;
+    if ((uint16_t)type < CONT_MODE_CHAN_COUNT) {
+        ContModeChan_t* chan = &contModeChannels[type];
+        bool looping = true;
+        while (looping) {
+            res = spiDriver_ChanPop(chan, msg);
+            if (res || !wait) {
+                looping = false;
+            } else {
+                const int32_t events = __atomic_load_n(&chan->events, __ATOMIC_SEQ_CST);
+                __atomic_add_fetch(&chan->waiters, 1u, __ATOMIC_SEQ_CST);
+                /* Check again, the message could be sent before the waiter was registered */
+                res = spiDriver_ChanPop(chan, msg);
+                if (res) {
+                    looping = false;
+                } else {
+                    __atomic_add_fetch(&chan->stats.sleeps, 1u, __ATOMIC_RELAXED);
+                    spiDriver_ChanFutexWait(&chan->events, events);
+                }
+                __atomic_sub_fetch(&chan->waiters, 1u, __ATOMIC_SEQ_CST);
+            }
+        }
+    }
+    return res;
+}
+
+
+uint16_t spiDriver_ContModeFlush(const ContMessageType_e type)
+{
+    uint16_t counter = 0u;
+    contModeInterface_t msg;
+    while (spiDriver_ContModeReceive(type, &msg, false)) {
+        counter++;
+    }
+    return counter;
+}
+
+
+void spiDriver_GetContModeChanStats(const ContMessageType_e type, ContModeChanStats_t* const stats)
+{
+    if ((uint16_t)type < CONT_MODE_CHAN_COUNT) {
+        *stats = contModeChannels[type].stats;
+    } else {
+        memset(stats, 0, sizeof(*stats));
+    }
+}
@@ -0,0 +1,106 @@
+/**
+ * @file
+ * @brief Continuous mode inter-thread channels
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_cont_chan SPI driver continuous mode inter-thread channels
+ * @ingroup spi_cont_mode
+ *
+ * @details provides the in-process channels used by the continuous mode threads to exchange the commands and
+ *      signals. There is a channel per message type (see ::ContMessageType_e), the message is routed by its
+ *      contModeInterface_t::mtype field.
+ *
+ *      Each channel is a bounded lock-free ring (multiple producers, multiple consumers), so sending and receiving
+ *      a message doesn't take any lock or copy the data into the kernel. The receiver waiting for a message sleeps
+ *      on a futex, which is signalled by the sender only when somebody is waiting. Thus, the message exchange
+ *      between the running threads costs no system calls.
+ *
+ *      The channels live in the process memory, so nothing is left after the process exits.
+ */
+
+#ifndef CONT_MODE_CHAN_H
+#define CONT_MODE_CHAN_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cont_mode_lib.h"
+
+/** Amount of messages a channel can hold. Should be a power of 2 */
+#define CONT_MODE_CHAN_SIZE 256u
+
+/** Amount of channels, one per message type */
+#define CONT_MODE_CHAN_COUNT ((uint16_t)CONT_MODE_MSG_COUNT)
+
+/** Signalling statistics of a channel */
+typedef struct {
+    uint32_t sent;              /**< Messages sent */
+    uint32_t received;          /**< Messages received */
+    uint32_t wakeups;           /**< Wake-up system calls done by the senders */
+    uint32_t sleeps;            /**< Sleeps of the receivers, waiting for a message */
+    uint32_t fullRetries;       /**< Retries of the senders, when the channel was full */
+    uint64_t latencyNsSum;      /**< Sum of the times between the message's send and receive, ns */
+    uint32_t latencyNsMax;      /**< Maximum time between the message's send and receive, ns */
+} ContModeChanStats_t;
+
+
+/** Initializes all channels, dropping the messages left
+ * @note    Should be called while no thread uses the channels
+ */
+void spiDriver_ContModeChanInit(void);
+
+
+/** Sends the message into the channel of contModeInterface_t::mtype
+ * Waits for the free space, if the channel is full
+ * @param[in]   msg     message to send
+ */
+void spiDriver_ContModeSend(const contModeInterface_t* const msg);
+
+
+/** Receives the message from the channel
+ * @param[in]   type    message type (channel) to receive from
+ * @param[out]  msg     message received
+ * @param[in]   wait    set to wait for the message, when the channel is empty
+ * @retval  true    the message is received
+ * @retval  false   the channel is empty (when not waiting) or the type is unknown
+ */
+bool spiDriver_ContModeReceive(const ContMessageType_e type, contModeInterface_t* const msg, const bool wait);
+
+
+/** Drops all messages of the channel
+ * @param[in]   type    message type (channel) to flush
+ * @return      amount of messages dropped
+ */
+uint16_t spiDriver_ContModeFlush(const ContMessageType_e type);
+
+
+/** Gets the signalling statistics of the channel
+ * @param[in]   type    message type (channel)
+ * @param[out]  stats   statistics' output
+ */
+void spiDriver_GetContModeChanStats(const ContMessageType_e type, ContModeChanStats_t* const stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* CONT_MODE_CHAN_H */
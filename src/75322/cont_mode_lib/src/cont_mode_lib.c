@@ -24,16 +24,17 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <pthread.h>
-#include <sys/types.h>
-#include <sys/ipc.h>
-#include <sys/msg.h>
 #include <string.h>
 #include <unistd.h>
 #include "cont_mode_lib.h"
+#include "cont_mode_chan.h"
 #include "spi_drv_common_types.h"
 #include "spi_drv_sync_mode.h"
 #include "trig_data.h"
+#include "deliver_data.h"
+#include "cont_mode_rt.h"
 #include "spi_drv_hal_udp.h"
+#include "spi_drv_instance_priv.h"
 
 /* API-level functions used by continuous mode which shouldn't be shared as driver's API */
 
@@ -50,10 +51,19 @@ extern FuncResult_e spiDriver_StartContinuousMode(const spiDriver_LayerConfig_t*
 static pthread_t ContModeThreadID;
 static ContModeCmd_e contModeThread[MAX_IC_ID_NUMBER] = { CONT_MODE_NOT_INITED };
 uint16_t contModePendingSteps[MAX_IC_ID_NUMBER] = { 0u };
-volatile int msqid = 0;
-ContModeCfg_t contModeCfg;
+ContModeCfg_t contModeCfgInst[SPI_DRV_MAX_HANDLES];
+/** Driver's instance the continuous mode is initialized for. Its threads and control functions work with it */
+static uint16_t contModeInstance = SPI_DRV_DEFAULT_INSTANCE;
+static uint16_t contModeInFlight = 0u;   /**< Items handed over to the delivery thread, not returned as credits yet */
+static ContModeCbRet_t contModeCbRequest = CB_RET_OK; /**< The strongest callback's request not handled yet */
+static ContModeDeliveryStats_t contModeDeliveryStats;
+static bool contModeSceneStart = true;      /**< The next item handed over starts a scene */
+static bool contModeSceneDropped = false;   /**< The items of the current scene are dropped */
+static contModeInterface_t* contModeRequeue = NULL; /**< Items taken back from the delivery queue, credits long */
+static int16_t contModeUdpConsumer = -1;  /**< UDP export consumer's identifier */
 
-extern volatile SpiDriver_State_t spiDriver_currentState;
+/** Items waiting for the UDP export */
+#define CONT_MODE_UDP_QUEUE_DEPTH 2u
 
 #if (CONT_MODE_DEBUG == 1)
 
@@ -78,17 +88,6 @@ char* spiDriver_GetContinuousModeName(const ContModeCmd_e mode)
 
 #endif /* CONT_MODE_DEBUG */
 
-/** Helper function which flushes the current message queue from previously left messages */
-static void FlushMessageQueue(volatile int msqid, const long msgid)
-{
-    contModeInterface_t rbuf;
-    uint16_t counter = 0;
-    while (msgrcv(msqid, &rbuf, contModeInterface_size, msgid, IPC_NOWAIT) >= 0) {
-        counter++;
-    }
-    CONT_PRINT("\nCont thread: %u messages were flushed before run\n", counter);
-}
-
 /** Checks if at least one IC in the configuration needs to be processed */
 static bool ContModeWork(void)
 {
@@ -102,50 +101,195 @@ static bool ContModeWork(void)
     return res;
 }
 
+/** Exports the data item via UDP, as a data consumer */
+static ContModeCbRet_t ContModeUdpConsumer(spiDriver_ChipData_t* chipData, const uint16_t chipDataSize, void* context)
+{
+    (void)context;
+    return spiDriver_UdpSend(chipData, chipDataSize);
+}
+
+/** Takes the credits returned by the delivery thread, collecting the callbacks' requests */
+static void ContModeTakeCredits(const bool wait)
+{
+    contModeInterface_t credit;
+    bool taken = spiDriver_ContModeReceive(CONT_MODE_CREDIT, &credit, wait);
+    while (taken) {
+        if (contModeInFlight > 0u) {
+            contModeInFlight--;
+        }
+        if (credit.cmd == CONT_MODE_EXIT) {
+            contModeCbRequest = CB_RET_EXIT;
+        } else if ((credit.cmd == CONT_MODE_STOP) && (contModeCbRequest == CB_RET_OK)) {
+            contModeCbRequest = CB_RET_STOP;
+        }
+        taken = spiDriver_ContModeReceive(CONT_MODE_CREDIT, &credit, false);
+    }
+}
+
+/** Releases the records of the item not delivered */
+static void ContModeDropItem(contModeInterface_t* const item)
+{
+    spiDriver_CleanChipData(item->chipData, &item->chipDataSize);
+    free(item->chipData);
+}
+
+/** Drops the oldest whole scene queued for the delivery thread, the other items are queued back in their order.
+ * In per-layer delivery the items up to the first scene's end may complete the scene being delivered, so they are kept
+ * @return  true when a scene is dropped */
+static bool ContModeDropOldestScene(void)
+{
+    const uint16_t credits = (contModeCfg.credits == 0u) ? 1u : contModeCfg.credits;
+    uint16_t count = 0u;
+    uint16_t first = 0u;
+    uint16_t last;
+    bool dropped = false;
+    while ((contModeRequeue != NULL) && (count < credits) &&
+           spiDriver_ContModeReceive(CONT_MODE_SCENE, &contModeRequeue[count], false)) {
+        count++;
+    }
+    if (contModeCfg.perLayerDelivery) {
+        while ((first < count) && !contModeRequeue[first].sceneComplete) {
+            first++;
+        }
+        first++;
+    }
+    last = first;
+    while ((last < count) && !contModeRequeue[last].sceneComplete) {
+        last++;
+    }
+    for (uint16_t ind = 0u; ind < count; ind++) {
+        if ((last < count) && (ind >= first) && (ind <= last)) {
+            ContModeDropItem(&contModeRequeue[ind]);
+            contModeInFlight--;
+            contModeDeliveryStats.droppedOldest++;
+            dropped = true;
+        } else {
+            spiDriver_ContModeSend(&contModeRequeue[ind]);
+        }
+    }
+    return dropped;
+}
+
+/** Hands the data item over to the delivery thread, applying the backpressure policy when no credits are left.
+ * The policy is applied per scene: in per-layer delivery a scene is dropped as a whole, and the scene being delivered
+ * waits for the credits. The item's data is owned by the receiver, the dropped items are released here */
+static void ContModeDeliver(const contModeInterface_t* const item)
+{
+    const uint16_t credits = (contModeCfg.credits == 0u) ? 1u : contModeCfg.credits;
+    const bool sceneStart = contModeSceneStart;
+    contModeInterface_t scene = *item;
+    bool deliver = true;
+    bool wait = false;
+    scene.mtype = CONT_MODE_SCENE;
+    scene.cmd = CONT_MODE_WORK;
+    contModeSceneStart = item->sceneComplete;
+    ContModeTakeCredits(false);
+    if (!sceneStart) {
+        /* The rest of the scene follows its first item */
+        deliver = !contModeSceneDropped;
+        wait = deliver && (contModeInFlight >= credits);
+    } else if (contModeInFlight >= credits) {
+        switch (contModeCfg.backpressure) {
+            case CONT_MODE_BP_DROP_OLDEST:
+                if (ContModeDropOldestScene()) {
+                    CONT_PRINT("Cont thread: No credits, drop the oldest scene\n");
+                    wait = (contModeInFlight >= credits);
+                    break;
+                }
+            /* All scenes are in the callback already, nothing older to drop */
+            /* fall through */
+            case CONT_MODE_BP_DROP_NEWEST:
+                CONT_PRINT("Cont thread: No credits, drop the newest scene\n");
+                deliver = false;
+                break;
+            case CONT_MODE_BP_BLOCK:
+            default:
+                wait = true;
+                break;
+        }
+    } else {
+        /* The scene is delivered */
+    }
+    if (sceneStart) {
+        contModeSceneDropped = !deliver;
+    }
+    if (wait) {
+        CONT_PRINT("Cont thread: No credits, wait for the callback\n");
+        contModeDeliveryStats.creditWaits++;
+        while (contModeInFlight >= credits) {
+            ContModeTakeCredits(true);
+        }
+    }
+    if (deliver) {
+        contModeInFlight++;
+        contModeDeliveryStats.delivered++;
+        spiDriver_ContModeSend(&scene);
+    } else {
+        ContModeDropItem(&scene);
+        contModeDeliveryStats.droppedNewest++;
+    }
+}
+
+/** Makes the calling thread work with the driver's instance the continuous mode is initialized for */
+void spiDriver_ContModeAdoptInstance(void)
+{
+    spiDriver_instanceIdx = __atomic_load_n(&contModeInstance, __ATOMIC_ACQUIRE);
+}
+
+
+/** Makes the calling thread work with the continuous mode's instance, returns the instance used before */
+static uint16_t ContModeEnterInstance(void)
+{
+    const uint16_t caller = spiDriver_instanceIdx;
+    spiDriver_ContModeAdoptInstance();
+    return caller;
+}
+
+
 /* Continuous mode thread function */
 void* contModeExecute(void* temp)
 {
     const contModeInterface_t msg_request_data = {.cmd = CONT_MODE_WORK, .mtype = CONT_MODE_REQUEST_DATA};
-    const int msgflg = IPC_CREAT | 0666;
 #if (CONT_MODE_DEBUG == 1)
     unsigned long index = 0ul;
 #endif /* CONT_MODE_DEBUG */
     bool looping = true;
     bool lastRequest[MAX_IC_ID_NUMBER] = { false };
     (void)temp;
-    /* get the message queue id for the key with value CONT_MODE_MSQ_KEY */
-    CONT_PRINT("\nmsgget: Calling msgget(%#x,\%#o)\n", CONT_MODE_MSQ_KEY, msgflg);
-    if ((msqid = msgget(CONT_MODE_MSQ_KEY, msgflg)) < 0) {
-        perror("msgget");
-        exit(1);
-    } else {
-        CONT_PRINT("msgget: msgget succeeded: msqid = %d\n", msqid);
-        FlushMessageQueue(msqid, 0l);
-    }
+    spiDriver_ContModeAdoptInstance();
+    spiDriver_ContModeRtThread(&contModeCfg.rt, &contModeCfg.rt.ctrlThread);
     for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
         contModePendingSteps[ic] = CONT_MODE_MAX_PENDING;
     }
+    contModeInFlight = 0u;
+    contModeCbRequest = CB_RET_OK;
+    contModeSceneStart = true;
+    contModeSceneDropped = false;
+    if (contModeCfg.backpressure == CONT_MODE_BP_DROP_OLDEST) {
+        contModeRequeue = calloc((contModeCfg.credits == 0u) ? 1u : contModeCfg.credits, sizeof(contModeInterface_t));
+    }
     while (looping) {
         contModeInterface_t ctrl_buf;
-        ssize_t cmd_res;
+        bool cmdReceived;
         if (!(ContModeWork())) {
             CONT_PRINT("\nCont thread: Wait for command\n");
-            cmd_res = msgrcv(msqid, &ctrl_buf, contModeInterface_size, CONT_MODE_CTRL, 0);
+            cmdReceived = spiDriver_ContModeReceive(CONT_MODE_CTRL, &ctrl_buf, true);
         } else {
-            cmd_res = msgrcv(msqid, &ctrl_buf, contModeInterface_size, CONT_MODE_CTRL, IPC_NOWAIT);
+            cmdReceived = spiDriver_ContModeReceive(CONT_MODE_CTRL, &ctrl_buf, false);
         }
 
-        if (cmd_res < 0) {
+        if (!cmdReceived) {
             /* No commands */
             if (ContModeWork()) {
                 contModeInterface_t rbuf;
-                if (msgrcv(msqid, &rbuf, contModeInterface_size, CONT_MODE_DATA_READY, 0) >= 0) { /* Wait for data ready signal */
-                    spiDriver_ChipData_t* chipData = (spiDriver_ChipData_t*)spiDriver_chipData;
-                    spiDriver_ChipData_t* chipDataIt = chipData;
+                if (spiDriver_ContModeReceive(CONT_MODE_DATA_READY, &rbuf, true)) { /* Wait for data ready signal */
+                    /* The item's data is published by the delivery thread */
+                    spiDriver_ChipData_t* chipDataIt = rbuf.chipData;
+                    /* Requests and stops are handled once per scene */
+                    const uint16_t sceneDataSize = rbuf.sceneComplete ? rbuf.chipDataSize : 0u;
                     bool newRequest = false;
-                    ContModeCbRet_t cbRes;
                     /* Update the pending flags when they're used */
-                    for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
+                    for (uint16_t ic = 0u; (ic < syncModeCfg.icCount) && rbuf.sceneComplete; ic++) {
                         if (contModePendingSteps[ic] < CONT_MODE_MAX_PENDING) {
                             if (contModePendingSteps[ic] > 0u) {
                                 #if (CONT_MODE_DEBUG == 1)
@@ -157,7 +301,7 @@ void* contModeExecute(void* temp)
                             }
                         }
                     }
-                    for (uint16_t dataInd = 0u; dataInd < spiDriver_chipDataSize; dataInd++) {
+                    for (uint16_t dataInd = 0u; dataInd < sceneDataSize; dataInd++) {
                         uint16_t icIdx = spiDriver_GetIcIndexById(chipDataIt->chip_id);
                         if (icIdx >= MAX_IC_ID_NUMBER) {
                             CONT_PRINT("Data acquisition error. IC ID [%u] returned was not found\n",
@@ -234,32 +378,51 @@ void* contModeExecute(void* temp)
                         }
                         chipDataIt++;
                     }
+                    /* The callback runs in the delivery thread, while the next data is being acquired */
+                    ContModeDeliver(&rbuf);
                     if (newRequest) {
-                        msgsnd(msqid, &msg_request_data, contModeInterface_size, IPC_CREAT);
-                    }
-                    CONT_PRINT("Cont thread: Run callback\n");
-                    spiDriver_UdpCallback(chipData);
-                    if (contModeCfg.callback != NULL) {
-                        cbRes = contModeCfg.callback(chipData);
-                    } else {
-                        cbRes = CB_RET_OK;
+                        spiDriver_ContModeSend(&msg_request_data);
                     }
-                    CONT_PRINT("Cont thread: CB result:%u\n", cbRes);
                     for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
                         if (contModePendingSteps[ic] == 0u) {
+                            /* Deliver all pending items before reporting the stop */
+                            while (contModeInFlight > 0u) {
+                                ContModeTakeCredits(true);
+                            }
                             const contModeInterface_t out_stop_msg =
                             {.cmd = CONT_MODE_IDLE, .mtype = CONT_MODE_FEEDBACK};
                             CONT_PRINT("Cont thread: No data left for IC%u\n",
                                        spiDriver_currentState.params[ic].icIndex);
                             spiDriver_currentState.params[ic].contState = CONT_MODE_STATE_IDLE;
                             contModeThread[ic] = CONT_MODE_IDLE;
-                            msgsnd(msqid, &out_stop_msg, contModeInterface_size, IPC_CREAT);
+                            spiDriver_ContModeSend(&out_stop_msg);
                             contModePendingSteps[ic] = CONT_MODE_MAX_PENDING;
                         }
                     }
 
-                    (void)cbRes;
-                    /* TODO: react on what the callback wants */
+                    ContModeTakeCredits(false);
+                    if (contModeCbRequest != CB_RET_OK) {
+                        if (!ContModeWork()) {
+                            if (contModeCbRequest == CB_RET_EXIT) {
+                                CONT_PRINT("Cont thread: Exit requested by the callback\n");
+                                spiDriver_ExitTrigData();
+                                looping = false;
+                            }
+                            contModeCbRequest = CB_RET_OK;
+                        } else {
+                            /* Stop as the STOP command does, unless the stop is already in progress */
+                            bool stopping = false;
+                            for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
+                                stopping |= lastRequest[ic] || (contModePendingSteps[ic] < CONT_MODE_MAX_PENDING);
+                            }
+                            if (!stopping) {
+                                CONT_PRINT("Cont thread: Stop requested by the callback\n");
+                                for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
+                                    lastRequest[ic] = true;
+                                }
+                            }
+                        }
+                    }
                 }
             } else {
                 for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
@@ -273,8 +436,9 @@ void* contModeExecute(void* temp)
                     CONT_PRINT("\nCont thread: Thread is idle\n");
                     break;
                 case CONT_MODE_WORK:  /* Command WORK. Do initial data request */
+                    contModeCbRequest = CB_RET_OK;
                     CONT_PRINT("\nCont thread: Run polling data. Send request %lu\n", index++);
-                    msgsnd(msqid, &msg_request_data, contModeInterface_size, IPC_CREAT);
+                    spiDriver_ContModeSend(&msg_request_data);
                     break;
                 case CONT_MODE_STOP: /* Command STOP. Wait for last response and go to IDLE */
                     CONT_PRINT("\nCont thread: Stop polling data. Waiting for last message\n");
@@ -299,6 +463,9 @@ void* contModeExecute(void* temp)
             }
         }
     }
+    spiDriver_ExitDeliverData();
+    free(contModeRequeue);
+    contModeRequeue = NULL;
     CONT_PRINT("\nCont thread: Finished\n");
     for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
         contModeThread[ic] = CONT_MODE_NOT_INITED;
@@ -307,40 +474,58 @@ void* contModeExecute(void* temp)
 }
 
 
-void spiDriver_InitContinuousMode(const ContModeCfg_t* const cfg)
+/** Initiates the continuous mode for the calling thread's instance, see ::spiDriver_InitContinuousMode
+ * @retval  SPI_DRV_FUNC_RES_OK             operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG the continuous mode is initialized for another instance, `cfg` is ignored
+ * @retval  SPI_DRV_FUNC_RES_FAIL           the continuous mode thread can't be created
+ */
+FuncResult_e spiDriver_InitContinuousModeInstance(const ContModeCfg_t* const cfg)
 {
-    contModeCfg = *cfg;
-    uint32_t msqid_counter = 0x10000;
-
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
     if (contModeThread[0u] == CONT_MODE_NOT_INITED) {
-        (void)pthread_create(&ContModeThreadID, NULL, &contModeExecute, NULL);
-        while((msqid == 0) && (msqid_counter-- != 0ul)) {
-            ;
-        }
-        if (msqid_counter != 0ul) {
-            CONT_PRINT("\nCont thread: Created\n");
-            /* get the message queue id for the key with value CONT_MODE_MSQ_KEY */
-            CONT_PRINT("\nmsgget: Calling msgget(%#x,\%#o)\n", CONT_MODE_MSQ_KEY, 0666);
-            if ((msqid = msgget(CONT_MODE_MSQ_KEY, 0666)) < 0) {
-                perror("msgget");
-                exit(1);
+        __atomic_store_n(&contModeInstance, SPI_DRV_INSTANCE, __ATOMIC_RELEASE);
+    }
+    if (contModeInstance != SPI_DRV_INSTANCE) {
+        CONT_PRINT("Continuous mode is initialized for the instance %u\n", contModeInstance);
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+    } else {
+        contModeCfg = *cfg;
+        if (contModeThread[0u] == CONT_MODE_NOT_INITED) {
+            /* Channels are set up before the threads start, so no messages are lost or left from the previous run */
+            spiDriver_ContModeChanInit();
+            spiDriver_ContModeRtSetup(&contModeCfg.rt);
+            if (pthread_create(&ContModeThreadID, NULL, &contModeExecute, NULL) == 0) {
+                CONT_PRINT("\nCont thread: Created\n");
+                for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
+                    contModeThread[ic] = CONT_MODE_IDLE;
+                }
+                (void)spiDriver_InitTrigData();
+                spiDriver_InitDeliverData();
+                spiDriver_InitUdpCallback(DEST_PORT);
+                if (contModeUdpConsumer < 0) {
+                    const ContModeConsumerCfg_t udpConsumer = {.callback = ContModeUdpConsumer, .context = NULL,
+                                                               .queueDepth = CONT_MODE_UDP_QUEUE_DEPTH, .cpu = -1};
+                    contModeUdpConsumer = spiDriver_SubscribeContMode(&udpConsumer);
+                }
+                spiDriver_InitContinuousModeInt();
             } else {
-                CONT_PRINT("msgget: msgget succeeded: msqid = %d\n", msqid);
-            }
-            for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
-                contModeThread[ic] = CONT_MODE_IDLE;
+                CONT_PRINT("\n Error creating continuous mode thread\n");
+                res = SPI_DRV_FUNC_RES_FAIL;
             }
-            (void)spiDriver_InitTrigData();
-            spiDriver_InitUdpCallback(DEST_PORT);
-            spiDriver_InitContinuousModeInt();
-        } else {
-            CONT_PRINT("\n Error creating message queue\n");
         }
     }
+    return res;
+}
+
+
+void spiDriver_InitContinuousMode(const ContModeCfg_t* const cfg)
+{
+    (void)spiDriver_InitContinuousModeInstance(cfg);
 }
 
 bool spiDriver_RunContinuousMode(void)
 {
+    const uint16_t caller = ContModeEnterInstance();
     bool res = true;
     if (contModeThread[0u] == CONT_MODE_IDLE) { /* TODO: check all thread states */
         contModeInterface_t msg;
@@ -363,31 +548,36 @@ bool spiDriver_RunContinuousMode(void)
                                           contModeCfg.layerOrder,
                                           contModeCfg.layerCount);
         }
+        /* The first scene after the run is started at once */
+        spiDriver_ContModePaceReset();
         CONT_PRINT("SEND MESSAGE RUN\n");
-        (void)msgsnd(msqid, &msg, contModeInterface_size, IPC_CREAT);
+        spiDriver_ContModeSend(&msg);
     } else {
         CONT_PRINT("Can't start continuous mode, it's in %s mode\n",
                    spiDriver_GetContinuousModeName(contModeThread[0u]));
         res = false;
     }
+    spiDriver_instanceIdx = caller;
     return res;
-
 }
 
 bool spiDriver_StopContinuousMode(void)
 {
+    const uint16_t caller = ContModeEnterInstance();
     bool res = true;
     contModeInterface_t rbuf;
     contModeInterface_t msg;
     msg.cmd = CONT_MODE_STOP;
     msg.mtype = CONT_MODE_CTRL;
-    FlushMessageQueue(msqid, CONT_MODE_FEEDBACK);
+    const uint16_t flushed = spiDriver_ContModeFlush(CONT_MODE_FEEDBACK);
+    CONT_PRINT("%u feedback messages were flushed before stop\n", flushed);
+    (void)flushed;
     CONT_PRINT("SEND MESSAGE STOP\n");
-    (void)msgsnd(msqid, &msg, contModeInterface_size, IPC_CREAT);
+    spiDriver_ContModeSend(&msg);
     // wait for threads to stop
     for (uint16_t ic = 0u; (ic < syncModeCfg.icCount) && res; ic++) {
-        if (msgrcv(msqid, &rbuf, contModeInterface_size, CONT_MODE_FEEDBACK, 0) < 0) {
-            CONT_PRINT("Trigger: msgrcv err:%x\n", errno);
+        if (!spiDriver_ContModeReceive(CONT_MODE_FEEDBACK, &rbuf, true)) {
+            CONT_PRINT("Trigger: feedback receive failed\n");
             res = false;
         }
     }
@@ -398,18 +588,20 @@ bool spiDriver_StopContinuousMode(void)
         CONT_PRINT("Continuous mode is not stopped\n");
         res = false;
     }
+    spiDriver_instanceIdx = caller;
     return res;
 }
 
 bool spiDriver_ExitContinuousMode(void)
 {
+    const uint16_t caller = ContModeEnterInstance();
     bool res;
     if (contModeThread[0u] == CONT_MODE_IDLE) { /* TODO: check all IC configs */
         contModeInterface_t msg;
         msg.cmd = CONT_MODE_EXIT;
         msg.mtype = CONT_MODE_CTRL;
         CONT_PRINT("SEND MESSAGE EXIT\n");
-        (void)msgsnd(msqid, &msg, contModeInterface_size, IPC_CREAT);
+        spiDriver_ContModeSend(&msg);
         spiDriver_ExitTrigData();
         res = true;
     } else {
@@ -417,10 +609,23 @@ bool spiDriver_ExitContinuousMode(void)
                    spiDriver_GetContinuousModeName(contModeThread[0u]));
         res = false;
     }
+    spiDriver_instanceIdx = caller;
     return res;
 }
 
 
+void spiDriver_GetContModeDeliveryStats(ContModeDeliveryStats_t* const stats)
+{
+    *stats = contModeDeliveryStats;
+}
+
+
+int16_t spiDriver_GetContModeUdpConsumer(void)
+{
+    return contModeUdpConsumer;
+}
+
+
 void spiDriver_UpdateCurrentData(const spiDriver_ChipData_t* const spiDriver_chipDataTmp,
                                  const uint16_t spiDriver_chipDataSizeTmp)
 {
@@ -428,6 +633,6 @@ void spiDriver_UpdateCurrentData(const spiDriver_ChipData_t* const spiDriver_chi
     uint16_t spiDriver_chipDataSizeOld = spiDriver_chipDataSize;
     spiDriver_chipData = (volatile spiDriver_ChipData_t*)spiDriver_chipDataTmp;
     spiDriver_chipDataSize = (volatile uint16_t)spiDriver_chipDataSizeTmp;
-    spiDriver_CleanChipData(spiDriver_chipDataOld, &spiDriver_chipDataSizeOld);
+    spiDriver_DeliverReleaseData(spiDriver_chipDataOld, spiDriver_chipDataSizeOld);
 }
 
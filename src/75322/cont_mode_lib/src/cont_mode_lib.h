@@ -44,9 +44,6 @@ extern "C"
 
 #include "spi_drv_trace.h"
 
-/** Continuous mode unique message queue identifier */
-#define CONT_MODE_MSQ_KEY ((key_t)0x01CAFE10)
-
 /* Use CON_MODE_DEBUG=1 option to add continuous mode debug output */
 #ifndef CONT_MODE_DEBUG
 #define CONT_MODE_DEBUG 0
@@ -61,6 +58,9 @@ extern "C"
 /** Specifies the buffer's size for holding the field's name in a structure */
 #define CONT_MODE_MAX_PENDING 100
 
+/** Maximum amount of the continuous mode data consumers (see ::spiDriver_SubscribeContMode) */
+#define CONT_MODE_MAX_CONSUMERS 8
+
 /** Continuous mode internal state-machine state */
 typedef enum {
     CONT_MODE_EMPTY = 0,        /**< Empty command, recognized as something wrong */
@@ -68,6 +68,9 @@ typedef enum {
     CONT_MODE_REQUEST_DATA,     /**< Request data command. */
     CONT_MODE_DATA_READY,       /**< Data ready command. Used to indicate the data is received and can be handled */
     CONT_MODE_FEEDBACK,         /**< The command or signal used as an additional flags flow */
+    CONT_MODE_SCENE,            /**< Data item handed over to the delivery thread. Used to run the callbacks */
+    CONT_MODE_CREDIT,           /**< Data item processed by the delivery thread. Carries the callback's result */
+    CONT_MODE_MSG_COUNT         /**< Amount of the message types */
 } ContMessageType_e;
 
 /** Callback function result type */
@@ -77,6 +80,16 @@ typedef enum {
     CB_RET_EXIT                 /**< Callback want to exit the continuous mode completely */
 } ContModeCbRet_t;
 
+/** The policy applied when the delivery thread has no credits left (see ContModeCfg_t::credits)
+ * The policy is applied to whole scenes: in per-layer delivery (see ContModeCfg_t::perLayerDelivery) all layers of a
+ * scene are dropped together, and the layers of the scene being delivered wait for the credits, so the consumers never
+ * get a part of a scene */
+typedef enum {
+    CONT_MODE_BP_BLOCK = 0,     /**< Don't request the new data until a credit is returned. The acquisition waits */
+    CONT_MODE_BP_DROP_NEWEST,   /**< Keep acquiring, drop the scene just acquired */
+    CONT_MODE_BP_DROP_OLDEST,   /**< Keep acquiring, drop the oldest scene not delivered yet */
+} ContModeBackpressure_e;
+
 /** Continuous mode control commands and modes */
 typedef enum {
     CONT_MODE_IDLE = 0,         /**< Idle state. Configured but not ran mode */
@@ -89,20 +102,95 @@ typedef enum {
 
 /** The message structure for threads interchange */
 typedef struct {
-    long mtype;             /**< Message type */
+    long mtype;             /**< Message type, selects the channel (see ::ContMessageType_e) */
     ContModeCmd_e cmd;      /**< Message command */
+    spiDriver_ChipData_t* chipData; /**< ::CONT_MODE_DATA_READY in per-layer delivery: the layer's records, owned by
+                                         the receiver. NULL when the data is published by the sender */
+    uint16_t chipDataSize;  /**< Items count in contModeInterface_t::chipData */
+    bool sceneComplete;     /**< ::CONT_MODE_DATA_READY: the data completes the scene */
 } contModeInterface_t;
 
-/** The size of the interchange message's payload, used for message sending in OS */
-#define contModeInterface_size (sizeof(contModeInterface_t) - sizeof(long))
-
 /** Callback function type definition.
  * The callback function receives the data structure of one scene received. This data is buffered and will be updated when
- * the callback will finish its execution
- * @param[in]   chipData        The pointer to a scene's data
+ * the callback will finish its execution. The callback is called from the delivery thread, so the acquisition
+ * continues meanwhile (see ContModeCfg_t::credits).
+ * @param[in]   chipData        The pointer to the data item delivered (a scene, or a layer in per-layer delivery)
+ * @retval  CB_RET_OK       continue the data acquisition
+ * @retval  CB_RET_STOP     stop the data acquisition, as ::spiDriver_StopContinuousMode does
+ * @retval  CB_RET_EXIT     stop the data acquisition and exit the continuous mode threads
  */
 typedef ContModeCbRet_t (* cbFunc_t)(spiDriver_ChipData_t* chipData);
 
+/** Receives the records of a single layer as soon as they are read (per-layer delivery).
+ * @param[in]   chipData        the layer's records. The receiver owns the array
+ * @param[in]   chipDataSize    items count in `chipData` array
+ * @param[in]   sceneComplete   the layer is the last one in the scene
+ */
+typedef void (* cbLayerReady_t)(spiDriver_ChipData_t* chipData, const uint16_t chipDataSize, const bool sceneComplete);
+
+/** Consumer's callback function type definition.
+ * The callback receives the data item (a scene, or a layer in per-layer delivery) shared with other consumers. The data
+ * must not be changed, it stays valid until the callback returns.
+ * @param[in]   chipData        the item's records
+ * @param[in]   chipDataSize    items count in `chipData` array
+ * @param[in]   context         consumer's context, see ContModeConsumerCfg_t::context
+ * @return  request to the continuous mode, see ::cbFunc_t
+ */
+typedef ContModeCbRet_t (* cbConsumer_t)(spiDriver_ChipData_t* chipData, const uint16_t chipDataSize, void* context);
+
+/** Continuous mode data consumer's configuration */
+typedef struct {
+    cbConsumer_t callback;      /**< The function called for each data item, in the consumer's own thread */
+    void* context;              /**< The pointer passed to the callback as is */
+    uint16_t queueDepth;        /**< Items waiting for the consumer. When the queue is full, the consumer's oldest
+                                     item is dropped, so a slow consumer doesn't block others. 0 is treated as 1 */
+    int16_t cpu;                /**< CPU the consumer's thread is bound to. Negative value - no binding */
+    bool blocking;              /**< When the queue is full, the consumer's items are not dropped. The items over
+                                     the queue's depth hold their credits back until the consumer's callback returns,
+                                     and the acquisition follows ContModeCfg_t::backpressure. The delivery never
+                                     waits for the consumer, the other consumers get the items first */
+} ContModeConsumerCfg_t;
+
+/** Continuous mode data consumer's statistics */
+typedef struct {
+    uint32_t delivered;         /**< Items processed by the consumer's callback */
+    uint32_t dropped;           /**< Items dropped since the consumer's queue was full */
+    uint32_t waits;             /**< Items over the blocking consumer's queue depth, which held their credits back */
+} ContModeConsumerStats_t;
+
+/** Real-time profile of a continuous mode thread */
+typedef struct {
+    int16_t priority;           /**< SCHED_FIFO priority of the thread. 0 - the thread keeps the default scheduling */
+    int16_t cpu;                /**< CPU the thread is bound to. Negative value - no binding */
+} ContModeThreadCfg_t;
+
+/** Continuous mode real-time profile, see @ref spi_cont_rt */
+typedef struct {
+    bool enabled;               /**< Applies the profile. Otherwise the threads and the memory are left by default */
+    ContModeThreadCfg_t trigThread; /**< Trigger (acquisition) thread's profile. The per-bus threads get its priority */
+    ContModeThreadCfg_t ctrlThread; /**< Control thread's profile */
+    uint32_t prefaultSize;      /**< Heap size in bytes touched and kept by the process for the data buffers.
+                                     0 - no prefault, the memory is only locked. Otherwise the process' malloc is
+                                     set up to never trim the heap and never map the big buffers separately
+                                     (M_TRIM_THRESHOLD, M_MMAP_MAX). This affects the whole process and stays after
+                                     the continuous mode is stopped */
+    bool hugePages;             /**< Requests the transparent huge pages for the prefaulted heap */
+} ContModeRtCfg_t;
+
+/** Waits for the external tick which starts the next scene, see ContModePaceCfg_t::tick */
+typedef void (* cbPaceTick_t)(void);
+
+/** Continuous mode pacing, see @ref spi_cont_rt */
+typedef struct {
+    uint32_t periodUs;          /**< The scenes' period in microseconds. 0 - the scenes are started as fast as the
+                                     data is requested (free running) */
+    cbPaceTick_t tick;          /**< External tick function. When set, each scene is started when it returns, the
+                                     ContModePaceCfg_t::periodUs is only used as the deadline of the scene */
+    bool fastPath;              /**< Skips the pacing when running flat out: a late scene starts at once and the
+                                     period is counted from it. Otherwise the missed periods are skipped to keep the
+                                     phase of the period */
+} ContModePaceCfg_t;
+
 /** The Continuous mode configuration structure */
 typedef struct {
     cbFunc_t callback;          /**< The callback function that should be called for data processing after all scene will be collected or layer collected if ContModeCfg_t::useAsyncSequence is set */
@@ -112,13 +200,65 @@ typedef struct {
     bool useAsyncSequence;    /**< When enabled - the multi-IC mode uses the separated flows for the ICs and calls the ContModeCfg_t::callback function per each layer */
     uint16_t* layerOrder;       /**< Array of layer orders, to be used in a scene */
     uint16_t layerCount;        /**< Layers number in "layerOrder" array */
+    bool perLayerDelivery;      /**< When enabled - the synchronous multi-IC mode publishes each layer and calls the
+                                     ContModeCfg_t::callback as soon as the layer is read, instead of once per scene.
+                                     The records of the scene's last layer have spiDriver_ChipData_t::sceneComplete set.
+                                     A scene with no layers read is completed by an empty item */
+    uint16_t credits;           /**< Maximum data items (scenes, or layers in per-layer delivery) handed over to the
+                                     callback but not processed yet. 0 is treated as 1 */
+    ContModeBackpressure_e backpressure; /**< The policy applied when all credits are used */
+    const uint16_t* icBus;      /**< Bus identifier per IC in the multi-IC configuration's order, used with
+                                     ContModeCfg_t::useAsyncSequence. The ICs of each bus are read by their own thread.
+                                     NULL means all ICs are read by the trigger thread */
+    ContModeRtCfg_t rt;         /**< Real-time profile of the threads and memory */
+    ContModePaceCfg_t pace;     /**< The scenes' pacing. A scene is a step when ContModeCfg_t::useAsyncSequence is set */
 } ContModeCfg_t;
 
-extern volatile int msqid;
+
+/** Continuous mode data delivery statistics */
+typedef struct {
+    uint32_t delivered;         /**< Items handed over to the delivery thread */
+    uint32_t droppedNewest;     /**< Items dropped just after the acquisition, see ::CONT_MODE_BP_DROP_NEWEST */
+    uint32_t droppedOldest;     /**< Items dropped from the delivery queue, see ::CONT_MODE_BP_DROP_OLDEST */
+    uint32_t creditWaits;       /**< The times the acquisition waited for a credit, see ::CONT_MODE_BP_BLOCK */
+} ContModeDeliveryStats_t;
+
+/** Continuous mode acquisition timing statistics, see @ref spi_cont_rt */
+typedef struct {
+    uint32_t steps;             /**< Acquisition steps measured */
+    uint32_t stepMinUs;         /**< The shortest step, in microseconds */
+    uint32_t stepMaxUs;         /**< The longest step, in microseconds */
+    uint32_t stepAvgUs;         /**< The average step, in microseconds */
+    uint32_t jitterUs;          /**< The steps' jitter: the latest start of a step after its scheduled start, in
+                                     microseconds. The steps are scheduled by ContModeCfg_t::pace, a free running
+                                     step is scheduled when it's requested */
+    uint32_t minorFaults;       /**< The acquiring threads' (trigger's and bus workers') page faults served without
+                                     I/O, while acquiring */
+    uint32_t majorFaults;       /**< The acquiring threads' (trigger's and bus workers') page faults which required
+                                     I/O, while acquiring */
+} ContModeJitterStats_t;
+
+/** The number of bins in the scenes' start jitter histogram, see ContModePaceStats_t::startJitter */
+#define CONT_MODE_PACE_JITTER_BINS 16u
+
+/** Continuous mode pacing statistics */
+typedef struct {
+    uint32_t scenes;            /**< Paced scenes */
+    uint32_t missed;            /**< Scenes not finished within their period (deadline misses) */
+    uint32_t skipped;           /**< Periods skipped since a scene started too late, see ContModePaceCfg_t::fastPath */
+    uint32_t startJitterMaxUs;  /**< The latest start of a scene after its planned time, in microseconds */
+    uint32_t startJitter[CONT_MODE_PACE_JITTER_BINS]; /**< Histogram of the scenes' start after their planned time.
+                                     Bin 0 counts the starts within 1 us, bin n - within [2^(n-1), 2^n) us.
+                                     The last bin counts all later starts */
+} ContModePaceStats_t;
 
 /** Initiates the continuous mode by the information provided
  * The function sets up the continuous mode threads and sets up the IC registers to
  * run the continuous mode.
+ * @note    The continuous mode is process-wide: its threads, channels, consumers, bus workers, real-time profile,
+ *          scene's shared memory and broker serve a single driver's instance, the one which initialized it (see
+ *          ::spiDriver_SelectHandle). A call from another instance is ignored until the continuous mode is exited,
+ *          use ::spiDriver_HandleInitContinuousMode to get the result.
  * @param[in]       cfg layers and layers' order configuration
  */
 void spiDriver_InitContinuousMode(const ContModeCfg_t* const cfg);
@@ -133,7 +273,7 @@ bool spiDriver_RunContinuousMode(void);
 
 /** Stop the continuous mode
  * Pauses the continuous mode execution, stopping the IC's data acquisition and gathering all pending information from it.
- * @note    the callback function can be called after this function, despite the mode change.
+ * @note    the data items acquired before the stop are delivered to the callback before this function returns.
  * @retval false returned when continuous mode cannot be stopped.
  * @retval true returned when continuous mode was completely stopped.
  */
@@ -147,6 +287,92 @@ bool spiDriver_StopContinuousMode(void);
  */
 bool spiDriver_ExitContinuousMode(void);
 
+/** Subscribes the data consumer
+ * Each consumer gets its own thread and queue of data items. All consumers share the same items, with no copies made.
+ * The UDP export (see ::spiDriver_UdpSend) is subscribed by ::spiDriver_InitContinuousMode.
+ * @param[in]   cfg     consumer's configuration
+ * @return  consumer's identifier. Negative value is returned if the consumer can't be subscribed
+ */
+int16_t spiDriver_SubscribeContMode(const ContModeConsumerCfg_t* const cfg);
+
+/** Gets the UDP export's consumer identifier, e.g. for ::spiDriver_GetContModeConsumerStats
+ * The UDP export is not blocking (see ContModeConsumerCfg_t::blocking), so a slow socket drops its oldest items
+ * instead of slowing down the acquisition. The drops are counted by ContModeConsumerStats_t::dropped
+ * @return  consumer's identifier. Negative value is returned if the UDP export is not subscribed
+ */
+int16_t spiDriver_GetContModeUdpConsumer(void);
+
+/** Unsubscribes the data consumer
+ * Waits for the consumer's callback to finish, the items not processed yet are dropped
+ * @param[in]   consumerId  consumer's identifier returned by ::spiDriver_SubscribeContMode
+ * @retval  true    the consumer is unsubscribed
+ * @retval  false   the consumer is not found
+ */
+bool spiDriver_UnsubscribeContMode(const int16_t consumerId);
+
+/** Gets the data consumer's statistics
+ * @param[in]   consumerId  consumer's identifier returned by ::spiDriver_SubscribeContMode
+ * @param[out]  stats       statistics' output
+ * @retval  true    the statistics are filled
+ * @retval  false   the consumer is not found
+ */
+bool spiDriver_GetContModeConsumerStats(const int16_t consumerId, ContModeConsumerStats_t* const stats);
+
+/** Opens the pull mode of the data delivery
+ * The data items (scenes, or layers in per-layer delivery) are queued for the application, which takes them by
+ * ::spiDriver_TryAcquireScene from its own thread. The items are shared with the other consumers, no copies are made.
+ * When the queue is full, the oldest item is dropped.
+ * @param[in]   queueDepth  items kept in the queue, also the items held by the application at most. 0 is treated as 1
+ * @return  eventfd (non-blocking), readable when new items are queued. The application reads it and takes the items
+ *      until ::spiDriver_TryAcquireScene returns false. Negative value is returned if the pull mode is already opened
+ *      or can't be opened
+ */
+int spiDriver_OpenContModePull(const uint16_t queueDepth);
+
+/** Closes the pull mode of the data delivery
+ * The items queued and the items still held by the application are released, the eventfd is closed
+ */
+void spiDriver_CloseContModePull(void);
+
+/** Takes the oldest data item queued for the pull mode, without waiting
+ * The item must not be changed, it stays valid until it's released by ::spiDriver_ReleaseScene
+ * @param[out]  chipData        the item's records
+ * @param[out]  chipDataSize    items count in `chipData` array
+ * @retval  true    the item is taken
+ * @retval  false   no items queued, or the application holds ::spiDriver_OpenContModePull's queueDepth items already
+ */
+bool spiDriver_TryAcquireScene(spiDriver_ChipData_t** chipData, uint16_t* chipDataSize);
+
+/** Releases the data item taken by ::spiDriver_TryAcquireScene
+ * @param[in]   chipData    the item's records
+ */
+void spiDriver_ReleaseScene(const spiDriver_ChipData_t* const chipData);
+
+/** Gets the pull mode's statistics
+ * ContModeConsumerStats_t::delivered counts the items taken by the application
+ * @param[out]  stats   statistics' output
+ * @retval  true    the statistics are filled
+ * @retval  false   the pull mode is not opened
+ */
+bool spiDriver_GetContModePullStats(ContModeConsumerStats_t* const stats);
+
+/** Gets the continuous mode data delivery statistics
+ * @param[out]  stats   statistics' output
+ */
+void spiDriver_GetContModeDeliveryStats(ContModeDeliveryStats_t* const stats);
+
+/** Gets the continuous mode acquisition timing statistics
+ * The statistics are reset by ::spiDriver_InitContinuousMode
+ * @param[out]  stats   statistics' output
+ */
+void spiDriver_GetContModeJitterStats(ContModeJitterStats_t* const stats);
+
+/** Gets the continuous mode pacing statistics
+ * The statistics are reset by ::spiDriver_InitContinuousMode
+ * @param[out]  stats   statistics' output
+ */
+void spiDriver_GetContModePaceStats(ContModePaceStats_t* const stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,312 @@
+/**
+ * @file
+ * @brief Continuous mode real-time profile
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_cont_rt
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include "cont_mode_lib.h"
+#include "cont_mode_rt.h"
+
+/** The huge page's size used for the prefaulted heap's alignment */
+#define CONT_MODE_HUGE_PAGE_SIZE (2ul * 1024ul * 1024ul)
+
+static ContModeJitterStats_t contModeJitterStats;
+static uint64_t contModeStepSumUs = 0u;
+static struct timespec contModeStepStart;
+static struct rusage contModeStepUsage;
+static uint64_t contModeStepPlannedNs = 0u; /**< The next step's scheduled start */
+static __thread struct rusage contModeWorkerUsage; /**< The bus worker's usage at its part's beginning */
+static uint32_t contModeWorkerMinorFaults = 0u; /**< The bus workers' faults, not counted to the step yet */
+static uint32_t contModeWorkerMajorFaults = 0u;
+/** Sequence count of the statistics: odd while the trigger thread updates them */
+static uint32_t contModeRtStatsSeq = 0u;
+static bool contModeMemLocked = false;
+static ContModePaceStats_t contModePaceStats;
+static bool contModePaceStarted = false;    /**< The next scene's start time is planned */
+static uint64_t contModePaceNextNs = 0u;    /**< The next scene's planned start time */
+static uint64_t contModePaceDeadlineNs = 0u; /**< The current scene should be finished by this time. 0 - no deadline */
+
+
+/** Returns the monotonic time in nanoseconds */
+static uint64_t ContModeRtNowNs(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+
+/** Starts the statistics' update. The trigger thread is the only writer, so the readers never block it */
+static void ContModeRtStatsWriteBegin(void)
+{
+    __atomic_store_n(&contModeRtStatsSeq, contModeRtStatsSeq + 1u, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+
+/** Finishes the statistics' update */
+static void ContModeRtStatsWriteEnd(void)
+{
+    __atomic_store_n(&contModeRtStatsSeq, contModeRtStatsSeq + 1u, __ATOMIC_RELEASE);
+}
+
+
+/** Copies the statistics consistently, retrying while they are updated */
+static void ContModeRtStatsRead(void* const out, const void* const stats, const size_t size)
+{
+    uint32_t seq;
+    do {
+        while (((seq = __atomic_load_n(&contModeRtStatsSeq, __ATOMIC_ACQUIRE)) & 1u) != 0u) {
+            (void)sched_yield();
+        }
+        memcpy(out, stats, size);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&contModeRtStatsSeq, __ATOMIC_RELAXED) != seq);
+}
+
+
+/** Counts the scene's start in the jitter histogram */
+static void ContModePaceStart(const uint64_t plannedNs)
+{
+    const uint64_t lateNs = ContModeRtNowNs() - plannedNs;
+    const uint32_t lateUs = (lateNs > (uint64_t)UINT32_MAX * 1000ull) ? UINT32_MAX : (uint32_t)(lateNs / 1000ull);
+    uint16_t bin = 0u;
+    while ((bin < (CONT_MODE_PACE_JITTER_BINS - 1u)) && ((lateUs >> bin) != 0u)) {
+        bin++;
+    }
+    ContModeRtStatsWriteBegin();
+    contModePaceStats.startJitter[bin]++;
+    if (lateUs > contModePaceStats.startJitterMaxUs) {
+        contModePaceStats.startJitterMaxUs = lateUs;
+    }
+    contModePaceStats.scenes++;
+    ContModeRtStatsWriteEnd();
+    contModeStepPlannedNs = plannedNs;
+}
+
+
+/** Touches the heap, so its pages are mapped and stay in the process after they are freed */
+static void ContModeRtPrefault(const ContModeRtCfg_t* const cfg)
+{
+    if (cfg->prefaultSize > 0u) {
+        uint8_t* heap;
+        /* Freed memory isn't returned to the system and the big buffers are taken from the heap, not mapped one by one.
+         * These are the process' malloc settings, they stay after the continuous mode is stopped */
+        (void)mallopt(M_TRIM_THRESHOLD, -1);
+        (void)mallopt(M_MMAP_MAX, 0);
+        heap = malloc(cfg->prefaultSize);
+        if (heap != NULL) {
+            if (cfg->hugePages && (cfg->prefaultSize >= CONT_MODE_HUGE_PAGE_SIZE)) {
+                const uintptr_t begin = ((uintptr_t)heap + CONT_MODE_HUGE_PAGE_SIZE - 1u) & ~(CONT_MODE_HUGE_PAGE_SIZE - 1u);
+                const uintptr_t end = ((uintptr_t)heap + cfg->prefaultSize) & ~(CONT_MODE_HUGE_PAGE_SIZE - 1u);
+                if ((end > begin) && (madvise((void*)begin, end - begin, MADV_HUGEPAGE) != 0)) {
+                    CONT_PRINT("RT: huge pages are not available\n");
+                }
+            }
+            memset(heap, 0, cfg->prefaultSize);
+            free(heap);
+        } else {
+            CONT_PRINT("RT: can't prefault %u bytes\n", cfg->prefaultSize);
+        }
+    }
+}
+
+
+void spiDriver_ContModeRtSetup(const ContModeRtCfg_t* const cfg)
+{
+    ContModeRtStatsWriteBegin();
+    memset(&contModeJitterStats, 0, sizeof(contModeJitterStats));
+    memset(&contModePaceStats, 0, sizeof(contModePaceStats));
+    ContModeRtStatsWriteEnd();
+    contModeStepSumUs = 0u;
+    contModeStepPlannedNs = 0u;
+    __atomic_store_n(&contModeWorkerMinorFaults, 0u, __ATOMIC_RELAXED);
+    __atomic_store_n(&contModeWorkerMajorFaults, 0u, __ATOMIC_RELAXED);
+    spiDriver_ContModePaceReset();
+    if (cfg->enabled) {
+        if (!contModeMemLocked) {
+            if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+                contModeMemLocked = true;
+            } else {
+                CONT_PRINT("RT: memory can't be locked\n");
+            }
+        }
+        ContModeRtPrefault(cfg);
+    }
+}
+
+
+void spiDriver_ContModeRtThread(const ContModeRtCfg_t* const cfg, const ContModeThreadCfg_t* const thread)
+{
+    if (cfg->enabled) {
+        if (thread->priority > 0) {
+            struct sched_param param;
+            memset(&param, 0, sizeof(param));
+            param.sched_priority = thread->priority;
+            if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) {
+                CONT_PRINT("RT: priority %d can't be set\n", thread->priority);
+            }
+        }
+        if (thread->cpu >= 0) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(thread->cpu, &cpus);
+            if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+                CONT_PRINT("RT: thread can't be bound to CPU %d\n", thread->cpu);
+            }
+        }
+    }
+}
+
+
+void spiDriver_ContModePace(const ContModePaceCfg_t* const cfg)
+{
+    const uint64_t periodNs = (uint64_t)cfg->periodUs * 1000ull;
+    contModePaceDeadlineNs = 0u;
+    if (cfg->tick != NULL) {
+        cfg->tick();
+        const uint64_t tickNs = ContModeRtNowNs();
+        if (periodNs > 0u) {
+            contModePaceDeadlineNs = tickNs + periodNs;
+        }
+        ContModePaceStart(tickNs);
+    } else if (periodNs > 0u) {
+        const uint64_t nowNs = ContModeRtNowNs();
+        if (!__atomic_load_n(&contModePaceStarted, __ATOMIC_ACQUIRE)) {
+            contModePaceNextNs = nowNs;
+            __atomic_store_n(&contModePaceStarted, true, __ATOMIC_RELEASE);
+        } else if (nowNs > contModePaceNextNs) {
+            /* Late start */
+            if (cfg->fastPath) {
+                contModePaceNextNs = nowNs;
+            } else {
+                const uint64_t skipped = (nowNs - contModePaceNextNs) / periodNs;
+                ContModeRtStatsWriteBegin();
+                contModePaceStats.skipped += (uint32_t)skipped;
+                ContModeRtStatsWriteEnd();
+                contModePaceNextNs += skipped * periodNs;
+            }
+        } else {
+            struct timespec next;
+            next.tv_sec = (time_t)(contModePaceNextNs / 1000000000ull);
+            next.tv_nsec = (long)(contModePaceNextNs % 1000000000ull);
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) {
+            }
+        }
+        ContModePaceStart(contModePaceNextNs);
+        contModePaceNextNs += periodNs;
+        contModePaceDeadlineNs = contModePaceNextNs;
+    } else {
+        /* Free running: the step is scheduled when it's requested */
+        contModeStepPlannedNs = ContModeRtNowNs();
+    }
+}
+
+
+void spiDriver_ContModePaceReset(void)
+{
+    __atomic_store_n(&contModePaceStarted, false, __ATOMIC_RELEASE);
+}
+
+
+void spiDriver_ContModeRtStepBegin(void)
+{
+    (void)getrusage(RUSAGE_THREAD, &contModeStepUsage);
+    (void)clock_gettime(CLOCK_MONOTONIC, &contModeStepStart);
+}
+
+
+void spiDriver_ContModeRtWorkerBegin(void)
+{
+    (void)getrusage(RUSAGE_THREAD, &contModeWorkerUsage);
+}
+
+
+void spiDriver_ContModeRtWorkerEnd(void)
+{
+    struct rusage usage;
+    (void)getrusage(RUSAGE_THREAD, &usage);
+    (void)__atomic_add_fetch(&contModeWorkerMinorFaults,
+                             (uint32_t)(usage.ru_minflt - contModeWorkerUsage.ru_minflt), __ATOMIC_RELAXED);
+    (void)__atomic_add_fetch(&contModeWorkerMajorFaults,
+                             (uint32_t)(usage.ru_majflt - contModeWorkerUsage.ru_majflt), __ATOMIC_RELAXED);
+}
+
+
+void spiDriver_ContModeRtStepEnd(void)
+{
+    struct timespec now;
+    struct rusage usage;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    (void)getrusage(RUSAGE_THREAD, &usage);
+    const uint32_t stepUs = (uint32_t)((now.tv_sec - contModeStepStart.tv_sec) * 1000000l +
+                                       (now.tv_nsec - contModeStepStart.tv_nsec) / 1000l);
+    const uint64_t startNs = (uint64_t)contModeStepStart.tv_sec * 1000000000ull + (uint64_t)contModeStepStart.tv_nsec;
+    const uint64_t lateNs = ((contModeStepPlannedNs != 0u) && (startNs > contModeStepPlannedNs)) ?
+                            (startNs - contModeStepPlannedNs) : 0u;
+    const uint32_t lateUs = (lateNs > (uint64_t)UINT32_MAX * 1000ull) ? UINT32_MAX : (uint32_t)(lateNs / 1000ull);
+    ContModeJitterStats_t* const stats = &contModeJitterStats;
+    ContModeRtStatsWriteBegin();
+    if ((stats->steps == 0u) || (stepUs < stats->stepMinUs)) {
+        stats->stepMinUs = stepUs;
+    }
+    if (stepUs > stats->stepMaxUs) {
+        stats->stepMaxUs = stepUs;
+    }
+    contModeStepSumUs += stepUs;
+    stats->steps++;
+    stats->stepAvgUs = (uint32_t)(contModeStepSumUs / stats->steps);
+    if (lateUs > stats->jitterUs) {
+        stats->jitterUs = lateUs;
+    }
+    /* The bus workers have finished their parts of the step */
+    stats->minorFaults += (uint32_t)(usage.ru_minflt - contModeStepUsage.ru_minflt) +
+                          __atomic_exchange_n(&contModeWorkerMinorFaults, 0u, __ATOMIC_RELAXED);
+    stats->majorFaults += (uint32_t)(usage.ru_majflt - contModeStepUsage.ru_majflt) +
+                          __atomic_exchange_n(&contModeWorkerMajorFaults, 0u, __ATOMIC_RELAXED);
+    if ((contModePaceDeadlineNs != 0u) &&
+        ((uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec > contModePaceDeadlineNs)) {
+        contModePaceStats.missed++;
+    }
+    ContModeRtStatsWriteEnd();
+    contModeStepPlannedNs = 0u;
+}
+
+
+void spiDriver_GetContModeJitterStats(ContModeJitterStats_t* const stats)
+{
+    ContModeRtStatsRead(stats, &contModeJitterStats, sizeof(*stats));
+}
+
+
+void spiDriver_GetContModePaceStats(ContModePaceStats_t* const stats)
+{
+    ContModeRtStatsRead(stats, &contModePaceStats, sizeof(*stats));
+}
@@ -0,0 +1,86 @@
+/**
+ * @file
+ * @brief SPI driver for MLX75322 Continuous mode support
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_cont_rt SPI driver continuous mode real-time profile
+ * @ingroup spi_cont_mode
+ *
+ * @details applies the real-time profile (see ContModeCfg_t::rt) to the continuous mode. The process' memory is locked
+ *      and the heap used for the data buffers is prefaulted and kept, so the acquisition doesn't take the page faults.
+ *      The acquisition and control threads get SCHED_FIFO priorities and CPU bindings. The acquisition steps' timing
+ *      and page faults are measured, see ::spiDriver_GetContModeJitterStats. The statistics are written by the
+ *      trigger thread only and read under a sequence count, so the readers never block the acquisition.
+ *
+ *      The scenes can be paced (see ContModeCfg_t::pace) by a fixed period, waiting with clock_nanosleep() for the
+ *      absolute start time, or by an external tick. The deadline misses and the start jitter are published by
+ *      ::spiDriver_GetContModePaceStats.
+ */
+
+#ifndef CONT_MODE_RT_H
+#define CONT_MODE_RT_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "cont_mode_lib.h"
+
+/** Sets up the process' memory by the real-time profile and resets the timing statistics
+ * @param[in]   cfg     real-time profile
+ * @note    This function is normally driven from the continuous mode library, before the threads are created
+ */
+void spiDriver_ContModeRtSetup(const ContModeRtCfg_t* const cfg);
+
+/** Applies the thread's real-time profile to the calling thread
+ * Nothing is changed when the profile is not enabled
+ * @param[in]   cfg     real-time profile
+ * @param[in]   thread  thread's profile
+ */
+void spiDriver_ContModeRtThread(const ContModeRtCfg_t* const cfg, const ContModeThreadCfg_t* const thread);
+
+/** Marks the beginning of an acquisition step, called by the trigger thread */
+void spiDriver_ContModeRtStepBegin(void);
+
+/** Waits for the next scene's start, called by the trigger thread before an acquisition step
+ * @param[in]   cfg     pacing configuration
+ */
+void spiDriver_ContModePace(const ContModePaceCfg_t* const cfg);
+
+/** Restarts the pacing, the next scene is started at once */
+void spiDriver_ContModePaceReset(void);
+
+/** Marks the end of an acquisition step and updates the timing statistics, called by the trigger thread
+ * The page faults of the bus workers' parts of the step are added too
+ */
+void spiDriver_ContModeRtStepEnd(void);
+
+/** Marks the beginning of a bus worker's part of the acquisition step, called by the bus worker */
+void spiDriver_ContModeRtWorkerBegin(void);
+
+/** Marks the end of a bus worker's part of the acquisition step, called by the bus worker before the step is
+ * finished by the trigger thread. The worker's page faults are counted to the step
+ */
+void spiDriver_ContModeRtWorkerEnd(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* CONT_MODE_RT_H */
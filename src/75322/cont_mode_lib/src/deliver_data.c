@@ -0,0 +1,621 @@
+/**
+ * @file
+ * @brief Continuous mode data delivery task
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_cont_deliver
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "cont_mode_lib.h"
+#include "cont_mode_chan.h"
+#include "deliver_data.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_instance_priv.h"
+
+/** Data item shared by the consumers and the publication. Released when the last reference is dropped */
+typedef struct {
+    spiDriver_ChipData_t* chipData; /**< Item's records */
+    uint16_t chipDataSize;          /**< Items count in DeliverScene_t::chipData */
+    uint32_t refs;                  /**< References count */
+    uint32_t creditHolds;           /**< Users holding the item's credit back. The last one returns the credit */
+    ContModeCbRet_t cbRes;          /**< The callback's result, returned with the credit */
+    bool sceneComplete;             /**< The item completes the scene, returned with the credit */
+} DeliverScene_t;
+
+/** Item queued for a consumer */
+typedef struct {
+    DeliverScene_t* scene;          /**< The item */
+    bool creditHeld;                /**< The item holds its credit back until the consumer's callback returns */
+} DeliverEntry_t;
+
+/** Data consumer's subscription */
+typedef struct {
+    bool active;                    /**< The subscription is used */
+    bool exiting;                   /**< The consumer's thread is requested to exit */
+    ContModeConsumerCfg_t cfg;      /**< Consumer's configuration */
+    pthread_t thread;               /**< Consumer's thread */
+    pthread_mutex_t lock;           /**< Guards the queue */
+    pthread_cond_t cond;            /**< Signals the new item in the queue */
+    DeliverEntry_t* queue;          /**< Items' ring, DeliverConsumer_t::capacity long */
+    uint16_t capacity;              /**< The ring's size. A blocking consumer's ring grows over its queue's depth */
+    uint16_t head;                  /**< The oldest item's index in the ring */
+    uint16_t count;                 /**< Items count in the ring */
+    ContModeConsumerStats_t stats;  /**< Statistics */
+} DeliverConsumer_t;
+
+/** Pull-mode queue, read by the application's thread */
+typedef struct {
+    int fd;                         /**< eventfd signalling the new items. Negative value - the pull mode is closed */
+    uint16_t depth;                 /**< Items kept in the queue and held by the application at most */
+    DeliverScene_t** queue;         /**< Items' ring, DeliverPull_t::depth long */
+    uint16_t head;                  /**< The oldest item's index in the ring */
+    uint16_t count;                 /**< Items count in the ring */
+    DeliverScene_t** held;          /**< Items acquired by the application, DeliverPull_t::depth long */
+    ContModeConsumerStats_t stats;  /**< Statistics */
+} DeliverPull_t;
+
+static pthread_t deliverDataThreadID;
+static ContModeCmd_e deliverDataMode = CONT_MODE_NOT_INITED;
+
+static DeliverConsumer_t deliverConsumers[CONT_MODE_MAX_CONSUMERS];
+/** Guards the subscriptions' changes against the items dispatch */
+static pthread_mutex_t deliverConsumersLock = PTHREAD_MUTEX_INITIALIZER;
+/** Guards the publication of the items into ::spiDriver_chipData */
+static pthread_mutex_t deliverPublishLock = PTHREAD_MUTEX_INITIALIZER;
+/** The item published into ::spiDriver_chipData */
+static DeliverScene_t* deliverPublished = NULL;
+/** Guards the pull-mode queue */
+static pthread_mutex_t deliverPullLock = PTHREAD_MUTEX_INITIALIZER;
+static DeliverPull_t deliverPull = {.fd = -1};
+/** The strongest consumers' request (see ::ContModeCbRet_t) not reported yet */
+static uint32_t deliverConsumersRequest = CB_RET_OK;
+
+extern void spiDriver_ContModeAdoptInstance(void);
+extern void spiDriver_UpdateCurrentData(const spiDriver_ChipData_t* const spiDriver_chipDataTmp,
+                                        const uint16_t spiDriver_chipDataSizeTmp);
+
+
+static DeliverScene_t* DeliverSceneCreate(spiDriver_ChipData_t* chipData, const uint16_t chipDataSize,
+                                          const bool sceneComplete)
+{
+    DeliverScene_t* scene = malloc(sizeof(DeliverScene_t));
+    if (scene != NULL) {
+        scene->chipData = chipData;
+        scene->chipDataSize = chipDataSize;
+        scene->refs = 1u;
+        scene->creditHolds = 1u;
+        scene->cbRes = CB_RET_OK;
+        scene->sceneComplete = sceneComplete;
+    }
+    return scene;
+}
+
+
+static void DeliverSceneRelease(DeliverScene_t* scene)
+{
+    if ((scene != NULL) && (__atomic_sub_fetch(&scene->refs, 1u, __ATOMIC_ACQ_REL) == 0u)) {
+        spiDriver_CleanChipData(scene->chipData, &scene->chipDataSize);
+        free(scene->chipData);
+        free(scene);
+    }
+}
+
+
+/** Keeps the strongest request of the consumers: EXIT over STOP over OK */
+static void DeliverConsumersRequest(const ContModeCbRet_t request)
+{
+    uint32_t current = __atomic_load_n(&deliverConsumersRequest, __ATOMIC_RELAXED);
+    while ((current < (uint32_t)request) &&
+           !__atomic_compare_exchange_n(&deliverConsumersRequest, &current, (uint32_t)request, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        ;
+    }
+}
+
+
+/** Returns the item's credit to the major thread, with the strongest request of the callbacks attached */
+static void DeliverCreditSend(const ContModeCbRet_t result, const bool sceneComplete)
+{
+    contModeInterface_t credit = {.cmd = CONT_MODE_WORK, .mtype = CONT_MODE_CREDIT};
+    ContModeCbRet_t cbRes = result;
+    if (__atomic_load_n(&deliverConsumersRequest, __ATOMIC_RELAXED) > (uint32_t)cbRes) {
+        cbRes = (ContModeCbRet_t)__atomic_exchange_n(&deliverConsumersRequest, CB_RET_OK, __ATOMIC_RELAXED);
+    }
+    CONT_PRINT("Deliver: CB result:%u\n", cbRes);
+    if (cbRes == CB_RET_STOP) {
+        credit.cmd = CONT_MODE_STOP;
+    } else if (cbRes == CB_RET_EXIT) {
+        credit.cmd = CONT_MODE_EXIT;
+    }
+    credit.sceneComplete = sceneComplete;
+    spiDriver_ContModeSend(&credit);
+}
+
+
+/** Drops a hold of the item's credit. The last one returns the credit */
+static void DeliverCreditRelease(DeliverScene_t* const scene)
+{
+    if (__atomic_sub_fetch(&scene->creditHolds, 1u, __ATOMIC_ACQ_REL) == 0u) {
+        DeliverCreditSend(scene->cbRes, scene->sceneComplete);
+    }
+}
+
+
+/* Data consumer's thread function */
+static void* DeliverConsumerExecute(void* temp)
+{
+    DeliverConsumer_t* consumer = (DeliverConsumer_t*)temp;
+    bool looping = true;
+    spiDriver_ContModeAdoptInstance();
+    while (looping) {
+        DeliverEntry_t entry = {.scene = NULL, .creditHeld = false};
+        pthread_mutex_lock(&consumer->lock);
+        while ((consumer->count == 0u) && !consumer->exiting) {
+            pthread_cond_wait(&consumer->cond, &consumer->lock);
+        }
+        if (consumer->exiting) {
+            looping = false;
+        } else {
+            entry = consumer->queue[consumer->head];
+            consumer->head = (consumer->head + 1u) % consumer->capacity;
+            consumer->count--;
+        }
+        pthread_mutex_unlock(&consumer->lock);
+        if (entry.scene != NULL) {
+            const ContModeCbRet_t cbRes = consumer->cfg.callback(entry.scene->chipData, entry.scene->chipDataSize,
+                                                                 consumer->cfg.context);
+            __atomic_add_fetch(&consumer->stats.delivered, 1u, __ATOMIC_RELAXED);
+            if (cbRes != CB_RET_OK) {
+                CONT_PRINT("Deliver: consumer's CB result:%u\n", cbRes);
+                DeliverConsumersRequest(cbRes);
+            }
+            if (entry.creditHeld) {
+                DeliverCreditRelease(entry.scene);
+            }
+            DeliverSceneRelease(entry.scene);
+        }
+    }
+    return NULL;
+}
+
+
+/** Puts the item into the pull-mode queue, dropping the oldest item when the queue is full */
+static void DeliverPullPush(DeliverScene_t* const scene)
+{
+    DeliverScene_t* dropped = NULL;
+    pthread_mutex_lock(&deliverPullLock);
+    if (deliverPull.fd >= 0) {
+        const uint64_t one = 1u;
+        __atomic_add_fetch(&scene->refs, 1u, __ATOMIC_RELAXED);
+        if (deliverPull.count >= deliverPull.depth) {
+            dropped = deliverPull.queue[deliverPull.head];
+            deliverPull.head = (deliverPull.head + 1u) % deliverPull.depth;
+            deliverPull.count--;
+            deliverPull.stats.dropped++;
+        }
+        deliverPull.queue[(deliverPull.head + deliverPull.count) % deliverPull.depth] = scene;
+        deliverPull.count++;
+        if (write(deliverPull.fd, &one, sizeof(one)) != (ssize_t)sizeof(one)) {
+            CONT_PRINT("Deliver: pull-mode event is not signalled\n");
+        }
+    }
+    pthread_mutex_unlock(&deliverPullLock);
+    DeliverSceneRelease(dropped);
+}
+
+
+/** Doubles the blocking consumer's ring, keeping the items' order. Called with the consumer's lock held
+ * @return  true when the ring has a free place */
+static bool DeliverConsumerGrow(DeliverConsumer_t* const consumer)
+{
+    bool res = false;
+    const uint16_t capacity = (uint16_t)(consumer->capacity * 2u);
+    DeliverEntry_t* queue = (capacity > consumer->capacity) ? calloc(capacity, sizeof(DeliverEntry_t)) : NULL;
+    if (queue != NULL) {
+        for (uint16_t ind = 0u; ind < consumer->count; ind++) {
+            queue[ind] = consumer->queue[(consumer->head + ind) % consumer->capacity];
+        }
+        free(consumer->queue);
+        consumer->queue = queue;
+        consumer->capacity = capacity;
+        consumer->head = 0u;
+        res = true;
+    }
+    return res;
+}
+
+
+/** Puts the item into the consumer's queue. A full queue drops its oldest item, unless the consumer is blocking.
+ * The blocking consumer keeps all items, and those over its queue's depth hold their credits back, so the acquisition
+ * is slowed down by ContModeCfg_t::backpressure instead of the delivery waiting. Called with the consumers' lock held */
+static void DeliverConsumerPush(DeliverConsumer_t* const consumer, DeliverScene_t* const scene)
+{
+    DeliverEntry_t dropped = {.scene = NULL, .creditHeld = false};
+    bool creditHeld = false;
+    __atomic_add_fetch(&scene->refs, 1u, __ATOMIC_RELAXED);
+    pthread_mutex_lock(&consumer->lock);
+    if (consumer->cfg.blocking && (consumer->count >= consumer->cfg.queueDepth)) {
+        if ((consumer->count < consumer->capacity) || DeliverConsumerGrow(consumer)) {
+            creditHeld = true;
+            __atomic_add_fetch(&scene->creditHolds, 1u, __ATOMIC_RELAXED);
+            consumer->stats.waits++;
+        }
+    }
+    if (consumer->count >= consumer->capacity) {
+        dropped = consumer->queue[consumer->head];
+        consumer->head = (consumer->head + 1u) % consumer->capacity;
+        consumer->count--;
+        consumer->stats.dropped++;
+    }
+    consumer->queue[(consumer->head + consumer->count) % consumer->capacity].scene = scene;
+    consumer->queue[(consumer->head + consumer->count) % consumer->capacity].creditHeld = creditHeld;
+    consumer->count++;
+    pthread_cond_signal(&consumer->cond);
+    pthread_mutex_unlock(&consumer->lock);
+    if (dropped.scene != NULL) {
+        if (dropped.creditHeld) {
+            DeliverCreditRelease(dropped.scene);
+        }
+        DeliverSceneRelease(dropped.scene);
+    }
+}
+
+
+/** Puts the item into the queues of all consumers and the pull-mode queue. The non-blocking consumers get the item
+ * first, none of the consumers is waited for */
+static void DeliverDispatch(DeliverScene_t* const scene)
+{
+    pthread_mutex_lock(&deliverConsumersLock);
+    for (uint16_t ind = 0u; ind < CONT_MODE_MAX_CONSUMERS; ind++) {
+        if (deliverConsumers[ind].active && !deliverConsumers[ind].cfg.blocking) {
+            DeliverConsumerPush(&deliverConsumers[ind], scene);
+        }
+    }
+    pthread_mutex_unlock(&deliverConsumersLock);
+    DeliverPullPush(scene);
+    pthread_mutex_lock(&deliverConsumersLock);
+    for (uint16_t ind = 0u; ind < CONT_MODE_MAX_CONSUMERS; ind++) {
+        if (deliverConsumers[ind].active && deliverConsumers[ind].cfg.blocking) {
+            DeliverConsumerPush(&deliverConsumers[ind], scene);
+        }
+    }
+    pthread_mutex_unlock(&deliverConsumersLock);
+}
+
+
+/** Publishes the item into ::spiDriver_chipData, releasing the item published before */
+static void DeliverPublish(DeliverScene_t* const scene)
+{
+    DeliverScene_t* old;
+    pthread_mutex_lock(&deliverPublishLock);
+    old = deliverPublished;
+    spiDriver_chipData = scene->chipData;
+    spiDriver_chipDataSize = scene->chipDataSize;
+    deliverPublished = scene;
+    pthread_mutex_unlock(&deliverPublishLock);
+    DeliverSceneRelease(old);
+}
+
+
+void spiDriver_DeliverReleaseData(spiDriver_ChipData_t* chipData, uint16_t chipDataSize)
+{
+    DeliverScene_t* scene = NULL;
+    pthread_mutex_lock(&deliverPublishLock);
+    if ((deliverPublished != NULL) && (deliverPublished->chipData == chipData)) {
+        scene = deliverPublished;
+        deliverPublished = NULL;
+    }
+    pthread_mutex_unlock(&deliverPublishLock);
+    if (scene != NULL) {
+        DeliverSceneRelease(scene);
+    } else {
+        spiDriver_CleanChipData(chipData, &chipDataSize);
+    }
+}
+
+
+/* Data delivery thread function */
+void* deliverDataExecute(void* temp)
+{
+    bool looping = true;
+    contModeInterface_t rbuf;
+    (void)temp;
+    spiDriver_ContModeAdoptInstance();
+    while (looping) {
+        if (!spiDriver_ContModeReceive(CONT_MODE_SCENE, &rbuf, true)) {
+            CONT_PRINT("Deliver: item receive failed\n");
+            looping = false;
+        } else if (rbuf.cmd == CONT_MODE_EXIT) {
+            CONT_PRINT("Deliver: exit signal received\n");
+            looping = false;
+        } else {
+            ContModeCbRet_t cbRes = CB_RET_OK;
+            DeliverScene_t* scene = DeliverSceneCreate(rbuf.chipData, rbuf.chipDataSize, rbuf.sceneComplete);
+            if (scene != NULL) {
+                /* The item is used below, after the application may have released the published one */
+                __atomic_add_fetch(&scene->refs, 1u, __ATOMIC_RELAXED);
+                /* The consumers run in parallel with the callback below */
+                DeliverDispatch(scene);
+                DeliverPublish(scene);
+            } else {
+                CONT_PRINT("Deliver: no memory to share the item, publish it only\n");
+                spiDriver_UpdateCurrentData(rbuf.chipData, rbuf.chipDataSize);
+            }
+            if (contModeCfg.callback != NULL) {
+                CONT_PRINT("Deliver: Run callback\n");
+                /* The item stays published, so valid, while the callback runs */
+                cbRes = contModeCfg.callback(rbuf.chipData);
+            }
+            if (scene != NULL) {
+                /* The blocking consumers may still hold the credit back */
+                scene->cbRes = cbRes;
+                DeliverCreditRelease(scene);
+                DeliverSceneRelease(scene);
+            } else {
+                DeliverCreditSend(cbRes, rbuf.sceneComplete);
+            }
+        }
+    }
+    CONT_PRINT("\nDeliver: Delivery thread is Finished\n");
+    deliverDataMode = CONT_MODE_NOT_INITED;
+    return NULL;
+}
+
+void spiDriver_InitDeliverData(void)
+{
+    if (deliverDataMode == CONT_MODE_NOT_INITED) {
+        deliverDataMode = CONT_MODE_IDLE;
+        if (pthread_create(&deliverDataThreadID, NULL, &deliverDataExecute, NULL) == 0) {
+            CONT_PRINT("\nDelivery thread created\n");
+        } else {
+            CONT_PRINT("\nDelivery thread is not created\n");
+            deliverDataMode = CONT_MODE_NOT_INITED;
+        }
+    }
+}
+
+void spiDriver_ExitDeliverData(void)
+{
+    contModeInterface_t msg = {.cmd = CONT_MODE_EXIT, .mtype = CONT_MODE_SCENE};
+    spiDriver_ContModeSend(&msg);
+}
+
+
+int16_t spiDriver_SubscribeContMode(const ContModeConsumerCfg_t* const cfg)
+{
+    int16_t consumerId = -1;
+    if ((cfg != NULL) && (cfg->callback != NULL)) {
+        pthread_mutex_lock(&deliverConsumersLock);
+        for (uint16_t ind = 0u; (ind < CONT_MODE_MAX_CONSUMERS) && (consumerId < 0); ind++) {
+            DeliverConsumer_t* consumer = &deliverConsumers[ind];
+            if (!consumer->active && (consumer->queue == NULL)) {
+                consumer->cfg = *cfg;
+                if (consumer->cfg.queueDepth == 0u) {
+                    consumer->cfg.queueDepth = 1u;
+                }
+                consumer->queue = calloc(consumer->cfg.queueDepth, sizeof(DeliverEntry_t));
+                consumer->capacity = consumer->cfg.queueDepth;
+                consumer->head = 0u;
+                consumer->count = 0u;
+                consumer->exiting = false;
+                consumer->stats.delivered = 0u;
+                consumer->stats.dropped = 0u;
+                consumer->stats.waits = 0u;
+                if (consumer->queue != NULL) {
+                    pthread_mutex_init(&consumer->lock, NULL);
+                    pthread_cond_init(&consumer->cond, NULL);
+                    if (pthread_create(&consumer->thread, NULL, &DeliverConsumerExecute, consumer) == 0) {
+                        if (cfg->cpu >= 0) {
+                            cpu_set_t cpus;
+                            CPU_ZERO(&cpus);
+                            CPU_SET(cfg->cpu, &cpus);
+                            if (pthread_setaffinity_np(consumer->thread, sizeof(cpus), &cpus) != 0) {
+                                CONT_PRINT("Deliver: consumer %u can't be bound to CPU %d\n", ind, cfg->cpu);
+                            }
+                        }
+                        consumer->active = true;
+                        consumerId = (int16_t)ind;
+                    } else {
+                        pthread_cond_destroy(&consumer->cond);
+                        pthread_mutex_destroy(&consumer->lock);
+                        free(consumer->queue);
+                        consumer->queue = NULL;
+                    }
+                }
+                if (consumerId < 0) {
+                    /* No resources to subscribe the consumer, don't try other slots */
+                    break;
+                }
+            }
+        }
+        pthread_mutex_unlock(&deliverConsumersLock);
+    }
+    return consumerId;
+}
+
+
+bool spiDriver_UnsubscribeContMode(const int16_t consumerId)
+{
+    bool res = false;
+    if ((consumerId >= 0) && (consumerId < CONT_MODE_MAX_CONSUMERS)) {
+        DeliverConsumer_t* consumer = &deliverConsumers[consumerId];
+        pthread_mutex_lock(&deliverConsumersLock);
+        if (consumer->active) {
+            consumer->active = false;
+            res = true;
+        }
+        pthread_mutex_unlock(&deliverConsumersLock);
+        if (res) {
+            /* Not dispatched anymore, so the consumer's data can be used without the lists' lock */
+            pthread_mutex_lock(&consumer->lock);
+            consumer->exiting = true;
+            pthread_cond_signal(&consumer->cond);
+            pthread_mutex_unlock(&consumer->lock);
+            pthread_join(consumer->thread, NULL);
+            while (consumer->count > 0u) {
+                DeliverEntry_t* entry = &consumer->queue[consumer->head];
+                if (entry->creditHeld) {
+                    DeliverCreditRelease(entry->scene);
+                }
+                DeliverSceneRelease(entry->scene);
+                consumer->head = (consumer->head + 1u) % consumer->capacity;
+                consumer->count--;
+            }
+            pthread_cond_destroy(&consumer->cond);
+            pthread_mutex_destroy(&consumer->lock);
+            /* The slot can be reused from now */
+            pthread_mutex_lock(&deliverConsumersLock);
+            free(consumer->queue);
+            consumer->queue = NULL;
+            pthread_mutex_unlock(&deliverConsumersLock);
+        }
+    }
+    return res;
+}
+
+
+bool spiDriver_GetContModeConsumerStats(const int16_t consumerId, ContModeConsumerStats_t* const stats)
+{
+    bool res = false;
+    if ((consumerId >= 0) && (consumerId < CONT_MODE_MAX_CONSUMERS)) {
+        pthread_mutex_lock(&deliverConsumersLock);
+        if (deliverConsumers[consumerId].active) {
+            DeliverConsumer_t* consumer = &deliverConsumers[consumerId];
+            pthread_mutex_lock(&consumer->lock);
+            stats->delivered = __atomic_load_n(&consumer->stats.delivered, __ATOMIC_RELAXED);
+            stats->dropped = consumer->stats.dropped;
+            stats->waits = consumer->stats.waits;
+            pthread_mutex_unlock(&consumer->lock);
+            res = true;
+        }
+        pthread_mutex_unlock(&deliverConsumersLock);
+    }
+    return res;
+}
+
+
+int spiDriver_OpenContModePull(const uint16_t queueDepth)
+{
+    int fd = -1;
+    pthread_mutex_lock(&deliverPullLock);
+    if (deliverPull.fd < 0) {
+        deliverPull.depth = (queueDepth == 0u) ? 1u : queueDepth;
+        deliverPull.queue = calloc(deliverPull.depth, sizeof(DeliverScene_t*));
+        deliverPull.held = calloc(deliverPull.depth, sizeof(DeliverScene_t*));
+        deliverPull.head = 0u;
+        deliverPull.count = 0u;
+        deliverPull.stats.delivered = 0u;
+        deliverPull.stats.dropped = 0u;
+        deliverPull.stats.waits = 0u;
+        if ((deliverPull.queue != NULL) && (deliverPull.held != NULL)) {
+            deliverPull.fd = eventfd(0u, EFD_NONBLOCK | EFD_CLOEXEC);
+        }
+        if (deliverPull.fd < 0) {
+            CONT_PRINT("Deliver: pull mode can't be opened\n");
+            free(deliverPull.queue);
+            free(deliverPull.held);
+            deliverPull.queue = NULL;
+            deliverPull.held = NULL;
+        }
+        fd = deliverPull.fd;
+    }
+    pthread_mutex_unlock(&deliverPullLock);
+    return fd;
+}
+
+
+void spiDriver_CloseContModePull(void)
+{
+    pthread_mutex_lock(&deliverPullLock);
+    if (deliverPull.fd >= 0) {
+        while (deliverPull.count > 0u) {
+            DeliverSceneRelease(deliverPull.queue[deliverPull.head]);
+            deliverPull.head = (deliverPull.head + 1u) % deliverPull.depth;
+            deliverPull.count--;
+        }
+        for (uint16_t ind = 0u; ind < deliverPull.depth; ind++) {
+            DeliverSceneRelease(deliverPull.held[ind]);
+        }
+        (void)close(deliverPull.fd);
+        deliverPull.fd = -1;
+        free(deliverPull.queue);
+        free(deliverPull.held);
+        deliverPull.queue = NULL;
+        deliverPull.held = NULL;
+    }
+    pthread_mutex_unlock(&deliverPullLock);
+}
+
+
+bool spiDriver_TryAcquireScene(spiDriver_ChipData_t** chipData, uint16_t* chipDataSize)
+{
+    bool res = false;
+    pthread_mutex_lock(&deliverPullLock);
+    if ((deliverPull.fd >= 0) && (deliverPull.count > 0u)) {
+        uint16_t slot = 0u;
+        while ((slot < deliverPull.depth) && (deliverPull.held[slot] != NULL)) {
+            slot++;
+        }
+        if (slot < deliverPull.depth) {
+            DeliverScene_t* scene = deliverPull.queue[deliverPull.head];
+            deliverPull.head = (deliverPull.head + 1u) % deliverPull.depth;
+            deliverPull.count--;
+            deliverPull.held[slot] = scene;
+            deliverPull.stats.delivered++;
+            *chipData = scene->chipData;
+            *chipDataSize = scene->chipDataSize;
+            res = true;
+        }
+    }
+    pthread_mutex_unlock(&deliverPullLock);
+    return res;
+}
+
+
+void spiDriver_ReleaseScene(const spiDriver_ChipData_t* const chipData)
+{
+    DeliverScene_t* scene = NULL;
+    pthread_mutex_lock(&deliverPullLock);
+    for (uint16_t slot = 0u; (slot < deliverPull.depth) && (deliverPull.held != NULL) && (scene == NULL); slot++) {
+        if ((deliverPull.held[slot] != NULL) && (deliverPull.held[slot]->chipData == chipData)) {
+            scene = deliverPull.held[slot];
+            deliverPull.held[slot] = NULL;
+        }
+    }
+    pthread_mutex_unlock(&deliverPullLock);
+    DeliverSceneRelease(scene);
+}
+
+
+bool spiDriver_GetContModePullStats(ContModeConsumerStats_t* const stats)
+{
+    bool res = false;
+    pthread_mutex_lock(&deliverPullLock);
+    if (deliverPull.fd >= 0) {
+        *stats = deliverPull.stats;
+        res = true;
+    }
+    pthread_mutex_unlock(&deliverPullLock);
+    return res;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file
+ * @brief SPI driver for MLX75322 Continuous mode support
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_cont_deliver SPI driver continuous mode data delivery thread
+ * @ingroup spi_cont_mode
+ *
+ * @details provides the continuous mode thread, which delivers the acquired data to the application - publishes the
+ *      data and calls the application's callbacks. Being separated from the major thread, a slow callback doesn't
+ *      stall the data acquisition. Each item processed is returned to the major thread as a credit, with the
+ *      callback's result attached.
+ *
+ *      The items are also shared with the subscribed consumers (see ::spiDriver_SubscribeContMode). Each consumer
+ *      runs in its own thread with its own queue, the item is reference-counted and released by the last user.
+ *
+ *      The application can also pull the items from its own thread (see ::spiDriver_OpenContModePull). The items are
+ *      queued with no thread of their own, an eventfd signals the new ones, so the application's event loop can
+ *      poll it together with its other descriptors.
+ *
+ */
+
+#ifndef DELIVER_DATA_H
+#define DELIVER_DATA_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include "spi_drv_trace.h"
+
+/** Initiates the data delivery thread
+ * This function creates a data delivery thread and starts it waiting for the data items
+ * @note    This function is normally driven from the continuous mode library
+ */
+void spiDriver_InitDeliverData(void);
+
+/** Exits the data delivery thread
+ * This function sends a message to finish the data delivery thread. The items sent before are delivered first
+ * @note    This function is normally driven from the continuous mode library
+ */
+void spiDriver_ExitDeliverData(void);
+
+/** Releases the data replaced in ::spiDriver_chipData
+ * The data published by the delivery thread is shared with the consumers, so it's released when the last consumer
+ * finishes with it. Other data is cleaned at once.
+ * @param[in]   chipData        the records replaced
+ * @param[in]   chipDataSize    items count in `chipData` array
+ */
+void spiDriver_DeliverReleaseData(spiDriver_ChipData_t* chipData, uint16_t chipDataSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* DELIVER_DATA_H */
@@ -0,0 +1,221 @@
+/**
+ * @file
+ * @brief Continuous mode shared memory transport
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_cont_shm
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "cont_mode_lib.h"
+#include "scene_shm.h"
+
+static pthread_mutex_t sceneShmLock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t* sceneShmBase = NULL;
+static size_t sceneShmSize = 0u;
+static char sceneShmName[NAME_MAX + 1];
+static SceneShmStats_t sceneShmStats;
+static uint32_t sceneShmMode = SCENE_SHM_MODE;
+
+
+/** Returns the size of the record's data */
+static uint32_t SceneShmDataSize(const spiDriver_ChipData_t* const chipData)
+{
+    uint32_t size = 0u;
+    if (chipData->data != NULL) {
+        switch (chipData->dataFormat) {
+            case CHIP_DATA_FAST:
+                size = sizeof(chipData->data->echo.format_fast);
+                break;
+            case CHIP_DATA_9P:
+                size = sizeof(chipData->data->echo.format_9p);
+                break;
+            case CHIP_DATA_SHORT:
+                size = sizeof(chipData->data->echo.format_short);
+                break;
+            case CHIP_DATA_DETAIL:
+                size = sizeof(chipData->data->echo.format_detail_1);
+                break;
+            case CHIP_DATA_TRACE:
+                size = (uint32_t)chipData->samples * N_CHANNELS * sizeof(uint16_t);
+                break;
+            default:
+                break;
+        }
+    }
+    return size;
+}
+
+
+FuncResult_e spiDriver_OpenSceneShm(const char* const name, const uint32_t slotSize, const uint16_t slotCount)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    pthread_mutex_lock(&sceneShmLock);
+    if ((name == NULL) || (strlen(name) > NAME_MAX) || (slotSize == 0u) || (slotCount == 0u) ||
+        (sceneShmBase != NULL)) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+    } else {
+        const uint32_t slotsOffset = SCENE_SHM_ALIGN(sizeof(SceneShmHeader_t));
+        const uint32_t slotStride = SCENE_SHM_ALIGN(sizeof(SceneShmSlot_t)) + SCENE_SHM_ALIGN(slotSize);
+        const size_t size = slotsOffset + (size_t)slotStride * slotCount;
+        /* Readers map the memory read-only. The mode is set again, since shm_open() applies the umask */
+        const int fd = shm_open(name, O_CREAT | O_TRUNC | O_RDWR, (mode_t)sceneShmMode);
+        void* base = MAP_FAILED;
+        if (fd >= 0) {
+            if ((fchmod(fd, (mode_t)sceneShmMode) == 0) && (ftruncate(fd, (off_t)size) == 0)) {
+                base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            (void)close(fd);
+        }
+        if (base != MAP_FAILED) {
+            SceneShmHeader_t* header = (SceneShmHeader_t*)base;
+            /* The new memory is zeroed, so all slots are free */
+            header->version = SCENE_SHM_VERSION;
+            header->slotCount = slotCount;
+            header->slotSize = SCENE_SHM_ALIGN(slotSize);
+            header->slotStride = slotStride;
+            header->slotsOffset = slotsOffset;
+            header->published = 0;
+            __atomic_store_n(&header->magic, SCENE_SHM_MAGIC, __ATOMIC_RELEASE);
+            sceneShmBase = (uint8_t*)base;
+            sceneShmSize = size;
+            strcpy(sceneShmName, name);
+            memset(&sceneShmStats, 0, sizeof(sceneShmStats));
+            CONT_PRINT("Shared memory %s: %u slots of %u bytes\n", name, slotCount, slotSize);
+        } else {
+            CONT_PRINT("Shared memory %s can't be created\n", name);
+            if (fd >= 0) {
+                (void)shm_unlink(name);
+            }
+            res = SPI_DRV_FUNC_RES_FAIL_MEMORY;
+        }
+    }
+    pthread_mutex_unlock(&sceneShmLock);
+    return res;
+}
+
+
+FuncResult_e spiDriver_SetSceneShmMode(const uint32_t mode)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    if (((mode & ~0777u) != 0u) || ((mode & 0600u) != 0600u)) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+    } else {
+        sceneShmMode = mode;
+    }
+    return res;
+}
+
+
+void spiDriver_CloseSceneShm(void)
+{
+    pthread_mutex_lock(&sceneShmLock);
+    if (sceneShmBase != NULL) {
+        (void)munmap(sceneShmBase, sceneShmSize);
+        (void)shm_unlink(sceneShmName);
+        sceneShmBase = NULL;
+        sceneShmSize = 0u;
+    }
+    pthread_mutex_unlock(&sceneShmLock);
+}
+
+
+bool spiDriver_SceneShmPublish(const spiDriver_ChipData_t* const chipData,
+                               const uint16_t chipDataSize,
+                               const bool sceneComplete)
+{
+    bool res = false;
+    pthread_mutex_lock(&sceneShmLock);
+    if (sceneShmBase != NULL) {
+        SceneShmHeader_t* header = (SceneShmHeader_t*)sceneShmBase;
+        uint32_t size = 0u;
+        for (uint16_t ind = 0u; ind < chipDataSize; ind++) {
+            size += SCENE_SHM_ALIGN(sizeof(SceneShmRecord_t)) + SCENE_SHM_ALIGN(SceneShmDataSize(&chipData[ind]));
+        }
+        if (size <= header->slotSize) {
+            const uint32_t item = (uint32_t)header->published + 1u;
+            SceneShmSlot_t* slot = (SceneShmSlot_t*)(sceneShmBase + header->slotsOffset +
+                                                     (size_t)((item - 1u) % header->slotCount) * header->slotStride);
+            uint8_t* out = (uint8_t*)slot + SCENE_SHM_ALIGN(sizeof(SceneShmSlot_t));
+            const uint32_t seq = slot->seq;
+            struct timespec now;
+
+            /* The odd sequence tells the readers the slot is changing */
+            __atomic_store_n(&slot->seq, seq + 1u, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+            for (uint16_t ind = 0u; ind < chipDataSize; ind++) {
+                SceneShmRecord_t* record = (SceneShmRecord_t*)out;
+                const uint32_t dataSize = SceneShmDataSize(&chipData[ind]);
+                memset(record, 0, sizeof(SceneShmRecord_t));
+                record->recordSize = SCENE_SHM_ALIGN(sizeof(SceneShmRecord_t)) + SCENE_SHM_ALIGN(dataSize);
+                record->dataSize = dataSize;
+                record->status = (int32_t)chipData[ind].status;
+                record->chipId = chipData[ind].chip_id;
+                record->samples = chipData[ind].samples;
+                record->dataFormat = (uint16_t)chipData[ind].dataFormat;
+                record->sequence = chipData[ind].sequence;
+                record->continuity = chipData[ind].continuity;
+                record->sceneComplete = chipData[ind].sceneComplete;
+                if (chipData[ind].metaData != NULL) {
+                    record->hasMetaData = 1u;
+                    record->metaData = *chipData[ind].metaData;
+                }
+                if (dataSize > 0u) {
+                    memcpy(out + SCENE_SHM_ALIGN(sizeof(SceneShmRecord_t)), chipData[ind].data, dataSize);
+                }
+                out += record->recordSize;
+            }
+            (void)clock_gettime(CLOCK_MONOTONIC, &now);
+            slot->item = item;
+            slot->size = size;
+            slot->records = chipDataSize;
+            slot->sceneComplete = sceneComplete;
+            slot->stampNs = (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+            __atomic_store_n(&slot->seq, seq + 2u, __ATOMIC_RELEASE);
+
+            __atomic_store_n(&header->published, (int32_t)item, __ATOMIC_RELEASE);
+            /* The readers map the memory read-only, so they can't tell they are waiting: always wake */
+            (void)syscall(SYS_futex, &header->published, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+            sceneShmStats.published++;
+            res = true;
+        } else {
+            sceneShmStats.dropped++;
+        }
+    }
+    pthread_mutex_unlock(&sceneShmLock);
+    return res;
+}
+
+
+void spiDriver_GetSceneShmStats(SceneShmStats_t* const stats)
+{
+    pthread_mutex_lock(&sceneShmLock);
+    *stats = sceneShmStats;
+    pthread_mutex_unlock(&sceneShmLock);
+}
@@ -0,0 +1,152 @@
+/**
+ * @file
+ * @brief SPI driver for MLX75322 Continuous mode support
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_cont_shm SPI driver continuous mode shared memory transport
+ * @ingroup spi_cont_mode
+ *
+ * @details exports the continuous mode data to other processes through POSIX shared memory. The shared memory holds a
+ *      ring of fixed-size slots, each slot carries a data item (a scene, or a layer in per-layer delivery). The
+ *      trigger thread copies each item acquired into the next slot once, before handing the records over to the
+ *      continuous mode thread. The acquisition can't read into the slot itself: the records are owned and freed by
+ *      the consumers, which may hold them longer than the ring keeps the slot. The slot is guarded by a sequence lock,
+ *      so the readers never block the writer. The reader processes map the memory read-only and wait on a futex of
+ *      the published items' counter, see @ref spi_cont_shm_reader.
+ *
+ *      Layout: ::SceneShmHeader_t, then SceneShmHeader_t::slotCount slots of SceneShmHeader_t::slotStride bytes.
+ *      A slot starts with ::SceneShmSlot_t, followed by the item's records. Each record is ::SceneShmRecord_t with the
+ *      record's data right after it (see ::SCENE_SHM_RECORD_DATA).
+ */
+
+#ifndef SCENE_SHM_H
+#define SCENE_SHM_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "spi_drv_trace.h"
+
+/** Shared memory's identification, see SceneShmHeader_t::magic */
+#define SCENE_SHM_MAGIC 0x4D485353u
+/** Shared memory's layout version, see SceneShmHeader_t::version */
+#define SCENE_SHM_VERSION 1u
+/** Alignment of the slots' and records' parts in the shared memory */
+#define SCENE_SHM_ALIGN(size) (((size) + 7u) & ~7u)
+/** The record's data, placed after the record's header */
+#define SCENE_SHM_RECORD_DATA(record) ((const uint8_t*)(record) + SCENE_SHM_ALIGN(sizeof(SceneShmRecord_t)))
+/** Default access permissions of the shared memory: the owner's user only */
+#define SCENE_SHM_MODE 0600u
+
+/** The shared memory's header */
+typedef struct {
+    uint32_t magic;             /**< ::SCENE_SHM_MAGIC */
+    uint32_t version;           /**< ::SCENE_SHM_VERSION */
+    uint32_t slotCount;         /**< Slots in the ring */
+    uint32_t slotSize;          /**< Item's records size a slot can hold, in bytes */
+    uint32_t slotStride;        /**< Distance between the slots, in bytes */
+    uint32_t slotsOffset;       /**< The first slot's offset from the memory's beginning, in bytes */
+    int32_t published;          /**< Items published since the memory was created. The futex word the readers wait on.
+                                     The item N is held by the slot (N - 1) % slotCount */
+} SceneShmHeader_t;
+
+/** The slot's header */
+typedef struct {
+    uint32_t seq;               /**< Sequence lock: odd while the slot is written */
+    uint32_t item;              /**< The item's number, see SceneShmHeader_t::published */
+    uint32_t size;              /**< The item's records size, in bytes */
+    uint16_t records;           /**< The item's records count */
+    uint8_t sceneComplete;      /**< The item completes the scene */
+    uint8_t reserved;           /**< Reserved */
+    uint64_t stampNs;           /**< CLOCK_MONOTONIC time the item was published */
+} SceneShmSlot_t;
+
+/** The record's header, a copy of spiDriver_ChipData_t with the data placed after it */
+typedef struct {
+    uint32_t recordSize;        /**< The record's size with its data, in bytes. The next record follows */
+    uint32_t dataSize;          /**< The data's size, in bytes */
+    int32_t status;             /**< spiDriver_ChipData_t::status */
+    uint16_t chipId;            /**< spiDriver_ChipData_t::chip_id */
+    uint16_t samples;           /**< spiDriver_ChipData_t::samples */
+    uint16_t dataFormat;        /**< spiDriver_ChipData_t::dataFormat */
+    uint16_t sequence;          /**< spiDriver_ChipData_t::sequence */
+    uint8_t continuity;         /**< spiDriver_ChipData_t::continuity */
+    uint8_t sceneComplete;      /**< spiDriver_ChipData_t::sceneComplete */
+    uint8_t hasMetaData;        /**< SceneShmRecord_t::metaData is filled */
+    uint8_t reserved;           /**< Reserved */
+    Metadata_t metaData;        /**< spiDriver_ChipData_t::metaData */
+} SceneShmRecord_t;
+
+/** Shared memory transport's statistics */
+typedef struct {
+    uint32_t published;         /**< Items published */
+    uint32_t dropped;           /**< Items not published, since they don't fit into a slot */
+} SceneShmStats_t;
+
+/** Sets the access permissions of the shared memory, applied by the next ::spiDriver_OpenSceneShm
+ * Any local process able to open the shared memory reads the sensor's data. So it's created with ::SCENE_SHM_MODE
+ * (the owner's user only) by default. The readers need the read permission only, i.e. 0640 lets a group in.
+ * @param[in]   mode    permissions' bits, like for chmod(2). Only the bits of 0777 are allowed, the owner's read and
+ *                      write bits are required
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     wrong permissions' bits
+ */
+FuncResult_e spiDriver_SetSceneShmMode(const uint32_t mode);
+
+/** Creates the shared memory and starts publishing the continuous mode data into it
+ * The shared memory is created with the permissions set by ::spiDriver_SetSceneShmMode (::SCENE_SHM_MODE by default)
+ * @param[in]   name        shared memory's name, see shm_open()
+ * @param[in]   slotSize    item's records size a slot can hold, in bytes
+ * @param[in]   slotCount   slots in the ring
+ * @retval  SPI_DRV_FUNC_RES_OK                 the shared memory is created
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     wrong parameters, or the shared memory is already opened
+ * @retval  SPI_DRV_FUNC_RES_FAIL_MEMORY        the shared memory can't be created
+ */
+FuncResult_e spiDriver_OpenSceneShm(const char* const name, const uint32_t slotSize, const uint16_t slotCount);
+
+/** Stops publishing the data and removes the shared memory
+ * The readers keep their mappings until they close them
+ */
+void spiDriver_CloseSceneShm(void);
+
+/** Publishes the data item into the next slot
+ * @param[in]   chipData        the item's records
+ * @param[in]   chipDataSize    items count in `chipData` array
+ * @param[in]   sceneComplete   the item completes the scene
+ * @retval  true    the item is published
+ * @retval  false   the shared memory is not opened, or the item doesn't fit into a slot
+ * @note    This function is normally driven from the trigger thread
+ */
+bool spiDriver_SceneShmPublish(const spiDriver_ChipData_t* const chipData,
+                               const uint16_t chipDataSize,
+                               const bool sceneComplete);
+
+/** Gets the shared memory transport's statistics
+ * @param[out]  stats   statistics' output
+ */
+void spiDriver_GetSceneShmStats(SceneShmStats_t* const stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* SCENE_SHM_H */
@@ -0,0 +1,221 @@
+/**
+ * @file
+ * @brief Continuous mode shared memory transport reader
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_cont_shm_reader
+ */
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "scene_shm.h"
+#include "scene_shm_reader.h"
+
+/** The reader's state */
+struct SceneShmReader {
+    const uint8_t* base;            /**< The shared memory mapped */
+    size_t size;                    /**< The shared memory's size */
+    const SceneShmHeader_t* header; /**< The shared memory's header */
+    uint32_t next;                  /**< The next item to read */
+    const SceneShmSlot_t* slot;     /**< The slot being read */
+    uint32_t seq;                   /**< The slot's sequence when the reading started */
+    uint32_t lost;                  /**< Items lost */
+};
+
+
+/** Returns the slot of the item */
+static const SceneShmSlot_t* SceneShmReaderSlot(const SceneShmReader_t* const reader, const uint32_t item)
+{
+    const SceneShmHeader_t* header = reader->header;
+    return (const SceneShmSlot_t*)(reader->base + header->slotsOffset +
+                                   (size_t)((item - 1u) % header->slotCount) * header->slotStride);
+}
+
+
+SceneShmReader_t* spiDriver_SceneShmOpenReader(const char* const name)
+{
+    SceneShmReader_t* reader = NULL;
+    const int fd = shm_open(name, O_RDONLY, 0);
+    if (fd >= 0) {
+        struct stat st;
+        if ((fstat(fd, &st) == 0) && ((size_t)st.st_size >= sizeof(SceneShmHeader_t))) {
+            void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (base != MAP_FAILED) {
+                const SceneShmHeader_t* header = (const SceneShmHeader_t*)base;
+                const bool valid = (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == SCENE_SHM_MAGIC) &&
+                                   (header->version == SCENE_SHM_VERSION) && (header->slotCount > 0u) &&
+                                   ((size_t)header->slotsOffset + (size_t)header->slotStride * header->slotCount <=
+                                    (size_t)st.st_size);
+                if (valid) {
+                    reader = calloc(1u, sizeof(SceneShmReader_t));
+                }
+                if (reader != NULL) {
+                    reader->base = (const uint8_t*)base;
+                    reader->size = (size_t)st.st_size;
+                    reader->header = header;
+                    reader->next = (uint32_t)__atomic_load_n(&header->published, __ATOMIC_ACQUIRE) + 1u;
+                } else {
+                    (void)munmap(base, (size_t)st.st_size);
+                }
+            }
+        }
+        (void)close(fd);
+    }
+    return reader;
+}
+
+
+void spiDriver_SceneShmCloseReader(SceneShmReader_t* const reader)
+{
+    if (reader != NULL) {
+        (void)munmap((void*)reader->base, reader->size);
+        free(reader);
+    }
+}
+
+
+bool spiDriver_SceneShmWait(SceneShmReader_t* const reader, const uint32_t timeoutMs)
+{
+    struct timespec deadline;
+    bool res = false;
+    bool waiting = true;
+    (void)clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += (time_t)(timeoutMs / 1000u);
+    deadline.tv_nsec += (long)(timeoutMs % 1000u) * 1000000l;
+    if (deadline.tv_nsec >= 1000000000l) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000l;
+    }
+    while (waiting) {
+        const int32_t published = __atomic_load_n(&reader->header->published, __ATOMIC_ACQUIRE);
+        if ((int32_t)((uint32_t)published - reader->next) >= 0) {
+            res = true;
+            waiting = false;
+        } else {
+            struct timespec now;
+            struct timespec left;
+            (void)clock_gettime(CLOCK_MONOTONIC, &now);
+            left.tv_sec = deadline.tv_sec - now.tv_sec;
+            left.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if (left.tv_nsec < 0) {
+                left.tv_sec--;
+                left.tv_nsec += 1000000000l;
+            }
+            if (left.tv_sec < 0) {
+                waiting = false;
+            } else {
+                (void)syscall(SYS_futex, &reader->header->published, FUTEX_WAIT, published, &left, NULL, 0);
+            }
+        }
+    }
+    return res;
+}
+
+
+const uint8_t* spiDriver_SceneShmBeginRead(SceneShmReader_t* const reader,
+                                           uint32_t* const size,
+                                           uint16_t* const records,
+                                           bool* const sceneComplete)
+{
+    const uint8_t* item = NULL;
+    const SceneShmHeader_t* header = reader->header;
+    bool reading = true;
+    reader->slot = NULL;
+    while (reading) {
+        const uint32_t published = (uint32_t)__atomic_load_n(&header->published, __ATOMIC_ACQUIRE);
+        if ((int32_t)(published - reader->next) < 0) {
+            /* Nothing new */
+            reading = false;
+        } else {
+            const SceneShmSlot_t* slot;
+            uint32_t seq;
+            if ((published - reader->next) >= header->slotCount) {
+                /* The writer has lapped the reader, continue from the oldest item kept */
+                const uint32_t oldest = published - header->slotCount + 1u;
+                reader->lost += oldest - reader->next;
+                reader->next = oldest;
+            }
+            slot = SceneShmReaderSlot(reader, reader->next);
+            seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+            if (((seq & 1u) == 0u) && (slot->item == reader->next)) {
+                reader->slot = slot;
+                reader->seq = seq;
+                *size = (slot->size <= header->slotSize) ? slot->size : header->slotSize;
+                *records = slot->records;
+                if (sceneComplete != NULL) {
+                    *sceneComplete = (slot->sceneComplete != 0u);
+                }
+                item = (const uint8_t*)slot + SCENE_SHM_ALIGN(sizeof(SceneShmSlot_t));
+                reading = false;
+            } else {
+                /* The slot is being overwritten by a newer item */
+                reader->lost++;
+                reader->next++;
+            }
+        }
+    }
+    return item;
+}
+
+
+bool spiDriver_SceneShmEndRead(SceneShmReader_t* const reader)
+{
+    bool res = false;
+    if (reader->slot != NULL) {
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        res = (__atomic_load_n(&reader->slot->seq, __ATOMIC_RELAXED) == reader->seq);
+        if (!res) {
+            reader->lost++;
+        }
+        reader->next++;
+        reader->slot = NULL;
+    }
+    return res;
+}
+
+
+const SceneShmRecord_t* spiDriver_SceneShmNextRecord(const uint8_t* const item,
+                                                     const uint32_t size,
+                                                     const SceneShmRecord_t* const record)
+{
+    const SceneShmRecord_t* next = NULL;
+    const uint32_t offset = (record == NULL) ? 0u :
+                            (uint32_t)((const uint8_t*)record - item) + record->recordSize;
+    if ((record == NULL) || (record->recordSize >= sizeof(SceneShmRecord_t))) {
+        if ((offset + sizeof(SceneShmRecord_t)) <= size) {
+            next = (const SceneShmRecord_t*)(item + offset);
+            if ((next->recordSize < sizeof(SceneShmRecord_t)) || (next->recordSize > (size - offset))) {
+                /* Torn record, see spiDriver_SceneShmEndRead */
+                next = NULL;
+            }
+        }
+    }
+    return next;
+}
+
+
+uint32_t spiDriver_SceneShmLost(const SceneShmReader_t* const reader)
+{
+    return reader->lost;
+}
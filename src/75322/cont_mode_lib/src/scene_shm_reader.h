@@ -0,0 +1,107 @@
+/**
+ * @file
+ * @brief SPI driver for MLX75322 Continuous mode support
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_cont_shm_reader SPI driver shared memory transport reader
+ * @ingroup spi_cont_shm
+ *
+ * @details reads the continuous mode data published into the shared memory (see @ref spi_cont_shm) from another
+ *      process. This part depends on the C library only, it can be built into the reader's application without the
+ *      driver. The memory is mapped read-only, any number of readers can use it at once.
+ *
+ *      The items are read in place: ::spiDriver_SceneShmBeginRead gives the item's records in the slot, and
+ *      ::spiDriver_SceneShmEndRead tells whether the slot was overwritten meanwhile, then the records must be dropped.
+ *      A reader which is slower than the writer loses the items overwritten (see ::spiDriver_SceneShmLost).
+ */
+
+#ifndef SCENE_SHM_READER_H
+#define SCENE_SHM_READER_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "scene_shm.h"
+
+/** The reader's state, opaque */
+typedef struct SceneShmReader SceneShmReader_t;
+
+/** Opens the shared memory for reading
+ * The reader gets the items published after it's opened
+ * @param[in]   name    shared memory's name, see ::spiDriver_OpenSceneShm
+ * @return  the reader, or NULL if the memory can't be opened or has unknown layout
+ */
+SceneShmReader_t* spiDriver_SceneShmOpenReader(const char* const name);
+
+/** Closes the reader
+ * @param[in]   reader  the reader
+ */
+void spiDriver_SceneShmCloseReader(SceneShmReader_t* const reader);
+
+/** Waits for the item not read yet
+ * @param[in]   reader      the reader
+ * @param[in]   timeoutMs   time to wait, in milliseconds
+ * @retval  true    an item can be read
+ * @retval  false   no items were published within the timeout
+ */
+bool spiDriver_SceneShmWait(SceneShmReader_t* const reader, const uint32_t timeoutMs);
+
+/** Starts reading the oldest item not read yet, without waiting
+ * @param[in]   reader          the reader
+ * @param[out]  size            the item's records size, in bytes
+ * @param[out]  records         the item's records count
+ * @param[out]  sceneComplete   the item completes the scene. Can be NULL
+ * @return  the item's records in the shared memory, see ::spiDriver_SceneShmNextRecord. NULL if no items to read
+ */
+const uint8_t* spiDriver_SceneShmBeginRead(SceneShmReader_t* const reader,
+                                           uint32_t* const size,
+                                           uint16_t* const records,
+                                           bool* const sceneComplete);
+
+/** Finishes reading the item
+ * @param[in]   reader  the reader
+ * @retval  true    the item's records read are consistent
+ * @retval  false   the item was overwritten while read, the records read must be dropped
+ */
+bool spiDriver_SceneShmEndRead(SceneShmReader_t* const reader);
+
+/** Iterates the item's records
+ * @param[in]   item    the item's records, returned by ::spiDriver_SceneShmBeginRead
+ * @param[in]   size    the item's records size, in bytes
+ * @param[in]   record  the current record. NULL to get the first one
+ * @return  the next record, or NULL when there are no more records. The record's data is ::SCENE_SHM_RECORD_DATA
+ */
+const SceneShmRecord_t* spiDriver_SceneShmNextRecord(const uint8_t* const item,
+                                                     const uint32_t size,
+                                                     const SceneShmRecord_t* const record);
+
+/** Returns the amount of items lost by the reader, overwritten before they were read
+ * @param[in]   reader  the reader
+ * @return  items lost
+ */
+uint32_t spiDriver_SceneShmLost(const SceneShmReader_t* const reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* SCENE_SHM_READER_H */
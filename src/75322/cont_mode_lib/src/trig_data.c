@@ -23,15 +23,18 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <pthread.h>
-#include <sys/types.h>
-#include <sys/ipc.h>
-#include <sys/msg.h>
 #include <string.h>
 #include <unistd.h>
 #include "cont_mode_lib.h"
+#include "cont_mode_chan.h"
 #include "trig_data.h"
+#include "bus_data.h"
+#include "cont_mode_rt.h"
+#include "scene_shm.h"
+#include "broker.h"
 #include "spi_drv_trace.h"
 #include "spi_drv_sync_mode.h"
+#include "spi_drv_instance_priv.h"
 
 static pthread_t trigDataThreadID;
 static ContModeCmd_e trigDataMode = CONT_MODE_NOT_INITED;
@@ -39,12 +42,28 @@ static ContModeCmd_e trigDataMode = CONT_MODE_NOT_INITED;
 extern FuncResult_e spiDriver_getSingleScene(volatile SpiDriver_Params_t* params,
                                              spiDriver_ChipData_t** spiDriver_chipDataTmp,
                                              uint16_t* spiDriver_chipDataSizeTmp);
+extern FuncResult_e spiDriver_getSingleSceneByLayer(volatile SpiDriver_Params_t* params,
+                                                    const cbLayerReady_t layerReady);
 extern FuncResult_e spiDriver_getSingleSyncStep(spiDriver_ChipData_t** spiDriver_chipDataTmp,
                                                 uint16_t* spiDriver_chipDataSizeTmp);
-extern void spiDriver_UpdateCurrentData(const spiDriver_ChipData_t* const spiDriver_chipDataTmp,
-                                        const uint16_t spiDriver_chipDataSizeTmp);
 
-extern ContModeCfg_t contModeCfg;
+extern void spiDriver_ContModeAdoptInstance(void);
+
+/** The scene's last item is sent by trigDataLayerReady(). Used by the trigger thread only */
+static bool trigDataSceneSent = false;
+
+/** Sends the records to the continuous mode thread. The receiver owns the records */
+static void trigDataLayerReady(spiDriver_ChipData_t* chipData, const uint16_t chipDataSize, const bool sceneComplete)
+{
+    const contModeInterface_t out_msg = {.cmd = CONT_MODE_WORK, .mtype = CONT_MODE_DATA_READY,
+                                         .chipData = chipData, .chipDataSize = chipDataSize,
+                                         .sceneComplete = sceneComplete};
+    /* The shared memory is written by the acquiring thread, before the item is handed over */
+    (void)spiDriver_SceneShmPublish(chipData, chipDataSize, sceneComplete);
+    CONT_PRINT("Trigger: Send layer ready message, scene complete: %u\n", sceneComplete);
+    trigDataSceneSent = sceneComplete;
+    spiDriver_ContModeSend(&out_msg);
+}
 
 /* Continuous mode thread function */
 void* trigDataExecute(void* temp)
@@ -54,21 +73,14 @@ void* trigDataExecute(void* temp)
 #endif /* CONT_MODE_DEBUG */
     bool looping = true;
     contModeInterface_t rbuf;
-    const contModeInterface_t out_msg = {.cmd = CONT_MODE_WORK, .mtype = CONT_MODE_DATA_READY};
-    const int msgflg = 0666;
     (void)temp;
-    /* get the message queue id for the key with value CONT_MODE_MSQ_KEY */
-    CONT_PRINT("\nmsgget: Calling msgget(%#x,\%#o)\n", CONT_MODE_MSQ_KEY, msgflg);
-    if ((msqid = msgget(CONT_MODE_MSQ_KEY, msgflg)) < 0) {
-        perror("msgget");
-        exit(1);
-    } else {
-        CONT_PRINT("msgget: msgget succeeded: msqid = %d\n", msqid);
-    }
+    spiDriver_ContModeAdoptInstance();
+    spiDriver_BrokerStepThread();
+    spiDriver_ContModeRtThread(&contModeCfg.rt, &contModeCfg.rt.trigThread);
     while ( looping ) {
         CONT_PRINT("Trigger: Waiting for trigger data request\n");
-        if (msgrcv(msqid, &rbuf, contModeInterface_size, CONT_MODE_REQUEST_DATA, 0) < 0) {
-            CONT_PRINT("Trigger: msgrcv err:%x\n", errno);
+        if (!spiDriver_ContModeReceive(CONT_MODE_REQUEST_DATA, &rbuf, true)) {
+            CONT_PRINT("Trigger: request receive failed\n");
             looping = false;
         } else {
             spiDriver_ChipData_t* spiDriver_chipDataTmp = NULL;
@@ -77,16 +89,29 @@ void* trigDataExecute(void* temp)
             if ((rbuf.cmd == CONT_MODE_WORK) && (trigDataMode != CONT_MODE_NOT_INITED)) {
 
                 CONT_PRINT("Trigger: WORK request to read data from ICs\n");
-                if (contModeCfg.useAsyncSequence) {
+                spiDriver_ContModePace(&contModeCfg.pace);
+                /* The broker's clients use the bus between the steps */
+                spiDriver_BrokerStepBegin();
+                spiDriver_ContModeRtStepBegin();
+                if (contModeCfg.useAsyncSequence && spiDriver_BusDataActive()) {
+                    spiDriver_GetBusSyncStep(&spiDriver_chipDataTmp, &spiDriver_chipDataSizeTmp);
+                } else if (contModeCfg.useAsyncSequence) {
                     spiDriver_getSingleSyncStep(&spiDriver_chipDataTmp, &spiDriver_chipDataSizeTmp);
+                } else if (contModeCfg.perLayerDelivery) {
+                    /* Layers are sent by trigDataLayerReady() */
+                    trigDataSceneSent = false;
+                    spiDriver_getSingleSceneByLayer(NULL, trigDataLayerReady);
                 } else {
                     spiDriver_getSingleScene(NULL, &spiDriver_chipDataTmp, &spiDriver_chipDataSizeTmp);
                 }
-                spiDriver_UpdateCurrentData(spiDriver_chipDataTmp, spiDriver_chipDataSizeTmp);
-
-                /* Signal about the new data's ready */
-                CONT_PRINT("Trigger: Send data ready message %lu\n", index++);
-                msgsnd(msqid, &out_msg, contModeInterface_size, IPC_CREAT);
+                spiDriver_ContModeRtStepEnd();
+                if (contModeCfg.useAsyncSequence || !contModeCfg.perLayerDelivery || !trigDataSceneSent) {
+                    /* Signal about the new data's ready, the data is handed over with the message. In per-layer
+                     * delivery the scene with no layers is completed by an empty item, so the next one is requested */
+                    CONT_PRINT("Trigger: Send data ready message %lu\n", index++);
+                    trigDataLayerReady(spiDriver_chipDataTmp, spiDriver_chipDataSizeTmp, true);
+                }
+                spiDriver_BrokerStepEnd();
             } else if (rbuf.cmd == CONT_MODE_EXIT) {
                 CONT_PRINT("Trigger: exit signal received\n");
                 looping = false;
@@ -96,6 +121,7 @@ void* trigDataExecute(void* temp)
             }
         }
     }
+    spiDriver_ExitBusData();
     CONT_PRINT("\nTrigger: Polling thread is Finished\n");
     trigDataMode = CONT_MODE_NOT_INITED;
     return NULL;
@@ -103,23 +129,15 @@ void* trigDataExecute(void* temp)
 
 void spiDriver_InitTrigData(void)
 {
-    uint32_t msqid_counter = 0x10000;
     if (trigDataMode == CONT_MODE_NOT_INITED) {
-        (void)pthread_create(&trigDataThreadID, NULL, &trigDataExecute, NULL);
-        while((msqid == 0) && (msqid_counter-- != 0ul)) {
-            ;
-        }
-        if (msqid_counter != 0ul) {
+        /* The channels are initialized by the continuous mode thread's owner, requests can be sent right away */
+        trigDataMode = CONT_MODE_IDLE;
+        spiDriver_InitBusData();
+        if (pthread_create(&trigDataThreadID, NULL, &trigDataExecute, NULL) == 0) {
             CONT_PRINT("\nTrigger thread created\n");
-            /* get the message queue id for the key with value CONT_MODE_MSQ_KEY */
-            CONT_PRINT("\nmsgget: Calling msgget(%#x,\%#o)\n", CONT_MODE_MSQ_KEY, 0666);
-            if ((msqid = msgget(CONT_MODE_MSQ_KEY, 0666)) < 0) {
-                perror("msgget");
-                exit(1);
-            } else {
-                CONT_PRINT("msgget: msgget succeeded: msqid = %d\n", msqid);
-            }
-            trigDataMode = CONT_MODE_IDLE;
+        } else {
+            CONT_PRINT("\nTrigger thread is not created\n");
+            trigDataMode = CONT_MODE_NOT_INITED;
         }
     }
 }
@@ -129,7 +147,7 @@ void spiDriver_RunTrigData(void)
     contModeInterface_t msg;
     msg.cmd = CONT_MODE_WORK;
     msg.mtype = CONT_MODE_REQUEST_DATA;
-    (void)msgsnd(msqid, &msg, contModeInterface_size, IPC_CREAT);
+    spiDriver_ContModeSend(&msg);
 }
 
 void spiDriver_StopTrigData(void)
@@ -137,7 +155,7 @@ void spiDriver_StopTrigData(void)
     contModeInterface_t msg;
     msg.cmd = CONT_MODE_STOP;
     msg.mtype = CONT_MODE_REQUEST_DATA;
-    (void)msgsnd(msqid, &msg, contModeInterface_size, IPC_CREAT);
+    spiDriver_ContModeSend(&msg);
 }
 
 void spiDriver_ExitTrigData(void)
@@ -145,6 +163,6 @@ void spiDriver_ExitTrigData(void)
     contModeInterface_t msg;
     msg.cmd = CONT_MODE_EXIT;
     msg.mtype = CONT_MODE_REQUEST_DATA;
-    (void)msgsnd(msqid, &msg, contModeInterface_size, IPC_CREAT);
+    spiDriver_ContModeSend(&msg);
 }
 
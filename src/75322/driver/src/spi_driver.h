@@ -27,11 +27,20 @@
 #include "spi_drv_common_types.h"
 #include "spi_drv_data.h"
 #include "spi_drv_api.h"
+#include "spi_drv_handle.h"
 #include "spi_drv_trace.h"
+#include "spi_drv_trace_conv.h"
+#include "spi_drv_echo_decode.h"
+#include "spi_drv_echo_refine.h"
+#include "spi_drv_point_cloud.h"
+#include "spi_drv_echo_extract.h"
+#include "spi_drv_trace_accu.h"
+#include "spi_drv_continuity.h"
 #include "spi_drv_hal_gpio.h"
 #include "spi_drv_hal_spidev.h"
 #include "spi_drv_tools.h"
 #include "cont_mode_lib.h"
+#include "cont_mode_chan.h"
 
 
 #endif /* SPI_DRIVER_H */
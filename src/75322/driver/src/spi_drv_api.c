@@ -27,16 +27,26 @@
 #include "spi_drv_api.h"
 #include "spi_drv_data.h"
 #include "spi_drv_com.h"
+#include "spi_drv_com_tools.h"
 #include "spi_drv_sync_com.h"
 #include "hex_parse.h"
 #include "spi_drv_trace.h"
 #include "cont_mode_lib.h"
+#include "spi_drv_instance_priv.h"
 
-static spiDriver_InputConfiguration_t* spiDriver_Configuration = NULL;
-static char delimiters[16] = SPI_DRV_TEXT_DEFAULT_DELIMITERS;
+/* The bus is shared with the broker's clients, see broker.c */
+extern void spiDriver_BrokerBusEnter(void);
+extern void spiDriver_BrokerBusLeave(void);
+
+static spiDriver_InputConfiguration_t* spiDriver_ConfigurationInst[SPI_DRV_MAX_HANDLES];
+static char delimitersInst[SPI_DRV_MAX_HANDLES][16] = {SPI_DRV_TEXT_DEFAULT_DELIMITERS};
 static char defaultIcName[] = "M75322";
-static char* icIntNames[MAX_IC_ID_NUMBER] = {defaultIcName};
-uint16_t icIntNamesNumber = 1;
+static char* icIntNamesInst[SPI_DRV_MAX_HANDLES][MAX_IC_ID_NUMBER] = {{defaultIcName}};
+uint16_t icIntNamesNumberInst[SPI_DRV_MAX_HANDLES] = {1u};
+
+#define spiDriver_Configuration (spiDriver_ConfigurationInst[SPI_DRV_INSTANCE])
+#define delimiters (delimitersInst[SPI_DRV_INSTANCE])
+#define icIntNames (icIntNamesInst[SPI_DRV_INSTANCE])
 
 const char* spiDriverScriptCommandStrings[SUPPORTED_SCRIPT_COMMANDS] = {
     "nop",
@@ -46,8 +56,18 @@ const char* spiDriverScriptCommandStrings[SUPPORTED_SCRIPT_COMMANDS] = {
     "import"
 };
 
-extern ContModeCfg_t contModeCfg;
-extern volatile SpiDriver_State_t spiDriver_currentState;
+
+/** Sets the API's state of the current instance to the defaults, called for the instance created */
+void spiDriver_ResetApiInstance(void)
+{
+    spiDriver_Configuration = NULL;
+    memset(delimiters, 0, sizeof(delimiters));
+    strncpy(delimiters, SPI_DRV_TEXT_DEFAULT_DELIMITERS, sizeof(delimiters) - 1u);
+    memset(icIntNames, 0, sizeof(icIntNames));
+    icIntNames[0u] = defaultIcName;
+    icIntNamesNumber = 1u;
+}
+
 
 void spiDriver_SetDelimiter(const char* const tableDelimiters)
 {
@@ -72,9 +92,9 @@ spiDriver_Status_t spiDriver_Initialize(const spiDriver_InputConfiguration_t* co
         memset((void*)spiDriver_currentState.params, 0u, sizeof(spiDriver_currentState.params[0u]) * MAX_IC_ID_NUMBER);
     }
 
+    spiDriver_InvalidateSceneParams(IC_ID_BROADCAST);
     spiDriver_Configuration = (spiDriver_InputConfiguration_t*)spiDriver_InputCfg;
-    free(fwFields);
-    fwFieldsCount = 0;
+    FreeFwJson();
     if (spiDriver_Configuration != NULL) {
         drv_res = ReadFwJson(spiDriver_Configuration->fwFileName);
         if (drv_res == SPI_DRV_FUNC_RES_OK) {
@@ -139,6 +159,7 @@ spiDriver_Status_t spiDriver_LoadPatch(const char* const patchFileName)
         if (comRes == SPI_DRV_FUNC_RES_OK) {
             comRes |= spiCom_ApplySyncPatch();
         }
+        spiDriver_InvalidateSceneParams(IC_ID_BROADCAST);
         if (comRes != SPI_DRV_FUNC_RES_OK) {
             res = SPI_DRV_FALSE;
         }
@@ -234,6 +255,7 @@ FuncResult_e spiDriver_SetByName(const SpiDriver_FldName_t* const varName,
 {
     FwFieldInfo_t* var;
     FuncResult_e res;
+    spiDriver_BrokerBusEnter();
     var = GetFwVariableByName(varName);
     if (var != NULL) {
         uint32_t cur_value;
@@ -253,11 +275,13 @@ FuncResult_e spiDriver_SetByName(const SpiDriver_FldName_t* const varName,
             }
             if (res == SPI_DRV_FUNC_RES_OK) {
                 res = spiCom_Write(var->offset, var->wordSize, (uint16_t*)&new_value, false);
+                spiDriver_SceneParamsOnWrite(varName, spiDriver_SpiGetDev());
             }
         }
     } else {
         res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
     }
+    spiDriver_BrokerBusLeave();
     return res;
 }
 
@@ -292,6 +316,159 @@ FuncResult_e spiDriver_GetByName(const SpiDriver_FldName_t* const varName,
 }
 
 
+FuncResult_e spiDriver_SetVarsByName(const SpiDriver_FldName_t* const* const varNames,
+                                     const uint32_t* const values,
+                                     const SpiDriver_FldName_t* const* const bitFieldNames,
+                                     const uint16_t varsNumber)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    FwFieldInfo_t** vars = malloc((sizeof(FwFieldInfo_t*) * 2u + sizeof(uint16_t)) * varsNumber);
+    FwFieldInfo_t** bvars = &vars[varsNumber];
+    uint16_t* order = (uint16_t*)&vars[2u * varsNumber];
+    uint16_t runWords[MAX_RW_SIZE];
+    uint16_t first = 0u;
+
+    spiDriver_BrokerBusEnter();
+    if ((vars == NULL) && (varsNumber > 0u)) {
+        res = SPI_DRV_FUNC_RES_FAIL_MEMORY;
+    }
+    for (uint16_t ind = 0u; (ind < varsNumber) && (res == SPI_DRV_FUNC_RES_OK); ind++) {
+        const SpiDriver_FldName_t* bitFieldName = (bitFieldNames != NULL) ? bitFieldNames[ind] : NULL;
+        vars[ind] = GetFwVariableByName(varNames[ind]);
+        bvars[ind] = NULL;
+        if (vars[ind] == NULL) {
+            res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+        } else if ((bitFieldName != NULL) && (bitFieldName[0] != '\0')) {
+            bvars[ind] = GetFwBitFieldByName(vars[ind], bitFieldName);
+            if (bvars[ind] == NULL) {
+                res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+            }
+        }
+        /* Keep the variables sorted by offset, the ones with the same offset stay in order given */
+        if (res == SPI_DRV_FUNC_RES_OK) {
+            uint16_t pos = ind;
+            while ((pos > 0u) && (vars[order[pos - 1u]]->offset > vars[ind]->offset)) {
+                order[pos] = order[pos - 1u];
+                pos--;
+            }
+            order[pos] = ind;
+        }
+    }
+
+    while ((first < varsNumber) && (res == SPI_DRV_FUNC_RES_OK)) {
+        /* Collect the run of variables overlapping or adjacent in memory */
+        const uint16_t runBegin = vars[order[first]]->offset;
+        uint16_t runEnd = runBegin + vars[order[first]]->wordSize;
+        uint16_t last = first + 1u;
+        while ((last < varsNumber) &&
+               (vars[order[last]]->offset <= runEnd) &&
+               ((vars[order[last]]->offset + vars[order[last]]->wordSize - runBegin) <= MAX_RW_SIZE)) {
+            if ((vars[order[last]]->offset + vars[order[last]]->wordSize) > runEnd) {
+                runEnd = vars[order[last]]->offset + vars[order[last]]->wordSize;
+            }
+            last++;
+        }
+
+        res = spiCom_Read(runBegin, runEnd - runBegin, runWords);
+        if (res == SPI_DRV_FUNC_RES_OK) {
+            for (uint16_t pos = first; pos < last; pos++) {
+                const uint16_t ind = order[pos];
+                uint16_t* varWords = &runWords[vars[ind]->offset - runBegin];
+                uint32_t cur_value = 0ul;
+                uint32_t new_value;
+                memcpy(&cur_value, varWords, vars[ind]->wordSize * sizeof(uint16_t));
+                if (bvars[ind] != NULL) {
+                    new_value = spiDriver_SetBitByVar(bvars[ind], cur_value, values[ind]);
+                } else {
+                    new_value = spiDriver_SetByteByVar(vars[ind], cur_value, values[ind]);
+                }
+                memcpy(varWords, &new_value, vars[ind]->wordSize * sizeof(uint16_t));
+            }
+            res = spiCom_Write(runBegin, runEnd - runBegin, runWords, false);
+            for (uint16_t pos = first; pos < last; pos++) {
+                spiDriver_SceneParamsOnWrite(varNames[order[pos]], spiDriver_SpiGetDev());
+            }
+        }
+        first = last;
+    }
+    free(vars);
+    spiDriver_BrokerBusLeave();
+    return res;
+}
+
+
+FuncResult_e spiDriver_GetVarsByName(const SpiDriver_FldName_t* const* const varNames,
+                                     uint32_t* const values,
+                                     const SpiDriver_FldName_t* const* const bitFieldNames,
+                                     const uint16_t varsNumber)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    FwFieldInfo_t** vars = malloc((sizeof(FwFieldInfo_t*) * 2u + sizeof(uint16_t)) * varsNumber);
+    FwFieldInfo_t** bvars = &vars[varsNumber];
+    uint16_t* order = (uint16_t*)&vars[2u * varsNumber];
+    uint16_t runWords[MAX_RW_SIZE];
+    uint16_t first = 0u;
+
+    if ((vars == NULL) && (varsNumber > 0u)) {
+        res = SPI_DRV_FUNC_RES_FAIL_MEMORY;
+    }
+    for (uint16_t ind = 0u; (ind < varsNumber) && (res == SPI_DRV_FUNC_RES_OK); ind++) {
+        const SpiDriver_FldName_t* bitFieldName = (bitFieldNames != NULL) ? bitFieldNames[ind] : NULL;
+        vars[ind] = GetFwVariableByName(varNames[ind]);
+        bvars[ind] = NULL;
+        if (vars[ind] == NULL) {
+            res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+        } else if ((bitFieldName != NULL) && (bitFieldName[0] != '\0')) {
+            bvars[ind] = GetFwBitFieldByName(vars[ind], bitFieldName);
+            if (bvars[ind] == NULL) {
+                res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+            }
+        }
+        /* Keep the variables sorted by offset, inserting the new one */
+        if (res == SPI_DRV_FUNC_RES_OK) {
+            uint16_t pos = ind;
+            while ((pos > 0u) && (vars[order[pos - 1u]]->offset > vars[ind]->offset)) {
+                order[pos] = order[pos - 1u];
+                pos--;
+            }
+            order[pos] = ind;
+        }
+    }
+
+    while ((first < varsNumber) && (res == SPI_DRV_FUNC_RES_OK)) {
+        /* Collect the run of variables close to each other in memory */
+        const uint16_t runBegin = vars[order[first]]->offset;
+        uint16_t runEnd = runBegin + vars[order[first]]->wordSize;
+        uint16_t last = first + 1u;
+        while ((last < varsNumber) &&
+               (vars[order[last]]->offset <= (runEnd + VARS_READ_GAP_MAX)) &&
+               ((vars[order[last]]->offset + vars[order[last]]->wordSize - runBegin) <= MAX_RW_SIZE)) {
+            if ((vars[order[last]]->offset + vars[order[last]]->wordSize) > runEnd) {
+                runEnd = vars[order[last]]->offset + vars[order[last]]->wordSize;
+            }
+            last++;
+        }
+
+        res = spiCom_Read(runBegin, runEnd - runBegin, runWords);
+        if (res == SPI_DRV_FUNC_RES_OK) {
+            for (uint16_t pos = first; pos < last; pos++) {
+                const uint16_t ind = order[pos];
+                uint32_t cur_value = 0ul;
+                memcpy(&cur_value, &runWords[vars[ind]->offset - runBegin], vars[ind]->wordSize * sizeof(uint16_t));
+                if (bvars[ind] != NULL) {
+                    values[ind] = spiDriver_GetBitByVar(bvars[ind], cur_value);
+                } else {
+                    values[ind] = (uint32_t)spiDriver_GetByteByVar(vars[ind], cur_value);
+                }
+            }
+        }
+        first = last;
+    }
+    free(vars);
+    return res;
+}
+
+
 uint16_t strncopyStripped(const char* const lineString, uint16_t maxSize, const SpiDriver_FldName_t* dest)
 {
     const char* line = lineString;
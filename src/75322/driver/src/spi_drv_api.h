@@ -43,6 +43,7 @@ extern "C"
 #include <stdint.h>
 #include <stdbool.h>
 #include "spi_drv_common_types.h"
+#include "spi_drv_instance.h"
 #include "spi_drv_data.h"
 #include "spi_drv_com.h"
 #include "spi_drv_sync_mode.h"
@@ -69,7 +70,6 @@ extern "C"
  * @{
  */
 
-extern uint16_t icIntNamesNumber;
 
 /** Default text-files (like variable's list/values) delimiter. This set should not have > 15 characters */
 #define SPI_DRV_TEXT_DEFAULT_DELIMITERS " \t\n\r"
@@ -81,6 +81,8 @@ extern uint16_t icIntNamesNumber;
 #define MAX_IC_ID_NUMBER 16
 /** The IC's id used to handle the command as a broadcast message */
 #define IC_ID_BROADCAST MAX_IC_ID_NUMBER
+/** Maximum gap (in words) between the variables, read by a single block read of ::spiDriver_GetVarsByName */
+#define VARS_READ_GAP_MAX 16u
 
 /** @}*/
 
@@ -180,6 +182,41 @@ FuncResult_e spiDriver_GetByName(const SpiDriver_FldName_t* const varName,
                                  uint32_t* const value,
                                  const SpiDriver_FldName_t* const bitFieldName);
 
+
+/** Sets several variables by their names, coalescing the adjacent ones
+ * The variables located next to each other in IC's memory are updated by a single block read-modify-write instead
+ * of a transaction pair per variable. The variables are sorted by their offsets, the ones with the same offset
+ * (e.g. bit-fields of a variable) are applied in order given, so later items override the earlier ones.
+ * @param[in]   varNames        variables' names
+ * @param[in]   values          values to set
+ * @param[in]   bitFieldNames   bit-field names per variable. NULL, NULL item or an empty string address whole variable
+ * @param[in]   varsNumber      items count in the arrays
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    variable or bit-field name is not found
+ * @retval  SPI_DRV_FUNC_RES_FAIL               Low-level communication operation had failed
+ */
+FuncResult_e spiDriver_SetVarsByName(const SpiDriver_FldName_t* const* const varNames,
+                                     const uint32_t* const values,
+                                     const SpiDriver_FldName_t* const* const bitFieldNames,
+                                     const uint16_t varsNumber);
+
+
+/** Gets several variables by their names, coalescing the ones close to each other
+ * The variables are sorted by their offsets and read by block reads, covering the runs of variables with the gaps up
+ * to ::VARS_READ_GAP_MAX words between them, instead of a transaction pair per variable.
+ * @param[in]   varNames        variables' names
+ * @param[out]  values          values read, in order of names
+ * @param[in]   bitFieldNames   bit-field names per variable. NULL, NULL item or an empty string address whole variable
+ * @param[in]   varsNumber      items count in the arrays
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    variable or bit-field name is not found
+ * @retval  SPI_DRV_FUNC_RES_FAIL               Low-level communication operation had failed
+ */
+FuncResult_e spiDriver_GetVarsByName(const SpiDriver_FldName_t* const* const varNames,
+                                     uint32_t* const values,
+                                     const SpiDriver_FldName_t* const* const bitFieldNames,
+                                     const uint16_t varsNumber);
+
 /** @} */
 
 /**
@@ -27,14 +27,21 @@
 #include "spi_drv_tools.h"
 #include "spi_drv_hal_spidev.h"
 #include "spi_drv_hal_gpio.h"
+#include "spi_drv_trace.h"
+
+/* The bus is shared with the broker's clients, see broker.c */
+extern void spiDriver_BrokerBusEnter(void);
+extern void spiDriver_BrokerBusLeave(void);
 
 /** @{*/
 
 /* ---------------- Variables ---------------- */
 
-DiagDetailsPkt_t diagDetails[2];
-uint16_t pktWords [MAX_PKT_WORDS];
-uint16_t payload [MAX_PKT_PAYLOAD_WORDS];
+/* The packets' buffers and diagnostics are per thread, so the ICs on different buses can be accessed by different
+ * threads at once (see ::spiDriver_getSingleSyncStepIcs) */
+__thread DiagDetailsPkt_t diagDetails[2];
+__thread uint16_t pktWords [MAX_PKT_WORDS];
+__thread uint16_t payload [MAX_PKT_PAYLOAD_WORDS];
 
 
 /** Used for CRC calculations on each SPI packet transferred (MISO, MOSI) */
@@ -109,8 +116,12 @@ FuncResult_e spiCom_ResetASIC(void)
     COM_DEBUG_PRINT(comDebugFile, "** %s: ---- RESET ----\n", __FUNCTION__);
     FuncResult_e res = SPI_DRV_FUNC_RES_OK;
 
+    spiDriver_BrokerBusEnter();
     spiDriver_PinResetAsic();
+    /* The reset brings the ICs' memory back to defaults, the scene's parameters cached are stale */
+    spiDriver_InvalidateSceneParams(IC_ID_BROADCAST);
 
+    spiDriver_BrokerBusLeave();
     return res;
 }
 
@@ -167,6 +178,7 @@ FuncResult_e spiCom_Read(const uint16_t offset, const uint16_t wordSize, uint16_
     uint16_t* misoWords = NULL;
     uint8_t* pktBytes;
 
+    spiDriver_BrokerBusEnter();
     COM_DEBUG_PRINT(comDebugFile,
                     "** %s:  ---- READ ----  devId = %0d, offset = 0x%04X, wordSize = %0d\n",
                     __FUNCTION__,
@@ -265,6 +277,7 @@ FuncResult_e spiCom_Read(const uint16_t offset, const uint16_t wordSize, uint16_
 
     }  /* for xactNum++ */
 
+    spiDriver_BrokerBusLeave();
     return res;
 }
 
@@ -287,6 +300,7 @@ FuncResult_e spiCom_Write(const uint16_t offset,const uint16_t wordSize,uint16_t
     uint16_t* misoWords = NULL;
     uint8_t* pktBytes;
 
+    spiDriver_BrokerBusEnter();
 #if (COM_DEBUG_DETAIL_0 == 1)
     if ( (wordSize == 1) && (patch == false) ) {
         COM_DEBUG_PRINT(comDebugFile,
@@ -392,6 +406,7 @@ FuncResult_e spiCom_Write(const uint16_t offset,const uint16_t wordSize,uint16_t
         ptrWriteWords += sizeXact;
     }
 
+    spiDriver_BrokerBusLeave();
     return res;
 }
 
@@ -403,6 +418,7 @@ FuncResult_e spiCom_WritePatch(uint32_t offset, uint32_t size, uint8_t* dataBuf)
     uint16_t* patchWords = NULL;
     uint16_t wordSize = size >> 1;     /* Check for and only allow even size */
 
+    spiDriver_BrokerBusEnter();
     COM_DEBUG_PRINT(comDebugFile, "** %s: devId = %0d\n", __FUNCTION__, spiDriver_SpiGetDev());
 
     patchWords = (uint16_t*)dataBuf;          /* Bytes become words for packet construction */
@@ -413,6 +429,7 @@ FuncResult_e spiCom_WritePatch(uint32_t offset, uint32_t size, uint8_t* dataBuf)
 
     spiCom_Write(offset, wordSize, patchWords, 1); /* patch=1 */
 
+    spiDriver_BrokerBusLeave();
     return res;
 }
 
@@ -424,6 +441,7 @@ FuncResult_e spiCom_ApplyPatch(void)
     uint16_t* misoWords;
     uint8_t* pktBytes;
 
+    spiDriver_BrokerBusEnter();
     clearDiagDetails();
 
     COM_DEBUG_PRINT(comDebugFile, "** %s: devId = %0d\n", __FUNCTION__, spiDriver_SpiGetDev());
@@ -446,6 +464,7 @@ FuncResult_e spiCom_ApplyPatch(void)
         res = SPI_DRV_FUNC_RES_FAIL_COMM;
     }
 
+    spiDriver_BrokerBusLeave();
     return(res);                                         /* (Overall Error Status Flag) */
 
 }
@@ -458,6 +477,7 @@ FuncResult_e spiCom_SensorStart(void)
     uint16_t* misoWords;
     uint8_t* pktBytes;
 
+    spiDriver_BrokerBusEnter();
     COM_DEBUG_PRINT(comDebugFile, "** %s: devId = %0d\n", __FUNCTION__, spiDriver_SpiGetDev());
     clearDiagDetails();
 
@@ -498,6 +518,7 @@ FuncResult_e spiCom_SensorStart(void)
         res |= SPI_DRV_FUNC_RES_FAIL_COMM;
     }
 
+    spiDriver_BrokerBusLeave();
     return res;
 }
 
@@ -509,6 +530,7 @@ FuncResult_e spiCom_AcquSync(void)
     uint16_t* misoWords;
     uint8_t* pktBytes;
 
+    spiDriver_BrokerBusEnter();
     COM_DEBUG_PRINT(comDebugFile, "** %s: devId = %0d\n", __FUNCTION__, spiDriver_SpiGetDev());
     clearDiagDetails();
 
@@ -530,6 +552,7 @@ FuncResult_e spiCom_AcquSync(void)
         res |= SPI_DRV_FUNC_RES_FAIL_COMM;
     }
 
+    spiDriver_BrokerBusLeave();
     return res;
 }
 
@@ -541,6 +564,7 @@ FuncResult_e spiCom_Sync(void)
     uint16_t* misoWords;
     uint8_t* pktBytes;
 
+    spiDriver_BrokerBusEnter();
     COM_DEBUG_PRINT(comDebugFile, "** %s:     devId = %0d\n", __FUNCTION__, spiDriver_SpiGetDev());
     clearDiagDetails();
 
@@ -562,12 +586,23 @@ FuncResult_e spiCom_Sync(void)
         res |= SPI_DRV_FUNC_RES_FAIL_COMM;
     }
 
+    spiDriver_BrokerBusLeave();
     return res;
 }
 
 
 
 FuncResult_e spiCom_GetRaw(uint16_t layersAndSamples, uint16_t* trace, uint16_t* rawMetaData)
+{
+    return spiCom_GetRawWindow(layersAndSamples, layersAndSamples - 8u, 0xFFFFu, trace, rawMetaData);
+}
+
+
+FuncResult_e spiCom_GetRawWindow(uint16_t layersAndSamples,
+                                 uint16_t samplesToRead,
+                                 uint16_t channelsMask,
+                                 uint16_t* trace,
+                                 uint16_t* rawMetaData)
 {
     FuncResult_e res = SPI_DRV_FUNC_RES_OK;
     uint16_t wordSize;
@@ -577,19 +612,26 @@ FuncResult_e spiCom_GetRaw(uint16_t layersAndSamples, uint16_t* trace, uint16_t*
     uint16_t* misoWords;
     uint8_t* pktBytes;
 
+    spiDriver_BrokerBusEnter();
     COM_DEBUG_PRINT(comDebugFile,
-                    "** %s:   devId = %0d, wordSize = %0d\n",
+                    "** %s:   devId = %0d, wordSize = %0d, samples = %0d, mask = 0x%04x\n",
                     __FUNCTION__,
                     spiDriver_SpiGetDev(),
-                    layersAndSamples);
+                    layersAndSamples,
+                    samplesToRead,
+                    channelsMask);
 
     clearDiagDetails();
 
-    wordSize = layersAndSamples;
+    if (samplesToRead > (layersAndSamples - 8u)) {
+        samplesToRead = layersAndSamples - 8u;
+    }
     dptr = trace;
     mptr = rawMetaData;
 
     for (cc = 0; cc < 16; cc++ ) {                 /*  always loop over 16 channels (a "frame") */
+        /* the channel's transaction is kept to pop it from the IC, masked channel returns the metadata only */
+        wordSize = ((channelsMask & (1u << cc)) != 0u) ? (samplesToRead + 8u) : 8u;
         payload[0] = GET_RAW;
         payload[1] = 0;
         makeSpiPacket(FUNCTION, wordSize, 2, payload); /*  Make Packet 1, wordSize is for Packet 2, payload[1] is always 0 */
@@ -631,9 +673,12 @@ FuncResult_e spiCom_GetRaw(uint16_t layersAndSamples, uint16_t* trace, uint16_t*
         mptr += 8;
         /* then remainder is echo structure data */
         memcpy(dptr, &pktBytes[18], (wordSize - 8) * sizeof(uint16_t));
-        dptr += wordSize - 8;
+        /* samples not transferred are cleared */
+        memset(&dptr[wordSize - 8], 0, (layersAndSamples - wordSize) * sizeof(uint16_t));
+        dptr += layersAndSamples - 8;
     }
 
+    spiDriver_BrokerBusLeave();
     return res;
 }
 
@@ -648,6 +693,7 @@ FuncResult_e spiCom_GetEcho(uint16_t echoByte, uint16_t* EchoesData, uint16_t* e
     uint16_t* misoWords;
     uint8_t* pktBytes;
 
+    spiDriver_BrokerBusEnter();
     COM_DEBUG_PRINT(comDebugFile,
                     "** %s:  devId = %0d, wordSize = %0d\n",
                     __FUNCTION__,
@@ -701,6 +747,7 @@ FuncResult_e spiCom_GetEcho(uint16_t echoByte, uint16_t* EchoesData, uint16_t* e
     memcpy(dptr, &pktBytes[18], (wordSize - 8) * sizeof(uint16_t));
     dptr += wordSize - 8;
 
+    spiDriver_BrokerBusLeave();
     return res;
 }
 
@@ -712,6 +759,7 @@ FuncResult_e spiCom_SensorStop(void)
     uint16_t* misoWords;
     uint8_t* pktBytes;
 
+    spiDriver_BrokerBusEnter();
     COM_DEBUG_PRINT(comDebugFile, "** %s: devId = %0d\n", __FUNCTION__, spiDriver_SpiGetDev());
     clearDiagDetails();
 
@@ -733,6 +781,7 @@ FuncResult_e spiCom_SensorStop(void)
         res |= SPI_DRV_FUNC_RES_FAIL_COMM;
     }
 
+    spiDriver_BrokerBusLeave();
     return res;
 }
 
@@ -744,6 +793,7 @@ FuncResult_e spiCom_SensorStandby(void)
     uint16_t* misoWords;
     uint8_t* pktBytes;
 
+    spiDriver_BrokerBusEnter();
     COM_DEBUG_PRINT(comDebugFile, "** %s: devId = %0d\n", __FUNCTION__, spiDriver_SpiGetDev());
     clearDiagDetails();
 
@@ -765,6 +815,7 @@ FuncResult_e spiCom_SensorStandby(void)
         res |= SPI_DRV_FUNC_RES_FAIL_COMM;
     }
 
+    spiDriver_BrokerBusLeave();
     return res;
 }
 
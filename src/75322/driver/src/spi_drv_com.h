@@ -57,6 +57,8 @@ FuncResult_e spiCom_Init(const SpiComConfig_t* const comCfg);
 
 /** Calls platform-specific function to apply a reset sequence on a Host pin
  * which connects to the RST_B pin of all attached 75322 ASICs.
+ * The scene's parameters and programming cached by the driver are dropped, since
+ * the ICs' memory gets its default values back.
  *
  * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
  */
@@ -135,12 +137,32 @@ FuncResult_e spiCom_Sync(void);
  */
 FuncResult_e spiCom_GetRaw(uint16_t layersAndSamples, uint16_t* trace, uint16_t* rawMetaData);
 
+/** Gets 1 Frame (16 channels) of Raw Trace data, transferring only a part of it
+ * The packet 2 of each channel is shortened to the requested samples, so the tail of the trace is not clocked out.
+ * The masked channels are still requested (the IC sends the channels in order) with the metadata only.
+ * The data which is not transferred is set to zero, the output layout is the same as for ::spiCom_GetRaw
+ * @param[in]   layersAndSamples Size (in words) of each channel's Raw Trace data set, plus 8, set for the Layer
+ * @param[in]   samplesToRead    Amount of the first samples to transfer for every channel selected
+ * @param[in]   channelsMask     Bit per channel's transaction of the Frame to transfer the samples for
+ * @param[out]  trace            16 Raw Trace data sets of (layersAndSamples - 8) words each
+ * @param[out]  rawMetaData      16 Raw Metadata structures, one for each channel of the Frame. 8 x 16-bit words
+ * @retval  SPI_DRV_FUNC_RES_OK  Operation is successful
+ */
+FuncResult_e spiCom_GetRawWindow(uint16_t layersAndSamples,
+                                 uint16_t samplesToRead,
+                                 uint16_t channelsMask,
+                                 uint16_t* trace,
+                                 uint16_t* rawMetaData);
+
 /** Gets 1 Layer (30 channels) of Echoes and corresponding Metadata
  * @param[in]   echoByte         Indicates size (in words) of the payload of the 2nd packet of the transaction (ECHO_DATA_RESP), set according to the current Echo Format configuration.
  *                                   If Echo Format = FMT_ECHO_FAST,     SIZE = 1208 dec
  *                                   If Echo Format = FMT_ECHO_9P,       SIZE = 1208 dec
  *                                   If Echo Format = FMT_ECHO_SHORT,    SIZE =  368 dec
  *                                   If Echo Format = FMT_ECHO_DETAIL_1, SIZE = 1208 dec
+ *                               The size can't be shortened to read a part of the layer, the whole packet is always
+ *                               requested. A partial read (e.g. for the acquisition mask) is done by clearing the data
+ *                               after the transfer.
  * @param[out]  EchoesData       1 Layer of Echoes. maximum of 1200 x 16-bit words = 4 echo structures per channel with maximum echo struct size set (10 words per struct)
  * @param[out]  echoMetaData     1 Echo Metadata structure for the Layer. 8 x 16-bit words
  * @retval  SPI_DRV_FUNC_RES_OK  Operation is successful
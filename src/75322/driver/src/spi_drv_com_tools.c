@@ -27,10 +27,10 @@
 
 /* ---------------- Variables ---------------- */
 
-extern DiagDetailsPkt_t diagDetails[2];         /* Global Variable, can be accessed by high level driver */
+extern __thread DiagDetailsPkt_t diagDetails[2]; /* Per-thread variable, can be accessed by high level driver */
 extern const uint16_t crcTable [];
-extern uint16_t pktWords [MAX_PKT_WORDS];
-extern uint16_t payload [MAX_PKT_PAYLOAD_WORDS];
+extern __thread uint16_t pktWords [MAX_PKT_WORDS];
+extern __thread uint16_t payload [MAX_PKT_PAYLOAD_WORDS];
 
 /* ---------------- Functions ---------------- */
 
@@ -42,6 +42,7 @@ typedef enum {
     SPI_DRV_FUNC_RES_FAIL_INPUT_CFG,    /**< Negative result, Something is wrong with an input configuration (in input parameters) */
     SPI_DRV_FUNC_RES_FAIL_INPUT_DATA,   /**< Negative result, Something is wrong with an input data (while parsing/reading some extern/global variables */
     SPI_DRV_FUNC_RES_FAIL_COMM,         /**< Negative result, Something is wrong with low_level communication */
+    SPI_DRV_FUNC_RES_FAIL_BUSY,         /**< Negative result, the operation conflicts with one already running (continuous mode) */
     SPI_DRV_FUNC_RES_UNKNOWN = 127u,    /**< Something really unexpected */
 } FuncResult_e;
 
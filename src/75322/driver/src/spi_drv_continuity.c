@@ -0,0 +1,140 @@
+/**
+ * @file
+ * @brief Layer counter continuity tracker
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_continuity
+ */
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_sync_com.h"
+#include "spi_drv_continuity.h"
+
+/** Counter's differences from this value on are treated as going backwards */
+#define LAYER_COUNTER_BACKWARDS 0x8000u
+
+/** Tracker's state of a single IC */
+typedef struct {
+    bool known;                         /**< The previous layer's counter is known */
+    uint16_t counter;                   /**< Layer counter of the previous layer */
+    uint16_t lastSequence;              /**< Tags of the latest data record, assigned to the meta-only records */
+    uint8_t lastContinuity;             /**< Tags of the latest data record, assigned to the meta-only records */
+    spiDriver_ContinuityStats_t stats;  /**< Statistics */
+} ContinuityState_t;
+
+static ContinuityState_t continuityStatesInst[SPI_DRV_MAX_HANDLES][MAX_IC_ID_NUMBER];
+
+#define continuityStates (continuityStatesInst[SPI_DRV_INSTANCE])
+
+
+void spiDriver_ContinuityUpdate(spiDriver_ChipData_t* const chipData, const uint16_t icId)
+{
+    if (icId < MAX_IC_ID_NUMBER) {
+        ContinuityState_t* state = &continuityStates[icId];
+        if (chipData->dataFormat == CHIP_DATA_META_ONLY) {
+            chipData->sequence = state->lastSequence;
+            chipData->continuity = state->lastContinuity;
+        } else {
+            uint8_t continuity = CHIP_DATA_CONT_OK;
+            uint16_t sequence = state->counter + 1u;
+            if ((chipData->status != SPI_DRV_FUNC_RES_OK) || (chipData->metaData == NULL)) {
+                continuity = CHIP_DATA_CONT_FAILED;
+                state->stats.failed++;
+            } else {
+                const uint16_t counter = chipData->metaData->layer_counter;
+                const uint16_t diff = counter - state->counter;
+                sequence = counter;
+                if (!state->known) {
+                    continuity = CHIP_DATA_CONT_FIRST;
+                    state->counter = counter;
+                    state->known = true;
+                } else if ((diff == 0u) || (diff >= LAYER_COUNTER_BACKWARDS)) {
+                    continuity = CHIP_DATA_CONT_REPEAT;
+                    state->stats.repeated++;
+                } else {
+                    if (diff > 1u) {
+                        continuity = CHIP_DATA_CONT_DROP;
+                        state->stats.dropped += diff - 1u;
+                        state->stats.gaps++;
+                        TRACE_PRINT("IC %u: %u layers dropped before the layer counter %u\n", icId, diff - 1u, counter);
+                    }
+                    state->counter = counter;
+                }
+            }
+            state->stats.layers++;
+            state->lastSequence = sequence;
+            state->lastContinuity = continuity;
+            chipData->sequence = sequence;
+            chipData->continuity = continuity;
+        }
+    }
+}
+
+
+void spiDriver_ContinuityRestart(const uint16_t icId)
+{
+    for (uint16_t ic = 0u; ic < MAX_IC_ID_NUMBER; ic++) {
+        if ((icId == IC_ID_BROADCAST) || (icId == ic)) {
+            continuityStates[ic].known = false;
+        }
+    }
+}
+
+
+FuncResult_e spiDriver_GetContinuityStats(const uint16_t icId, spiDriver_ContinuityStats_t* const stats)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    if (icId < MAX_IC_ID_NUMBER) {
+        *stats = continuityStates[icId].stats;
+    } else if (icId == IC_ID_BROADCAST) {
+        memset(stats, 0, sizeof(*stats));
+        for (uint16_t ic = 0u; ic < MAX_IC_ID_NUMBER; ic++) {
+            stats->layers += continuityStates[ic].stats.layers;
+            stats->dropped += continuityStates[ic].stats.dropped;
+            stats->gaps += continuityStates[ic].stats.gaps;
+            stats->repeated += continuityStates[ic].stats.repeated;
+            stats->failed += continuityStates[ic].stats.failed;
+        }
+    } else {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+    }
+    return res;
+}
+
+
+void spiDriver_ResetContinuityStats(const uint16_t icId)
+{
+    for (uint16_t ic = 0u; ic < MAX_IC_ID_NUMBER; ic++) {
+        if ((icId == IC_ID_BROADCAST) || (icId == ic)) {
+            memset(&continuityStates[ic], 0, sizeof(continuityStates[ic]));
+        }
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
@@ -0,0 +1,97 @@
+/**
+ * @file
+ * @brief Layer counter continuity tracker
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_continuity Layer counter continuity tracker
+ * @ingroup spi_trace
+ *
+ * @details
+ *
+ * The IC increments ::Metadata_t.layer_counter for every layer acquired. The tracker follows the counter per IC
+ * in the acquisition path and tags each ::spiDriver_ChipData_t with the layer's sequence number and continuity
+ * flags (see ::ChipDataContinuity_e), so the layers dropped (e.g. when the data is read too late in continuous mode)
+ * or received twice are detected.
+ *
+ * The counter's difference to the previous layer of the same IC is treated as follows:
+ * - 1 - the layer follows the previous one;
+ * - 0 or negative (in 16-bit modulo arithmetic) - the layer is repeated;
+ * - greater than 1 - the layers in between are dropped.
+ *
+ * The layers with failed communication (CRC or other errors) don't update the tracker, since their metadata can't be
+ * trusted. The tracking is restarted on each sensor's start, keeping the statistics.
+ *
+ * The statistics are plain counters updated by the acquisition thread, so these can be read while the stream runs.
+ */
+
+#ifndef SPI_DRV_CONTINUITY_H
+#define SPI_DRV_CONTINUITY_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+
+/** Statistics of the layer counter's continuity */
+typedef struct {
+    uint32_t layers;        /**< Layers tracked */
+    uint32_t dropped;       /**< Layers dropped, counted by the gaps in layer counter */
+    uint32_t gaps;          /**< Gaps detected. One gap may drop several layers */
+    uint32_t repeated;      /**< Layers repeated */
+    uint32_t failed;        /**< Layers with CRC or communication failed */
+} spiDriver_ContinuityStats_t;
+
+
+/** Tags the chip-data record and updates the IC's tracker
+ * Called by the acquisition for each record appended. The ::CHIP_DATA_META_ONLY records get the tags of the
+ * layer's data record preceding them and are not counted.
+ * @param[in,out]   chipData    record to check and tag
+ * @param[in]       icId        IC's ID the record is read from
+ */
+void spiDriver_ContinuityUpdate(spiDriver_ChipData_t* const chipData, const uint16_t icId);
+
+
+/** Restarts the tracking, so the next layer is not compared with the previous one. The statistics are kept
+ * @param[in]   icId    IC's ID. ::IC_ID_BROADCAST restarts all ICs
+ */
+void spiDriver_ContinuityRestart(const uint16_t icId);
+
+
+/** Gets the continuity statistics
+ * @param[in]   icId    IC's ID. ::IC_ID_BROADCAST returns the sum for all ICs
+ * @param[out]  stats   statistics' output
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     IC's ID is out of range
+ */
+FuncResult_e spiDriver_GetContinuityStats(const uint16_t icId, spiDriver_ContinuityStats_t* const stats);
+
+
+/** Resets the continuity statistics and restarts the tracking
+ * @param[in]   icId    IC's ID. ::IC_ID_BROADCAST resets all ICs
+ */
+void spiDriver_ResetContinuityStats(const uint16_t icId);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* SPI_DRV_CONTINUITY_H */
@@ -28,10 +28,13 @@
 #include "spi_drv_data.h"
 #include "regmap_tools.h"
 #include "hash_lib.h"
+#include "spi_drv_instance_priv.h"
 
-FwFieldInfo_t* fwFields = NULL;
-static uint16_t* fwNameIdx;
-uint16_t fwFieldsCount = 0u;
+FwFieldInfo_t* fwFieldsInst[SPI_DRV_MAX_HANDLES];
+static uint16_t* fwNameIdxInst[SPI_DRV_MAX_HANDLES];
+uint16_t fwFieldsCountInst[SPI_DRV_MAX_HANDLES];
+
+#define fwNameIdx (fwNameIdxInst[SPI_DRV_INSTANCE])
 
 /* Local functions declaration, to handle the input data parsing */
 static int DumpFwJson(const char* js, jsmntok_t* t, size_t count, int indent);
@@ -41,6 +44,19 @@ FuncResult_e ReadFwJson(const char* const f_name)
     return ReadJson(f_name, DumpFwJson);
 }
 
+
+void FreeFwJson(void)
+{
+    for (uint16_t ind = 0u; ind < fwFieldsCount; ind++) {
+        free(fwFields[ind].bitFields);
+    }
+    free(fwFields);
+    free(fwNameIdx);
+    fwFields = NULL;
+    fwNameIdx = NULL;
+    fwFieldsCount = 0u;
+}
+
 static void parseFwInfoBitField(FwFieldInfo_t* field, const char* js, jsmntok_t* info)
 {
     strncpy(field->fldName, js + info[0].start, int_min(MAX_FLD_NAME, info[0].end - info[0].start));
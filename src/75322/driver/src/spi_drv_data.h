@@ -36,6 +36,7 @@ extern "C"
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "spi_drv_instance.h"
 
 /** MAX_FLD_NAME specifies the buffer's size for holding the field's name in a structure */
 #define MAX_FLD_NAME 64
@@ -62,15 +63,15 @@ typedef struct FwFieldInfo_s {
     struct FwFieldInfo_s* bitFields;       /**< bit-fields included into the field */
 } FwFieldInfo_t;
 
-extern FwFieldInfo_t* fwFields;
-extern uint16_t fwFieldsCount;
-
 /** Allocates an instance of fwFields[] array and reads the FW fields from a file specified by "f_name"
  * @param[in]   f_name      Database's file name
  * @return      result of an operation
  */
 FuncResult_e ReadFwJson(const char* const f_name);
 
+/** Releases the fwFields[] array read by ReadFwJson() */
+void FreeFwJson(void);
+
 /** Returns the FW variable by its name
  * @param[in]   var_name        Variable's name
  * @return      a pointer to a FW variable's structure. Returns NULL if variable was not found
@@ -0,0 +1,309 @@
+/**
+ * @file
+ * @brief Columnar echo data decoder
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_echo_decode
+ */
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_data.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_sync_com.h"
+#include "spi_drv_echo_decode.h"
+
+/** Flags value assigned to the objects of formats without flags */
+#define ECHO_FLAGS_VALID 0x0001u
+
+/** Echo formats in order of the size */
+static const EchoFormatSize_e echoFormatsBySize[] = {
+    FMT_ECHO_SHORT,
+    FMT_ECHO_DETAIL,
+    FMT_ECHO_FAST,
+    FMT_ECHO_9P,
+};
+
+
+/** Stores the object into the columns at position `pos`
+ * The object is always written, and the returned position is advanced only for the objects to be kept. Thus, the
+ * compaction has no branches in the loop.
+ */
+static inline uint16_t spiDriver_EchoColumnsPut(spiDriver_EchoColumns_t* const columns,
+                                                uint16_t pos,
+                                                const uint16_t ch,
+                                                const uint16_t obj,
+                                                const uint16_t distance,
+                                                const uint16_t amplitude,
+                                                const uint16_t flags,
+                                                const bool validOnly)
+{
+    columns->distance[pos] = distance;
+    columns->amplitude[pos] = amplitude;
+    columns->flags[pos] = flags;
+    columns->channel[pos] = (uint8_t)ch;
+    columns->object[pos] = (uint8_t)obj;
+    return pos + ((!validOnly) || ((flags & ECHO_FLAGS_VALID) != 0u));
+}
+
+
+static uint16_t spiDriver_DecodeFast(const EchoFastData_t* const echo,
+                                     const bool validOnly,
+                                     spiDriver_EchoColumns_t* const columns)
+{
+    uint16_t pos = 0u;
+    for (uint16_t ch = 0u; ch < ECHO_NUM_CHANNEL; ch++) {
+        for (uint16_t obj = 0u; obj < ECHO_NUM_OBJS; obj++) {
+            const EchoFastDataItem_t* item = &(*echo)[ch][obj];
+            columns->inflectionRise[pos] = item->maxSLi;
+            columns->inflectionFall[pos] = item->maxSRi;
+            pos = spiDriver_EchoColumnsPut(columns, pos, ch, obj, item->maxi, item->max,
+                                           (item->max != 0u) ? ECHO_FLAGS_VALID : 0u, validOnly);
+        }
+    }
+    return pos;
+}
+
+
+static uint16_t spiDriver_Decode9P(const Echo9PData_t* const echo,
+                                   const bool validOnly,
+                                   spiDriver_EchoColumns_t* const columns)
+{
+    uint16_t pos = 0u;
+    for (uint16_t ch = 0u; ch < ECHO_NUM_CHANNEL; ch++) {
+        for (uint16_t obj = 0u; obj < ECHO_NUM_OBJS; obj++) {
+            const Echo9PDataItem_t* item = &(*echo)[ch][obj];
+            uint16_t maxPos = 0u;
+            uint16_t maxValue = item->data[0u];
+            columns->samplesStart[pos] = item->index;
+            memcpy(columns->samples[pos], item->data, sizeof(item->data));
+            for (uint16_t ind = 1u; ind < ECHO_9P_SAMPLES; ind++) {
+                if (item->data[ind] > maxValue) {
+                    maxValue = item->data[ind];
+                    maxPos = ind;
+                }
+            }
+            pos = spiDriver_EchoColumnsPut(columns, pos, ch, obj, item->index + maxPos, maxValue,
+                                           (maxValue != 0u) ? ECHO_FLAGS_VALID : 0u, validOnly);
+        }
+    }
+    return pos;
+}
+
+
+static uint16_t spiDriver_DecodeShort(const EchoShortData_t* const echo,
+                                      const bool validOnly,
+                                      spiDriver_EchoColumns_t* const columns)
+{
+    uint16_t pos = 0u;
+    for (uint16_t ch = 0u; ch < ECHO_NUM_CHANNEL; ch++) {
+        for (uint16_t obj = 0u; obj < ECHO_NUM_OBJS; obj++) {
+            const EchoShortDataItem_t* item = &(*echo)[ch][obj];
+            pos = spiDriver_EchoColumnsPut(columns, pos, ch, obj, item->distance, item->amplitude, item->flags,
+                                           validOnly);
+        }
+    }
+    return pos;
+}
+
+
+static uint16_t spiDriver_DecodeDetail(const EchoDetailData_t* const echo,
+                                       const bool validOnly,
+                                       spiDriver_EchoColumns_t* const columns)
+{
+    uint16_t pos = 0u;
+    for (uint16_t ch = 0u; ch < ECHO_NUM_CHANNEL; ch++) {
+        for (uint16_t obj = 0u; obj < ECHO_NUM_OBJS; obj++) {
+            const EchoDetailDataItem_t* item = &(*echo)[ch][obj];
+            columns->inflectionRise[pos] = item->inflection;
+            columns->inflectionFall[pos] = item->infl_fall;
+            pos = spiDriver_EchoColumnsPut(columns, pos, ch, obj, item->distance, item->amplitude,
+                                           item->flags.all_flags, validOnly);
+        }
+    }
+    return pos;
+}
+
+
+FuncResult_e spiDriver_EchoArenaInit(spiDriver_EchoArena_t* const arena, const uint16_t capacity)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    arena->layers = malloc(sizeof(spiDriver_EchoColumns_t) * capacity);
+    arena->count = 0u;
+    if (arena->layers != NULL) {
+        arena->capacity = capacity;
+    } else {
+        arena->capacity = 0u;
+        res = SPI_DRV_FUNC_RES_FAIL_MEMORY;
+    }
+    return res;
+}
+
+
+void spiDriver_EchoArenaFree(spiDriver_EchoArena_t* const arena)
+{
+    free(arena->layers);
+    arena->layers = NULL;
+    arena->capacity = 0u;
+    arena->count = 0u;
+}
+
+
+FuncResult_e spiDriver_DecodeEchoLayer(const ChannelEchoAll_t* const echo,
+                                       const EchoFormatSize_e format,
+                                       const bool validOnly,
+                                       spiDriver_EchoColumns_t* const columns)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    switch (format) {
+        case FMT_ECHO_FAST:
+            columns->count = spiDriver_DecodeFast(EchoParseAsFast(echo), validOnly, columns);
+            break;
+
+        case FMT_ECHO_9P:
+            columns->count = spiDriver_Decode9P(EchoParseAs9P(echo), validOnly, columns);
+            break;
+
+        case FMT_ECHO_SHORT:
+            columns->count = spiDriver_DecodeShort(EchoParseAsShort(echo), validOnly, columns);
+            break;
+
+        case FMT_ECHO_DETAIL:
+            columns->count = spiDriver_DecodeDetail(EchoParseAsDetail(echo), validOnly, columns);
+            break;
+
+        default:
+            columns->count = 0u;
+            res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+            break;
+    }
+    columns->format = format;
+    columns->distUnit = spiDriver_EchoFormatDistUnit(format);
+    columns->fields = spiDriver_EchoFormatFields(format);
+    return res;
+}
+
+
+FuncResult_e spiDriver_DecodeEchoScene(const spiDriver_ChipData_t* const chipData,
+                                       const uint16_t chipDataSize,
+                                       const bool validOnly,
+                                       spiDriver_EchoArena_t* const arena)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    arena->count = 0u;
+    for (uint16_t ind = 0u; ind < chipDataSize; ind++) {
+        const spiDriver_ChipData_t* item = &chipData[ind];
+        if ((item->dataFormat <= CHIP_DATA_DETAIL) && (item->data != NULL)) {
+            if (arena->count < arena->capacity) {
+                spiDriver_EchoColumns_t* columns = &arena->layers[arena->count];
+                res |= spiDriver_DecodeEchoLayer(&item->data->echo, (EchoFormatSize_e)item->dataFormat, validOnly,
+                                                 columns);
+                columns->chip_id = item->chip_id;
+                columns->layer = (item->metaData != NULL) ? item->metaData->layer : 0u;
+                arena->count++;
+            } else {
+                res |= SPI_DRV_FUNC_RES_FAIL_MEMORY;
+            }
+        }
+    }
+    return res;
+}
+
+
+
+EchoDistUnit_e spiDriver_EchoFormatDistUnit(const EchoFormatSize_e format)
+{
+    return ((format == FMT_ECHO_FAST) || (format == FMT_ECHO_9P)) ? ECHO_DIST_UNIT_SAMPLES :
+           ECHO_DIST_UNIT_DIST_FORMAT;
+}
+
+
+uint16_t spiDriver_EchoFormatFields(const EchoFormatSize_e format)
+{
+    uint16_t fields = 0u;
+    switch (format) {
+        case FMT_ECHO_FAST:
+            fields = ECHO_FIELD_PEAK_INDEX | ECHO_FIELD_AMPLITUDE | ECHO_FIELD_INFLECTIONS;
+            break;
+
+        case FMT_ECHO_9P:
+            fields = ECHO_FIELD_PEAK_INDEX | ECHO_FIELD_AMPLITUDE | ECHO_FIELD_SAMPLES_9P;
+            break;
+
+        case FMT_ECHO_SHORT:
+            fields = ECHO_FIELD_DISTANCE | ECHO_FIELD_AMPLITUDE | ECHO_FIELD_FLAGS;
+            break;
+
+        case FMT_ECHO_DETAIL:
+            fields = ECHO_FIELD_DISTANCE | ECHO_FIELD_AMPLITUDE | ECHO_FIELD_FLAGS | ECHO_FIELD_INFLECTIONS;
+            break;
+
+        default:
+            break;
+    }
+    return fields;
+}
+
+
+FuncResult_e spiDriver_SelectEchoFormat(const uint16_t fields, EchoFormatSize_e* const format)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+    for (uint16_t ind = 0u; (ind < (sizeof(echoFormatsBySize) / sizeof(echoFormatsBySize[0]))) &&
+         (res != SPI_DRV_FUNC_RES_OK); ind++) {
+        if ((spiDriver_EchoFormatFields(echoFormatsBySize[ind]) & fields) == fields) {
+            *format = echoFormatsBySize[ind];
+            res = SPI_DRV_FUNC_RES_OK;
+        }
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_SetEchoFields(const uint16_t icId,
+                                     const uint16_t layerId,
+                                     const uint16_t fields,
+                                     EchoFormatSize_e* const format)
+{
+    FuncResult_e res;
+    EchoFormatSize_e selected = FMT_ECHO_DETAIL;
+    char name[MAX_FLD_NAME];
+
+    res = spiDriver_SelectEchoFormat(fields, &selected);
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        TRACE_PRINT("Layer %u fields 0x%02x, echo format: %u\n", layerId, fields, selected);
+        sprintf(name, "layer_%u_echo_format", layerId);
+        res = spiDriver_SetMultiByName(icId, name, (uint32_t)selected, NULL);
+        if (format != NULL) {
+            *format = selected;
+        }
+    }
+    return res;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
@@ -0,0 +1,215 @@
+/**
+ * @file
+ * @brief Columnar echo data decoder
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_echo_decode Columnar echo decoder
+ * @ingroup spi_trace
+ *
+ * @details
+ *
+ * Echo data is received from IC as an array of structures (see ::ChannelEchoAll_t), which format depends on the layer's
+ * echo format. This component decodes the echo layer of any format into the set of columns (structure of arrays), so
+ * all distances, amplitudes etc. of a layer are placed sequentially in memory.
+ *
+ * The columns are filled-in as follows:
+ *
+ * | Format            | distance                      | unit       | amplitude         | flags                         |
+ * |-------------------|-------------------------------|------------|-------------------|-------------------------------|
+ * | ::FMT_ECHO_FAST   | maxi                          | samples    | max               | valid, when max is not zero   |
+ * | ::FMT_ECHO_9P     | index + position of maximum   | samples    | maximum of data[] | valid, when maximum not zero  |
+ * | ::FMT_ECHO_SHORT  | distance                      | DistFormat | amplitude         | flags                         |
+ * | ::FMT_ECHO_DETAIL | distance                      | DistFormat | amplitude         | flags                         |
+ *
+ * The distance column's unit is kept in ::spiDriver_EchoColumns_t.distUnit. The formats reporting the peak's sample
+ * index provide ::ECHO_FIELD_PEAK_INDEX instead of ::ECHO_FIELD_DISTANCE, so the format selected for the fields
+ * requested always reports the distance in the same unit.
+ *
+ * The optional columns are filled-in when the format provides them, see ::spiDriver_EchoColumns_t.fields:
+ *
+ * | Format            | inflections                   | samples           |
+ * |-------------------|-------------------------------|-------------------|
+ * | ::FMT_ECHO_FAST   | maxSLi, maxSRi                | -                 |
+ * | ::FMT_ECHO_9P     | -                             | index, data[]     |
+ * | ::FMT_ECHO_SHORT  | -                             | -                 |
+ * | ::FMT_ECHO_DETAIL | inflection, infl_fall         | -                 |
+ *
+ * In the compaction mode only the objects with ::EchoFlags.valid set are placed into the columns.
+ *
+ * The application may declare the echo fields it consumes (see ::EchoField_e) by ::spiDriver_SetEchoFields, which
+ * programs the layer with the smallest echo format providing them. The formats' sizes are:
+ * ::FMT_ECHO_SHORT - 360 words, ::FMT_ECHO_FAST, ::FMT_ECHO_9P and ::FMT_ECHO_DETAIL - 1200 words of echoes per layer.
+ *
+ * The decoded layers are stored into the arena, allocated once (see ::spiDriver_EchoArenaInit) and re-used for each
+ * scene, so the decoding doesn't allocate the memory.
+ */
+
+#ifndef SPI_DRV_ECHO_DECODE_H
+#define SPI_DRV_ECHO_DECODE_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+
+/** Maximum amount of objects in one echo layer */
+#define ECHO_LAYER_OBJS_MAX (ECHO_NUM_CHANNEL * ECHO_NUM_OBJS)
+
+/** Amount of amplitudes of ::FMT_ECHO_9P object */
+#define ECHO_9P_SAMPLES 9u
+
+/** Echo fields consumed by the application. Used as bit-mask */
+typedef enum {
+    ECHO_FIELD_DISTANCE = 0x01u,        /**< Object's distance computed by IC (DistFormat) */
+    ECHO_FIELD_AMPLITUDE = 0x02u,       /**< Object's amplitude */
+    ECHO_FIELD_FLAGS = 0x04u,           /**< Object's flags, reported by IC */
+    ECHO_FIELD_INFLECTIONS = 0x08u,     /**< Rising and falling edges' inflection points */
+    ECHO_FIELD_SAMPLES_9P = 0x10u,      /**< Nine amplitudes around the object */
+    ECHO_FIELD_PEAK_INDEX = 0x20u,      /**< Sample index of the object's peak, reported in the distance column */
+} EchoField_e;
+
+/** Unit of the decoded distance column */
+typedef enum {
+    ECHO_DIST_UNIT_DIST_FORMAT = 0u,    /**< Distance computed by IC according to DISTANCE_METHOD (DistFormat) */
+    ECHO_DIST_UNIT_SAMPLES,             /**< Sample index of the peak, the same as the trace's samples */
+} EchoDistUnit_e;
+
+/** Columns of a single decoded echo layer. Only the first `count` items of each column are valid */
+typedef struct {
+    uint16_t distance[ECHO_LAYER_OBJS_MAX];     /**< Object's distance, in spiDriver_EchoColumns_t::distUnit */
+    uint16_t amplitude[ECHO_LAYER_OBJS_MAX];    /**< Object's amplitude */
+    uint16_t flags[ECHO_LAYER_OBJS_MAX];        /**< Object's flags. See ::EchoFlags */
+    uint16_t inflectionRise[ECHO_LAYER_OBJS_MAX];   /**< Rising edge inflection point. ::ECHO_FIELD_INFLECTIONS */
+    uint16_t inflectionFall[ECHO_LAYER_OBJS_MAX];   /**< Falling edge inflection point. ::ECHO_FIELD_INFLECTIONS */
+    uint16_t samplesStart[ECHO_LAYER_OBJS_MAX];     /**< Position of the first amplitude. ::ECHO_FIELD_SAMPLES_9P */
+    uint16_t samples[ECHO_LAYER_OBJS_MAX][ECHO_9P_SAMPLES]; /**< Amplitudes around the object. ::ECHO_FIELD_SAMPLES_9P */
+    uint8_t channel[ECHO_LAYER_OBJS_MAX];       /**< Channel of the object */
+    uint8_t object[ECHO_LAYER_OBJS_MAX];        /**< Object's index in the channel */
+    uint16_t count;                             /**< Amount of objects in columns */
+    uint16_t fields;                            /**< Columns filled-in, bit-mask of ::EchoField_e */
+    uint16_t chip_id;                           /**< The chip ID of the layer */
+    uint8_t layer;                              /**< Layer record, taken from metadata */
+    EchoFormatSize_e format;                    /**< Echo format the layer was decoded from */
+    EchoDistUnit_e distUnit;                    /**< Unit of the distance column, given by the format */
+} spiDriver_EchoColumns_t;
+
+/** Pre-allocated storage of the decoded echo layers for one scene */
+typedef struct {
+    spiDriver_EchoColumns_t* layers;    /**< Decoded layers */
+    uint16_t capacity;                  /**< Amount of layers allocated */
+    uint16_t count;                     /**< Amount of layers decoded */
+} spiDriver_EchoArena_t;
+
+
+/** Allocates the arena for the desired amount of layers
+ * @param[out]  arena       arena to initialize
+ * @param[in]   capacity    maximum amount of echo layers in scene
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_MEMORY        memory allocation failed
+ */
+FuncResult_e spiDriver_EchoArenaInit(spiDriver_EchoArena_t* const arena, const uint16_t capacity);
+
+
+/** Frees the memory allocated for the arena
+ * @param[in,out]   arena   arena to release
+ */
+void spiDriver_EchoArenaFree(spiDriver_EchoArena_t* const arena);
+
+
+/** Decodes a single echo layer into the columns
+ * @param[in]   echo        echo data of the layer
+ * @param[in]   format      echo format of the data
+ * @param[in]   validOnly   set to place only the valid objects into the columns
+ * @param[out]  columns     columns to fill-in
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    unknown echo format
+ */
+FuncResult_e spiDriver_DecodeEchoLayer(const ChannelEchoAll_t* const echo,
+                                       const EchoFormatSize_e format,
+                                       const bool validOnly,
+                                       spiDriver_EchoColumns_t* const columns);
+
+
+/** Decodes all echo layers of the scene into the arena. The records of other formats are skipped.
+ * @param[in]   chipData        chip-data array of the scene
+ * @param[in]   chipDataSize    items count in `chipData` array
+ * @param[in]   validOnly       set to place only the valid objects into the columns
+ * @param[in,out]   arena       arena to store the layers. Previous content is replaced
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_MEMORY        the arena has not enough capacity, the layers which fit are decoded
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    unknown echo format
+ */
+FuncResult_e spiDriver_DecodeEchoScene(const spiDriver_ChipData_t* const chipData,
+                                       const uint16_t chipDataSize,
+                                       const bool validOnly,
+                                       spiDriver_EchoArena_t* const arena);
+
+
+
+/** Returns the unit of the distance column decoded from the format
+ * @param[in]   format      echo format
+ * @return      distance's unit
+ */
+EchoDistUnit_e spiDriver_EchoFormatDistUnit(const EchoFormatSize_e format);
+
+
+/** Returns the echo fields provided by the format
+ * The amplitude is provided by all formats. ::FMT_ECHO_SHORT and ::FMT_ECHO_DETAIL provide the distance computed by IC,
+ * ::FMT_ECHO_FAST and ::FMT_ECHO_9P provide the peak's sample index instead.
+ * @param[in]   format      echo format
+ * @return      bit-mask of ::EchoField_e. Zero for the unknown format
+ */
+uint16_t spiDriver_EchoFormatFields(const EchoFormatSize_e format);
+
+
+/** Selects the smallest echo format providing all the fields requested
+ * ::ECHO_FIELD_DISTANCE selects the formats with the distance computed by IC only, ::ECHO_FIELD_PEAK_INDEX - the
+ * formats with the peak's sample index only, so the distance column's unit follows the fields requested.
+ * @param[in]   fields      bit-mask of ::EchoField_e consumed by the application
+ * @param[out]  format      echo format selected
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     no format provides all the fields (e.g. flags and 9-point samples)
+ */
+FuncResult_e spiDriver_SelectEchoFormat(const uint16_t fields, EchoFormatSize_e* const format);
+
+
+/** Programs the layer's echo format to the smallest one, providing the fields requested
+ * Writes `layer_N_echo_format` only, the scene's parameters are re-read by the next capture.
+ * @param[in]   icId        IC's identifier, ::IC_ID_BROADCAST programs all ICs
+ * @param[in]   layerId     layer's ID
+ * @param[in]   fields      bit-mask of ::EchoField_e consumed by the application
+ * @param[out]  format      echo format programmed. Can be NULL
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     no format provides all the fields
+ * @retval  SPI_DRV_FUNC_RES_FAIL               Low-level communication operation had failed
+ */
+FuncResult_e spiDriver_SetEchoFields(const uint16_t icId,
+                                     const uint16_t layerId,
+                                     const uint16_t fields,
+                                     EchoFormatSize_e* const format);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* SPI_DRV_ECHO_DECODE_H */
@@ -0,0 +1,306 @@
+/**
+ * @file
+ * @brief Host-side echo extraction from raw traces
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_echo_extract
+ */
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_echo_extract.h"
+
+#define EXTRACT_BASELINE_SAMPLES 16u    /**< Default amount of samples for the baseline estimation */
+#define EXTRACT_MIN_WIDTH 2u            /**< Default minimum echo width */
+
+/** Work of a single thread in the scene extraction */
+typedef struct {
+    const spiDriver_EchoExtractCfg_t* cfg;      /**< Extraction settings */
+    const spiDriver_ChipData_t* chipData;       /**< Chip-data array of the scene */
+    uint16_t chipDataSize;                      /**< Items count in chipData */
+    EchoDetailData_t* echoes;                   /**< Output array */
+    uint16_t first;                             /**< First record handled by the thread */
+    uint16_t step;                              /**< Step between the records handled by the thread */
+    FuncResult_e res;                           /**< Result of the thread's work */
+} ExtractWork_t;
+
+
+/** Finds the echoes in a single channel's trace */
+static void spiDriver_ExtractChannel(const spiDriver_EchoExtractCfg_t* const cfg,
+                                     const uint16_t* const samples,
+                                     const uint16_t nSamples,
+                                     EchoDetailDataItem_t* const objs)
+{
+    uint8_t above[MAX_SAMPLES_N];
+    uint32_t sum = 0u;
+    uint16_t baseline;
+    uint32_t threshold;
+    uint16_t obj = 0u;
+    uint16_t ind = 0u;
+    uint16_t prevStop = 0u;
+
+    memset(objs, 0, sizeof(EchoDetailDataObject_t));
+    for (uint16_t s = 0u; s < cfg->baselineSamples; s++) {
+        sum += samples[s];
+    }
+    baseline = (uint16_t)(sum / cfg->baselineSamples);
+    threshold = (uint32_t)baseline + cfg->echoThreshold;
+    for (uint16_t s = 0u; s < nSamples; s++) {
+        above[s] = (samples[s] > threshold);
+    }
+
+    while ((ind < nSamples) && (obj < ECHO_NUM_OBJS)) {
+        if (above[ind]) {
+            EchoDetailDataItem_t* item = &objs[obj];
+            uint16_t begin = ind;
+            uint16_t end;
+            uint16_t peak = ind;
+            uint16_t start = ind;
+            uint16_t stop;
+            uint16_t maximums = 0u;
+            int32_t slope;
+            int32_t riseSlope = 0;
+            int32_t fallSlope = 0;
+
+            while ((ind < nSamples) && above[ind]) {
+                ind++;
+            }
+            end = ind - 1u;
+            for (uint16_t k = begin; k <= end; k++) {
+                if (samples[k] > samples[peak]) {
+                    peak = k;
+                }
+                if ((k > begin) && (k < end) && (samples[k] > samples[k - 1u]) && (samples[k] >= samples[k + 1u])) {
+                    maximums++;
+                }
+            }
+            /* Walk down to the local minimums around the region */
+            while ((start > prevStop) && (samples[start - 1u] < samples[start])) {
+                start--;
+            }
+            stop = end;
+            while (((stop + 1u) < nSamples) && (samples[stop + 1u] < samples[stop])) {
+                stop++;
+            }
+
+            item->start_i = start;
+            item->baseline = samples[start];
+            item->peak = peak;
+            item->amplitude = samples[peak];
+            item->stop_i = stop;
+            item->baseline_fall = samples[stop];
+            item->inflection = start;
+            item->infl_fall = stop;
+            for (uint16_t k = start; k < peak; k++) {
+                slope = (int32_t)samples[k + 1u] - samples[k];
+                if (slope > riseSlope) {
+                    riseSlope = slope;
+                    item->inflection = k;
+                }
+            }
+            for (uint16_t k = peak; k < stop; k++) {
+                slope = (int32_t)samples[k + 1u] - samples[k];
+                if (slope < fallSlope) {
+                    fallSlope = slope;
+                    item->infl_fall = k + 1u;
+                }
+            }
+            item->distance = peak;
+
+            item->flags.valid = 1u;
+            item->flags.low_amplitude = ((uint32_t)(samples[peak] - baseline) < cfg->lowAmplitude);
+            item->flags.issue_width = ((uint16_t)(end - begin + 1u) < cfg->minWidth);
+            item->flags.saturated = (cfg->saturationLevel != 0u) && (samples[peak] >= cfg->saturationLevel);
+            item->flags.merge_suspicion = (maximums > 1u);
+            item->flags.undershoot = (((int32_t)samples[stop] + cfg->echoThreshold) < baseline);
+
+            obj++;
+            prevStop = stop;
+            if (ind <= stop) {
+                ind = stop + 1u;
+            }
+        } else {
+            ind++;
+        }
+    }
+}
+
+
+void spiDriver_EchoExtractCfgInit(spiDriver_EchoExtractCfg_t* const cfg, const spiDriver_LayerConfig_t* const layerCfg)
+{
+    const spiDriver_LayerConfig_t* layer = (layerCfg != NULL) ? layerCfg : &spiDriver_DefaultLayerConfig;
+    cfg->echoThreshold = layer->echoThreshold;
+    cfg->baselineSamples = EXTRACT_BASELINE_SAMPLES;
+    cfg->saturationLevel = 0u;
+    cfg->minWidth = EXTRACT_MIN_WIDTH;
+    cfg->lowAmplitude = 2u * layer->echoThreshold;
+    cfg->channelOffset = 0u;
+}
+
+
+FuncResult_e spiDriver_ExtractEchoLayer(const spiDriver_EchoExtractCfg_t* const cfg,
+                                        const uint16_t* const trace,
+                                        const uint16_t nSamples,
+                                        EchoDetailData_t* const echo)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    if ((nSamples == 0u) || (nSamples > MAX_SAMPLES_N)) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+    } else if ((cfg->baselineSamples == 0u) || (cfg->baselineSamples > nSamples) ||
+               ((cfg->channelOffset + ECHO_NUM_CHANNEL) > N_CHANNELS)) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+    } else {
+        for (uint16_t ch = 0u; ch < ECHO_NUM_CHANNEL; ch++) {
+            spiDriver_ExtractChannel(cfg,
+                                     &trace[(uint32_t)(ch + cfg->channelOffset) * nSamples],
+                                     nSamples,
+                                     (*echo)[ch]);
+        }
+    }
+    return res;
+}
+
+
+static void* spiDriver_ExtractWorker(void* arg)
+{
+    ExtractWork_t* work = (ExtractWork_t*)arg;
+    work->res = SPI_DRV_FUNC_RES_OK;
+    for (uint16_t ind = work->first; ind < work->chipDataSize; ind += work->step) {
+        const spiDriver_ChipData_t* item = &work->chipData[ind];
+        if ((item->dataFormat == CHIP_DATA_TRACE) && (item->data != NULL)) {
+            work->res |= spiDriver_ExtractEchoLayer(work->cfg, item->data->trace, item->samples, &work->echoes[ind]);
+        } else {
+            memset(&work->echoes[ind], 0, sizeof(EchoDetailData_t));
+        }
+    }
+    return NULL;
+}
+
+
+FuncResult_e spiDriver_ExtractEchoScene(const spiDriver_EchoExtractCfg_t* const cfg,
+                                        const spiDriver_ChipData_t* const chipData,
+                                        const uint16_t chipDataSize,
+                                        EchoDetailData_t* const echoes,
+                                        const uint16_t nThreads)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    uint16_t threads = (nThreads > 1u) ? nThreads : 1u;
+    ExtractWork_t* work;
+    pthread_t* tid;
+    bool* started;
+
+    if (threads > chipDataSize) {
+        threads = (chipDataSize > 0u) ? chipDataSize : 1u;
+    }
+    work = malloc(sizeof(ExtractWork_t) * threads);
+    tid = malloc(sizeof(pthread_t) * threads);
+    started = malloc(sizeof(bool) * threads);
+    if ((work == NULL) || (tid == NULL) || (started == NULL)) {
+        res = SPI_DRV_FUNC_RES_FAIL_MEMORY;
+    } else {
+        for (uint16_t t = 0u; t < threads; t++) {
+            work[t].cfg = cfg;
+            work[t].chipData = chipData;
+            work[t].chipDataSize = chipDataSize;
+            work[t].echoes = echoes;
+            work[t].first = t;
+            work[t].step = threads;
+            /* The first part is handled by the caller's thread */
+            started[t] = (t > 0u) && (pthread_create(&tid[t], NULL, spiDriver_ExtractWorker, &work[t]) == 0);
+        }
+        for (uint16_t t = 0u; t < threads; t++) {
+            if (!started[t]) {
+                spiDriver_ExtractWorker(&work[t]);
+            }
+        }
+        for (uint16_t t = 0u; t < threads; t++) {
+            if (started[t]) {
+                pthread_join(tid[t], NULL);
+            }
+            res |= work[t].res;
+        }
+    }
+    free(work);
+    free(tid);
+    free(started);
+    return res;
+}
+
+
+void spiDriver_CompareEchoes(const EchoDetailData_t* const hostEcho,
+                             const EchoDetailData_t* const icEcho,
+                             const uint16_t tolerance,
+                             spiDriver_EchoCompareStat_t* const stat)
+{
+    uint32_t errorSum = 0u;
+    memset(stat, 0, sizeof(*stat));
+    for (uint16_t ch = 0u; ch < ECHO_NUM_CHANNEL; ch++) {
+        bool used[ECHO_NUM_OBJS] = {false};
+        for (uint16_t icObj = 0u; icObj < ECHO_NUM_OBJS; icObj++) {
+            const EchoDetailDataItem_t* icItem = &(*icEcho)[ch][icObj];
+            uint16_t best = ECHO_NUM_OBJS;
+            uint16_t bestError = UINT16_MAX;
+            if (!icItem->flags.valid) {
+                continue;
+            }
+            for (uint16_t hostObj = 0u; hostObj < ECHO_NUM_OBJS; hostObj++) {
+                const EchoDetailDataItem_t* hostItem = &(*hostEcho)[ch][hostObj];
+                if (hostItem->flags.valid && (!used[hostObj])) {
+                    uint16_t error = (hostItem->peak > icItem->peak) ? (hostItem->peak - icItem->peak) :
+                                     (icItem->peak - hostItem->peak);
+                    if (error < bestError) {
+                        bestError = error;
+                        best = hostObj;
+                    }
+                }
+            }
+            if ((best < ECHO_NUM_OBJS) && (bestError <= tolerance)) {
+                used[best] = true;
+                stat->matched++;
+                errorSum += bestError;
+                if (bestError > stat->peakErrorMax) {
+                    stat->peakErrorMax = bestError;
+                }
+            } else {
+                stat->missed++;
+            }
+        }
+        for (uint16_t hostObj = 0u; hostObj < ECHO_NUM_OBJS; hostObj++) {
+            if ((*hostEcho)[ch][hostObj].flags.valid && (!used[hostObj])) {
+                stat->extra++;
+            }
+        }
+    }
+    if (stat->matched > 0u) {
+        stat->peakErrorMean = (float)errorSum / (float)stat->matched;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
@@ -0,0 +1,131 @@
+/**
+ * @file
+ * @brief Host-side echo extraction from raw traces
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_echo_extract Echo extraction from traces
+ * @ingroup spi_trace
+ *
+ * @details
+ *
+ * The layers captured in trace mode provide the full waveforms, but no echoes. This component finds the echoes in the
+ * traces on the host side and reports them in ::FMT_ECHO_DETAIL format, so the trace layer can be processed by the
+ * same application code as the echo layer.
+ *
+ * For each channel the extraction does:
+ *
+ * - estimates the **baseline** as the mean of the first samples;
+ * - finds the regions above the **threshold** (baseline + layer's echoThreshold);
+ * - for each region finds the **peak**, the **start/stop** points (local minimums around the region) and the
+ *   **inflection** points (steepest rise and fall);
+ * - assigns the **flags**: valid, low_amplitude, issue_width, saturated, merge_suspicion (several maximums in a
+ *   region) and undershoot (the trace falls below baseline by more than threshold after the echo).
+ *
+ * Up to ::ECHO_NUM_OBJS echoes per channel are reported, in order of their distance. The distance is reported in
+ * samples, equal to the peak.
+ *
+ * The result can be compared with the echoes produced by IC for the same layer with ::spiDriver_CompareEchoes.
+ */
+
+#ifndef SPI_DRV_ECHO_EXTRACT_H
+#define SPI_DRV_ECHO_EXTRACT_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+
+/** Echo extraction settings */
+typedef struct {
+    uint16_t echoThreshold;     /**< Threshold above the baseline. Normally the layer's echoThreshold */
+    uint16_t baselineSamples;   /**< Amount of first samples used for the baseline estimation */
+    uint16_t saturationLevel;   /**< Sample level treated as saturated. 0 disables the check */
+    uint16_t minWidth;          /**< Minimum echo width in samples. Narrower echoes get issue_width flag */
+    uint16_t lowAmplitude;      /**< Amplitude above baseline, below which the echo gets low_amplitude flag */
+    uint16_t channelOffset;     /**< Trace channel mapped to the echo channel 0 */
+} spiDriver_EchoExtractCfg_t;
+
+/** Result of the comparison between the host and IC echoes */
+typedef struct {
+    uint16_t matched;           /**< Amount of IC echoes with a host echo within the tolerance */
+    uint16_t missed;            /**< Amount of IC echoes without a host echo */
+    uint16_t extra;             /**< Amount of host echoes without IC echo */
+    float peakErrorMean;        /**< Mean absolute peak position error of matched echoes, samples */
+    uint16_t peakErrorMax;      /**< Maximum absolute peak position error of matched echoes, samples */
+} spiDriver_EchoCompareStat_t;
+
+
+/** Initializes the extraction settings
+ * @param[out]  cfg         settings to initialize
+ * @param[in]   layerCfg    layer's configuration to take the threshold from. NULL to use ::spiDriver_DefaultLayerConfig
+ */
+void spiDriver_EchoExtractCfgInit(spiDriver_EchoExtractCfg_t* const cfg, const spiDriver_LayerConfig_t* const layerCfg);
+
+
+/** Extracts the echoes from the layer's traces
+ * @param[in]   cfg         extraction settings
+ * @param[in]   trace       raw traces in order [N_CHANNELS][nSamples]
+ * @param[in]   nSamples    samples per channel
+ * @param[out]  echo        echoes found
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    nSamples is out of range
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     channelOffset or baselineSamples are out of range
+ */
+FuncResult_e spiDriver_ExtractEchoLayer(const spiDriver_EchoExtractCfg_t* const cfg,
+                                        const uint16_t* const trace,
+                                        const uint16_t nSamples,
+                                        EchoDetailData_t* const echo);
+
+
+/** Extracts the echoes from all trace layers of the scene
+ * The layers are distributed between the threads. The output items of non-trace records are cleared.
+ * @param[in]   cfg             extraction settings
+ * @param[in]   chipData        chip-data array of the scene
+ * @param[in]   chipDataSize    items count in `chipData` array
+ * @param[out]  echoes          output array of `chipDataSize` items
+ * @param[in]   nThreads        amount of threads to use. 0 or 1 runs in the caller's thread
+ * @return  result of an operation. See ::FuncResult_e for details
+ */
+FuncResult_e spiDriver_ExtractEchoScene(const spiDriver_EchoExtractCfg_t* const cfg,
+                                        const spiDriver_ChipData_t* const chipData,
+                                        const uint16_t chipDataSize,
+                                        EchoDetailData_t* const echoes,
+                                        const uint16_t nThreads);
+
+
+/** Compares the echoes found by host with the echoes reported by IC for the same layer
+ * Echoes are matched per channel by the nearest peak position.
+ * @param[in]   hostEcho    echoes extracted by host
+ * @param[in]   icEcho      echoes reported by IC
+ * @param[in]   tolerance   maximum peak position difference for matched echoes, samples
+ * @param[out]  stat        comparison result
+ */
+void spiDriver_CompareEchoes(const EchoDetailData_t* const hostEcho,
+                             const EchoDetailData_t* const icEcho,
+                             const uint16_t tolerance,
+                             spiDriver_EchoCompareStat_t* const stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* SPI_DRV_ECHO_EXTRACT_H */
@@ -0,0 +1,282 @@
+/**
+ * @file
+ * @brief Echo features refinement for FMT_ECHO_9P and FMT_ECHO_FAST formats
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_echo_refine
+ */
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <math.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_echo_refine.h"
+
+/** Maximum amount of points describing the echo pulse */
+#define REFINE_POINTS_MAX 9u
+/** Amount of points in FMT_ECHO_9P object */
+#define REFINE_POINTS_9P 9u
+/** Amount of points in FMT_ECHO_FAST object */
+#define REFINE_POINTS_FAST 5u
+
+/** Points of all objects of a layer, gathered column-wise to process the objects in a batch */
+typedef struct {
+    float x[REFINE_POINTS_MAX][ECHO_LAYER_OBJS_MAX];    /**< Points' positions, in samples */
+    float y[REFINE_POINTS_MAX][ECHO_LAYER_OBJS_MAX];    /**< Points' amplitudes */
+    uint8_t peak[ECHO_LAYER_OBJS_MAX];                  /**< Index of the maximum point */
+} EchoProfiles_t;
+
+
+/** Fits the peak for all objects
+ * The parabola is built through the maximum point and its neighbours. The positions are relative to the maximum
+ * point, thus the spacing of points is not required to be equal.
+ */
+static void spiDriver_RefineFit(const EchoProfiles_t* const prof,
+                                const uint16_t nPoints,
+                                const uint16_t count,
+                                const float* const baseline,
+                                const EchoFitMethod_e method,
+                                spiDriver_RefinedEchoes_t* const refined)
+{
+    float u0[ECHO_LAYER_OBJS_MAX];
+    float u2[ECHO_LAYER_OBJS_MAX];
+    float y0[ECHO_LAYER_OBJS_MAX];
+    float y1[ECHO_LAYER_OBJS_MAX];
+    float y2[ECHO_LAYER_OBJS_MAX];
+    float xm[ECHO_LAYER_OBJS_MAX];
+    bool logFit[ECHO_LAYER_OBJS_MAX];
+
+    /* Gather the neighbours of the maximum point */
+    for (uint16_t i = 0u; i < count; i++) {
+        uint16_t m = prof->peak[i];
+        if (m < 1u) {
+            m = 1u;
+        } else if (m > (nPoints - 2u)) {
+            m = nPoints - 2u;
+        }
+        xm[i] = prof->x[m][i];
+        u0[i] = prof->x[m - 1u][i] - xm[i];
+        u2[i] = prof->x[m + 1u][i] - xm[i];
+        y0[i] = prof->y[m - 1u][i] - baseline[i];
+        y1[i] = prof->y[m][i] - baseline[i];
+        y2[i] = prof->y[m + 1u][i] - baseline[i];
+        logFit[i] = (method == ECHO_FIT_GAUSSIAN) && (y0[i] > 0.0f) && (y1[i] > 0.0f) && (y2[i] > 0.0f);
+        if (logFit[i]) {
+            y0[i] = logf(y0[i]);
+            y1[i] = logf(y1[i]);
+            y2[i] = logf(y2[i]);
+        }
+    }
+
+    /* Vertex of the parabola */
+    for (uint16_t i = 0u; i < count; i++) {
+        const float d0 = y0[i] - y1[i];
+        const float d2 = y2[i] - y1[i];
+        const float det = u0[i] * u2[i] * (u0[i] - u2[i]);
+        float u = 0.0f;
+        float v = y1[i];
+        if (det != 0.0f) {
+            const float a = ((d0 * u2[i]) - (d2 * u0[i])) / det;
+            const float b = ((u0[i] * u0[i] * d2) - (u2[i] * u2[i] * d0)) / det;
+            if (a < 0.0f) {
+                u = -b / (2.0f * a);
+                if (u < u0[i]) {
+                    u = u0[i];
+                } else if (u > u2[i]) {
+                    u = u2[i];
+                }
+                v = y1[i] + (((a * u) + b) * u);
+            }
+        }
+        refined->position[i] = xm[i] + u;
+        refined->amplitude[i] = logFit[i] ? expf(v) : v;
+    }
+}
+
+
+/** Computes the pulse width at the half of amplitude, using the linear interpolation between points */
+static void spiDriver_RefineWidth(const EchoProfiles_t* const prof,
+                                  const uint16_t nPoints,
+                                  const uint16_t count,
+                                  const float* const baseline,
+                                  spiDriver_RefinedEchoes_t* const refined)
+{
+    for (uint16_t i = 0u; i < count; i++) {
+        const uint16_t m = prof->peak[i];
+        const float half = baseline[i] + ((prof->y[m][i] - baseline[i]) * 0.5f);
+        float left = prof->x[0u][i];
+        float right = prof->x[nPoints - 1u][i];
+        for (uint16_t k = m; k > 0u; k--) {
+            const float ya = prof->y[k - 1u][i];
+            const float yb = prof->y[k][i];
+            if (ya <= half) {
+                left = prof->x[k - 1u][i];
+                if (yb > ya) {
+                    left += (half - ya) * (prof->x[k][i] - prof->x[k - 1u][i]) / (yb - ya);
+                }
+                break;
+            }
+        }
+        for (uint16_t k = m; k < (nPoints - 1u); k++) {
+            const float ya = prof->y[k][i];
+            const float yb = prof->y[k + 1u][i];
+            if (yb <= half) {
+                right = prof->x[k + 1u][i];
+                if (ya > yb) {
+                    right -= (half - yb) * (prof->x[k + 1u][i] - prof->x[k][i]) / (ya - yb);
+                }
+                break;
+            }
+        }
+        refined->width[i] = right - left;
+    }
+}
+
+
+/** Computes the steepest slopes of the rising and falling edges */
+static void spiDriver_RefineSlopes(const EchoProfiles_t* const prof,
+                                   const uint16_t nPoints,
+                                   const uint16_t count,
+                                   spiDriver_RefinedEchoes_t* const refined)
+{
+    for (uint16_t i = 0u; i < count; i++) {
+        refined->riseSlope[i] = 0.0f;
+        refined->fallSlope[i] = 0.0f;
+    }
+    for (uint16_t k = 0u; k < (nPoints - 1u); k++) {
+        for (uint16_t i = 0u; i < count; i++) {
+            const float dx = prof->x[k + 1u][i] - prof->x[k][i];
+            const float slope = (dx > 0.0f) ? ((prof->y[k + 1u][i] - prof->y[k][i]) / dx) : 0.0f;
+            if (k < prof->peak[i]) {
+                refined->riseSlope[i] = (slope > refined->riseSlope[i]) ? slope : refined->riseSlope[i];
+            } else {
+                refined->fallSlope[i] = (slope < refined->fallSlope[i]) ? slope : refined->fallSlope[i];
+            }
+        }
+    }
+}
+
+
+static void spiDriver_RefineProfiles(const EchoProfiles_t* const prof,
+                                     const uint16_t nPoints,
+                                     const EchoFitMethod_e method,
+                                     spiDriver_RefinedEchoes_t* const refined)
+{
+    float baseline[ECHO_LAYER_OBJS_MAX];
+    const uint16_t count = refined->count;
+    for (uint16_t i = 0u; i < count; i++) {
+        const float first = prof->y[0u][i];
+        const float last = prof->y[nPoints - 1u][i];
+        baseline[i] = (first < last) ? first : last;
+    }
+    spiDriver_RefineFit(prof, nPoints, count, baseline, method, refined);
+    spiDriver_RefineWidth(prof, nPoints, count, baseline, refined);
+    spiDriver_RefineSlopes(prof, nPoints, count, refined);
+}
+
+
+FuncResult_e spiDriver_RefineEcho9P(const Echo9PData_t* const echo,
+                                    const EchoFitMethod_e method,
+                                    spiDriver_RefinedEchoes_t* const refined)
+{
+    EchoProfiles_t prof;
+    uint16_t count = 0u;
+    for (uint16_t ch = 0u; ch < ECHO_NUM_CHANNEL; ch++) {
+        for (uint16_t obj = 0u; obj < ECHO_NUM_OBJS; obj++) {
+            const Echo9PDataItem_t* item = &(*echo)[ch][obj];
+            uint8_t peak = 0u;
+            for (uint16_t k = 0u; k < REFINE_POINTS_9P; k++) {
+                prof.x[k][count] = (float)(item->index + k);
+                prof.y[k][count] = (float)item->data[k];
+                if (item->data[k] > item->data[peak]) {
+                    peak = k;
+                }
+            }
+            if (item->data[peak] != 0u) {
+                prof.peak[count] = peak;
+                refined->channel[count] = (uint8_t)ch;
+                refined->object[count] = (uint8_t)obj;
+                count++;
+            }
+        }
+    }
+    refined->count = count;
+    spiDriver_RefineProfiles(&prof, REFINE_POINTS_9P, method, refined);
+    return SPI_DRV_FUNC_RES_OK;
+}
+
+
+FuncResult_e spiDriver_RefineEchoFast(const EchoFastData_t* const echo,
+                                      const EchoFitMethod_e method,
+                                      spiDriver_RefinedEchoes_t* const refined)
+{
+    EchoProfiles_t prof;
+    uint16_t count = 0u;
+    for (uint16_t ch = 0u; ch < ECHO_NUM_CHANNEL; ch++) {
+        for (uint16_t obj = 0u; obj < ECHO_NUM_OBJS; obj++) {
+            const EchoFastDataItem_t* item = &(*echo)[ch][obj];
+            if (item->max != 0u) {
+                prof.x[0u][count] = (float)item->minLi;
+                prof.y[0u][count] = (float)item->minL;
+                prof.x[1u][count] = (float)item->maxSLi;
+                prof.y[1u][count] = (float)item->maxSL;
+                prof.x[2u][count] = (float)item->maxi;
+                prof.y[2u][count] = (float)item->max;
+                prof.x[3u][count] = (float)item->maxSRi;
+                prof.y[3u][count] = (float)item->maxSR;
+                prof.x[4u][count] = (float)item->minRi;
+                prof.y[4u][count] = (float)item->minR;
+                prof.peak[count] = 2u;
+                refined->channel[count] = (uint8_t)ch;
+                refined->object[count] = (uint8_t)obj;
+                count++;
+            }
+        }
+    }
+    refined->count = count;
+    spiDriver_RefineProfiles(&prof, REFINE_POINTS_FAST, method, refined);
+    return SPI_DRV_FUNC_RES_OK;
+}
+
+
+FuncResult_e spiDriver_RefineChipData(const spiDriver_ChipData_t* const chipData,
+                                      const EchoFitMethod_e method,
+                                      spiDriver_RefinedEchoes_t* const refined)
+{
+    FuncResult_e res;
+    if ((chipData->data != NULL) && (chipData->dataFormat == CHIP_DATA_9P)) {
+        res = spiDriver_RefineEcho9P(EchoParseAs9P(&chipData->data->echo), method, refined);
+    } else if ((chipData->data != NULL) && (chipData->dataFormat == CHIP_DATA_FAST)) {
+        res = spiDriver_RefineEchoFast(EchoParseAsFast(&chipData->data->echo), method, refined);
+    } else {
+        refined->count = 0u;
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+    }
+    return res;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
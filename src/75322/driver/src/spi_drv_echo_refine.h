@@ -0,0 +1,112 @@
+/**
+ * @file
+ * @brief Echo features refinement for FMT_ECHO_9P and FMT_ECHO_FAST formats
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_echo_refine Echo features refinement
+ * @ingroup spi_trace
+ *
+ * @details
+ *
+ * The formats ::FMT_ECHO_9P and ::FMT_ECHO_FAST provide several points of the echo pulse instead of the distance
+ * computed by IC. This component computes the echo features from these points for all objects of a layer at once:
+ *
+ * - **position** - sub-sample peak position, found as the vertex of parabola through the maximum point and its
+ *   neighbours. In ::ECHO_FIT_GAUSSIAN mode the parabola is fitted to logarithm of amplitudes, which is exact for
+ *   Gaussian pulse shape;
+ * - **amplitude** - amplitude at the peak position, above the baseline;
+ * - **width** - pulse width at the half of amplitude, found by the linear interpolation between the points;
+ * - **rise/fall slopes** - the steepest slopes of the rising and falling edges, in LSB per sample.
+ *
+ * For ::FMT_ECHO_9P the neighbours are the adjacent points of data[] and the baseline is the lowest of the
+ * outer points. For ::FMT_ECHO_FAST the neighbours are the inflection points and the baseline is the lowest of the
+ * left and right points.
+ *
+ * The objects with zero amplitude are skipped, so the output contains only the detected objects.
+ */
+
+#ifndef SPI_DRV_ECHO_REFINE_H
+#define SPI_DRV_ECHO_REFINE_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_echo_decode.h"
+
+/** Peak fitting method */
+typedef enum {
+    ECHO_FIT_PARABOLIC = 0u,    /**< Parabola through the amplitudes */
+    ECHO_FIT_GAUSSIAN,          /**< Parabola through logarithm of the amplitudes (Gaussian fit) */
+} EchoFitMethod_e;
+
+/** Refined echo features of a layer. Only the first `count` items of each column are valid */
+typedef struct {
+    float position[ECHO_LAYER_OBJS_MAX];    /**< Sub-sample peak position, in samples */
+    float amplitude[ECHO_LAYER_OBJS_MAX];   /**< Peak amplitude above the baseline */
+    float width[ECHO_LAYER_OBJS_MAX];       /**< Pulse width at half of amplitude, in samples */
+    float riseSlope[ECHO_LAYER_OBJS_MAX];   /**< Steepest slope of the rising edge, LSB per sample */
+    float fallSlope[ECHO_LAYER_OBJS_MAX];   /**< Steepest slope of the falling edge, LSB per sample (negative) */
+    uint8_t channel[ECHO_LAYER_OBJS_MAX];   /**< Channel of the object */
+    uint8_t object[ECHO_LAYER_OBJS_MAX];    /**< Object's index in the channel */
+    uint16_t count;                         /**< Amount of refined objects */
+} spiDriver_RefinedEchoes_t;
+
+
+/** Refines the echoes of FMT_ECHO_9P layer
+ * @param[in]   echo        echo data of the layer
+ * @param[in]   method      peak fitting method
+ * @param[out]  refined     refined echoes of the layer
+ * @return  result of an operation. See ::FuncResult_e for details
+ */
+FuncResult_e spiDriver_RefineEcho9P(const Echo9PData_t* const echo,
+                                    const EchoFitMethod_e method,
+                                    spiDriver_RefinedEchoes_t* const refined);
+
+
+/** Refines the echoes of FMT_ECHO_FAST layer
+ * @param[in]   echo        echo data of the layer
+ * @param[in]   method      peak fitting method
+ * @param[out]  refined     refined echoes of the layer
+ * @return  result of an operation. See ::FuncResult_e for details
+ */
+FuncResult_e spiDriver_RefineEchoFast(const EchoFastData_t* const echo,
+                                      const EchoFitMethod_e method,
+                                      spiDriver_RefinedEchoes_t* const refined);
+
+
+/** Refines the echoes of the chip-data record
+ * @param[in]   chipData    chip-data record of ::CHIP_DATA_9P or ::CHIP_DATA_FAST format
+ * @param[in]   method      peak fitting method
+ * @param[out]  refined     refined echoes of the layer
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    the record has other data format
+ */
+FuncResult_e spiDriver_RefineChipData(const spiDriver_ChipData_t* const chipData,
+                                      const EchoFitMethod_e method,
+                                      spiDriver_RefinedEchoes_t* const refined);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* SPI_DRV_ECHO_REFINE_H */
@@ -0,0 +1,240 @@
+/**
+ * @file
+ * @brief SPI driver instance handles
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_drv_handle
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_continuity.h"
+#include "spi_drv_handle.h"
+#include "spi_drv_instance_priv.h"
+
+extern void spiDriver_ResetApiInstance(void);
+extern void spiDriver_ResetTraceInstance(void);
+extern FuncResult_e spiDriver_InitContinuousModeInstance(const ContModeCfg_t* const cfg);
+
+/** Driver's instance handle */
+struct spiDriver_Handle {
+    uint16_t index;     /**< Index of the instance's items in the per-instance variables */
+    bool used;          /**< The instance is created */
+};
+
+__thread uint16_t spiDriver_instanceIdx __attribute__((tls_model("initial-exec"))) = SPI_DRV_DEFAULT_INSTANCE;
+
+static spiDriver_Handle_t handles[SPI_DRV_MAX_HANDLES] = {
+    [SPI_DRV_DEFAULT_INSTANCE] = {.index = SPI_DRV_DEFAULT_INSTANCE, .used = true},
+};
+/** Guards the handles' creation and destruction */
+static pthread_mutex_t handlesLock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/** Checks the handle is the one created */
+static bool HandleValid(const spiDriver_Handle_t* const handle)
+{
+    bool res = false;
+    if ((handle >= &handles[0u]) && (handle < &handles[SPI_DRV_MAX_HANDLES])) {
+        pthread_mutex_lock(&handlesLock);
+        res = handle->used;
+        pthread_mutex_unlock(&handlesLock);
+    }
+    return res;
+}
+
+
+/** Sets the current instance's state to the defaults, releasing the resources */
+static void HandleReset(void)
+{
+    spiDriver_ResetTraceInstance();
+    spiDriver_ResetContinuityStats(IC_ID_BROADCAST);
+    FreeFwJson();
+    spiDriver_ResetApiInstance();
+    memset(&syncModeCfg, 0, sizeof(syncModeCfg));
+    memset(&contModeCfg, 0, sizeof(contModeCfg));
+}
+
+
+spiDriver_Handle_t* spiDriver_CreateHandle(void)
+{
+    spiDriver_Handle_t* res = NULL;
+    pthread_mutex_lock(&handlesLock);
+    for (uint16_t ind = 0u; (ind < SPI_DRV_MAX_HANDLES) && (res == NULL); ind++) {
+        if (!handles[ind].used) {
+            handles[ind].index = ind;
+            handles[ind].used = true;
+            res = &handles[ind];
+        }
+    }
+    pthread_mutex_unlock(&handlesLock);
+    if (res != NULL) {
+        spiDriver_Handle_t* caller;
+        (void)spiDriver_SelectHandle(res, &caller);
+        spiDriver_ResetApiInstance();
+        (void)spiDriver_SelectHandle(caller, NULL);
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_DestroyHandle(spiDriver_Handle_t* const handle)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    if ((!HandleValid(handle)) || (handle->index == SPI_DRV_DEFAULT_INSTANCE)) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+    } else if (handle->index == spiDriver_instanceIdx) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+    } else {
+        spiDriver_Handle_t* caller;
+        (void)spiDriver_SelectHandle(handle, &caller);
+        HandleReset();
+        (void)spiDriver_SelectHandle(caller, NULL);
+        pthread_mutex_lock(&handlesLock);
+        handle->used = false;
+        pthread_mutex_unlock(&handlesLock);
+    }
+    return res;
+}
+
+
+spiDriver_Handle_t* spiDriver_DefaultHandle(void)
+{
+    return &handles[SPI_DRV_DEFAULT_INSTANCE];
+}
+
+
+FuncResult_e spiDriver_SelectHandle(spiDriver_Handle_t* const handle, spiDriver_Handle_t** const previous)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    if ((handle != NULL) && (!HandleValid(handle))) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+    } else {
+        if (previous != NULL) {
+            *previous = &handles[spiDriver_instanceIdx];
+        }
+        spiDriver_instanceIdx = (handle != NULL) ? handle->index : SPI_DRV_DEFAULT_INSTANCE;
+    }
+    return res;
+}
+
+
+spiDriver_Handle_t* spiDriver_CurrentHandle(void)
+{
+    return &handles[spiDriver_instanceIdx];
+}
+
+
+spiDriver_Status_t spiDriver_HandleInitialize(spiDriver_Handle_t* const handle,
+                                              const spiDriver_InputConfiguration_t* const spiDriver_InputCfg)
+{
+    spiDriver_Handle_t* caller;
+    spiDriver_Status_t res = SPI_DRV_FALSE;
+    if (spiDriver_SelectHandle(handle, &caller) == SPI_DRV_FUNC_RES_OK) {
+        res = spiDriver_Initialize(spiDriver_InputCfg);
+        (void)spiDriver_SelectHandle(caller, NULL);
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_HandleSetupMultiICs(spiDriver_Handle_t* const handle,
+                                           const char** icNames,
+                                           const uint16_t icNumber)
+{
+    spiDriver_Handle_t* caller;
+    FuncResult_e res = spiDriver_SelectHandle(handle, &caller);
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        res = spiDriver_SetupMultiICs(icNames, icNumber);
+        (void)spiDriver_SelectHandle(caller, NULL);
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_HandleSetByName(spiDriver_Handle_t* const handle,
+                                       const SpiDriver_FldName_t* const varName,
+                                       const uint32_t value,
+                                       const SpiDriver_FldName_t* const bitFieldName)
+{
+    spiDriver_Handle_t* caller;
+    FuncResult_e res = spiDriver_SelectHandle(handle, &caller);
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        res = spiDriver_SetByName(varName, value, bitFieldName);
+        (void)spiDriver_SelectHandle(caller, NULL);
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_HandleGetByName(spiDriver_Handle_t* const handle,
+                                       const SpiDriver_FldName_t* const varName,
+                                       uint32_t* const value,
+                                       const SpiDriver_FldName_t* const bitFieldName)
+{
+    spiDriver_Handle_t* caller;
+    FuncResult_e res = spiDriver_SelectHandle(handle, &caller);
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        res = spiDriver_GetByName(varName, value, bitFieldName);
+        (void)spiDriver_SelectHandle(caller, NULL);
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_HandleSetLayersConfig(spiDriver_Handle_t* const handle,
+                                             const spiDriver_LayerConfig_t* const layerConfigurations,
+                                             const uint16_t layersCount)
+{
+    spiDriver_Handle_t* caller;
+    FuncResult_e res = spiDriver_SelectHandle(handle, &caller);
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        res = spiDriver_SetLayersConfig(layerConfigurations, layersCount);
+        (void)spiDriver_SelectHandle(caller, NULL);
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_HandleGetScenes(spiDriver_Handle_t* const handle,
+                                       const uint16_t* const layerOrder,
+                                       const uint16_t layerCount,
+                                       const ProcOrder_e* const procOrder,
+                                       spiDriver_Scene_t* const scenes,
+                                       const uint16_t nScenes,
+                                       uint16_t* const nScenesRead)
+{
+    spiDriver_Handle_t* caller;
+    FuncResult_e res = spiDriver_SelectHandle(handle, &caller);
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        res = spiDriver_GetScenes(layerOrder, layerCount, procOrder, scenes, nScenes, nScenesRead);
+        (void)spiDriver_SelectHandle(caller, NULL);
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_HandleInitContinuousMode(spiDriver_Handle_t* const handle, const ContModeCfg_t* const cfg)
+{
+    spiDriver_Handle_t* caller;
+    FuncResult_e res = spiDriver_SelectHandle(handle, &caller);
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        res = spiDriver_InitContinuousModeInstance(cfg);
+        (void)spiDriver_SelectHandle(caller, NULL);
+    }
+    return res;
+}
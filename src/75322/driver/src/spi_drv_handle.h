@@ -0,0 +1,153 @@
+/**
+ * @file
+ * @brief SPI driver instance handles
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_drv_handle SPI driver instance handles
+ * @ingroup spi_api
+ *
+ * @details
+ *
+ * A handle is an independent instance of the driver: the sensor's state, the multi-IC configuration, the FW database,
+ * the data captured and the caches. So one process can drive several sensor heads, each one with its own handle.
+ *
+ * The driver's API works with the instance selected by the calling thread (see ::spiDriver_SelectHandle). The
+ * threads not selecting any handle work with the default one, so the API without a handle behaves as a single
+ * instance driver. A handle should be used by one thread at a time, different handles can be used concurrently.
+ * The functions taking a handle select it for the call's duration, and fail with ::SPI_DRV_FUNC_RES_FAIL_INPUT_DATA
+ * (::SPI_DRV_FALSE for ::spiDriver_HandleInitialize) when the handle isn't a valid one.
+ *
+ * The HAL keeps its devices per instance as well, so each handle opens its own SPI ports by
+ * ::spiDriver_HandleInitialize and closes them by ::spiDriver_SpiClosePort with the handle selected.
+ *
+ * The continuous mode runs for one instance at a time, the one which called ::spiDriver_InitContinuousMode. Its
+ * threads, as well as ::spiDriver_RunContinuousMode, ::spiDriver_StopContinuousMode and
+ * ::spiDriver_ExitContinuousMode work with that instance whatever the caller's selection is. The other instances
+ * can't initialize it until it's exited (see ::spiDriver_HandleInitContinuousMode), they capture the data by the
+ * blocking functions only.
+ */
+
+#ifndef SPI_DRV_HANDLE_H
+#define SPI_DRV_HANDLE_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_instance.h"
+#include "spi_drv_api.h"
+#include "spi_drv_trace.h"
+#include "cont_mode_lib.h"
+
+/** Driver's instance handle */
+typedef struct spiDriver_Handle spiDriver_Handle_t;
+
+
+/** Creates the driver's instance
+ * The instance is empty, as the driver at the process' start, and should be initialized by
+ * ::spiDriver_HandleInitialize
+ * @return  handle created, or NULL when all ::SPI_DRV_MAX_HANDLES instances are used
+ */
+spiDriver_Handle_t* spiDriver_CreateHandle(void);
+
+
+/** Destroys the driver's instance, releasing its FW database and the data captured
+ * The continuous mode initialized for the instance should be exited and its HAL ports closed before.
+ * @param[in]   handle      handle to destroy
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    the handle is invalid, or the default one
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     the handle is selected by the calling thread
+ */
+FuncResult_e spiDriver_DestroyHandle(spiDriver_Handle_t* const handle);
+
+
+/** Returns the default instance's handle, used by the threads not selecting any handle */
+spiDriver_Handle_t* spiDriver_DefaultHandle(void);
+
+
+/** Selects the instance the calling thread works with
+ * @param[in]   handle      handle to select. NULL selects the default instance
+ * @param[out]  previous    handle selected before, to restore it when needed. May be NULL
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    the handle isn't created or is destroyed, the selection is unchanged
+ */
+FuncResult_e spiDriver_SelectHandle(spiDriver_Handle_t* const handle, spiDriver_Handle_t** const previous);
+
+
+/** Returns the instance's handle the calling thread works with */
+spiDriver_Handle_t* spiDriver_CurrentHandle(void);
+
+
+/** Initializes the instance. See ::spiDriver_Initialize */
+spiDriver_Status_t spiDriver_HandleInitialize(spiDriver_Handle_t* const handle,
+                                              const spiDriver_InputConfiguration_t* const spiDriver_InputCfg);
+
+
+/** Sets up the ICs of the instance. See ::spiDriver_SetupMultiICs */
+FuncResult_e spiDriver_HandleSetupMultiICs(spiDriver_Handle_t* const handle,
+                                           const char** icNames,
+                                           const uint16_t icNumber);
+
+
+/** Writes the variable of the instance's IC. See ::spiDriver_SetByName */
+FuncResult_e spiDriver_HandleSetByName(spiDriver_Handle_t* const handle,
+                                       const SpiDriver_FldName_t* const varName,
+                                       const uint32_t value,
+                                       const SpiDriver_FldName_t* const bitFieldName);
+
+
+/** Reads the variable of the instance's IC. See ::spiDriver_GetByName */
+FuncResult_e spiDriver_HandleGetByName(spiDriver_Handle_t* const handle,
+                                       const SpiDriver_FldName_t* const varName,
+                                       uint32_t* const value,
+                                       const SpiDriver_FldName_t* const bitFieldName);
+
+
+/** Writes the layers' configurations into the instance's ICs. See ::spiDriver_SetLayersConfig */
+FuncResult_e spiDriver_HandleSetLayersConfig(spiDriver_Handle_t* const handle,
+                                             const spiDriver_LayerConfig_t* const layerConfigurations,
+                                             const uint16_t layersCount);
+
+
+/** Reads the scenes from the instance's ICs. See ::spiDriver_GetScenes */
+FuncResult_e spiDriver_HandleGetScenes(spiDriver_Handle_t* const handle,
+                                       const uint16_t* const layerOrder,
+                                       const uint16_t layerCount,
+                                       const ProcOrder_e* const procOrder,
+                                       spiDriver_Scene_t* const scenes,
+                                       const uint16_t nScenes,
+                                       uint16_t* const nScenesRead);
+
+
+/** Initializes the continuous mode for the instance. See ::spiDriver_InitContinuousMode
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    the handle is invalid
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     the continuous mode is initialized for another instance, `cfg` is
+ *                                              ignored
+ * @retval  SPI_DRV_FUNC_RES_FAIL               the continuous mode thread can't be created
+ */
+FuncResult_e spiDriver_HandleInitContinuousMode(spiDriver_Handle_t* const handle, const ContModeCfg_t* const cfg);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* SPI_DRV_HANDLE_H */
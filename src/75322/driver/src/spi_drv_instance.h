@@ -0,0 +1,61 @@
+/**
+ * @file
+ * @brief Per-instance state of the SPI driver
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_drv_instance SPI driver instances' state
+ * @ingroup spi_drv_handle
+ *
+ * @details
+ *
+ * The driver's state (the sensor's current state, multi-IC configuration, FW database, data captured, caches) is kept
+ * per instance, so one process can drive several sensor heads. Each state variable is an array with an item per
+ * instance, accessed through a macro with the variable's former name, selecting the item of the instance the calling
+ * thread works with (see ::spiDriver_SelectHandle). The API without a handle works with the default instance.
+ *
+ * Only the macros with the spiDriver_ prefix (::spiDriver_chipData, ::spiDriver_chipDataSize) are public, the driver's
+ * internal state is addressed through the private header spi_drv_instance_priv.h, not installed with the library.
+ */
+
+#ifndef SPI_DRV_INSTANCE_H
+#define SPI_DRV_INSTANCE_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+/** Maximum amount of the driver's instances, the default one included */
+#define SPI_DRV_MAX_HANDLES 4u
+
+/** Index of the default instance, used by the threads not selecting any handle */
+#define SPI_DRV_DEFAULT_INSTANCE 0u
+
+/** Index of the instance the calling thread works with */
+extern __thread uint16_t spiDriver_instanceIdx __attribute__((tls_model("initial-exec")));
+
+/** Index of the instance the calling thread works with, selects the item of the per-instance variables */
+#define SPI_DRV_INSTANCE (spiDriver_instanceIdx)
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* SPI_DRV_INSTANCE_H */
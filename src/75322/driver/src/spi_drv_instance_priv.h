@@ -0,0 +1,59 @@
+/**
+ * @file
+ * @brief Per-instance state variables of the SPI driver, private to the driver
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_drv_instance
+ *
+ * The state variables are addressed by the macros with the variables' former names, selecting the item of the
+ * instance the calling thread works with. The header isn't installed with the library, so these lowercase names don't
+ * clash with the application's identifiers.
+ */
+
+#ifndef SPI_DRV_INSTANCE_PRIV_H
+#define SPI_DRV_INSTANCE_PRIV_H
+
+#include <stdint.h>
+#include "spi_drv_instance.h"
+#include "spi_drv_api.h"
+#include "spi_drv_data.h"
+#include "spi_drv_sync_mode.h"
+#include "spi_drv_trace.h"
+#include "cont_mode_lib.h"
+
+extern uint16_t icIntNamesNumberInst[SPI_DRV_MAX_HANDLES];
+extern FwFieldInfo_t* fwFieldsInst[SPI_DRV_MAX_HANDLES];
+extern uint16_t fwFieldsCountInst[SPI_DRV_MAX_HANDLES];
+extern SyncModeCfg_t syncModeCfgInst[SPI_DRV_MAX_HANDLES];
+extern volatile SpiDriver_State_t spiDriver_currentStateInst[SPI_DRV_MAX_HANDLES];
+extern ContModeCfg_t contModeCfgInst[SPI_DRV_MAX_HANDLES];
+
+/** Amount of the ICs set up by spiDriver_SetupMultiICs() for the current instance */
+#define icIntNamesNumber (icIntNamesNumberInst[SPI_DRV_INSTANCE])
+
+/** FW fields' database of the current instance */
+#define fwFields (fwFieldsInst[SPI_DRV_INSTANCE])
+/** Items count in ::fwFields */
+#define fwFieldsCount (fwFieldsCountInst[SPI_DRV_INSTANCE])
+
+/** Synchronous mode configuration of the current instance, used in driver's API functions */
+#define syncModeCfg (syncModeCfgInst[SPI_DRV_INSTANCE])
+
+/** Sensor's state of the current instance */
+#define spiDriver_currentState (spiDriver_currentStateInst[SPI_DRV_INSTANCE])
+
+/** Continuous mode's configuration of the current driver's instance */
+#define contModeCfg (contModeCfgInst[SPI_DRV_INSTANCE])
+
+#endif /* SPI_DRV_INSTANCE_PRIV_H */
@@ -0,0 +1,228 @@
+/**
+ * @file
+ * @brief Echo to 3D point cloud conversion
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_point_cloud
+ */
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_echo_decode.h"
+#include "spi_drv_point_cloud.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/** Amount of values in the geometry file's line */
+#define PC_LUT_LINE_ITEMS 9
+
+
+/** Computes the point as origin + direction * distance, and assigns the intensity */
+static inline void spiDriver_PointCloudPut(const spiDriver_ChannelGeometry_t* const geometry,
+                                           const float distance,
+                                           const float intensity,
+                                           spiDriver_PointXYZI_t* const point)
+{
+#if defined(__SSE2__)
+    __m128 p = _mm_add_ps(_mm_loadu_ps(geometry->origin),
+                          _mm_mul_ps(_mm_loadu_ps(geometry->direction), _mm_set1_ps(distance)));
+    p = _mm_add_ps(p, _mm_set_ps(intensity, 0.0f, 0.0f, 0.0f));
+    _mm_storeu_ps(&point->x, p);
+#elif defined(__ARM_NEON)
+    float32x4_t p = vaddq_f32(vld1q_f32(geometry->origin),
+                              vmulq_f32(vld1q_f32(geometry->direction), vdupq_n_f32(distance)));
+    vst1q_f32(&point->x, vsetq_lane_f32(intensity, p, 3));
+#else
+    point->x = geometry->origin[0] + (geometry->direction[0] * distance);
+    point->y = geometry->origin[1] + (geometry->direction[1] * distance);
+    point->z = geometry->origin[2] + (geometry->direction[2] * distance);
+    point->intensity = intensity;
+#endif
+}
+
+
+void spiDriver_PointCloudInit(spiDriver_PointCloudCfg_t* const cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->ledPowerComp = NULL;
+    cfg->distOffsetComp = NULL;
+    cfg->tempComp = NULL;
+}
+
+
+FuncResult_e spiDriver_PointCloudSetChannel(spiDriver_PointCloudCfg_t* const cfg,
+                                            const uint16_t chipId,
+                                            const uint16_t channel,
+                                            const spiDriver_ChannelGeometry_t* const geometry,
+                                            const float distScale)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    const float* dir = geometry->direction;
+    const float norm = sqrtf((dir[0] * dir[0]) + (dir[1] * dir[1]) + (dir[2] * dir[2]));
+    if ((chipId < MAX_IC_ID_NUMBER) && (channel < ECHO_NUM_CHANNEL) && (norm > 0.0f) &&
+        (isfinite(distScale)) && (distScale > 0.0f)) {
+        spiDriver_ChannelGeometry_t* dest = &cfg->ic[chipId].channels[channel];
+        for (uint16_t ind = 0u; ind < 3u; ind++) {
+            dest->origin[ind] = geometry->origin[ind];
+            dest->direction[ind] = dir[ind] / norm;
+        }
+        dest->origin[3] = 0.0f;
+        dest->direction[3] = 0.0f;
+        dest->distOffset = geometry->distOffset;
+        cfg->ic[chipId].distScale = distScale;
+        cfg->ic[chipId].loaded = true;
+    } else {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_PointCloudLoadLut(spiDriver_PointCloudCfg_t* const cfg,
+                                         const char* const fileName,
+                                         const float distScale)
+{
+    FuncResult_e res;
+    FILE* fp = NULL;
+    char line[256];
+    uint16_t lineNum = 0u;
+    unsigned int chipId;
+    unsigned int channel;
+    spiDriver_ChannelGeometry_t geometry;
+    const bool scaleValid = (isfinite(distScale)) && (distScale > 0.0f);
+
+    if (scaleValid) {
+        fp = fopen(fileName, "r");
+    }
+    if (!scaleValid) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+        fprintf(stderr, "Error: Wrong distance scale %f for geometry file [%s]\n", (double)distScale, fileName);
+    } else if (fp != NULL) {
+        res = SPI_DRV_FUNC_RES_OK;
+        while ((fgets(line, sizeof(line), fp) != NULL) && (res == SPI_DRV_FUNC_RES_OK)) {
+            const char* ptr = line;
+            lineNum++;
+            while ((*ptr == ' ') || (*ptr == '\t')) {
+                ptr++;
+            }
+            if ((*ptr == '#') || (*ptr == '\n') || (*ptr == '\r') || (*ptr == '\0')) {
+                continue;
+            }
+            if (sscanf(ptr, "%u %u %f %f %f %f %f %f %f", &chipId, &channel,
+                       &geometry.origin[0], &geometry.origin[1], &geometry.origin[2],
+                       &geometry.direction[0], &geometry.direction[1], &geometry.direction[2],
+                       &geometry.distOffset) == PC_LUT_LINE_ITEMS) {
+                res = spiDriver_PointCloudSetChannel(cfg, chipId, channel, &geometry, distScale);
+            } else {
+                res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+            }
+            if (res != SPI_DRV_FUNC_RES_OK) {
+                fprintf(stderr, "Geometry file [%s] read error, line %u\n", fileName, lineNum);
+            }
+        }
+        fclose(fp);
+    } else {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+        fprintf(stderr, "Error: Cannot open file [%s] for reading\n", fileName);
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_MakePointCloud(const spiDriver_PointCloudCfg_t* const cfg,
+                                      const spiDriver_EchoColumns_t* const columns,
+                                      const Metadata_t* const meta,
+                                      spiDriver_PointXYZI_t* const points,
+                                      uint16_t* const pointsCount)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    uint16_t count = 0u;
+    if (columns->distUnit != ECHO_DIST_UNIT_DIST_FORMAT) {
+        /* distScale is given per DistFormat LSB, the peak's sample index would be scaled wrongly */
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+    } else if ((columns->chip_id < MAX_IC_ID_NUMBER) && (cfg->ic[columns->chip_id].loaded)) {
+        const spiDriver_IcGeometry_t* icGeometry = &cfg->ic[columns->chip_id];
+        for (uint16_t ind = 0u; ind < columns->count; ind++) {
+            EchoFlags flags;
+            flags.all_flags = columns->flags[ind];
+            if (flags.valid) {
+                const uint8_t ch = columns->channel[ind];
+                const spiDriver_ChannelGeometry_t* geometry = &icGeometry->channels[ch];
+                float distance = (float)columns->distance[ind] * icGeometry->distScale;
+                if ((!flags.led_p_comp_en) && (cfg->ledPowerComp != NULL)) {
+                    distance = cfg->ledPowerComp(columns->chip_id, ch, meta, distance);
+                }
+                if (!flags.dist_off_comp_en) {
+                    if (cfg->distOffsetComp != NULL) {
+                        distance = cfg->distOffsetComp(columns->chip_id, ch, meta, distance);
+                    } else {
+                        distance -= geometry->distOffset;
+                    }
+                }
+                if ((!flags.temp_comp_en) && (cfg->tempComp != NULL)) {
+                    distance = cfg->tempComp(columns->chip_id, ch, meta, distance);
+                }
+                spiDriver_PointCloudPut(geometry, distance, (float)columns->amplitude[ind], &points[count]);
+                count++;
+            }
+        }
+    } else {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+    }
+    *pointsCount = count;
+    return res;
+}
+
+
+FuncResult_e spiDriver_MakePointCloudChipData(const spiDriver_PointCloudCfg_t* const cfg,
+                                              const spiDriver_ChipData_t* const chipData,
+                                              spiDriver_PointXYZI_t* const points,
+                                              uint16_t* const pointsCount)
+{
+    FuncResult_e res;
+    spiDriver_EchoColumns_t columns;
+    *pointsCount = 0u;
+    if ((chipData->dataFormat <= CHIP_DATA_DETAIL) && (chipData->data != NULL)) {
+        res = spiDriver_DecodeEchoLayer(&chipData->data->echo, (EchoFormatSize_e)chipData->dataFormat, true, &columns);
+        columns.chip_id = chipData->chip_id;
+        if (res == SPI_DRV_FUNC_RES_OK) {
+            res = spiDriver_MakePointCloud(cfg, &columns, chipData->metaData, points, pointsCount);
+        }
+    } else {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+    }
+    return res;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
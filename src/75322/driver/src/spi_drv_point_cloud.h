@@ -0,0 +1,176 @@
+/**
+ * @file
+ * @brief Echo to 3D point cloud conversion
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_point_cloud Point cloud generator
+ * @ingroup spi_trace
+ *
+ * @details
+ *
+ * Converts the echo objects of a layer into the packed array of 3D points with intensity (XYZI). Each channel of each
+ * IC is described by its origin and direction (geometry look-up table), so the point of an object is:
+ *
+ *     P = origin[ic][channel] + direction[ic][channel] * distance * distScale[ic]
+ *
+ * The distance is compensated before the conversion by the hooks of ::spiDriver_PointCloudCfg_t. The hook is called only
+ * when the IC did not apply the same compensation, what is reported by the object's flags ::EchoFlags.led_p_comp_en,
+ * ::EchoFlags.dist_off_comp_en and ::EchoFlags.temp_comp_en. The layers of ::FMT_ECHO_FAST and ::FMT_ECHO_9P report
+ * the peak's sample index instead of the distance (see ::spiDriver_EchoColumns_t.distUnit), so they are not converted.
+ *
+ * The conversion functions do not allocate the memory, so they can be called from the continuous mode callback.
+ *
+ * The geometry file, loaded by ::spiDriver_PointCloudLoadLut, is a text file with one channel per line:
+ *
+ *     # ic channel origin_x origin_y origin_z dir_x dir_y dir_z dist_offset
+ *     0 0 0.0 0.0 0.0 0.998 -0.052 0.0 0.12
+ *
+ * The lines started with '#' and empty lines are skipped. The direction is normalized on load.
+ */
+
+#ifndef SPI_DRV_POINT_CLOUD_H
+#define SPI_DRV_POINT_CLOUD_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_echo_decode.h"
+
+/** Single point of the point cloud */
+typedef struct {
+    float x;            /**< X coordinate, m */
+    float y;            /**< Y coordinate, m */
+    float z;            /**< Z coordinate, m */
+    float intensity;    /**< Object's amplitude */
+} spiDriver_PointXYZI_t;
+ASSERT(sizeof(spiDriver_PointXYZI_t) == 16u);
+
+/** Geometry of a single channel */
+typedef struct {
+    float origin[4];        /**< Origin of the channel's ray x, y, z, m. The 4th item should be 0 */
+    float direction[4];     /**< Unit direction vector of the channel's ray x, y, z. The 4th item should be 0 */
+    float distOffset;       /**< Distance offset, m. Subtracted by the default distance offset compensation */
+} spiDriver_ChannelGeometry_t;
+
+/** Geometry of the IC's channels */
+typedef struct {
+    spiDriver_ChannelGeometry_t channels[ECHO_NUM_CHANNEL];     /**< Geometry per channel */
+    float distScale;                                            /**< Meters per distance LSB (DistFormat) */
+    bool loaded;                                                /**< The IC's geometry is assigned */
+} spiDriver_IcGeometry_t;
+
+/** Distance compensation hook
+ * @param[in]   chipId      the chip ID of the layer
+ * @param[in]   channel     channel of the object
+ * @param[in]   meta        metadata of the layer. May be NULL
+ * @param[in]   distance    distance to compensate, m
+ * @return      compensated distance, m
+ */
+typedef float (* pcCompFunc_t)(const uint16_t chipId,
+                               const uint8_t channel,
+                               const Metadata_t* const meta,
+                               const float distance);
+
+/** Point cloud generator configuration */
+typedef struct {
+    spiDriver_IcGeometry_t ic[MAX_IC_ID_NUMBER];    /**< Geometry look-up table, indexed by the chip ID */
+    pcCompFunc_t ledPowerComp;      /**< LED power compensation. NULL to skip */
+    pcCompFunc_t distOffsetComp;    /**< Distance offset compensation. NULL to subtract the channel's distOffset */
+    pcCompFunc_t tempComp;          /**< Temperature compensation. NULL to skip */
+} spiDriver_PointCloudCfg_t;
+
+
+/** Initializes the configuration with no geometry loaded and default compensations
+ * @param[out]  cfg     configuration to initialize
+ */
+void spiDriver_PointCloudInit(spiDriver_PointCloudCfg_t* const cfg);
+
+
+/** Assigns the geometry of a single channel
+ * @param[in,out]   cfg         configuration to update
+ * @param[in]       chipId      the chip ID
+ * @param[in]       channel     channel index
+ * @param[in]       geometry    channel's geometry. The direction is normalized
+ * @param[in]       distScale   meters per distance LSB, assigned to the IC. Should be positive
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    the chip ID or channel is out of range, the direction is zero or the
+ *                                              distance scale isn't positive
+ */
+FuncResult_e spiDriver_PointCloudSetChannel(spiDriver_PointCloudCfg_t* const cfg,
+                                            const uint16_t chipId,
+                                            const uint16_t channel,
+                                            const spiDriver_ChannelGeometry_t* const geometry,
+                                            const float distScale);
+
+
+/** Loads the geometry look-up table from file
+ * @param[in,out]   cfg         configuration to update
+ * @param[in]       fileName    geometry file name
+ * @param[in]       distScale   meters per distance LSB, assigned to all ICs loaded. Should be positive
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     the file can't be opened
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    the file has wrong content, or the distance scale isn't positive
+ */
+FuncResult_e spiDriver_PointCloudLoadLut(spiDriver_PointCloudCfg_t* const cfg,
+                                         const char* const fileName,
+                                         const float distScale);
+
+
+/** Converts the decoded echo layer into points. Only the valid objects produce points
+ * @param[in]   cfg         point cloud configuration
+ * @param[in]   columns     decoded echo layer
+ * @param[in]   meta        metadata of the layer, passed to the compensation hooks. May be NULL
+ * @param[out]  points      output buffer of ::ECHO_LAYER_OBJS_MAX points
+ * @param[out]  pointsCount amount of points produced
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    the layer's distance is not in DistFormat (::FMT_ECHO_FAST and
+ *                                              ::FMT_ECHO_9P report the peak's sample index)
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     the geometry of the layer's chip is not loaded
+ */
+FuncResult_e spiDriver_MakePointCloud(const spiDriver_PointCloudCfg_t* const cfg,
+                                      const spiDriver_EchoColumns_t* const columns,
+                                      const Metadata_t* const meta,
+                                      spiDriver_PointXYZI_t* const points,
+                                      uint16_t* const pointsCount);
+
+
+/** Converts the echo chip-data record into points
+ * @param[in]   cfg         point cloud configuration
+ * @param[in]   chipData    chip-data record of any echo format
+ * @param[out]  points      output buffer of ::ECHO_LAYER_OBJS_MAX points
+ * @param[out]  pointsCount amount of points produced
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    the record is not an echo, or its distance is not in DistFormat
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     the geometry of the layer's chip is not loaded
+ */
+FuncResult_e spiDriver_MakePointCloudChipData(const spiDriver_PointCloudCfg_t* const cfg,
+                                              const spiDriver_ChipData_t* const chipData,
+                                              spiDriver_PointXYZI_t* const points,
+                                              uint16_t* const pointsCount);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* SPI_DRV_POINT_CLOUD_H */
@@ -29,8 +29,11 @@ extern "C"
 #include "spi_drv_api.h"
 #include "spi_drv_sync_mode.h"
 #include "spi_drv_sync_com.h"
+#include "spi_drv_instance_priv.h"
 
-extern volatile SpiDriver_State_t spiDriver_currentState;
+/* The bus is shared with the broker's clients, see broker.c */
+extern void spiDriver_BrokerBusEnter(void);
+extern void spiDriver_BrokerBusLeave(void);
 
 FuncResult_e spiDriver_SetMultiByName(const uint16_t id,
                                       const SpiDriver_FldName_t* const varName,
@@ -38,6 +41,7 @@ FuncResult_e spiDriver_SetMultiByName(const uint16_t id,
                                       const SpiDriver_FldName_t* const bitFieldName)
 {
     FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    spiDriver_BrokerBusEnter();
     SYNC_PRINT("Set parameter %s[%s] to %u for IC(s) %u\n", varName, bitFieldName, value, id);
     if (id == IC_ID_BROADCAST) {
         uint16_t ind;
@@ -49,6 +53,7 @@ FuncResult_e spiDriver_SetMultiByName(const uint16_t id,
         res |= spiCom_SetDev(id);
         res |= spiDriver_SetByName(varName, value, bitFieldName);
     }
+    spiDriver_BrokerBusLeave();
     return res;
 }
 
@@ -59,6 +64,7 @@ FuncResult_e spiDriver_GetMultiByName(const uint16_t id,
                                       const SpiDriver_FldName_t* const bitFieldName)
 {
     FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    spiDriver_BrokerBusEnter();
     SYNC_PRINT("Get parameter %s[%s] from IC(s) %u\n", varName, bitFieldName, id);
     if (id == IC_ID_BROADCAST) {
         uint16_t ind;
@@ -71,6 +77,7 @@ FuncResult_e spiDriver_GetMultiByName(const uint16_t id,
         res |= spiCom_SetDev(id);
         res |= spiDriver_GetByName(varName, values, bitFieldName);
     }
+    spiDriver_BrokerBusLeave();
     return res;
 }
 
@@ -81,6 +88,7 @@ FuncResult_e spiDriver_SetSyncByName(const SpiDriver_FldName_t* const varName,
                                      const SpiDriver_FldName_t* const bitFieldName)
 {
     FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    spiDriver_BrokerBusEnter();
     SYNC_PRINT("Set var %s[%s] = 0x%04x for %u ICs\n", varName, bitFieldName, value, syncModeCfg.icCount);
 #if (SYNC_TEST_FLOW != 1)
     uint16_t ind;
@@ -98,6 +106,36 @@ FuncResult_e spiDriver_SetSyncByName(const SpiDriver_FldName_t* const varName,
     {
         res = spiDriver_SetByName(varName, value, bitFieldName);
     }
+    spiDriver_BrokerBusLeave();
+    return res;
+}
+
+
+FuncResult_e spiDriver_SetSyncVarsByName(const SpiDriver_FldName_t* const* const varNames,
+                                         const uint32_t* const values,
+                                         const SpiDriver_FldName_t* const* const bitFieldNames,
+                                         const uint16_t varsNumber)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    spiDriver_BrokerBusEnter();
+    SYNC_PRINT("Set %u vars for %u ICs\n", varsNumber, syncModeCfg.icCount);
+#if (SYNC_TEST_FLOW != 1)
+    uint16_t ind;
+    uint16_t ic;
+    if (syncModeCfg.icCount > 1u) {
+        for (ind = 0u; ind < syncModeCfg.icCount; ind++) {
+            ic = syncModeCfg.icCount - ind - 1;
+            spiCom_SetDev(spiDriver_currentState.params[ic].icIndex);
+            res |= spiDriver_SetVarsByName(varNames, values, bitFieldNames, varsNumber);
+        }
+    } else
+#else
+    spiCom_SetDev(0u);
+#endif
+    {
+        res = spiDriver_SetVarsByName(varNames, values, bitFieldNames, varsNumber);
+    }
+    spiDriver_BrokerBusLeave();
     return res;
 }
 
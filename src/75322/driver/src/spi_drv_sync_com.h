@@ -90,6 +90,20 @@ FuncResult_e spiDriver_SetSyncByName(const SpiDriver_FldName_t* const varName,
                                      const SpiDriver_FldName_t* const bitFieldName);
 
 
+/** Sets several variables by their names in all ICs, coalescing the adjacent ones
+ * See ::spiDriver_SetVarsByName for details.
+ * @param[in]   varNames        variables' names
+ * @param[in]   values          values to set
+ * @param[in]   bitFieldNames   bit-field names per variable. Can be NULL
+ * @param[in]   varsNumber      items count in the arrays
+ * @return  result of an operation. See ::FuncResult_e for details
+ */
+FuncResult_e spiDriver_SetSyncVarsByName(const SpiDriver_FldName_t* const* const varNames,
+                                         const uint32_t* const values,
+                                         const SpiDriver_FldName_t* const* const bitFieldNames,
+                                         const uint16_t varsNumber);
+
+
 /** Uploads the patch into the IC
  * @param[in]       offset  data initial offset
  * @param[in]       size    data size to write
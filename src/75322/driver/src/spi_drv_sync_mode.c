@@ -27,11 +27,10 @@
 #include "spi_drv_api.h"
 #include "spi_drv_sync_mode.h"
 #include "spi_drv_trace.h"
+#include "spi_drv_instance_priv.h"
 
-/** Global synchronous mode configuration data, used in driver's API functions */
-SyncModeCfg_t syncModeCfg = {
-    .icCount = 0u,                  /**< Actual number of IC in a sequence */
-};
+/** Synchronous mode configuration data per instance. The actual number of IC in a sequence is 0 until configured */
+SyncModeCfg_t syncModeCfgInst[SPI_DRV_MAX_HANDLES];
 
 /** Specific layer's parameters taken into account in syncronous mode */
 typedef struct {
@@ -54,9 +53,6 @@ typedef struct {
 } SyncSceneConfig_t;
 
 
-extern volatile SpiDriver_State_t spiDriver_currentState;
-
-
 FuncResult_e spiDriver_SyncModeInit(const SyncModeCfg_t* cfg)
 {
     FuncResult_e res = SPI_DRV_FUNC_RES_OK;
@@ -72,6 +68,8 @@ FuncResult_e spiDriver_SyncModeInit(const SyncModeCfg_t* cfg)
             /* Intentionally skip the normal case */
         }
         syncModeCfg = *cfg;
+        /* The scene's programming cached is the one of the former ICs set */
+        spiDriver_InvalidateSceneParams(IC_ID_BROADCAST);
     }
     return res;
 }
@@ -98,6 +96,8 @@ FuncResult_e spiDriver_SetSyncIcOrder(const uint16_t* const icIds, const uint16_
             for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
                 spiDriver_currentState.params[ic].icIndex = icIds[ic];
             }
+            /* The ICs added don't have the scene's programming cached */
+            spiDriver_InvalidateSceneParams(IC_ID_BROADCAST);
         } else {
             fprintf(stderr, "Error: ICs number %u cannot be more than %u\n", icCount, MAX_IC_ID_NUMBER);
             res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
@@ -45,6 +45,7 @@ extern "C"
 #include <stdbool.h>
 #include <stdio.h>
 #include "spi_drv_common_types.h"
+#include "spi_drv_instance.h"
 #include "cont_mode_lib.h"
 #include "spi_drv_trace.h"
 #include "spi_drv_sync_com.h"
@@ -72,8 +73,6 @@ typedef struct {
     uint16_t icCount;       /**< IC's count in a sequence the very first one is master */
 } SyncModeCfg_t;
 
-extern SyncModeCfg_t syncModeCfg;
-
 
 /** Inititates the syncronous mode
  * The function copies the configuration to the local variables
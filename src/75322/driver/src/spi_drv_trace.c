@@ -26,14 +26,66 @@
 #include "spi_drv_api.h"
 #include "spi_drv_data.h"
 #include "spi_drv_trace.h"
+#include "spi_drv_trace_conv.h"
+#include "spi_drv_continuity.h"
 #include "spi_drv_com.h"
 #include "cont_mode_lib.h"
 #include "spi_drv_sync_com.h"
+#include "spi_drv_instance_priv.h"
 
 /* Internal types */
 
+/** Scene's descriptor cached per IC */
+typedef struct {
+    bool valid;                                             /**< The descriptor matches the IC's state */
+    uint32_t sceneParam;                                    /**< scene_param */
+    uint32_t sceneLayersAmount;                             /**< scene_layers_amount */
+    uint32_t sceneSyncMode;                                 /**< scene_sync_mode */
+    spiDriver_LayerCurrentConfig_t layers[LAYERS_ORDER_MAX]; /**< Layers' order, output mode and size */
+} SceneParamsCache_t;
+
+/** Scene's programming last applied by spiDriver_SetLayers() to all ICs */
+typedef struct {
+    bool contKnown;                         /**< continuous_en value is known */
+    bool cont;                              /**< continuous_en */
+    bool amountKnown;                       /**< scene_layers_amount value is known */
+    uint8_t amount;                         /**< scene_layers_amount */
+    bool orderKnown[LAYERS_ORDER_MAX];      /**< scene_layers_order_N value is known */
+    uint16_t order[LAYERS_ORDER_MAX];       /**< scene_layers_order_N */
+    bool rawModeKnown[LAYERS_ORDER_MAX];    /**< layer_N_raw_mode_en value is known, per layer's ID */
+    bool rawMode[LAYERS_ORDER_MAX];         /**< layer_N_raw_mode_en, per layer's ID */
+} SceneProgram_t;
+
+/** Layer's acquisition mask set by spiDriver_SetAcquMask() */
+typedef struct {
+    bool enabled;                   /**< The mask is applied */
+    spiDriver_AcquMask_t mask;      /**< Mask */
+} AcquMaskEntry_t;
+
+/** Amount of gain variables per layer */
+#define LAYER_GAIN_VARS 8u
+/** Amount of variables written per layer by spiDriver_SetLayersConfig(), except gains */
+#define LAYER_CONFIG_WRITE_VARS 6u
+
+/** Set of variables' writes, collected to be done by block writes */
+typedef struct {
+    SpiDriver_FldName_t (*names)[MAX_FLD_NAME]; /**< Variables' names, followed by the fields' names */
+    const SpiDriver_FldName_t** namePtrs;       /**< Pointers to variables' names, followed by the fields' names */
+    uint32_t* values;                           /**< Values to write */
+    uint16_t count;                             /**< Amount of variables in batch */
+    uint16_t capacity;                          /**< Maximum amount of variables */
+} VarsBatch_t;
+
+/** Amount of variables read per layer by spiDriver_ReadLayerConfig() */
+#define LAYER_CONFIG_VARS 8u
+
+/** Minimum amount of scenes captured by spiDriver_GetScenes() in continuous mode */
+#define BURST_SCENES_MIN 3u
+
+/** Maximum amount of variable writes done by spiDriver_SetLayers() */
+#define SCENE_PROGRAM_WRITES_MAX (1u + (2u * LAYERS_ORDER_MAX))
+
 /* Global Variables */
-extern ContModeCfg_t contModeCfg;
 
 /** Default setLayer configuration used for spiDriver_SetLayerConfig() call */
 const spiDriver_LayerConfig_t spiDriver_DefaultLayerConfig = {
@@ -53,21 +105,64 @@ extern ComStat_e spiCom_WaitForReady(void);
 extern void spiDriver_UpdateCurrentData(const spiDriver_ChipData_t* const spiDriver_chipDataTmp,
                                         const uint16_t spiDriver_chipDataSizeTmp);
 
-volatile spiDriver_ChipData_t* spiDriver_chipData;
-volatile uint16_t spiDriver_chipDataSize;
-volatile SpiDriver_State_t spiDriver_currentState;
-
-static cbLightFunc_t lightControlFunction = NULL;
+volatile spiDriver_ChipData_t* spiDriver_chipDataInst[SPI_DRV_MAX_HANDLES];
+volatile uint16_t spiDriver_chipDataSizeInst[SPI_DRV_MAX_HANDLES];
+volatile SpiDriver_State_t spiDriver_currentStateInst[SPI_DRV_MAX_HANDLES];
+
+static cbLightFunc_t lightControlFunctionInst[SPI_DRV_MAX_HANDLES];
+static cbSyncDone_t syncDoneFunctionInst[SPI_DRV_MAX_HANDLES];
+static SceneParamsCache_t sceneParamsCacheInst[SPI_DRV_MAX_HANDLES][MAX_IC_ID_NUMBER];
+static SceneProgram_t sceneProgramInst[SPI_DRV_MAX_HANDLES];
+static AcquMaskEntry_t acquMasksInst[SPI_DRV_MAX_HANDLES][LAYERS_ORDER_MAX];
+static spiDriver_AcquMaskStats_t acquMaskStatsInst[SPI_DRV_MAX_HANDLES];
+static uint32_t acquSceneBytesInst[SPI_DRV_MAX_HANDLES];
+static uint32_t acquSceneBytesSavedInst[SPI_DRV_MAX_HANDLES];
+
+#define lightControlFunction (lightControlFunctionInst[SPI_DRV_INSTANCE])
+#define syncDoneFunction (syncDoneFunctionInst[SPI_DRV_INSTANCE])
+#define sceneParamsCache (sceneParamsCacheInst[SPI_DRV_INSTANCE])
+#define sceneProgram (sceneProgramInst[SPI_DRV_INSTANCE])
+#define acquMasks (acquMasksInst[SPI_DRV_INSTANCE])
+#define acquMaskStats (acquMaskStatsInst[SPI_DRV_INSTANCE])
+#define acquSceneBytes (acquSceneBytesInst[SPI_DRV_INSTANCE])
+#define acquSceneBytesSaved (acquSceneBytesSavedInst[SPI_DRV_INSTANCE])
 
 /* Internal helper functions */
 static uint16_t spiDriver_GetEchoSize(const EchoFormatSize_e echoFormat);
 static uint16_t spiDriver_GetCurrentLayer(uint16_t layerIndex);
 static FuncResult_e spiDriver_SendSensorStart(SpiDriver_Params_t* params);
+FuncResult_e spiDriver_StopContinuousModeInt(const uint16_t icIdx);
 
 
 
-/** Reads necessary variables */
-static FuncResult_e spiDriver_GetParam(SpiDriver_Params_t* params)
+/** Copies the cached scene's descriptor into the parameters */
+static void spiDriver_SceneParamsFromCache(const SceneParamsCache_t* const cache, SpiDriver_Params_t* params)
+{
+    params->sceneParam = cache->sceneParam;
+    params->sceneLayersAmount = cache->sceneLayersAmount;
+    params->sceneSyncMode = cache->sceneSyncMode;
+    for (uint16_t layerInd = 0u; layerInd < cache->sceneLayersAmount; layerInd++) {
+        params->layers[layerInd].layerId = cache->layers[layerInd].layerId;
+        params->layers[layerInd].isTrace = cache->layers[layerInd].isTrace;
+        params->layers[layerInd].nSamples = cache->layers[layerInd].nSamples;
+        params->layers[layerInd].format = cache->layers[layerInd].format;
+    }
+}
+
+
+/** Stores the scene's descriptor into the cache */
+static void spiDriver_SceneParamsToCache(const SpiDriver_Params_t* params, SceneParamsCache_t* const cache)
+{
+    cache->sceneParam = params->sceneParam;
+    cache->sceneLayersAmount = params->sceneLayersAmount;
+    cache->sceneSyncMode = params->sceneSyncMode;
+    memcpy(cache->layers, params->layers, sizeof(cache->layers[0u]) * params->sceneLayersAmount);
+    cache->valid = true;
+}
+
+
+/** Reads necessary variables from IC */
+static FuncResult_e spiDriver_ReadParam(SpiDriver_Params_t* params)
 {
     FuncResult_e res;
     char name[MAX_FLD_NAME];
@@ -109,6 +204,188 @@ static FuncResult_e spiDriver_GetParam(SpiDriver_Params_t* params)
 }
 
 
+/** Reads necessary variables
+ * The values are taken from the cache of the selected IC when they were not changed since the last read.
+ */
+static FuncResult_e spiDriver_GetParam(SpiDriver_Params_t* params)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    const uint16_t dev = spiDriver_SpiGetDev();
+    SceneParamsCache_t* cache = (dev < MAX_IC_ID_NUMBER) ? &sceneParamsCache[dev] : NULL;
+
+    if ((cache != NULL) && cache->valid) {
+        spiDriver_SceneParamsFromCache(cache, params);
+        TRACE_PRINT("IC %u: scene params from cache, layers: %u\n", dev, params->sceneLayersAmount);
+    } else {
+        res = spiDriver_ReadParam(params);
+        if ((cache != NULL) && (res == SPI_DRV_FUNC_RES_OK) && (params->sceneLayersAmount <= LAYERS_ORDER_MAX)) {
+            spiDriver_SceneParamsToCache(params, cache);
+        }
+    }
+    return res;
+}
+
+
+void spiDriver_InvalidateSceneParams(const uint16_t icId)
+{
+    /* The scene's programming is shared by all ICs */
+    memset(&sceneProgram, 0, sizeof(sceneProgram));
+    if (icId < MAX_IC_ID_NUMBER) {
+        sceneParamsCache[icId].valid = false;
+    } else {
+        for (uint16_t ic = 0u; ic < MAX_IC_ID_NUMBER; ic++) {
+            sceneParamsCache[ic].valid = false;
+        }
+    }
+}
+
+
+void spiDriver_SceneParamsOnWrite(const SpiDriver_FldName_t* const varName, const uint16_t icId)
+{
+    bool isSceneVar = (strncmp(varName, "scene_", 6u) == 0);
+    if ((!isSceneVar) && (strncmp(varName, "layer_", 6u) == 0)) {
+        /* layer_<N>_param, layer_<N>_n_samples, layer_<N>_echo_format */
+        const char* suffix = strchr(&varName[6u], '_');
+        isSceneVar = (suffix != NULL) &&
+                     ((strcmp(suffix, "_param") == 0) ||
+                      (strcmp(suffix, "_n_samples") == 0) ||
+                      (strcmp(suffix, "_echo_format") == 0));
+    }
+    if (isSceneVar) {
+        spiDriver_InvalidateSceneParams(icId);
+    } else if (strcmp(varName, "param") == 0) {
+        /* continuous_en */
+        sceneProgram.contKnown = false;
+    }
+}
+
+
+FuncResult_e spiDriver_SetAcquMask(const uint16_t layerId, const spiDriver_AcquMask_t* const mask)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    if (layerId < LAYERS_ORDER_MAX) {
+        if (mask != NULL) {
+            acquMasks[layerId].mask = *mask;
+            acquMasks[layerId].enabled = true;
+        } else {
+            acquMasks[layerId].enabled = false;
+        }
+        TRACE_PRINT("Layer %u acquisition mask: %s\n", layerId, (mask != NULL) ? "set" : "cleared");
+    } else {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+    }
+    return res;
+}
+
+
+void spiDriver_GetAcquMaskStats(spiDriver_AcquMaskStats_t* const stats)
+{
+    if (stats != NULL) {
+        *stats = acquMaskStats;
+    }
+}
+
+
+void spiDriver_ResetAcquMaskStats(void)
+{
+    memset(&acquMaskStats, 0, sizeof(acquMaskStats));
+    acquSceneBytes = 0u;
+    acquSceneBytesSaved = 0u;
+}
+
+
+/** Returns the acquisition mask of the layer or NULL if the whole layer should be read */
+static const spiDriver_AcquMask_t* spiDriver_GetAcquMask(const uint16_t layerId)
+{
+    const spiDriver_AcquMask_t* mask = NULL;
+    if ((layerId < LAYERS_ORDER_MAX) && acquMasks[layerId].enabled) {
+        mask = &acquMasks[layerId].mask;
+    }
+    return mask;
+}
+
+
+/** Accounts the data packet's bytes of the current scene */
+static void spiDriver_AcquCount(const uint32_t fullBytes, const uint32_t bytes)
+{
+    /* The ICs can be read by several threads, see ::spiDriver_getSingleSyncStepIcs */
+    __atomic_add_fetch(&acquSceneBytes, bytes, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&acquSceneBytesSaved, fullBytes - bytes, __ATOMIC_RELAXED);
+}
+
+
+/** Publishes the statistics of the scene finished */
+static void spiDriver_AcquSceneDone(void)
+{
+    acquMaskStats.sceneBytes = acquSceneBytes;
+    acquMaskStats.sceneBytesSaved = acquSceneBytesSaved;
+    acquMaskStats.totalBytesSaved += acquSceneBytesSaved;
+    acquMaskStats.scenesCount++;
+    acquSceneBytes = 0u;
+    acquSceneBytesSaved = 0u;
+}
+
+
+/** Reads the half of the trace layer's frame, applying the layer's acquisition mask
+ * The even half-frame returns the channels 0, 2, .. 30. The odd one starts with the channel 31, followed by
+ * the channels 1, 3, .. 29 (see spiDriver_CombineTraces()). */
+static FuncResult_e spiDriver_GetRawMasked(const uint16_t nSamples,
+                                           const uint16_t layerId,
+                                           const bool oddFrame,
+                                           uint16_t* trace,
+                                           uint16_t* rawMetaData)
+{
+    const spiDriver_AcquMask_t* mask = spiDriver_GetAcquMask(layerId);
+    uint16_t frameMask = 0xFFFFu;
+    uint16_t samples = nSamples;
+    uint16_t channels = N_CHANNELS / 2u;
+    if (mask != NULL) {
+        if (mask->channelMask != 0u) {
+            frameMask = 0u;
+            channels = 0u;
+            for (uint16_t cc = 0u; cc < (N_CHANNELS / 2u); cc++) {
+                const uint16_t channel = oddFrame ? ((2u * ((cc + 15u) % 16u)) + 1u) : (2u * cc);
+                if ((mask->channelMask & (1u << channel)) != 0u) {
+                    frameMask |= (uint16_t)(1u << cc);
+                    channels++;
+                }
+            }
+        }
+        if ((mask->samplesCount != 0u) && (((uint32_t)mask->firstSample + mask->samplesCount) < nSamples)) {
+            samples = mask->firstSample + mask->samplesCount;
+        }
+    }
+    /* Each channel's packet 2 carries 8 words of metadata and a header with CRC of 2 words */
+    spiDriver_AcquCount((N_CHANNELS / 2u) * (nSamples + METADATA_SIZE + 2u) * sizeof(uint16_t),
+                        ((channels * samples) + ((N_CHANNELS / 2u) * (METADATA_SIZE + 2u))) * sizeof(uint16_t));
+    return spiCom_GetRawWindow(nSamples + METADATA_SIZE, samples, frameMask, trace, rawMetaData);
+}
+
+
+/** Reads the echo layer, applying the layer's acquisition mask
+ * The echo transfer has the size fixed by the echo format, so the whole layer is read and the channels masked-out
+ * are cleared after */
+static FuncResult_e spiDriver_GetEchoMasked(const uint16_t echoWords,
+                                            const uint16_t layerId,
+                                            uint16_t* echoesData,
+                                            uint16_t* echoMetaData)
+{
+    const spiDriver_AcquMask_t* mask = spiDriver_GetAcquMask(layerId);
+    FuncResult_e res;
+    spiDriver_AcquCount((echoWords + 2u) * sizeof(uint16_t), (echoWords + 2u) * sizeof(uint16_t));
+    res = spiCom_GetEcho(echoWords, echoesData, echoMetaData);
+    if ((mask != NULL) && (mask->channelMask != 0u) && (echoWords > METADATA_SIZE)) {
+        const uint16_t channelWords = (echoWords - METADATA_SIZE) / ECHO_NUM_CHANNEL;
+        for (uint16_t channel = 0u; channel < ECHO_NUM_CHANNEL; channel++) {
+            if ((mask->channelMask & (1u << channel)) == 0u) {
+                memset(&echoesData[channel * channelWords], 0, channelWords * sizeof(uint16_t));
+            }
+        }
+    }
+    return res;
+}
+
+
 static uint16_t spiDriver_GetEchoSize(const EchoFormatSize_e echoFormat)
 {
     uint16_t size = 0u;
@@ -149,6 +426,38 @@ static uint16_t spiDriver_GetCurrentLayer(uint16_t layerIndex)
     return currLayer;
 }
 
+/** Returns raw_mode_en value for the layer in a sequence */
+static uint32_t spiDriver_GetTraceModeValue(const uint16_t layerIndex,
+                                            const TraceCfgType_t isTrace,
+                                            const ProcOrder_e* const procOrder)
+{
+    uint32_t traceModeValue;
+    if (procOrder == NULL) {
+        /* Set order for current layer */
+        switch (isTrace) {
+            case SPI_DRV_CFG_OUT_ECHO:
+                traceModeValue = 0u;
+                break;
+            case SPI_DRV_CFG_OUT_TRACE:
+                traceModeValue = 1u;
+                break;
+            default:
+                traceModeValue = 1u;
+                break;
+        }
+    } else {
+        if (procOrder[layerIndex] == PROC_ORDER_TRACE) {
+            traceModeValue = 1;
+        } else if (procOrder[layerIndex] == PROC_ORDER_ECHO) {
+            traceModeValue = 0;
+        } else {
+            traceModeValue = 0; /* The value should be assigned anyway */
+        }
+    }
+    return traceModeValue;
+}
+
+
 FuncResult_e spiDriver_SetLayers(uint8_t nLayer,
                                  const uint16_t* const layerOrder,
                                  const TraceCfgType_t isTrace,
@@ -156,10 +465,15 @@ FuncResult_e spiDriver_SetLayers(uint8_t nLayer,
                                  bool cont)
 {
     FuncResult_e res;
-    uint32_t traceModeValue;
     uint32_t contMode;
-    char name[MAX_FLD_NAME];
-    char fld_name[MAX_FLD_NAME];
+    SceneProgram_t next = sceneProgram;
+    char names[SCENE_PROGRAM_WRITES_MAX][MAX_FLD_NAME];
+    char fldNames[SCENE_PROGRAM_WRITES_MAX][MAX_FLD_NAME];
+    const SpiDriver_FldName_t* varList[SCENE_PROGRAM_WRITES_MAX];
+    const SpiDriver_FldName_t* fldList[SCENE_PROGRAM_WRITES_MAX];
+    uint32_t values[SCENE_PROGRAM_WRITES_MAX];
+    uint16_t orderWrites = 0u;
+    uint16_t writes;
 
     /* Continuous mode ? */
     res = SPI_DRV_FUNC_RES_OK;
@@ -168,77 +482,88 @@ FuncResult_e spiDriver_SetLayers(uint8_t nLayer,
     } else {
         contMode = 0ul;
     }
-    res |= spiDriver_SetSyncByName("param", contMode, "continuous_en");
+    if ((!next.contKnown) || (next.cont != cont)) {
+        res |= spiDriver_SetSyncByName("param", contMode, "continuous_en");
+        next.contKnown = true;
+        next.cont = cont;
+    }
     spiDriver_currentState.continuousMode = cont;
 
-    if (nLayer > 0u) {
+    if ((nLayer > 0u) && (nLayer <= LAYERS_ORDER_MAX)) {
         /* Set number of layers */
         TRACE_PRINT("Scene's layers amount:%u\n", nLayer);
-        res |= spiDriver_SetSyncByName("scene_layers_amount", (uint32_t)nLayer, NULL); /* TODO: layers should be managed for whole multi-layers' config */
+        if ((!next.amountKnown) || (next.amount != nLayer)) {
+            strcpy(names[orderWrites], "scene_layers_amount");
+            fldNames[orderWrites][0] = '\0';
+            values[orderWrites] = (uint32_t)nLayer;
+            orderWrites++;
+            next.amountKnown = true;
+            next.amount = nLayer;
+        }
 
+        writes = orderWrites;
         if (layerOrder != NULL) {
             /* Set layers order */
             TRACE_PRINT("Scene's layers sequence:");
             for (uint16_t layerIndex = 0; layerIndex < nLayer; layerIndex++) {
-                sprintf(name, "scene_layers_order_%u", layerIndex);
-                res |= spiDriver_SetSyncByName(name, (uint32_t)(layerOrder[layerIndex]), NULL);
                 TRACE_PRINT("%u, ", layerOrder[layerIndex]);
-                if (isTrace != SPI_DRV_CFG_OUT_NC) {
-                    sprintf(name, "layer_%u_param", layerOrder[layerIndex]);
-                    sprintf(fld_name, "layer_%u_raw_mode_en", layerOrder[layerIndex]);
-                    if (procOrder == NULL) {
-                        /* Set order for current layer */
-                        switch (isTrace) {
-                            case SPI_DRV_CFG_OUT_ECHO:
-                                traceModeValue = 0u;
-                                break;
-                            case SPI_DRV_CFG_OUT_TRACE:
-                                traceModeValue = 1u;
-                                break;
-                            default:
-                                traceModeValue = 1u;
-                                break;
-                        }
-                    } else {
-                        if (procOrder[layerIndex] == PROC_ORDER_TRACE) {
-                            traceModeValue = 1;
-                        } else if (procOrder[layerIndex] == PROC_ORDER_ECHO) {
-                            traceModeValue = 0;
-                        } else {
-                            traceModeValue = 0; /* The value should be assigned anyway */
-                        }
-                    }
-                    res |= spiDriver_SetSyncByName(name, traceModeValue, fld_name);
+                if ((!next.orderKnown[layerIndex]) || (next.order[layerIndex] != layerOrder[layerIndex])) {
+                    sprintf(names[writes], "scene_layers_order_%u", layerIndex);
+                    fldNames[writes][0] = '\0';
+                    values[writes] = (uint32_t)(layerOrder[layerIndex]);
+                    writes++;
+                    next.orderKnown[layerIndex] = true;
+                    next.order[layerIndex] = layerOrder[layerIndex];
                 }
             }
             TRACE_PRINT("\n");
+            orderWrites = writes;
+
+            /* Set layers' processing mode. The mode is kept per layer's ID */
+            for (uint16_t layerIndex = 0; (layerIndex < nLayer) && (isTrace != SPI_DRV_CFG_OUT_NC); layerIndex++) {
+                const uint16_t layerId = layerOrder[layerIndex];
+                const uint32_t traceModeValue = spiDriver_GetTraceModeValue(layerIndex, isTrace, procOrder);
+                const bool known = (layerId < LAYERS_ORDER_MAX) && next.rawModeKnown[layerId];
+                if ((!known) || (next.rawMode[layerId] != (traceModeValue != 0u))) {
+                    sprintf(names[writes], "layer_%u_param", layerId);
+                    sprintf(fldNames[writes], "layer_%u_raw_mode_en", layerId);
+                    values[writes] = traceModeValue;
+                    writes++;
+                    if (layerId < LAYERS_ORDER_MAX) {
+                        next.rawModeKnown[layerId] = true;
+                        next.rawMode[layerId] = (traceModeValue != 0u);
+                    }
+                }
+            }
         }
-    }
-    return res;
-}
-
 
-static FuncResult_e spiDriver_SetGain(const spiDriver_LayerConfig_t* const layerConfiguration)
-{
-    FuncResult_e res;
-    char name[MAX_FLD_NAME];
-    uint16_t gainPattern = layerConfiguration->gain;
-    /* Gains for all channels */
-    if (layerConfiguration->gain < GAIN_MAX_VALUE) {
-        gainPattern = gainPattern + (gainPattern << 4) + (gainPattern << 8) + (gainPattern << 12);
-        for (uint8_t i = 0u; i < 2; i++) {
-            for (uint8_t j = 0u; j < 4; j++) {
-                sprintf(name, "layer_%u_gains_%u_%u", layerConfiguration->layer_nth, i, j);
-                res = SPI_DRV_FUNC_RES_OK;
-                res |= spiDriver_SetSyncByName(name, gainPattern, NULL);
-            }
+        for (uint16_t ind = 0u; ind < writes; ind++) {
+            varList[ind] = names[ind];
+            fldList[ind] = fldNames[ind];
         }
+        /* Layers amount and order are adjacent, they are written as one block */
+        if (orderWrites > 0u) {
+            res |= spiDriver_SetSyncVarsByName(varList, values, fldList, orderWrites);
+        }
+        if (writes > orderWrites) {
+            res |= spiDriver_SetSyncVarsByName(&varList[orderWrites], &values[orderWrites], &fldList[orderWrites],
+                                               writes - orderWrites);
+        }
+        TRACE_PRINT("Scene programming: %u of %u writes needed\n", writes, (uint16_t)(1u + 2u * nLayer));
+    } else if (nLayer > LAYERS_ORDER_MAX) {
+        res |= SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+    }
+
+    /* Own writes drop the state, so it's replaced only when all of them succeeded */
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        sceneProgram = next;
     } else {
-        res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+        memset(&sceneProgram, 0, sizeof(sceneProgram));
     }
     return res;
 }
 
+
 FuncResult_e spiDriver_SetOutputModeConfig(const spiDriver_LayerConfig_t* const layerConfiguration)
 {
     FuncResult_e res;
@@ -262,61 +587,190 @@ FuncResult_e spiDriver_SetOutputModeConfig(const spiDriver_LayerConfig_t* const
     return res;
 }
 
-FuncResult_e spiDriver_SetLayerConfig(const spiDriver_LayerConfig_t* const layerConfiguration)
+/** Creates the variables' batch for the desired amount of variables */
+static FuncResult_e spiDriver_VarsBatchInit(VarsBatch_t* const batch, const uint16_t capacity)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    batch->names = malloc(2u * capacity * MAX_FLD_NAME);
+    batch->namePtrs = malloc(2u * capacity * sizeof(SpiDriver_FldName_t*));
+    batch->values = malloc(capacity * sizeof(uint32_t));
+    batch->count = 0u;
+    batch->capacity = capacity;
+    if ((batch->names == NULL) || (batch->namePtrs == NULL) || (batch->values == NULL)) {
+        batch->capacity = 0u;
+        res = SPI_DRV_FUNC_RES_FAIL_MEMORY;
+    }
+    return res;
+}
+
+
+/** Releases the variables' batch */
+static void spiDriver_VarsBatchFree(VarsBatch_t* const batch)
+{
+    free(batch->names);
+    free(batch->namePtrs);
+    free(batch->values);
+    batch->names = NULL;
+    batch->namePtrs = NULL;
+    batch->values = NULL;
+    batch->capacity = 0u;
+}
+
+
+/** Appends the variable's write into the batch. The field's name can be NULL */
+static void spiDriver_VarsBatchAdd(VarsBatch_t* const batch,
+                                   const char* const name,
+                                   const char* const fldName,
+                                   const uint32_t value)
+{
+    if (batch->count < batch->capacity) {
+        const uint16_t ind = batch->count;
+        SpiDriver_FldName_t* varName = batch->names[ind];
+        SpiDriver_FldName_t* varFldName = batch->names[batch->capacity + ind];
+        strncpy(varName, name, MAX_FLD_NAME - 1u);
+        varName[MAX_FLD_NAME - 1u] = '\0';
+        batch->namePtrs[ind] = varName;
+        batch->namePtrs[batch->capacity + ind] = NULL;
+        if (fldName != NULL) {
+            strncpy(varFldName, fldName, MAX_FLD_NAME - 1u);
+            varFldName[MAX_FLD_NAME - 1u] = '\0';
+            batch->namePtrs[batch->capacity + ind] = varFldName;
+        }
+        batch->values[ind] = value;
+        batch->count++;
+    }
+}
+
+
+/** Writes the batch into the currently selected IC */
+static FuncResult_e spiDriver_VarsBatchWrite(const VarsBatch_t* const batch)
+{
+    return spiDriver_SetVarsByName(batch->namePtrs, batch->values, &batch->namePtrs[batch->capacity], batch->count);
+}
+
+
+/** Writes the batch into all ICs */
+static FuncResult_e spiDriver_VarsBatchWriteSync(const VarsBatch_t* const batch)
+{
+    return spiDriver_SetSyncVarsByName(batch->namePtrs, batch->values, &batch->namePtrs[batch->capacity],
+                                       batch->count);
+}
+
+
+/** Appends the layer's own variables, except gains */
+static void spiDriver_AddLayerVars(VarsBatch_t* const batch, const spiDriver_LayerConfig_t* const layerConfiguration)
 {
-    FuncResult_e res;
     char name[MAX_FLD_NAME];
     char fld_name[MAX_FLD_NAME];
-    uint32_t contModeValue;
+    const uint16_t layer = layerConfiguration->layer_nth;
 
-    /* Continuous mode */
-    res = SPI_DRV_FUNC_RES_OK;
-    if (layerConfiguration->continuousEnable) {
-        contModeValue = 1ul;
-    } else {
-        contModeValue = 0ul;
-    }
-    res |= spiDriver_SetSyncByName("param", contModeValue, "continuous_en");
+    /* Layer's raw mode */
+    sprintf(name, "layer_%u_param", layer);
+    sprintf(fld_name, "layer_%u_raw_mode_en", layer);
+    spiDriver_VarsBatchAdd(batch, name, fld_name, layerConfiguration->isTrace ? 1ul : 0ul);
 
-    if (layerConfiguration->samplingMode < SAMPLING_MODE_COUNT) {
+    /* Sampling mode */
+    sprintf(name, "layer_%u_sampling_port_sampling_mode", layer);
+    spiDriver_VarsBatchAdd(batch, name, NULL, layerConfiguration->samplingMode);
 
-        /* Set layer's raw mode */
-        res |= spiDriver_SetOutputModeConfig(layerConfiguration);
+    /* Sampling size */
+    sprintf(name, "layer_%u_sampling_PORT_SAMP_CFG", layer);
+    sprintf(fld_name, "layer_%u_sampling_size", layer);
+    spiDriver_VarsBatchAdd(batch, name, fld_name, layerConfiguration->samplingSize);
 
-        if (syncModeCfg.icCount >= 2) {
-            res |= spiCom_SetDev(layerConfiguration->ic_id);
-        }
+    /* Samples number */
+    sprintf(name, "layer_%u_n_samples", layer);
+    spiDriver_VarsBatchAdd(batch, name, NULL, layerConfiguration->nSamples);
 
-        /* Sampling mode */
-        sprintf(name, "layer_%u_sampling_port_sampling_mode", layerConfiguration->layer_nth);
-        res |= spiDriver_SetByName(name, layerConfiguration->samplingMode, NULL);
+    /* Averaging */
+    sprintf(name, "layer_%u_averaging", layer);
+    spiDriver_VarsBatchAdd(batch, name, NULL, layerConfiguration->averaging);
 
-        /* Sampling size */
-        sprintf(name, "layer_%u_sampling_PORT_SAMP_CFG", layerConfiguration->layer_nth);
-        sprintf(fld_name, "layer_%u_sampling_size", layerConfiguration->layer_nth);
-        res |= spiDriver_SetByName(name, layerConfiguration->samplingSize, fld_name);
+    /* Threshold */
+    sprintf(name, "layer_%u_threshold", layer);
+    spiDriver_VarsBatchAdd(batch, name, NULL, layerConfiguration->echoThreshold);
+}
 
-        /* Samples number */
-        sprintf(name, "layer_%u_n_samples", layerConfiguration->layer_nth);
-        res |= spiDriver_SetByName(name, layerConfiguration->nSamples, NULL);
 
-        /* Averaging */
-        sprintf(name, "layer_%u_averaging", layerConfiguration->layer_nth);
-        res |= spiDriver_SetByName(name, layerConfiguration->averaging, NULL);
+/** Appends the layer's gains for all channels */
+static void spiDriver_AddGainVars(VarsBatch_t* const batch, const spiDriver_LayerConfig_t* const layerConfiguration)
+{
+    char name[MAX_FLD_NAME];
+    uint16_t gainPattern = layerConfiguration->gain;
+    gainPattern = gainPattern + (gainPattern << 4) + (gainPattern << 8) + (gainPattern << 12);
+    for (uint8_t i = 0u; i < 2; i++) {
+        for (uint8_t j = 0u; j < 4; j++) {
+            sprintf(name, "layer_%u_gains_%u_%u", layerConfiguration->layer_nth, i, j);
+            spiDriver_VarsBatchAdd(batch, name, NULL, gainPattern);
+        }
+    }
+}
 
-        res |= spiDriver_SetGain(layerConfiguration);
-        /* Threshold */
-        sprintf(name, "layer_%u_threshold", layerConfiguration->layer_nth);
-        res |= spiDriver_SetByName(name, layerConfiguration->echoThreshold, NULL);
 
-    } else {
+FuncResult_e spiDriver_SetLayersConfig(const spiDriver_LayerConfig_t* const layerConfigurations,
+                                       const uint16_t layersCount)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    VarsBatch_t common = {0};
+    VarsBatch_t layers = {0};
+
+    for (uint16_t layer = 0u; layer < layersCount; layer++) {
         /* samplingMode should be within the range [0..6] */
-        res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+        if ((layerConfigurations[layer].samplingMode >= SAMPLING_MODE_COUNT) ||
+            (layerConfigurations[layer].gain >= GAIN_MAX_VALUE)) {
+            res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+        }
     }
+    if ((res == SPI_DRV_FUNC_RES_OK) && (layersCount > 0u)) {
+        res |= spiDriver_VarsBatchInit(&common, 1u + (layersCount * (LAYER_GAIN_VARS + LAYER_CONFIG_WRITE_VARS)));
+        res |= spiDriver_VarsBatchInit(&layers, layersCount * LAYER_CONFIG_WRITE_VARS);
+    }
+    if ((res == SPI_DRV_FUNC_RES_OK) && (layersCount > 0u)) {
+        /* Continuous mode and gains are set for all ICs */
+        spiDriver_VarsBatchAdd(&common, "param", "continuous_en",
+                               layerConfigurations[layersCount - 1u].continuousEnable ? 1ul : 0ul);
+        for (uint16_t layer = 0u; layer < layersCount; layer++) {
+            spiDriver_AddGainVars(&common, &layerConfigurations[layer]);
+        }
+        if (syncModeCfg.icCount >= 2) {
+            res |= spiDriver_VarsBatchWriteSync(&common);
+            /* The layer's own variables are written into the IC it belongs to */
+            for (uint16_t layer = 0u; layer < layersCount; layer++) {
+                const uint16_t ic_id = layerConfigurations[layer].ic_id;
+                bool icDone = false;
+                for (uint16_t prev = 0u; prev < layer; prev++) {
+                    icDone = icDone || (layerConfigurations[prev].ic_id == ic_id);
+                }
+                if (!icDone) {
+                    layers.count = 0u;
+                    for (uint16_t icLayer = layer; icLayer < layersCount; icLayer++) {
+                        if (layerConfigurations[icLayer].ic_id == ic_id) {
+                            spiDriver_AddLayerVars(&layers, &layerConfigurations[icLayer]);
+                        }
+                    }
+                    res |= spiCom_SetDev(ic_id);
+                    res |= spiDriver_VarsBatchWrite(&layers);
+                }
+            }
+        } else {
+            for (uint16_t layer = 0u; layer < layersCount; layer++) {
+                spiDriver_AddLayerVars(&common, &layerConfigurations[layer]);
+            }
+            res |= spiDriver_VarsBatchWrite(&common);
+        }
+    }
+    spiDriver_VarsBatchFree(&common);
+    spiDriver_VarsBatchFree(&layers);
     return res;
 }
 
 
+FuncResult_e spiDriver_SetLayerConfig(const spiDriver_LayerConfig_t* const layerConfiguration)
+{
+    return spiDriver_SetLayersConfig(layerConfiguration, 1u);
+}
+
+
 static void spiDriver_AppendChipData(volatile SpiDriver_Params_t* params,
                                      spiDriver_ChipData_t** chipDataArrayP,
                                      uint16_t* chipDataArraySize,
@@ -357,17 +811,34 @@ static void spiDriver_AppendChipData(volatile SpiDriver_Params_t* params,
         chipDataArray[dataIndex].samples = samples;
         chipDataArray[dataIndex].status = status[ic];
         chipDataArray[dataIndex].chip_id = params->icIndex;
+        chipDataArray[dataIndex].sceneComplete = false;
+        spiDriver_ContinuityUpdate(&chipDataArray[dataIndex],
+                                   (icCount > 1u) ? spiDriver_currentState.params[ic].icIndex : params->icIndex);
+        spiDriver_TraceConvInline(&chipDataArray[dataIndex]);
         dataIndex++;
     }
     *chipDataArraySize = dataIndex;
 }
 
 
+/** Sets the scene-complete marker for the records of the layer */
+static void spiDriver_MarkSceneComplete(spiDriver_ChipData_t* chipDataArray,
+                                        const uint16_t first,
+                                        const uint16_t last,
+                                        const bool sceneComplete)
+{
+    for (uint16_t ind = first; ind < last; ind++) {
+        chipDataArray[ind].sceneComplete = sceneComplete;
+    }
+}
+
+
 void spiDriver_CleanChipData(spiDriver_ChipData_t* chipDataArray, uint16_t* chipDataArraySize)
 {
     for (uint16_t ind = 0u; ind < *chipDataArraySize; ind++) {
         free(chipDataArray[ind].data);
         free(chipDataArray[ind].metaData);
+        free(chipDataArray[ind].outData);
     }
     *chipDataArraySize = 0u;
 }
@@ -398,7 +869,11 @@ static void spiDriver_CombineTraces(volatile SpiDriver_Params_t* params,
 }
 
 
-/** Runs the Sync process according the (frame)-phase used, and settings */
+/** Runs the Sync process according the (frame)-phase used, and settings
+ * The sync of all ICs is made by the first IC's tick. With per-bus acquisition it runs in IC0's worker, which selects
+ * the ICs of the other buses too, so the other workers read only after the sync-done callback (see
+ * ::spiDriver_AssignSyncDone).
+ */
 static FuncResult_e spiDriver_MakeSync(const uint8_t nth_part)
 {
     volatile SpiDriver_Params_t* params;
@@ -478,9 +953,11 @@ static FuncResult_e spiDriver_GetSingleTrace(const uint16_t icInd,
     evenStatus[params->icIndex] = SPI_DRV_FUNC_RES_OK;
 #else
     /* Get trace of even channels */
-    evenStatus[params->icIndex] = spiCom_GetRaw(params->layers[layerInd].nSamples + 8,
-                                                (uint16_t*)evenTraceData,
-                                                (uint16_t*)evenEchoMetadata);
+    evenStatus[params->icIndex] = spiDriver_GetRawMasked(params->layers[layerInd].nSamples,
+                                                         params->layers[layerInd].layerId,
+                                                         false,
+                                                         (uint16_t*)evenTraceData,
+                                                         (uint16_t*)evenEchoMetadata);
 #endif /* SYNC_TEST_FLOW */
 
     if (icInd == 0u) {
@@ -497,8 +974,11 @@ static FuncResult_e spiDriver_GetSingleTrace(const uint16_t icInd,
     SYNC_PRINT("Getting the trace[2 from 2] from IC %u\n", params->icIndex);
     oddStatus[params->icIndex] = SPI_DRV_FUNC_RES_OK;
 #else
-    oddStatus[params->icIndex] = spiCom_GetRaw(params->layers[layerInd].nSamples + 8, (uint16_t*)oddTraceData,
-                                               (uint16_t*)oddEchoMetadata);
+    oddStatus[params->icIndex] = spiDriver_GetRawMasked(params->layers[layerInd].nSamples,
+                                                        params->layers[layerInd].layerId,
+                                                        true,
+                                                        (uint16_t*)oddTraceData,
+                                                        (uint16_t*)oddEchoMetadata);
 #endif /* SYNC_TEST_FLOW */
     spiDriver_CombineTraces(params,
                             (uint16_t*)evenTraceData,
@@ -509,6 +989,9 @@ static FuncResult_e spiDriver_GetSingleTrace(const uint16_t icInd,
 
     if (icInd == 0u) {
         spiDriver_MakeSync(1u);
+        if (syncDoneFunction != NULL) {
+            syncDoneFunction();
+        }
     }
 
     spiDriver_AppendChipData(params,
@@ -564,6 +1047,9 @@ static inline FuncResult_e spiDriver_GetSingleEcho(const uint16_t icInd,
     if (icInd == 0u) {
         spiDriver_MakeSync(0u);
         spiDriver_MakeSync(1u);
+        if (syncDoneFunction != NULL) {
+            syncDoneFunction();
+        }
     }
 
     TRACE_PRINT("Requesting %u words\n", params->layers[layerInd].nSamples);
@@ -575,9 +1061,10 @@ static inline FuncResult_e spiDriver_GetSingleEcho(const uint16_t icInd,
     SYNC_PRINT("Getting the echo from IC %u\n", params->icIndex);
     echoStatus[params->icIndex] = SPI_DRV_FUNC_RES_OK;
 #else
-    echoStatus[params->icIndex] = spiCom_GetEcho(params->layers[layerInd].nSamples,
-                                                 (uint16_t*)echoesData,
-                                                 (uint16_t*)echoMetadata);
+    echoStatus[params->icIndex] = spiDriver_GetEchoMasked(params->layers[layerInd].nSamples,
+                                                          params->layers[layerInd].layerId,
+                                                          (uint16_t*)echoesData,
+                                                          (uint16_t*)echoMetadata);
 #endif /* SYNC_TEST_FLOW */
     spiDriver_AppendChipData(params,
                              spiDriver_chipDataTmp,
@@ -620,11 +1107,17 @@ static inline FuncResult_e spiDriver_MakeSingleTick(const uint16_t icIdx,
                     params->layers[layerInd].layerId,
                     isTrace ? "TRACE" : "ECHO");
 
+        const uint16_t layerFirstRecord = *spiDriver_chipDataSizeTmp;
         if (isTrace) {
             res = spiDriver_GetSingleTrace(icIdx, params, spiDriver_chipDataTmp, spiDriver_chipDataSizeTmp);
         } else {
             res = spiDriver_GetSingleEcho(icIdx, params, spiDriver_chipDataTmp, spiDriver_chipDataSizeTmp);
         }
+        spiDriver_MarkSceneComplete(*spiDriver_chipDataTmp, layerFirstRecord, *spiDriver_chipDataSizeTmp,
+                                    (layerInd + 1u) >= params->sceneLayersAmount);
+        if (((layerInd + 1u) >= params->sceneLayersAmount) && ((icIdx + 1u) >= syncModeCfg.icCount)) {
+            spiDriver_AcquSceneDone();
+        }
     }
     return res;
 }
@@ -664,18 +1157,24 @@ FuncResult_e spiDriver_getSingleSceneAsync(const uint16_t icIdx,
     return res;
 }
 
-/** Makes a single synchro step in a synchronous mode
- * This function uses per-IC loop inside to make the single tick (in layers) for all chips
- * Returns the layers from all ICs in a structure
+/** Makes a single synchro step in a synchronous mode for the ICs selected
+ * This function uses per-IC loop inside to make the single tick (in layers) for the chips selected by the mask (bit
+ * per IC's index in the multi-IC configuration). The ICs on different buses can be read by different threads at
+ * once, then the synchronization of all ICs made by the first IC's tick should be waited for (see ::cbSyncDone_t)
+ * Returns the layers from the ICs selected in a structure
  * @return
  */
-FuncResult_e spiDriver_getSingleSyncStep(spiDriver_ChipData_t** spiDriver_chipDataTmp,
-                                         uint16_t* spiDriver_chipDataSizeTmp)
+FuncResult_e spiDriver_getSingleSyncStepIcs(const uint32_t icMask,
+                                            spiDriver_ChipData_t** spiDriver_chipDataTmp,
+                                            uint16_t* spiDriver_chipDataSizeTmp)
 {
     volatile SpiDriver_Params_t* params;
     FuncResult_e res = SPI_DRV_FUNC_RES_OK;
 
     for (uint16_t ic = 0u; (ic < syncModeCfg.icCount) && (res == SPI_DRV_FUNC_RES_OK); ic++) { /* TODO: the sync should be triggered for (ic==0) only */
+        if ((icMask & (1ul << ic)) == 0u) {
+            continue;
+        }
         params = &spiDriver_currentState.params[ic];
         if ((params->contState == CONT_MODE_STATE_STARTED) || (params->contState == CONT_MODE_STATE_FINISHED)) {
             params->contState = CONT_MODE_STATE_WORKING;
@@ -700,12 +1199,24 @@ FuncResult_e spiDriver_getSingleSyncStep(spiDriver_ChipData_t** spiDriver_chipDa
     return res;
 }
 
-/** Gets the single scene for the single chip
- * This function uses the loop inside to make the single-chip getting data possible. It allocates the memory
- * for the buffer and fills-in received data into the buffers for all layers of a single IC */
-FuncResult_e spiDriver_getSingleScene(volatile SpiDriver_Params_t* params,
-                                      spiDriver_ChipData_t** spiDriver_chipDataTmp,
-                                      uint16_t* spiDriver_chipDataSizeTmp)
+/** Makes a single synchro step in a synchronous mode
+ * This function uses per-IC loop inside to make the single tick (in layers) for all chips
+ * Returns the layers from all ICs in a structure
+ * @return
+ */
+FuncResult_e spiDriver_getSingleSyncStep(spiDriver_ChipData_t** spiDriver_chipDataTmp,
+                                         uint16_t* spiDriver_chipDataSizeTmp)
+{
+    return spiDriver_getSingleSyncStepIcs(UINT32_MAX, spiDriver_chipDataTmp, spiDriver_chipDataSizeTmp);
+}
+
+/** Gets the single scene in synchronous mode
+ * Reads all layers of all ICs. When `layerReady` is assigned, the records of each layer are passed to it as soon as
+ * the layer is read, otherwise they are collected in the output array */
+static FuncResult_e spiDriver_GetSceneLayers(volatile SpiDriver_Params_t* params,
+                                             spiDriver_ChipData_t** spiDriver_chipDataTmp,
+                                             uint16_t* spiDriver_chipDataSizeTmp,
+                                             const cbLayerReady_t layerReady)
 {
     FuncResult_e res = SPI_DRV_FUNC_RES_OK;
     if (params == NULL) { /* Use default global setting if the params are not defined explicitly */
@@ -752,6 +1263,8 @@ FuncResult_e spiDriver_getSingleScene(volatile SpiDriver_Params_t* params,
     params->sceneCurrentLayer = 0u;
     while (params->sceneCurrentLayer < params->sceneLayersAmount) {
         bool layerMode = params->layers[params->sceneCurrentLayer].isTrace;
+        const uint16_t layerFirstRecord = *spiDriver_chipDataSizeTmp;
+        const bool lastLayer = ((params->sceneCurrentLayer + icCount) >= params->sceneLayersAmount);
         TRACE_PRINT("Current layer: %u\n", params->layers[params->sceneCurrentLayer].layerId);
         TRACE_PRINT("Layer mode: %s\n", layerMode ? "TRACE" : "ECHO");
         if (layerMode) {
@@ -761,9 +1274,11 @@ FuncResult_e spiDriver_getSingleScene(volatile SpiDriver_Params_t* params,
                 if (syncModeCfg.icCount >= 2) {
                     res |= spiCom_SetDev(spiDriver_currentState.params[ic].icIndex);
                 }
-                evenStatus[ic] = spiCom_GetRaw(params->layers[params->sceneCurrentLayer + ic].nSamples + 8,
-                                               (uint16_t*)&evenTraceData[ic],
-                                               (uint16_t*)&evenEchoMetadata[ic]);
+                evenStatus[ic] = spiDriver_GetRawMasked(params->layers[params->sceneCurrentLayer + ic].nSamples,
+                                                        params->layers[params->sceneCurrentLayer + ic].layerId,
+                                                        false,
+                                                        (uint16_t*)&evenTraceData[ic],
+                                                        (uint16_t*)&evenEchoMetadata[ic]);
             }
         }
 
@@ -791,9 +1306,11 @@ FuncResult_e spiDriver_getSingleScene(volatile SpiDriver_Params_t* params,
                 if (syncModeCfg.icCount >= 2) {
                     res |= spiCom_SetDev(spiDriver_currentState.params[ic].icIndex);
                 }
-                oddStatus[ic] |= spiCom_GetRaw(params->layers[params->sceneCurrentLayer + ic].nSamples + 8,
-                                               (uint16_t*)&oddTraceData[ic],
-                                               (uint16_t*)&oddEchoMetadata[ic]);
+                oddStatus[ic] |= spiDriver_GetRawMasked(params->layers[params->sceneCurrentLayer + ic].nSamples,
+                                                        params->layers[params->sceneCurrentLayer + ic].layerId,
+                                                        true,
+                                                        (uint16_t*)&oddTraceData[ic],
+                                                        (uint16_t*)&oddEchoMetadata[ic]);
             }
             spiDriver_CombineTraces(params,
                                     (uint16_t*)evenTraceData,
@@ -820,9 +1337,10 @@ FuncResult_e spiDriver_getSingleScene(volatile SpiDriver_Params_t* params,
                     res |= spiCom_SetDev(spiDriver_currentState.params[ic].icIndex);
                 }
                 echoStatus[ic] |=
-                    spiCom_GetEcho(params->layers[params->sceneCurrentLayer + ic].nSamples,
-                                   (uint16_t*)&echoesData[ic],
-                                   (uint16_t*)&echoMetadata[ic]);
+                    spiDriver_GetEchoMasked(params->layers[params->sceneCurrentLayer + ic].nSamples,
+                                            params->layers[params->sceneCurrentLayer + ic].layerId,
+                                            (uint16_t*)&echoesData[ic],
+                                            (uint16_t*)&echoMetadata[ic]);
             }
             spiDriver_AppendChipData(params,
                                      spiDriver_chipDataTmp,
@@ -853,11 +1371,19 @@ FuncResult_e spiDriver_getSingleScene(volatile SpiDriver_Params_t* params,
                                      oddStatus,
                                      icCount);
         }
+        spiDriver_MarkSceneComplete(*spiDriver_chipDataTmp, layerFirstRecord, *spiDriver_chipDataSizeTmp, lastLayer);
+        if (layerReady != NULL) {
+            /* The layer is passed to the receiver */
+            layerReady(*spiDriver_chipDataTmp, *spiDriver_chipDataSizeTmp, lastLayer);
+            *spiDriver_chipDataTmp = NULL;
+            *spiDriver_chipDataSizeTmp = 0u;
+        }
         params->sceneCurrentLayer += icCount;
     }
     for (uint16_t ic = 0u; ic < icCount; ic++) {
         spiDriver_currentState.params[ic].contState = CONT_MODE_STATE_FINISHED;
     }
+    spiDriver_AcquSceneDone();
 
     /* free assigned memory buffers */
     free(evenEchoMetadata);
@@ -874,22 +1400,42 @@ FuncResult_e spiDriver_getSingleScene(volatile SpiDriver_Params_t* params,
 }
 
 
-static FuncResult_e spiDriver_GetScene(void)
+/** Gets the single scene for the single chip
+ * This function uses the loop inside to make the single-chip getting data possible. It allocates the memory
+ * for the buffer and fills-in received data into the buffers for all layers of a single IC */
+FuncResult_e spiDriver_getSingleScene(volatile SpiDriver_Params_t* params,
+                                      spiDriver_ChipData_t** spiDriver_chipDataTmp,
+                                      uint16_t* spiDriver_chipDataSizeTmp)
+{
+    return spiDriver_GetSceneLayers(params, spiDriver_chipDataTmp, spiDriver_chipDataSizeTmp, NULL);
+}
+
+
+/** Gets the single scene in synchronous mode, passing each layer to the receiver as soon as it's read */
+FuncResult_e spiDriver_getSingleSceneByLayer(volatile SpiDriver_Params_t* params, const cbLayerReady_t layerReady)
+{
+    spiDriver_ChipData_t* spiDriver_chipDataTmp = NULL;
+    uint16_t spiDriver_chipDataSizeTmp = 0u;
+    return spiDriver_GetSceneLayers(params, &spiDriver_chipDataTmp, &spiDriver_chipDataSizeTmp, layerReady);
+}
+
+
+/** Captures the single scene into the chip-data array allocated */
+static FuncResult_e spiDriver_ReadScene(spiDriver_ChipData_t** spiDriver_chipDataTmp,
+                                        uint16_t* spiDriver_chipDataSizeTmp)
 {
     FuncResult_e res = SPI_DRV_FUNC_RES_OK;
     volatile SpiDriver_Params_t* params = &spiDriver_currentState.params[0u];
-    spiDriver_ChipData_t* spiDriver_chipDataTmp;
-    uint16_t spiDriver_chipDataSizeTmp;
 
-    spiDriver_chipDataSizeTmp = 0u;
-    spiDriver_chipDataTmp = NULL;
+    *spiDriver_chipDataSizeTmp = 0u;
+    *spiDriver_chipDataTmp = NULL;
 
     res |= spiDriver_SendSensorStart(NULL);
 
     if (contModeCfg.useAsyncSequence) {
-        res |= spiDriver_getSingleSceneAsync(0u, params, &spiDriver_chipDataTmp, &spiDriver_chipDataSizeTmp);
+        res |= spiDriver_getSingleSceneAsync(0u, params, spiDriver_chipDataTmp, spiDriver_chipDataSizeTmp);
     } else {
-        res |= spiDriver_getSingleScene(params, &spiDriver_chipDataTmp, &spiDriver_chipDataSizeTmp);
+        res |= spiDriver_getSingleScene(params, spiDriver_chipDataTmp, spiDriver_chipDataSizeTmp);
     }
 
     res |= spiCom_SensorSyncStop();
@@ -897,6 +1443,17 @@ static FuncResult_e spiDriver_GetScene(void)
     for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
         spiDriver_currentState.params[ic].contState = CONT_MODE_STATE_IDLE;
     }
+    return res;
+}
+
+
+static FuncResult_e spiDriver_GetScene(void)
+{
+    FuncResult_e res;
+    spiDriver_ChipData_t* spiDriver_chipDataTmp;
+    uint16_t spiDriver_chipDataSizeTmp;
+
+    res = spiDriver_ReadScene(&spiDriver_chipDataTmp, &spiDriver_chipDataSizeTmp);
 
     /* Replace old shared data with the new created */
     spiDriver_UpdateCurrentData(spiDriver_chipDataTmp, spiDriver_chipDataSizeTmp);
@@ -962,6 +1519,87 @@ FuncResult_e spiDriver_GetMixed(const uint16_t* const layerOrder,
 }
 
 
+FuncResult_e spiDriver_GetScenes(const uint16_t* const layerOrder,
+                                 const uint16_t layerCount,
+                                 const ProcOrder_e* const procOrder,
+                                 spiDriver_Scene_t* const scenes,
+                                 const uint16_t nScenes,
+                                 uint16_t* const nScenesRead)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    uint16_t sceneInd = 0u;
+    uint16_t tailScenes;
+    bool contModeActive = spiDriver_currentState.continuousMode;
+
+    for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
+        if (spiDriver_currentState.params[ic].contState != CONT_MODE_STATE_IDLE) {
+            contModeActive = true;
+        }
+    }
+
+    if ((layerOrder == NULL) || (scenes == NULL) || (nScenesRead == NULL) ||
+        (layerCount == 0u) || (layerCount > LAYERS_ORDER_MAX)) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+    } else if (contModeActive) {
+        /* The burst would steal the continuous mode's sensor and state */
+        res = SPI_DRV_FUNC_RES_FAIL_BUSY;
+    } else if ((contModeCfg.useAsyncSequence) || (nScenes < BURST_SCENES_MIN)) {
+        /* Single-scene captures */
+        memset(scenes, 0, sizeof(spiDriver_Scene_t) * nScenes);
+        res = spiDriver_SetLayers((uint8_t)layerCount, layerOrder, SPI_DRV_CFG_OUT_NC, procOrder, false);
+        while ((sceneInd < nScenes) && (res == SPI_DRV_FUNC_RES_OK)) {
+            res |= spiDriver_ReadScene(&scenes[sceneInd].chipData, &scenes[sceneInd].chipDataSize);
+            sceneInd++;
+        }
+    } else {
+        memset(scenes, 0, sizeof(spiDriver_Scene_t) * nScenes);
+        res = spiDriver_SetLayers((uint8_t)layerCount, layerOrder, SPI_DRV_CFG_OUT_NC, procOrder, true);
+        for (uint16_t ic = 0u; (ic < syncModeCfg.icCount) && (res == SPI_DRV_FUNC_RES_OK); ic++) {
+#if (SYNC_TEST_FLOW != 1)
+            spiCom_SetDev(spiDriver_currentState.params[ic].icIndex);
+#endif
+            res |= spiDriver_GetParam((SpiDriver_Params_t*)&spiDriver_currentState.params[ic]);
+        }
+        spiDriver_currentState.continuousMode = true;
+        if (res == SPI_DRV_FUNC_RES_OK) {
+            res |= spiDriver_SendSensorStart((SpiDriver_Params_t*)&spiDriver_currentState.params[0u]);
+        }
+        /* Scenes already started when the STOP is sent. The same as in continuous mode thread */
+        tailScenes = (spiDriver_currentState.params[0u].sceneLayersAmount == 1u) ? 2u : 1u;
+        TRACE_PRINT("Burst of %u scenes\n", nScenes);
+        while ((sceneInd < nScenes) && (res == SPI_DRV_FUNC_RES_OK)) {
+            if ((nScenes - sceneInd) == tailScenes) {
+                for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
+                    res |= spiDriver_StopContinuousModeInt(ic);
+                }
+                spiDriver_currentState.continuousMode = false;
+            }
+            res |= spiDriver_getSingleScene(NULL, &scenes[sceneInd].chipData, &scenes[sceneInd].chipDataSize);
+            sceneInd++;
+        }
+        spiDriver_currentState.continuousMode = false;
+        res |= spiCom_SensorSyncStop();
+        for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
+            spiDriver_currentState.params[ic].contState = CONT_MODE_STATE_IDLE;
+        }
+    }
+    if (nScenesRead != NULL) {
+        *nScenesRead = sceneInd;
+    }
+    return res;
+}
+
+
+void spiDriver_FreeScenes(spiDriver_Scene_t* const scenes, const uint16_t nScenes)
+{
+    for (uint16_t sceneInd = 0u; sceneInd < nScenes; sceneInd++) {
+        spiDriver_CleanChipData(scenes[sceneInd].chipData, &scenes[sceneInd].chipDataSize);
+        free(scenes[sceneInd].chipData);
+        scenes[sceneInd].chipData = NULL;
+    }
+}
+
+
 static FuncResult_e spiDriver_SendSensorStart(SpiDriver_Params_t* params)
 {
     FuncResult_e res = SPI_DRV_FUNC_RES_OK;
@@ -970,6 +1608,7 @@ static FuncResult_e spiDriver_SendSensorStart(SpiDriver_Params_t* params)
         res |= spiDriver_GetParam(params);
     }
     res |= spiCom_SensorSyncStart();
+    spiDriver_ContinuityRestart(IC_ID_BROADCAST);
     if ((params->sceneSyncMode == ACQU_SYNC_FRAME) || (params->sceneSyncMode == ACQU_SYNC_LAYER)) {
         res |= spiCom_AcquSyncSync();
         if (lightControlFunction != NULL) {
@@ -1084,71 +1723,163 @@ void spiDriver_UpdateCurrentData(const spiDriver_ChipData_t* const spiDriver_chi
 }
 
 
+/** Releases the data and sets the acquisition's state of the current instance to the defaults, called for the
+ * instance destroyed */
+void spiDriver_ResetTraceInstance(void)
+{
+    spiDriver_UpdateCurrentData(NULL, 0u);
+    memset((void*)&spiDriver_currentState, 0, sizeof(spiDriver_currentState));
+    lightControlFunction = NULL;
+    syncDoneFunction = NULL;
+    memset(sceneParamsCache, 0, sizeof(sceneParamsCache));
+    memset(&sceneProgram, 0, sizeof(sceneProgram));
+    memset(acquMasks, 0, sizeof(acquMasks));
+    memset(&acquMaskStats, 0, sizeof(acquMaskStats));
+    acquSceneBytes = 0u;
+    acquSceneBytesSaved = 0u;
+    (void)spiDriver_SetTraceConversion(NULL);
+}
+
+
 void spiDriver_AssignLightControl(const cbLightFunc_t lightFunction)
 {
     lightControlFunction = lightFunction;
 }
 
+
+void spiDriver_AssignSyncDone(const cbSyncDone_t syncDone)
+{
+    syncDoneFunction = syncDone;
+}
+
+/** Reads the configurations of several layers of the currently selected IC by block reads
+ * All layers' variables are read by a single ::spiDriver_GetVarsByName call, so the adjacent ones share the transaction.
+ * The fields `ic_id`, `layer_nth` and `continuousEnable` are not touched. */
+static FuncResult_e spiDriver_ReadLayersVars(const uint16_t* const layerIds,
+                                             const uint16_t layersCount,
+                                             spiDriver_LayerConfig_t* const layerCfgs)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    const uint16_t varsNumber = layersCount * LAYER_CONFIG_VARS;
+    SpiDriver_FldName_t (*names)[MAX_FLD_NAME] = malloc(2u * varsNumber * MAX_FLD_NAME);
+    SpiDriver_FldName_t (*fldNames)[MAX_FLD_NAME] = &names[varsNumber];
+    const SpiDriver_FldName_t** namePtrs = calloc(2u * varsNumber, sizeof(SpiDriver_FldName_t*));
+    const SpiDriver_FldName_t** fldNamePtrs = &namePtrs[varsNumber];
+    uint32_t* values = malloc(varsNumber * sizeof(uint32_t));
+
+    if ((varsNumber > 0u) && ((names == NULL) || (namePtrs == NULL) || (values == NULL))) {
+        res = SPI_DRV_FUNC_RES_FAIL_MEMORY;
+    } else {
+        for (uint16_t layer = 0u; layer < layersCount; layer++) {
+            const uint16_t layer_id = layerIds[layer];
+            const uint16_t base = layer * LAYER_CONFIG_VARS;
+            for (uint16_t ind = base; ind < (base + LAYER_CONFIG_VARS); ind++) {
+                namePtrs[ind] = names[ind];
+                fldNamePtrs[ind] = NULL;
+            }
+            sprintf(names[base + 0u], "layer_%u_param", layer_id);
+            sprintf(fldNames[base + 0u], "layer_%u_raw_mode_en", layer_id);
+            fldNamePtrs[base + 0u] = fldNames[base + 0u];
+            sprintf(names[base + 1u], "layer_%u_sampling_port_sampling_mode", layer_id);
+            sprintf(names[base + 2u], "layer_%u_sampling_PORT_SAMP_CFG", layer_id);
+            sprintf(fldNames[base + 2u], "layer_%u_sampling_size", layer_id);
+            fldNamePtrs[base + 2u] = fldNames[base + 2u];
+            sprintf(names[base + 3u], "layer_%u_n_samples", layer_id);
+            sprintf(names[base + 4u], "layer_%u_skip_samples", layer_id);
+            sprintf(names[base + 5u], "layer_%u_averaging", layer_id);
+            sprintf(names[base + 6u], "layer_%u_gains_0_0", layer_id);
+            sprintf(names[base + 7u], "layer_%u_threshold", layer_id);
+        }
+        res = spiDriver_GetVarsByName(namePtrs, values, fldNamePtrs, varsNumber);
+        for (uint16_t layer = 0u; (layer < layersCount) && (res == SPI_DRV_FUNC_RES_OK); layer++) {
+            const uint32_t* layerValues = &values[layer * LAYER_CONFIG_VARS];
+            layerCfgs[layer].isTrace = (layerValues[0u] != 0u);
+            layerCfgs[layer].samplingMode = layerValues[1u];
+            layerCfgs[layer].samplingSize = layerValues[2u];
+            layerCfgs[layer].nSamples = layerValues[3u];
+            layerCfgs[layer].skipSamples = layerValues[4u];
+            layerCfgs[layer].averaging = layerValues[5u];
+            layerCfgs[layer].gain = layerValues[6u];
+            layerCfgs[layer].echoThreshold = layerValues[7u];
+        }
+    }
+    free(names);
+    free(namePtrs);
+    free(values);
+    return res;
+}
+
+
 FuncResult_e spiDriver_ReadLayerConfig(const uint16_t icIdx,
                                        const uint16_t layerIdx,
                                        spiDriver_LayerConfig_t* const layerCfg)
 {
     FuncResult_e res;
     char name[MAX_FLD_NAME];
-    char fld_name[MAX_FLD_NAME];
-    uint32_t tmp32;
+    const SpiDriver_FldName_t* names[2u] = {name, "param"};
+    const SpiDriver_FldName_t* fldNames[2u] = {NULL, "continuous_en"};
+    uint32_t values[2u] = {0u, 0u};
     uint16_t layer_id;
 
     layerCfg->ic_id = spiDriver_currentState.params[icIdx].icIndex;
     spiCom_SetDev(layerCfg->ic_id);
 
     sprintf(name, "scene_layers_order_%u", layerIdx);
-    res = spiDriver_GetByName(name, &tmp32, NULL);
-    layerCfg->layer_nth = tmp32;
-    layer_id = tmp32;
-
-    sprintf(name, "layer_%u_param", layer_id);
-    sprintf(fld_name, "layer_%u_raw_mode_en", layer_id);
-    res |= spiDriver_GetByName(name, &tmp32, fld_name);
-    layerCfg->isTrace = (tmp32 != 0u);
-
-    sprintf(name, "layer_%u_sampling_port_sampling_mode", layer_id);
-    res |= spiDriver_GetByName(name, &tmp32, NULL);
-    layerCfg->samplingMode = tmp32;
-
-    sprintf(name, "layer_%u_sampling_PORT_SAMP_CFG", layer_id);
-    sprintf(fld_name, "layer_%u_sampling_size", layer_id);
-    res |= spiDriver_GetByName(name, &tmp32, fld_name);
-    layerCfg->samplingSize = tmp32;
-
-    sprintf(name, "layer_%u_n_samples", layer_id);
-    res |= spiDriver_GetByName(name, &tmp32, NULL);
-    layerCfg->nSamples = tmp32;
-
-    sprintf(name, "layer_%u_skip_samples", layer_id);
-    res |= spiDriver_GetByName(name, &tmp32, NULL);
-    layerCfg->skipSamples = tmp32;
+    res = spiDriver_GetVarsByName(names, values, fldNames, 2u);
+    layer_id = values[0u];
+    layerCfg->layer_nth = layer_id;
+    layerCfg->continuousEnable = (values[1u] != 0u);
 
-    sprintf(name, "layer_%u_averaging", layer_id);
-    res |= spiDriver_GetByName(name, &tmp32, NULL);
-    layerCfg->averaging = tmp32;
-
-    sprintf(name, "layer_%u_gains_0_0", layer_id);
-    res |= spiDriver_GetByName(name, &tmp32, NULL);
-    layerCfg->gain = tmp32;
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        res = spiDriver_ReadLayersVars(&layer_id, 1u, layerCfg);
+    }
+    return res;
+}
 
-    sprintf(name, "layer_%u_threshold", layer_id);
-    res |= spiDriver_GetByName(name, &tmp32, NULL);
-    layerCfg->echoThreshold = tmp32;
 
-    sprintf(name, "param");
-    sprintf(fld_name, "continuous_en");
-    res |= spiDriver_GetByName(name, &tmp32, fld_name);
-    layerCfg->continuousEnable = (tmp32 != 0u);
+/** Reads all layers' configurations of the IC by block reads
+ * The scene's descriptor, the layers' order and all layers' variables are read by one ::spiDriver_GetVarsByName call
+ * each. */
+static FuncResult_e spiDriver_ReadIcSceneConfig(const uint16_t icIdx,
+                                                uint32_t* const layersAmount,
+                                                spiDriver_LayerConfig_t* const layerCfgs)
+{
+    FuncResult_e res;
+    char orderNames[LAYERS_ORDER_MAX][MAX_FLD_NAME];
+    const SpiDriver_FldName_t* names[LAYERS_ORDER_MAX] = {"scene_layers_amount", "param"};
+    const SpiDriver_FldName_t* fldNames[LAYERS_ORDER_MAX] = {NULL, "continuous_en"};
+    uint32_t values[LAYERS_ORDER_MAX];
+    uint16_t layerIds[LAYERS_ORDER_MAX];
+    bool continuousEnable;
+
+    spiCom_SetDev(spiDriver_currentState.params[icIdx].icIndex);
+    res = spiDriver_GetVarsByName(names, values, fldNames, 2u);
+    *layersAmount = values[0u];
+    continuousEnable = (values[1u] != 0u);
+    if (*layersAmount > LAYERS_ORDER_MAX) {
+        res |= SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+    }
 
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        for (uint16_t layer = 0u; layer < *layersAmount; layer++) {
+            sprintf(orderNames[layer], "scene_layers_order_%u", layer);
+            names[layer] = orderNames[layer];
+        }
+        res = spiDriver_GetVarsByName(names, values, NULL, (uint16_t)*layersAmount);
+    }
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        for (uint16_t layer = 0u; layer < *layersAmount; layer++) {
+            layerIds[layer] = values[layer];
+            layerCfgs[layer].ic_id = spiDriver_currentState.params[icIdx].icIndex;
+            layerCfgs[layer].layer_nth = layerIds[layer];
+            layerCfgs[layer].continuousEnable = continuousEnable;
+        }
+        res = spiDriver_ReadLayersVars(layerIds, (uint16_t)*layersAmount, layerCfgs);
+    }
     return res;
 }
 
+
 FuncResult_e spiDriver_ReadSceneConfig(spiDriver_LayerConfig_t** layerConfigurations, uint16_t* layerConfigCount)
 {
     FuncResult_e res = SPI_DRV_FUNC_RES_OK;
@@ -1156,27 +1887,35 @@ FuncResult_e spiDriver_ReadSceneConfig(spiDriver_LayerConfig_t** layerConfigurat
     uint32_t layers_amount_max = 0u;
     uint32_t layers_amount_sum = 0u;
     uint16_t idx;
-    /* Read amount of layers to read from IC */
+    spiDriver_LayerConfig_t* icLayers = malloc(syncModeCfg.icCount * LAYERS_ORDER_MAX * sizeof(spiDriver_LayerConfig_t));
+
+    if (icLayers == NULL) {
+        res = SPI_DRV_FUNC_RES_FAIL_MEMORY;
+    }
+    /* Read the whole configuration of each IC, one IC after another by the calling thread. Only the continuous mode's
+     * per-bus workers read the ICs concurrently */
     for (uint16_t ic = 0u; (ic < syncModeCfg.icCount) && (res == SPI_DRV_FUNC_RES_OK); ic++) {
-        spiCom_SetDev(spiDriver_currentState.params[ic].icIndex);
-        res = spiDriver_GetByName("scene_layers_amount", &layers_amount[ic], NULL);
+        res = spiDriver_ReadIcSceneConfig(ic, &layers_amount[ic], &icLayers[ic * LAYERS_ORDER_MAX]);
         if (layers_amount_max < layers_amount[ic]) {
             layers_amount_max = layers_amount[ic];
         }
         layers_amount_sum += layers_amount[ic];
     }
 
-    *layerConfigurations = realloc(*layerConfigurations, layers_amount_sum * sizeof(spiDriver_LayerConfig_t));
-    idx = 0u;
-    /* Read the layer's configuration as they appear in multiIC configuration */
-    for (uint16_t layer = 0u; layer < layers_amount_max; layer++) {
-        for (uint16_t ic = 0u; (ic < syncModeCfg.icCount) && (res == SPI_DRV_FUNC_RES_OK); ic++) {
-            if (layer < layers_amount[ic]) {
-                res = spiDriver_ReadLayerConfig(ic, layer, &((*layerConfigurations)[idx++]));
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        *layerConfigurations = realloc(*layerConfigurations, layers_amount_sum * sizeof(spiDriver_LayerConfig_t));
+        idx = 0u;
+        /* Place the layer's configuration as they appear in multiIC configuration */
+        for (uint16_t layer = 0u; layer < layers_amount_max; layer++) {
+            for (uint16_t ic = 0u; ic < syncModeCfg.icCount; ic++) {
+                if (layer < layers_amount[ic]) {
+                    (*layerConfigurations)[idx++] = icLayers[(ic * LAYERS_ORDER_MAX) + layer];
+                }
             }
         }
+        *layerConfigCount = layers_amount_sum;
     }
-    *layerConfigCount = layers_amount_sum;
+    free(icLayers);
 
     return res;
 }
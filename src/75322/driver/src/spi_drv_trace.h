@@ -41,6 +41,7 @@ extern "C"
 #include <stdbool.h>
 #include "static_assert.h"
 #include "spi_drv_common_types.h"
+#include "spi_drv_instance.h"
 #include "spi_drv_sync_com.h"
 
 /**
@@ -102,6 +103,21 @@ typedef enum {
     CHIP_DATA_META_ONLY,                    /**< Meta-data format */
 } ChipDataFormat_e;
 
+/** Continuity of the layer counter, see @ref spi_continuity */
+typedef enum {
+    CHIP_DATA_CONT_OK = 0u,                 /**< The layer follows the previous one */
+    CHIP_DATA_CONT_FIRST = 0x01u,           /**< The first layer tracked, no previous layer to compare with */
+    CHIP_DATA_CONT_DROP = 0x02u,            /**< The layers before this one were dropped */
+    CHIP_DATA_CONT_REPEAT = 0x04u,          /**< The layer was already received */
+    CHIP_DATA_CONT_FAILED = 0x08u,          /**< The layer's communication failed, the layer counter is unknown */
+} ChipDataContinuity_e;
+
+/** Output format of the converted traces */
+typedef enum {
+    TRACE_CONV_OUT_F32 = 0u,                /**< float32 output, see ::spiDriver_OutTraceData_t */
+    TRACE_CONV_OUT_Q,                       /**< signed 16-bit fixed-point (Q-format) output */
+} TraceConvFormat_e;
+
 /** Processing order selection */
 typedef enum {
     PROC_ORDER_NONE = 0u,                   /**< No processing */
@@ -305,6 +321,12 @@ typedef struct {
     ChipDataFormat_e dataFormat;        /**< Data format for the data */
     FuncResult_e status;                /**< The status returned */
     uint16_t chip_id;                   /**< The Сhip ID of the layer data provided */
+    void* outData;                      /**< Converted trace data in order [N_CHANNELS][samples], or NULL if the
+                                             conversion was not applied. See @ref spi_trace_conv */
+    TraceConvFormat_e outFormat;        /**< Format of the converted trace data */
+    bool sceneComplete;                 /**< The record belongs to the last layer of the scene */
+    uint16_t sequence;                  /**< Layer's sequence number, taken from ::Metadata_t.layer_counter */
+    uint8_t continuity;                 /**< Layer counter's continuity flags. See ::ChipDataContinuity_e */
 } spiDriver_ChipData_t;
 
 
@@ -405,11 +427,15 @@ typedef struct {
  * This is done to make the data bufferred meaning a way of FIFO'ing it. During the high-level function execution the elder data is still available,
  * and the pointer spiDriver_chipData is replaced at-once, when the data is read.
  * @note this pointer is automatically allocated within the high-level function, and should be freed at the end (if needed).
+ * @note the pointer is kept per driver's instance, the one of the instance selected by the calling thread is used
  */
-extern volatile spiDriver_ChipData_t* spiDriver_chipData;
+#define spiDriver_chipData (spiDriver_chipDataInst[SPI_DRV_INSTANCE])
 
 /** Holds the size of a data array, stored in `spiDriver_chipData` structure */
-extern volatile uint16_t spiDriver_chipDataSize;
+#define spiDriver_chipDataSize (spiDriver_chipDataSizeInst[SPI_DRV_INSTANCE])
+
+extern volatile spiDriver_ChipData_t* spiDriver_chipDataInst[SPI_DRV_MAX_HANDLES];
+extern volatile uint16_t spiDriver_chipDataSizeInst[SPI_DRV_MAX_HANDLES];
 
 /** @}*/
 
@@ -508,12 +534,30 @@ FuncResult_e spiDriver_SetOutputModeConfig(const spiDriver_LayerConfig_t* const
 
 
 /** Configures the layer according desired mode and settings
+ * The layer's variables are collected in memory and written by block writes. See ::spiDriver_SetLayersConfig
  * @param[in]   layerConfiguration      set of parameters required for layers configuration
  * @return      result of an operation. See ::FuncResult_e for details
  */
 FuncResult_e spiDriver_SetLayerConfig(const spiDriver_LayerConfig_t* const layerConfiguration);
 
 
+/** Configures several layers according desired modes and settings
+ * The variables of all layers are collected in memory and written by block read-modify-writes of the adjacent
+ * variables, instead of a transaction pair per variable. In multi-IC configuration the continuous mode and the
+ * gains are written into all ICs, other layer's variables into the IC of ::spiDriver_LayerConfig_t.ic_id.
+ * The continuous mode is taken from the last layer's configuration. Nothing is written if any configuration is
+ * out of range.
+ * @param[in]   layerConfigurations     layers' configurations
+ * @param[in]   layersCount             items count in `layerConfigurations`
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    the sampling mode or gain is out of range
+ * @retval  SPI_DRV_FUNC_RES_FAIL_MEMORY        memory allocation failed
+ * @return  other results of an operation. See ::FuncResult_e for details
+ */
+FuncResult_e spiDriver_SetLayersConfig(const spiDriver_LayerConfig_t* const layerConfigurations,
+                                       const uint16_t layersCount);
+
+
 /** Reads the layer's configuration from certain IC in order they will be captured
  *
  */
@@ -529,6 +573,25 @@ FuncResult_e spiDriver_ReadLayerConfig(const uint16_t icIdx,
  */
 FuncResult_e spiDriver_ReadSceneConfig(spiDriver_LayerConfig_t** layerConfigurations, uint16_t* layerConfigCount);
 
+
+/** Drops the cached scene parameters
+ * The scene's descriptor (layers amount and order, layers' output mode, samples and echo format) is read from IC once
+ * and kept per IC until the driver writes one of these variables. Call this function when the IC's state was changed
+ * by other means (reset, external tool, direct memory writes).
+ * The scene's programming last applied by ::spiDriver_SetLayers is shared by all ICs, so it's dropped for any IC.
+ * It's also dropped when the ICs set changes (see ::spiDriver_SetSyncIcOrder, ::spiDriver_SyncModeInit).
+ * @param[in]   icId    IC ID to drop the cache for. ::IC_ID_BROADCAST drops the cache for all ICs
+ */
+void spiDriver_InvalidateSceneParams(const uint16_t icId);
+
+
+/** Drops the cached scene parameters of the IC if the variable written belongs to the scene's descriptor
+ * Called by ::spiDriver_SetByName on each write.
+ * @param[in]   varName     name of the variable written
+ * @param[in]   icId        IC ID the variable was written to
+ */
+void spiDriver_SceneParamsOnWrite(const SpiDriver_FldName_t* const varName, const uint16_t icId);
+
 /** @}*/
 
 
@@ -601,6 +664,49 @@ FuncResult_e spiDriver_GetMixed(const uint16_t* const layerOrder,
                                 spiDriver_ChipData_t** chipDataResult,
                                 uint16_t* chipDataSizeResult);
 
+
+/** Scene's data captured by ::spiDriver_GetScenes */
+typedef struct {
+    spiDriver_ChipData_t* chipData;     /**< Chip-data array of the scene */
+    uint16_t chipDataSize;              /**< Items count in `chipData` array */
+} spiDriver_Scene_t;
+
+
+/** Reads several scenes back-to-back
+ *
+ * This function starts the sensor once in continuous mode, reads the scenes sequentially using the same
+ * synchronization sequence as the continuous mode, and stops the sensor once. It's intended for short bursts of
+ * scenes (i.e. calibration sweeps) without the continuous mode's threads.
+ * Each scene's chip-data is allocated by the function and should be released by ::spiDriver_FreeScenes.
+ * The scenes are not published into ::spiDriver_chipData.
+ * @note When the asynchronous sequence is used (see ::ContModeCfg_t) or less than 3 scenes are requested, the scenes
+ *       are read by single-scene captures.
+ *
+ * @param[in]   layerOrder      array of layers to read
+ * @param[in]   layerCount      items count in `layerOrder` array
+ * @param[in]   procOrder       array of processing types, according to layerOrder array provided. NULL keeps the
+ *                              layers' modes unchanged
+ * @param[out]  scenes          caller's array to receive the scenes
+ * @param[in]   nScenes         amount of scenes to read, the size of `scenes` array
+ * @param[out]  nScenesRead     amount of scenes read. Can be less than `nScenes` in case of error
+ * @return      result of an operation. See ::FuncResult_e for details
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    `layerCount` is 0 or above ::LAYERS_ORDER_MAX, or a pointer is NULL
+ * @retval  SPI_DRV_FUNC_RES_FAIL_BUSY          the continuous mode is running. Stop it before the burst
+ */
+FuncResult_e spiDriver_GetScenes(const uint16_t* const layerOrder,
+                                 const uint16_t layerCount,
+                                 const ProcOrder_e* const procOrder,
+                                 spiDriver_Scene_t* const scenes,
+                                 const uint16_t nScenes,
+                                 uint16_t* const nScenesRead);
+
+
+/** Frees the chip-data of the scenes read by ::spiDriver_GetScenes
+ * @param[in,out]   scenes      scenes array
+ * @param[in]       nScenes     items count in `scenes` array
+ */
+void spiDriver_FreeScenes(spiDriver_Scene_t* const scenes, const uint16_t nScenes);
+
 /** @}*/
 
 /**
@@ -633,10 +739,81 @@ typedef void (* cbLightFunc_t)(const uint16_t layer);
  */
 void spiDriver_AssignLightControl(const cbLightFunc_t lightFunction);
 
+/** Synchronization done callback function type
+ * Called by the first IC's tick of a synchronous step, once all ICs are synchronized
+ */
+typedef void (* cbSyncDone_t)(void);
+
+/** Assigns the callback function called when the synchronization of the step is done
+ *
+ * The synchronization of all ICs is made by the first IC's tick of a step. When the ICs are read by several threads
+ * (per-bus acquisition), the reads of other ICs should wait for this callback.
+ *
+ * @param[in]   syncDone    the function's address. Use NULL to disable the callback
+ */
+void spiDriver_AssignSyncDone(const cbSyncDone_t syncDone);
+
 /** @}*/
 
+/**
+ * @ingroup spi_trace
+ * @defgroup spi_trace_acqu_mask Acquisition mask
+ *
+ * @details
+ *
+ * The acquisition mask allows to read only a part of the layer's data to reduce the SPI traffic. The mask is set per
+ * layer's ID and applied to all ICs.
+ *
+ * The SPI protocol streams every channel's trace from its first sample, and every channel of the frame should be
+ * requested to get the next one. Thus, for the trace layers:
+ * - the tail of each channel's trace after the sample window is not transferred;
+ * - the channels masked-out are requested with the metadata only;
+ * - the samples before the window are transferred, since these can't be skipped by the protocol.
+ *
+ * The echo layers are always transferred with the size set by the echo format (see ::spiCom_GetEcho), so the mask
+ * doesn't save SPI bytes for them. The channels masked-out are set to zero in the output.
+ *
+ * @{
+ */
+
+/** Layer's acquisition mask */
+typedef struct {
+    uint32_t channelMask;   /**< Channels to read, bit per channel. 0 - all channels */
+    uint16_t firstSample;   /**< First sample of the window needed */
+    uint16_t samplesCount;  /**< Amount of samples in the window. 0 - up to the end of the trace */
+} spiDriver_AcquMask_t;
+
+
+/** Statistics of the SPI bytes saved by the acquisition masks */
+typedef struct {
+    uint32_t sceneBytes;        /**< Bytes of the data packets transferred for the latest scene */
+    uint32_t sceneBytesSaved;   /**< Bytes saved for the latest scene */
+    uint64_t totalBytesSaved;   /**< Bytes saved since the statistics reset */
+    uint32_t scenesCount;       /**< Scenes captured since the statistics reset */
+} spiDriver_AcquMaskStats_t;
+
+
+/** Sets the acquisition mask for the layer
+ * @param[in]   layerId     layer's ID, [0..::LAYERS_ORDER_MAX - 1]
+ * @param[in]   mask        mask to apply. NULL reads the whole layer's data
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     the layer's ID is out of range
+ */
+FuncResult_e spiDriver_SetAcquMask(const uint16_t layerId, const spiDriver_AcquMask_t* const mask);
+
+
+/** Gets the statistics of the bytes saved by the acquisition masks
+ * @param[out]  stats       statistics' output
+ */
+void spiDriver_GetAcquMaskStats(spiDriver_AcquMaskStats_t* const stats);
+
+
+/** Resets the statistics of the bytes saved by the acquisition masks */
+void spiDriver_ResetAcquMaskStats(void);
+
 /** @}*/
 
+/** @}*/
 
 
 #ifdef __cplusplus
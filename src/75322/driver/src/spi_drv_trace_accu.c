@@ -0,0 +1,265 @@
+/**
+ * @file
+ * @brief Temporal accumulator of raw traces
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_trace_accu
+ */
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_trace_accu.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/** Amount of samples processed by one vector step */
+#define TRACE_ACCU_BLOCK 8u
+
+
+/** Updates the running sum: sum += add - sub. The sub frame is optional. Not static for the tests */
+void spiDriver_AccuAddSub(uint32_t* const sum, const uint16_t* const add, const uint16_t* const sub,
+                          const uint32_t size)
+{
+    uint32_t ind = 0u;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; (ind + TRACE_ACCU_BLOCK) <= size; ind += TRACE_ACCU_BLOCK) {
+        __m128i a = _mm_loadu_si128((const __m128i*)&add[ind]);
+        __m128i lo = _mm_unpacklo_epi16(a, zero);
+        __m128i hi = _mm_unpackhi_epi16(a, zero);
+        if (sub != NULL) {
+            __m128i s = _mm_loadu_si128((const __m128i*)&sub[ind]);
+            lo = _mm_sub_epi32(lo, _mm_unpacklo_epi16(s, zero));
+            hi = _mm_sub_epi32(hi, _mm_unpackhi_epi16(s, zero));
+        }
+        _mm_storeu_si128((__m128i*)&sum[ind], _mm_add_epi32(_mm_loadu_si128((const __m128i*)&sum[ind]), lo));
+        _mm_storeu_si128((__m128i*)&sum[ind + 4u], _mm_add_epi32(_mm_loadu_si128((const __m128i*)&sum[ind + 4u]), hi));
+    }
+#elif defined(__ARM_NEON)
+    for (; (ind + TRACE_ACCU_BLOCK) <= size; ind += TRACE_ACCU_BLOCK) {
+        uint16x8_t a = vld1q_u16(&add[ind]);
+        uint32x4_t lo = vaddw_u16(vld1q_u32(&sum[ind]), vget_low_u16(a));
+        uint32x4_t hi = vaddw_u16(vld1q_u32(&sum[ind + 4u]), vget_high_u16(a));
+        if (sub != NULL) {
+            uint16x8_t s = vld1q_u16(&sub[ind]);
+            lo = vsubw_u16(lo, vget_low_u16(s));
+            hi = vsubw_u16(hi, vget_high_u16(s));
+        }
+        vst1q_u32(&sum[ind], lo);
+        vst1q_u32(&sum[ind + 4u], hi);
+    }
+#endif
+    for (; ind < size; ind++) {
+        sum[ind] += add[ind];
+        if (sub != NULL) {
+            sum[ind] -= sub[ind];
+        }
+    }
+}
+
+
+/** Updates EWMA state: state += ((x << FRAC) - state) >> shift. Not static for the tests */
+void spiDriver_AccuEwma(uint32_t* const state, const uint16_t* const frame, const uint8_t shift,
+                        const uint32_t size)
+{
+    uint32_t ind = 0u;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    for (; (ind + TRACE_ACCU_BLOCK) <= size; ind += TRACE_ACCU_BLOCK) {
+        __m128i x = _mm_loadu_si128((const __m128i*)&frame[ind]);
+        __m128i lo = _mm_slli_epi32(_mm_unpacklo_epi16(x, zero), TRACE_ACCU_EWMA_FRAC);
+        __m128i hi = _mm_slli_epi32(_mm_unpackhi_epi16(x, zero), TRACE_ACCU_EWMA_FRAC);
+        __m128i sLo = _mm_loadu_si128((const __m128i*)&state[ind]);
+        __m128i sHi = _mm_loadu_si128((const __m128i*)&state[ind + 4u]);
+        sLo = _mm_add_epi32(sLo, _mm_sra_epi32(_mm_sub_epi32(lo, sLo), count));
+        sHi = _mm_add_epi32(sHi, _mm_sra_epi32(_mm_sub_epi32(hi, sHi), count));
+        _mm_storeu_si128((__m128i*)&state[ind], sLo);
+        _mm_storeu_si128((__m128i*)&state[ind + 4u], sHi);
+    }
+#elif defined(__ARM_NEON)
+    const int32x4_t count = vdupq_n_s32(-(int32_t)shift);
+    for (; (ind + TRACE_ACCU_BLOCK) <= size; ind += TRACE_ACCU_BLOCK) {
+        uint16x8_t x = vld1q_u16(&frame[ind]);
+        int32x4_t lo = vreinterpretq_s32_u32(vshll_n_u16(vget_low_u16(x), TRACE_ACCU_EWMA_FRAC));
+        int32x4_t hi = vreinterpretq_s32_u32(vshll_n_u16(vget_high_u16(x), TRACE_ACCU_EWMA_FRAC));
+        int32x4_t sLo = vreinterpretq_s32_u32(vld1q_u32(&state[ind]));
+        int32x4_t sHi = vreinterpretq_s32_u32(vld1q_u32(&state[ind + 4u]));
+        sLo = vaddq_s32(sLo, vshlq_s32(vsubq_s32(lo, sLo), count));
+        sHi = vaddq_s32(sHi, vshlq_s32(vsubq_s32(hi, sHi), count));
+        vst1q_u32(&state[ind], vreinterpretq_u32_s32(sLo));
+        vst1q_u32(&state[ind + 4u], vreinterpretq_u32_s32(sHi));
+    }
+#endif
+    for (; ind < size; ind++) {
+        int32_t diff = (int32_t)((uint32_t)frame[ind] << TRACE_ACCU_EWMA_FRAC) - (int32_t)state[ind];
+        state[ind] = (uint32_t)((int32_t)state[ind] + (diff >> shift));
+    }
+}
+
+
+FuncResult_e spiDriver_TraceAccuInit(spiDriver_TraceAccu_t* const accu,
+                                     const TraceAccuMode_e mode,
+                                     const uint16_t depth,
+                                     const uint16_t binning,
+                                     const uint16_t nSamples)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    const uint32_t size = (uint32_t)N_CHANNELS * nSamples;
+
+    memset(accu, 0, sizeof(*accu));
+    if ((nSamples == 0u) || (nSamples > MAX_SAMPLES_N) || (binning == 0u) || (binning > nSamples)) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+    } else if (mode == TRACE_ACCU_BOXCAR) {
+        if ((depth == 0u) || (depth > TRACE_ACCU_FRAMES_MAX)) {
+            res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+        } else {
+            accu->frames = depth;
+            accu->history = malloc(sizeof(uint16_t) * size * depth);
+        }
+    } else if (mode == TRACE_ACCU_EWMA) {
+        if (depth > TRACE_ACCU_EWMA_SHIFT_MAX) {
+            res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+        } else {
+            accu->frames = 1u;
+            accu->ewmaShift = (uint8_t)depth;
+        }
+    } else {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+    }
+
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        accu->mode = mode;
+        accu->binning = binning;
+        accu->nSamples = nSamples;
+        accu->sum = calloc(size, sizeof(uint32_t));
+        if ((accu->sum == NULL) || ((mode == TRACE_ACCU_BOXCAR) && (accu->history == NULL))) {
+            spiDriver_TraceAccuFree(accu);
+            res = SPI_DRV_FUNC_RES_FAIL_MEMORY;
+        }
+    }
+    return res;
+}
+
+
+void spiDriver_TraceAccuFree(spiDriver_TraceAccu_t* const accu)
+{
+    free(accu->sum);
+    free(accu->history);
+    accu->sum = NULL;
+    accu->history = NULL;
+    accu->filled = 0u;
+}
+
+
+void spiDriver_TraceAccuReset(spiDriver_TraceAccu_t* const accu)
+{
+    if (accu->sum != NULL) {
+        memset(accu->sum, 0, sizeof(uint32_t) * N_CHANNELS * accu->nSamples);
+    }
+    accu->head = 0u;
+    accu->filled = 0u;
+}
+
+
+void spiDriver_TraceAccuPush(spiDriver_TraceAccu_t* const accu, const uint16_t* const trace)
+{
+    const uint32_t size = (uint32_t)N_CHANNELS * accu->nSamples;
+    if (accu->mode == TRACE_ACCU_BOXCAR) {
+        uint16_t* slot;
+        if (accu->filled < accu->frames) {
+            slot = &accu->history[(uint32_t)accu->filled * size];
+            spiDriver_AccuAddSub(accu->sum, trace, NULL, size);
+            accu->filled++;
+        } else {
+            /* Replace the oldest frame in the ring */
+            slot = &accu->history[(uint32_t)accu->head * size];
+            spiDriver_AccuAddSub(accu->sum, trace, slot, size);
+            accu->head = (accu->head + 1u) % accu->frames;
+        }
+        memcpy(slot, trace, sizeof(uint16_t) * size);
+    } else {
+        if (accu->filled == 0u) {
+            for (uint32_t ind = 0u; ind < size; ind++) {
+                accu->sum[ind] = (uint32_t)trace[ind] << TRACE_ACCU_EWMA_FRAC;
+            }
+            accu->filled = 1u;
+        } else {
+            spiDriver_AccuEwma(accu->sum, trace, accu->ewmaShift, size);
+        }
+    }
+}
+
+
+FuncResult_e spiDriver_TraceAccuPushChipData(spiDriver_TraceAccu_t* const accu,
+                                             const spiDriver_ChipData_t* const chipData)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    if ((chipData->dataFormat == CHIP_DATA_TRACE) && (chipData->data != NULL) &&
+        (chipData->samples == accu->nSamples)) {
+        spiDriver_TraceAccuPush(accu, chipData->data->trace);
+    } else {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_TraceAccuGet(const spiDriver_TraceAccu_t* const accu, uint16_t* const out)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    const uint16_t outSamples = spiDriver_TraceAccuOutSamples(accu);
+    uint32_t divisor;
+    if (accu->filled == 0u) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+    } else {
+        if (accu->mode == TRACE_ACCU_BOXCAR) {
+            divisor = (uint32_t)accu->filled * accu->binning;
+        } else {
+            divisor = (uint32_t)accu->binning << TRACE_ACCU_EWMA_FRAC;
+        }
+        for (uint16_t ch = 0u; ch < N_CHANNELS; ch++) {
+            const uint32_t* sum = &accu->sum[(uint32_t)ch * accu->nSamples];
+            uint16_t* dest = &out[(uint32_t)ch * outSamples];
+            for (uint16_t s = 0u; s < outSamples; s++) {
+                uint64_t acc = 0u;
+                for (uint16_t b = 0u; b < accu->binning; b++) {
+                    acc += sum[(s * accu->binning) + b];
+                }
+                dest[s] = (uint16_t)((acc + (divisor / 2u)) / divisor);
+            }
+        }
+    }
+    return res;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
@@ -0,0 +1,147 @@
+/**
+ * @file
+ * @brief Temporal accumulator of raw traces
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_trace_accu Temporal trace accumulator
+ * @ingroup spi_trace
+ *
+ * @details
+ *
+ * Averages the traces of the same layer over several scenes on the host side. It allows to improve the signal to
+ * noise ratio without increasing the layer's averaging in IC, which costs the frame rate.
+ *
+ * Two modes are supported:
+ *
+ * - ::TRACE_ACCU_BOXCAR - the mean of the latest N frames. The accumulator keeps the ring of N frames and the running
+ *   sum, updated by adding the new frame and subtracting the oldest one;
+ * - ::TRACE_ACCU_EWMA - exponentially weighted moving average with the weight of new frame 1/2^shift.
+ *
+ * The sums are kept in 32-bit integers, so no precision is lost on accumulation. The output can be decimated by
+ * averaging (binning) of consecutive samples.
+ *
+ * One accumulator handles one layer. All buffers are allocated by ::spiDriver_TraceAccuInit, so adding the frames
+ * and reading the output don't allocate the memory.
+ */
+
+#ifndef SPI_DRV_TRACE_ACCU_H
+#define SPI_DRV_TRACE_ACCU_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+
+/** Maximum amount of frames in the boxcar window */
+#define TRACE_ACCU_FRAMES_MAX 1024u
+/** Maximum shift of EWMA weight */
+#define TRACE_ACCU_EWMA_SHIFT_MAX 12u
+/** Fractional bits of EWMA state */
+#define TRACE_ACCU_EWMA_FRAC 8u
+
+/** Accumulation mode */
+typedef enum {
+    TRACE_ACCU_BOXCAR = 0u,     /**< Mean of the latest N frames */
+    TRACE_ACCU_EWMA,            /**< Exponentially weighted moving average */
+} TraceAccuMode_e;
+
+/** Accumulator of a single layer's traces */
+typedef struct {
+    TraceAccuMode_e mode;       /**< Accumulation mode */
+    uint16_t frames;            /**< ::TRACE_ACCU_BOXCAR: amount of frames in window */
+    uint8_t ewmaShift;          /**< ::TRACE_ACCU_EWMA: weight of the new frame is 1/2^ewmaShift */
+    uint16_t binning;           /**< Amount of consecutive samples averaged into one output sample */
+    uint16_t nSamples;          /**< Samples per channel */
+    uint32_t* sum;              /**< Running sum (boxcar) or state (EWMA, with ::TRACE_ACCU_EWMA_FRAC fractional bits) */
+    uint16_t* history;          /**< Ring of the latest frames (boxcar only) */
+    uint16_t head;              /**< Position of the oldest frame in the ring */
+    uint16_t filled;            /**< Amount of frames accumulated, up to the window size */
+} spiDriver_TraceAccu_t;
+
+
+/** Allocates and initializes the accumulator
+ * @param[out]  accu        accumulator to initialize
+ * @param[in]   mode        accumulation mode
+ * @param[in]   depth       ::TRACE_ACCU_BOXCAR: frames in window [1..::TRACE_ACCU_FRAMES_MAX],
+ *                          ::TRACE_ACCU_EWMA: shift of the new frame's weight [0..::TRACE_ACCU_EWMA_SHIFT_MAX]
+ * @param[in]   binning     amount of samples averaged into one output sample. 1 disables the decimation
+ * @param[in]   nSamples    samples per channel of the layer
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     the settings are out of range
+ * @retval  SPI_DRV_FUNC_RES_FAIL_MEMORY        memory allocation failed
+ */
+FuncResult_e spiDriver_TraceAccuInit(spiDriver_TraceAccu_t* const accu,
+                                     const TraceAccuMode_e mode,
+                                     const uint16_t depth,
+                                     const uint16_t binning,
+                                     const uint16_t nSamples);
+
+
+/** Frees the memory allocated for the accumulator
+ * @param[in,out]   accu    accumulator to release
+ */
+void spiDriver_TraceAccuFree(spiDriver_TraceAccu_t* const accu);
+
+
+/** Drops all frames accumulated
+ * @param[in,out]   accu    accumulator to reset
+ */
+void spiDriver_TraceAccuReset(spiDriver_TraceAccu_t* const accu);
+
+
+/** Adds the layer's traces to the accumulator
+ * @param[in,out]   accu    accumulator
+ * @param[in]       trace   raw traces in order [N_CHANNELS][nSamples]
+ */
+void spiDriver_TraceAccuPush(spiDriver_TraceAccu_t* const accu, const uint16_t* const trace);
+
+
+/** Adds the traces of the chip-data record to the accumulator
+ * @param[in,out]   accu        accumulator
+ * @param[in]       chipData    chip-data record of ::CHIP_DATA_TRACE format
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    the record is not a trace or has other amount of samples
+ */
+FuncResult_e spiDriver_TraceAccuPushChipData(spiDriver_TraceAccu_t* const accu,
+                                             const spiDriver_ChipData_t* const chipData);
+
+
+/** Returns amount of output samples per channel, after the binning */
+static inline uint16_t spiDriver_TraceAccuOutSamples(const spiDriver_TraceAccu_t* const accu)
+{
+    return accu->nSamples / accu->binning;
+}
+
+
+/** Reads the averaged traces
+ * @param[in]   accu        accumulator
+ * @param[out]  out         output traces in order [N_CHANNELS][::spiDriver_TraceAccuOutSamples]
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    no frames accumulated yet
+ */
+FuncResult_e spiDriver_TraceAccuGet(const spiDriver_TraceAccu_t* const accu, uint16_t* const out);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* SPI_DRV_TRACE_ACCU_H */
@@ -0,0 +1,355 @@
+/**
+ * @file
+ * @brief Raw trace conversion functions
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @ingroup spi_trace_conv
+ */
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_trace_conv.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/** Amount of samples processed by one vector step */
+#define TRACE_CONV_BLOCK 8u
+
+#define TRACE_CONV_Q_MAX 32767.0f       /**< Upper saturation limit for Q-format output */
+#define TRACE_CONV_Q_MIN (-32768.0f)    /**< Lower saturation limit for Q-format output */
+
+/** Calibration used for the inline conversion, per driver's instance. NULL if conversion is disabled */
+static const spiDriver_TraceCalib_t* volatile inlineCalibInst[SPI_DRV_MAX_HANDLES];
+#define inlineCalib (inlineCalibInst[SPI_DRV_INSTANCE])
+
+
+/* Vector kernels. Each one converts TRACE_CONV_BLOCK samples with the same operations' order as the scalar one */
+
+#if defined(__AVX2__)
+
+static inline __m256 spiDriver_ConvLoad(const uint16_t* raw, const uint16_t* dark, const float offset, const float gain)
+{
+    __m256i r = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)raw));
+    if (dark != NULL) {
+        r = _mm256_sub_epi32(r, _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)dark)));
+    }
+    return _mm256_mul_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(r), _mm256_set1_ps(offset)), _mm256_set1_ps(gain));
+}
+
+static inline void spiDriver_ConvBlockF32(const uint16_t* raw, const uint16_t* dark,
+                                          const float offset, const float gain, float* out)
+{
+    _mm256_storeu_ps(out, spiDriver_ConvLoad(raw, dark, offset, gain));
+}
+
+static inline void spiDriver_ConvBlockQ(const uint16_t* raw, const uint16_t* dark,
+                                        const float offset, const float scale, int16_t* out)
+{
+    __m256 v = spiDriver_ConvLoad(raw, dark, offset, scale);
+    v = _mm256_add_ps(v, _mm256_or_ps(_mm256_and_ps(v, _mm256_set1_ps(-0.0f)), _mm256_set1_ps(0.5f)));
+    v = _mm256_max_ps(_mm256_min_ps(v, _mm256_set1_ps(TRACE_CONV_Q_MAX)), _mm256_set1_ps(TRACE_CONV_Q_MIN));
+    __m256i i = _mm256_cvttps_epi32(v);
+    _mm_storeu_si128((__m128i*)out, _mm_packs_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1)));
+}
+
+#elif defined(__SSE2__)
+
+static inline void spiDriver_ConvLoad(const uint16_t* raw, const uint16_t* dark, const float offset, const float gain,
+                                      __m128* lo, __m128* hi)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i r = _mm_loadu_si128((const __m128i*)raw);
+    __m128i rLo = _mm_unpacklo_epi16(r, zero);
+    __m128i rHi = _mm_unpackhi_epi16(r, zero);
+    if (dark != NULL) {
+        __m128i d = _mm_loadu_si128((const __m128i*)dark);
+        rLo = _mm_sub_epi32(rLo, _mm_unpacklo_epi16(d, zero));
+        rHi = _mm_sub_epi32(rHi, _mm_unpackhi_epi16(d, zero));
+    }
+    *lo = _mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(rLo), _mm_set1_ps(offset)), _mm_set1_ps(gain));
+    *hi = _mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(rHi), _mm_set1_ps(offset)), _mm_set1_ps(gain));
+}
+
+static inline __m128i spiDriver_ConvRoundQ(__m128 v)
+{
+    v = _mm_add_ps(v, _mm_or_ps(_mm_and_ps(v, _mm_set1_ps(-0.0f)), _mm_set1_ps(0.5f)));
+    v = _mm_max_ps(_mm_min_ps(v, _mm_set1_ps(TRACE_CONV_Q_MAX)), _mm_set1_ps(TRACE_CONV_Q_MIN));
+    return _mm_cvttps_epi32(v);
+}
+
+static inline void spiDriver_ConvBlockF32(const uint16_t* raw, const uint16_t* dark,
+                                          const float offset, const float gain, float* out)
+{
+    __m128 lo;
+    __m128 hi;
+    spiDriver_ConvLoad(raw, dark, offset, gain, &lo, &hi);
+    _mm_storeu_ps(out, lo);
+    _mm_storeu_ps(out + 4, hi);
+}
+
+static inline void spiDriver_ConvBlockQ(const uint16_t* raw, const uint16_t* dark,
+                                        const float offset, const float scale, int16_t* out)
+{
+    __m128 lo;
+    __m128 hi;
+    spiDriver_ConvLoad(raw, dark, offset, scale, &lo, &hi);
+    _mm_storeu_si128((__m128i*)out, _mm_packs_epi32(spiDriver_ConvRoundQ(lo), spiDriver_ConvRoundQ(hi)));
+}
+
+#elif defined(__ARM_NEON)
+
+static inline void spiDriver_ConvLoad(const uint16_t* raw, const uint16_t* dark, const float offset, const float gain,
+                                      float32x4_t* lo, float32x4_t* hi)
+{
+    uint16x8_t r = vld1q_u16(raw);
+    int32x4_t rLo = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(r)));
+    int32x4_t rHi = vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(r)));
+    if (dark != NULL) {
+        uint16x8_t d = vld1q_u16(dark);
+        rLo = vsubq_s32(rLo, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(d))));
+        rHi = vsubq_s32(rHi, vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(d))));
+    }
+    *lo = vmulq_f32(vsubq_f32(vcvtq_f32_s32(rLo), vdupq_n_f32(offset)), vdupq_n_f32(gain));
+    *hi = vmulq_f32(vsubq_f32(vcvtq_f32_s32(rHi), vdupq_n_f32(offset)), vdupq_n_f32(gain));
+}
+
+static inline int16x4_t spiDriver_ConvRoundQ(float32x4_t v)
+{
+    v = vaddq_f32(v, vbslq_f32(vcltq_f32(v, vdupq_n_f32(0.0f)), vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f)));
+    v = vmaxq_f32(vminq_f32(v, vdupq_n_f32(TRACE_CONV_Q_MAX)), vdupq_n_f32(TRACE_CONV_Q_MIN));
+    return vmovn_s32(vcvtq_s32_f32(v));
+}
+
+static inline void spiDriver_ConvBlockF32(const uint16_t* raw, const uint16_t* dark,
+                                          const float offset, const float gain, float* out)
+{
+    float32x4_t lo;
+    float32x4_t hi;
+    spiDriver_ConvLoad(raw, dark, offset, gain, &lo, &hi);
+    vst1q_f32(out, lo);
+    vst1q_f32(out + 4, hi);
+}
+
+static inline void spiDriver_ConvBlockQ(const uint16_t* raw, const uint16_t* dark,
+                                        const float offset, const float scale, int16_t* out)
+{
+    float32x4_t lo;
+    float32x4_t hi;
+    spiDriver_ConvLoad(raw, dark, offset, scale, &lo, &hi);
+    vst1q_s16(out, vcombine_s16(spiDriver_ConvRoundQ(lo), spiDriver_ConvRoundQ(hi)));
+}
+
+#endif
+
+
+static inline float spiDriver_ConvSample(const uint16_t* raw, const uint16_t* dark, const uint16_t ind,
+                                         const float offset, const float gain)
+{
+    int32_t value = raw[ind];
+    if (dark != NULL) {
+        value -= dark[ind];
+    }
+    return ((float)value - offset) * gain;
+}
+
+
+static inline int16_t spiDriver_ConvSampleQ(const uint16_t* raw, const uint16_t* dark, const uint16_t ind,
+                                            const float offset, const float scale)
+{
+    float value = spiDriver_ConvSample(raw, dark, ind, offset, scale);
+    value += (value < 0.0f) ? -0.5f : 0.5f;
+    if (value > TRACE_CONV_Q_MAX) {
+        value = TRACE_CONV_Q_MAX;
+    } else if (value < TRACE_CONV_Q_MIN) {
+        value = TRACE_CONV_Q_MIN;
+    }
+    return (int16_t)value;
+}
+
+
+/** Checks input parameters common for all conversions and returns the dark frame to use (or NULL) */
+static FuncResult_e spiDriver_ConvCheck(const spiDriver_TraceCalib_t* const calib,
+                                        const uint16_t nSamples,
+                                        const uint16_t** dark)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    *dark = NULL;
+    if ((calib == NULL) || (nSamples > MAX_SAMPLES_N)) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+    } else if (calib->darkFrame != NULL) {
+        if (calib->darkSamples == nSamples) {
+            *dark = calib->darkFrame;
+        } else {
+            res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+        }
+    }
+    return res;
+}
+
+
+void spiDriver_TraceCalibInit(spiDriver_TraceCalib_t* const calib, const TraceConvFormat_e outFormat)
+{
+    for (uint16_t ch = 0u; ch < N_CHANNELS; ch++) {
+        calib->offset[ch] = 0.0f;
+        calib->gain[ch] = 1.0f;
+    }
+    calib->darkFrame = NULL;
+    calib->darkSamples = 0u;
+    calib->outFormat = outFormat;
+    calib->qFracBits = 0u;
+}
+
+
+FuncResult_e spiDriver_ConvertTraceF32(const spiDriver_TraceCalib_t* const calib,
+                                       const uint16_t* const trace,
+                                       const uint16_t nSamples,
+                                       float* const out)
+{
+    const uint16_t* dark;
+    FuncResult_e res = spiDriver_ConvCheck(calib, nSamples, &dark);
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        for (uint16_t ch = 0u; ch < N_CHANNELS; ch++) {
+            const uint32_t base = (uint32_t)ch * nSamples;
+            const uint16_t* chDark = (dark != NULL) ? &dark[base] : NULL;
+            const float offset = calib->offset[ch];
+            const float gain = calib->gain[ch];
+            uint16_t ind = 0u;
+#if defined(__AVX2__) || defined(__SSE2__) || defined(__ARM_NEON)
+            for (; (ind + TRACE_CONV_BLOCK) <= nSamples; ind += TRACE_CONV_BLOCK) {
+                spiDriver_ConvBlockF32(&trace[base + ind],
+                                       (chDark != NULL) ? &chDark[ind] : NULL,
+                                       offset, gain, &out[base + ind]);
+            }
+#endif
+            for (; ind < nSamples; ind++) {
+                out[base + ind] = spiDriver_ConvSample(&trace[base], chDark, ind, offset, gain);
+            }
+        }
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_ConvertTraceQ(const spiDriver_TraceCalib_t* const calib,
+                                     const uint16_t* const trace,
+                                     const uint16_t nSamples,
+                                     int16_t* const out)
+{
+    const uint16_t* dark;
+    FuncResult_e res = spiDriver_ConvCheck(calib, nSamples, &dark);
+    if ((res == SPI_DRV_FUNC_RES_OK) && (calib->qFracBits > TRACE_CONV_Q_FRAC_BITS_MAX)) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+    }
+    if (res == SPI_DRV_FUNC_RES_OK) {
+        const float qScale = (float)(1ul << calib->qFracBits);
+        for (uint16_t ch = 0u; ch < N_CHANNELS; ch++) {
+            const uint32_t base = (uint32_t)ch * nSamples;
+            const uint16_t* chDark = (dark != NULL) ? &dark[base] : NULL;
+            const float offset = calib->offset[ch];
+            const float scale = calib->gain[ch] * qScale;
+            uint16_t ind = 0u;
+#if defined(__AVX2__) || defined(__SSE2__) || defined(__ARM_NEON)
+            for (; (ind + TRACE_CONV_BLOCK) <= nSamples; ind += TRACE_CONV_BLOCK) {
+                spiDriver_ConvBlockQ(&trace[base + ind],
+                                     (chDark != NULL) ? &chDark[ind] : NULL,
+                                     offset, scale, &out[base + ind]);
+            }
+#endif
+            for (; ind < nSamples; ind++) {
+                out[base + ind] = spiDriver_ConvSampleQ(&trace[base], chDark, ind, offset, scale);
+            }
+        }
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_ConvertChipData(const spiDriver_TraceCalib_t* const calib, spiDriver_ChipData_t* const chipData)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    bool allocated = false;
+    if ((calib == NULL) || (chipData == NULL)) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_DATA;
+    } else if ((chipData->dataFormat == CHIP_DATA_TRACE) && (chipData->data != NULL)) {
+        if (chipData->outData == NULL) {
+            /* The buffer fits any of output formats, so it's reused when the format changes */
+            chipData->outData = malloc(sizeof(spiDriver_OutTraceData_t) * N_CHANNELS);
+            allocated = true;
+        }
+        if (chipData->outData == NULL) {
+            res = SPI_DRV_FUNC_RES_FAIL_MEMORY;
+        } else if (calib->outFormat == TRACE_CONV_OUT_Q) {
+            res = spiDriver_ConvertTraceQ(calib, chipData->data->trace, chipData->samples, chipData->outData);
+        } else {
+            res = spiDriver_ConvertTraceF32(calib, chipData->data->trace, chipData->samples, chipData->outData);
+        }
+        if (res == SPI_DRV_FUNC_RES_OK) {
+            chipData->outFormat = calib->outFormat;
+        } else if (allocated) {
+            free(chipData->outData);
+            chipData->outData = NULL;
+        }
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_SetTraceConversion(const spiDriver_TraceCalib_t* const calib)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    if ((calib != NULL) &&
+        (((calib->outFormat != TRACE_CONV_OUT_F32) && (calib->outFormat != TRACE_CONV_OUT_Q)) ||
+         (calib->qFracBits > TRACE_CONV_Q_FRAC_BITS_MAX))) {
+        res = SPI_DRV_FUNC_RES_FAIL_INPUT_CFG;
+    } else {
+        inlineCalib = calib;
+    }
+    return res;
+}
+
+
+void spiDriver_TraceConvInline(spiDriver_ChipData_t* const chipData)
+{
+    const spiDriver_TraceCalib_t* calib = inlineCalib;
+    chipData->outData = NULL;
+    chipData->outFormat = TRACE_CONV_OUT_F32;
+    if (calib != NULL) {
+        FuncResult_e res = spiDriver_ConvertChipData(calib, chipData);
+        if (res != SPI_DRV_FUNC_RES_OK) {
+            TRACE_PRINT("Trace conversion failed (%d) for IC %u\n", res, chipData->chip_id);
+        }
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
@@ -0,0 +1,143 @@
+/**
+ * @file
+ * @brief Raw trace conversion functions
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * @defgroup spi_trace_conv Raw trace conversion
+ * @ingroup spi_trace
+ *
+ * @details
+ *
+ * Converts the raw 16-bit trace samples, received from IC, into calibrated output values. Each sample is processed as:
+ *
+ *     out = (raw - dark - offset[channel]) * gain[channel]
+ *
+ * where the dark frame subtraction is optional. The output is either ::spiDriver_OutTraceData_t (float32), or the
+ * signed 16-bit fixed-point (Q-format) value with configurable number of fractional bits.
+ *
+ * The conversion can be used in two ways:
+ *
+ * - **inline** - the calibration is assigned by ::spiDriver_SetTraceConversion and each trace layer received by the
+ *   driver gets the converted data in ::spiDriver_ChipData_t.outData field;
+ * - **lazy** - the application calls ::spiDriver_ConvertChipData (or the low-level kernels) only for the layers it needs.
+ *
+ * The kernels use SSE2/AVX2 (x86) or NEON (ARM) instructions when the compiler targets them, and the plain C loop
+ * otherwise. The results of all variants are equal.
+ */
+
+#ifndef SPI_DRV_TRACE_CONV_H
+#define SPI_DRV_TRACE_CONV_H
+
+/** @{*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+
+/** Maximum amount of fractional bits in Q-format output */
+#define TRACE_CONV_Q_FRAC_BITS_MAX 15u
+
+/** Signed fixed-point trace type, used for Q-format output */
+typedef int16_t spiDriver_OutTraceDataQ_t[sizeof(spiDriver_TraceData_t) / sizeof(uint16_t)];
+
+/** Per-channel calibration, applied during the trace conversion */
+typedef struct {
+    float offset[N_CHANNELS];               /**< Offset in LSB, subtracted from each sample of the channel */
+    float gain[N_CHANNELS];                 /**< Gain, applied to each sample of the channel after the offset */
+    const uint16_t* darkFrame;              /**< Optional dark frame in order [N_CHANNELS][darkSamples]. NULL to disable */
+    uint16_t darkSamples;                   /**< Samples per channel in darkFrame. Should match the layer's samples */
+    TraceConvFormat_e outFormat;            /**< Output format of converted data */
+    uint8_t qFracBits;                      /**< Fractional bits for ::TRACE_CONV_OUT_Q format output */
+} spiDriver_TraceCalib_t;
+
+
+/** Initializes the calibration with unity gain, zero offset and no dark frame
+ * @param[out]  calib       calibration structure to initialize
+ * @param[in]   outFormat   output format to use
+ */
+void spiDriver_TraceCalibInit(spiDriver_TraceCalib_t* const calib, const TraceConvFormat_e outFormat);
+
+
+/** Converts the layer's traces into float32 values
+ * @param[in]   calib       calibration to apply
+ * @param[in]   trace       raw traces in order [N_CHANNELS][nSamples]
+ * @param[in]   nSamples    samples per channel, not greater than ::MAX_SAMPLES_N
+ * @param[out]  out         output buffer of N_CHANNELS * nSamples items
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    nSamples is out of range
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     dark frame does not match nSamples
+ */
+FuncResult_e spiDriver_ConvertTraceF32(const spiDriver_TraceCalib_t* const calib,
+                                       const uint16_t* const trace,
+                                       const uint16_t nSamples,
+                                       float* const out);
+
+
+/** Converts the layer's traces into signed Q-format values with calib->qFracBits fractional bits.
+ * The values are rounded to nearest and saturated to int16_t range.
+ * @param[in]   calib       calibration to apply
+ * @param[in]   trace       raw traces in order [N_CHANNELS][nSamples]
+ * @param[in]   nSamples    samples per channel, not greater than ::MAX_SAMPLES_N
+ * @param[out]  out         output buffer of N_CHANNELS * nSamples items
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    nSamples is out of range
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     dark frame does not match nSamples or qFracBits is out of range
+ */
+FuncResult_e spiDriver_ConvertTraceQ(const spiDriver_TraceCalib_t* const calib,
+                                     const uint16_t* const trace,
+                                     const uint16_t nSamples,
+                                     int16_t* const out);
+
+
+/** Converts the trace data of a chip-data record (lazy conversion)
+ * The output buffer chipData->outData is allocated when it's not assigned yet, and is freed by ::spiDriver_CleanChipData.
+ * Records of non-trace formats are left untouched.
+ * @param[in]       calib       calibration to apply
+ * @param[in,out]   chipData    chip-data record to convert
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful, or the record is not a trace
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_DATA    calib or chipData is NULL, or the record's samples are out of range
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     the calibration doesn't match the record, see ::spiDriver_ConvertTraceF32
+ *                                              and ::spiDriver_ConvertTraceQ
+ * @retval  SPI_DRV_FUNC_RES_FAIL_MEMORY        the output buffer can't be allocated
+ */
+FuncResult_e spiDriver_ConvertChipData(const spiDriver_TraceCalib_t* const calib, spiDriver_ChipData_t* const chipData);
+
+
+/** Assigns the calibration for the inline conversion in acquisition path
+ * When assigned, every trace layer received gets its converted data in ::spiDriver_ChipData_t.outData.
+ * The calibration is kept per driver's instance (see ::spiDriver_SelectHandle).
+ * @param[in]   calib       calibration to apply. The structure should be valid while assigned. Use NULL to disable
+ * @retval  SPI_DRV_FUNC_RES_OK                 operation is successful
+ * @retval  SPI_DRV_FUNC_RES_FAIL_INPUT_CFG     calibration has invalid output format settings
+ */
+FuncResult_e spiDriver_SetTraceConversion(const spiDriver_TraceCalib_t* const calib);
+
+
+/** Applies the inline conversion (if assigned) to the chip-data record just received
+ * @param[in,out]   chipData    chip-data record
+ */
+void spiDriver_TraceConvInline(spiDriver_ChipData_t* const chipData);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif /* SPI_DRV_TRACE_CONV_H */
@@ -76,6 +76,33 @@
     SPI driver releases history
     ===========================
 
+    Release RC 2.0.0
+    ----------------
+
+    Tag used for sources:
+    `SW75322_SPI_DRV_RC_2_0_0 <https://gitlab.melexis.com/m75322-host-support/mlx75322_driver_c/tags/SW75322_SPI_DRV_RC_2_0_0>`_
+
+    The release breaks the binary interface, the applications and the CFFI [for Python] declarations must be rebuilt
+    against the new headers:
+
+    - spiDriver_ChipData_t got the fields outData, outFormat, sceneComplete, sequence and continuity, appended after
+        chip_id. The size of the structure and the stride of the chip-data arrays are changed;
+    - spiDriver_chipData and spiDriver_chipDataSize are not exported variables anymore, but the macros selecting the
+        current driver's instance in spiDriver_chipDataInst[] and spiDriver_chipDataSizeInst[]. The bindings reading
+        these symbols directly must read the default instance's items of these arrays (index 0);
+
+    Changes:
+
+    - Driver's instances (handles) support;
+    - Continuous mode: in-process channels, delivery thread with credits and backpressure, data consumers, pull mode,
+        per-layer delivery, pacing and real-time profile;
+    - Sensor sharing with local processes by the broker and the shared memory scene transport;
+    - Burst acquisition, block reads/writes of the configuration and the per-layer acquisition mask;
+    - Layer counter continuity tracking;
+    - Columnar echo decoder, echo format selection by fields, echo features refinement and point cloud conversion;
+    - Raw trace conversion, host-side echo extraction and temporal trace accumulator;
+    - Unit tests against the emulated IC, run by `make test`;
+
     Release RC 1.3.0
     ----------------
 
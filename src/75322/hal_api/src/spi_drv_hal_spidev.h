@@ -40,6 +40,8 @@ typedef struct {
     uint32_t mode;          /**< The SPI mode configuration (polarity, phase, LSB/MSB order) */
     uint32_t speed;         /**< The SPI baudrate speed of communication */
     uint32_t bitsPerWord;   /**< The number of bits in a 'word' */
+    uint32_t bus;           /**< The SPI controller's number, its chip selects 0 and 1 are used. Each driver's instance
+                                 (see ::spiDriver_Handle_t) drives the sensor head on its own controller */
 } SpiConfig_t;
 
 /** This function configures the SPI connection based on provided platform-specific settings.
@@ -35,3 +35,9 @@ __attribute__((weak)) ContModeCbRet_t spiDriver_UdpCallback(spiDriver_ChipData_t
     return CB_RET_OK;
 }
 
+__attribute__((weak)) ContModeCbRet_t spiDriver_UdpSend(spiDriver_ChipData_t* chipData, const uint16_t chipDataSize)
+{
+    printf("\nUDP callback processing: Data offset is %08lx, %u records\n", (unsigned long)chipData, chipDataSize);
+    return CB_RET_OK;
+}
+
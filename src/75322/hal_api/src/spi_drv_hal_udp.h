@@ -42,6 +42,15 @@ extern "C"
  */
 ContModeCbRet_t spiDriver_UdpCallback(spiDriver_ChipData_t* chipData);
 
+/** Provides the API for UDP's export of the data item, used as a continuous mode data consumer
+ * @param[in] chipData      the item's records
+ * @param[in] chipDataSize  items count in `chipData` array
+ * @return                  callback's result of an operation, whether the flow should be continued.
+ *
+ * @note This function is overloaded by the UDP-component's implementation
+ */
+ContModeCbRet_t spiDriver_UdpSend(spiDriver_ChipData_t* chipData, const uint16_t chipDataSize);
+
 /** Provides initialization functions called from continuous mode initialization
  *
  * @param[in]   dest_port   Destination port for the UDP-packets. If this parameter is 0, default value ::DEST_PORT is used.
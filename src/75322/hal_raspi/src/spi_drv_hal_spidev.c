@@ -30,20 +30,31 @@
 #include <stdint.h>
 #include <unistd.h>
 #include "spi_drv_hal_spidev.h"
+#include "spi_drv_instance.h"
 
-static uint16_t devIdSpiDevGlobal = 0;
+/* The devices are opened per driver's instance, so each instance drives its own sensor head */
+static uint16_t devIdSpiDevGlobalInst[SPI_DRV_MAX_HANDLES];
+#define devIdSpiDevGlobal (devIdSpiDevGlobalInst[SPI_DRV_INSTANCE])
+/** The device selected by the current thread. Overrides devIdSpiDevGlobal when set, so the threads reading the ICs
+ * on different buses don't interfere. It's kept per driver's instance as well */
+static __thread uint16_t devIdSpiDevThreadInst[SPI_DRV_MAX_HANDLES];
+#define devIdSpiDevThread (devIdSpiDevThreadInst[SPI_DRV_INSTANCE]) /* devId + 1, 0 - not set by the thread */
 
-static SpiConfig_t spiCfg = {0};
+static SpiConfig_t spiCfgInst[SPI_DRV_MAX_HANDLES];
+#define spiCfg (spiCfgInst[SPI_DRV_INSTANCE])
 
 const SpiConfig_t defaultSpiCfg = {
     .initDevId = 0,
     .mode = SPI_MODE_1,
     .bitsPerWord = 8,
     .speed = 12500000ul,
+    .bus = 0,
 };
 
-int spiCs0GlobalFd;
-int spiCs1GlobalFd;
+int spiCs0GlobalFdInst[SPI_DRV_MAX_HANDLES];
+int spiCs1GlobalFdInst[SPI_DRV_MAX_HANDLES];
+#define spiCs0GlobalFd (spiCs0GlobalFdInst[SPI_DRV_INSTANCE])
+#define spiCs1GlobalFd (spiCs1GlobalFdInst[SPI_DRV_INSTANCE])
 
 FuncResult_e spiDriver_SpiOpenPort(const SpiConfig_t* const spiCfgInput)
 {
@@ -52,6 +63,7 @@ FuncResult_e spiDriver_SpiOpenPort(const SpiConfig_t* const spiCfgInput)
     int* spiCs0Fd;
     int* spiCs1Fd;
     unsigned long tmpVal;
+    char devName[32];
 
     /* ----- SET SPI MODE ----- */
     /* SPI_MODE_0: CPOL = 0, CPHA = 0, Clock idle low, data sampled on rising edge, data change on falling edge */
@@ -71,8 +83,10 @@ FuncResult_e spiDriver_SpiOpenPort(const SpiConfig_t* const spiCfgInput)
     spiCs0Fd = &spiCs0GlobalFd;
     spiCs1Fd = &spiCs1GlobalFd;
 
-    *spiCs0Fd = open("/dev/spidev0.0", O_RDWR);
-    *spiCs1Fd = open("/dev/spidev0.1", O_RDWR);
+    (void)snprintf(devName, sizeof(devName), "/dev/spidev%u.0", spiCfg.bus);
+    *spiCs0Fd = open(devName, O_RDWR);
+    (void)snprintf(devName, sizeof(devName), "/dev/spidev%u.1", spiCfg.bus);
+    *spiCs1Fd = open(devName, O_RDWR);
 
     if (*spiCs0Fd < 0) {
         statusValue |= 0x0001;
@@ -181,6 +195,7 @@ FuncResult_e spiDriver_SpiSetDev(uint16_t devId)
 {
 #if (SYNC_TEST_FLOW != 1)
     devIdSpiDevGlobal = devId;
+    devIdSpiDevThread = devId + 1u;
 #endif /* SYNC_TEST_FLOW */
     return SPI_DRV_FUNC_RES_OK;
 }
@@ -189,7 +204,7 @@ FuncResult_e spiDriver_SpiSetDev(uint16_t devId)
 
 uint16_t spiDriver_SpiGetDev(void)
 {
-    return devIdSpiDevGlobal;
+    return (devIdSpiDevThread != 0u) ? (devIdSpiDevThread - 1u) : devIdSpiDevGlobal;
 }
 
 
@@ -201,7 +216,7 @@ FuncResult_e spiDriver_SpiWriteAndRead(unsigned char* data, int length)
     int ioctlRes = -1;
     uint16_t statusValue = 0;
 
-    if (devIdSpiDevGlobal == 0) {
+    if (spiDriver_SpiGetDev() == 0) {
         spiCsFd = &spiCs0GlobalFd;
     } else {
         spiCsFd = &spiCs1GlobalFd;
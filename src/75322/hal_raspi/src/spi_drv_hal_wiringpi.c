@@ -25,6 +25,7 @@
 #include <wiringPi.h>
 #include "spi_drv_common_types.h"
 #include "spi_drv_hal_gpio.h"
+#include "spi_drv_instance.h"
 
 /* uint32_t, so max value (2**32) - 1. Example value: 200000 (x 5us  = 1 second) */
 #define READY_POLL_LIMIT_CNT 200000
@@ -33,7 +34,13 @@
 #define RESET_ASSERTION_WIDTH_MS 1
 #define RESET_RECOVERY_TIME_MS 100
 
-static uint16_t devIdPinGlobal = 0;
+/* The pins are configured per driver's instance, so each instance drives its own sensor head */
+static uint16_t devIdPinGlobalInst[SPI_DRV_MAX_HANDLES];
+#define devIdPinGlobal (devIdPinGlobalInst[SPI_DRV_INSTANCE])
+/** The device selected by the current thread. Overrides devIdPinGlobal when set, so the threads reading the ICs on
+ * different buses don't interfere. It's kept per driver's instance as well */
+static __thread uint16_t devIdPinThreadInst[SPI_DRV_MAX_HANDLES];
+#define devIdPinThread (devIdPinThreadInst[SPI_DRV_INSTANCE]) /* devId + 1, 0 - not set by the thread */
 
 /** RaspberryPi GPIO pinout default configuration */
 const GpioConfig_t raspiDefaultGpioCfg = {
@@ -82,7 +89,8 @@ const GpioConfig_t raspiDefaultGpioCfg = {
     },
 };
 
-static GpioConfig_t pinCfg;
+static GpioConfig_t pinCfgInst[SPI_DRV_MAX_HANDLES];
+#define pinCfg (pinCfgInst[SPI_DRV_INSTANCE])
 
 FuncResult_e spiDriver_PinInit(const GpioConfig_t* const raspiGpioCfg)
 {
@@ -142,6 +150,7 @@ FuncResult_e spiDriver_PinSetDev(uint16_t devId)
 {
 #if (SYNC_TEST_FLOW != 1)
     devIdPinGlobal = devId;
+    devIdPinThread = devId + 1u;
 #endif /* SYNC_TEST_FLOW */
     return SPI_DRV_FUNC_RES_OK;
 }
@@ -193,7 +202,9 @@ ComStat_e spiDriver_PinWaitForReady(void)
     uint32_t ii;
     uint16_t pinId;
 
-    if (devIdPinGlobal == 1) {
+    const uint16_t devId = (devIdPinThread != 0u) ? (devIdPinThread - 1u) : devIdPinGlobal;
+
+    if (devId == 1) {
         pinId = pinCfg.ready1Pin.pin;
     } else {
         pinId = pinCfg.ready0Pin.pin;
@@ -110,7 +110,7 @@ static void spiDriver_InitUdpSocket(const uint16_t dest_port)
  *  S : status
  *  M : metadata structure
  */
-ContModeCbRet_t spiDriver_UdpCallback(spiDriver_ChipData_t* chipData)
+ContModeCbRet_t spiDriver_UdpSend(spiDriver_ChipData_t* chipData, const uint16_t chipDataSize)
 {
     bool size_ok = false;
     ContModeCbRet_t res = CB_RET_OK;
@@ -126,8 +126,10 @@ ContModeCbRet_t spiDriver_UdpCallback(spiDriver_ChipData_t* chipData)
     cliaddr.sin_port = htons(udp_dest_port);
 
     /* when echo: append all layers to one buffer to send through UDP */
-    if (chipData[0].dataFormat != CHIP_DATA_TRACE) {
-        for (int i = 0; i < spiDriver_chipDataSize; i++) {
+    if (chipDataSize == 0u) {
+        /* Nothing to send */
+    } else if (chipData[0].dataFormat != CHIP_DATA_TRACE) {
+        for (int i = 0; i < chipDataSize; i++) {
             size_ok = calculateDataLength(chipData[i], &data_length);
             if (size_ok != true) {
                 res = CB_RET_EXIT;
@@ -144,7 +146,7 @@ ContModeCbRet_t spiDriver_UdpCallback(spiDriver_ChipData_t* chipData)
                              sizeof(struct sockaddr));
         }
     } else { /* when trace: send every layer separately through UDP */
-        for (int i = 0; i < spiDriver_chipDataSize; i += 2) {
+        for (int i = 0; i < chipDataSize; i += 2) {
             size_ok = calculateDataLength(chipData[i], &data_length);
             if (size_ok != true) {
                 res = CB_RET_EXIT;
@@ -161,12 +163,17 @@ ContModeCbRet_t spiDriver_UdpCallback(spiDriver_ChipData_t* chipData)
         }
     }
 
-    if (udp_res != 0) {
+    if (udp_res < 0) {
         res = CB_RET_EXIT;
     }
     return res;
 }
 
+ContModeCbRet_t spiDriver_UdpCallback(spiDriver_ChipData_t* chipData)
+{
+    return spiDriver_UdpSend(chipData, spiDriver_chipDataSize);
+}
+
 void spiDriver_InitUdpCallback(uint16_t dest_port)
 {
     if (dest_port == 0u) {
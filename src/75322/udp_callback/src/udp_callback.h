@@ -36,3 +36,12 @@ void spiDriver_InitUdpCallback(uint16_t dest_port);
  */
 ContModeCbRet_t spiDriver_UdpCallback(spiDriver_ChipData_t* chipData);
 
+/** Sends the data item via the UDP socket
+ * This function is used by the continuous mode as a data consumer, see ::spiDriver_SubscribeContMode
+ *
+ * @param[in] chipData      the item's records
+ * @param[in] chipDataSize  items count in `chipData` array
+ * @return                  callback's result of an operation, whether the flow should be continued.
+ */
+ContModeCbRet_t spiDriver_UdpSend(spiDriver_ChipData_t* chipData, const uint16_t chipDataSize);
+
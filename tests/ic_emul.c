@@ -0,0 +1,158 @@
+/**
+ * @file
+ * @brief Emulated IC memory for the driver tests
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "spi_drv_common_types.h"
+#include "ic_emul.h"
+
+#define LAYERS_AMOUNT_OFFSET 1u
+#define LAYERS_ORDER_OFFSET 2u
+
+uint16_t icEmulMemory[IC_EMUL_MEMORY_SIZE];
+uint32_t icEmulWrites;
+uint32_t icEmulResets;
+uint32_t icEmulOverlaps;
+uint32_t icEmulTransferUs;
+static uint16_t fwLayersCount;
+static uint32_t busActive;
+
+
+/** Emulates the transaction's duration, counting the transactions overlapping it */
+static void IcEmulTransfer(void)
+{
+    if (__atomic_add_fetch(&busActive, 1u, __ATOMIC_SEQ_CST) > 1u) {
+        __atomic_add_fetch(&icEmulOverlaps, 1u, __ATOMIC_SEQ_CST);
+    }
+    if (icEmulTransferUs > 0u) {
+        const struct timespec delay = {.tv_sec = 0, .tv_nsec = (long)icEmulTransferUs * 1000l};
+        (void)nanosleep(&delay, NULL);
+    }
+    __atomic_sub_fetch(&busActive, 1u, __ATOMIC_SEQ_CST);
+}
+
+
+FuncResult_e spiCom_Read(const uint16_t offset, const uint16_t wordSize, uint16_t* read_words)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    if (((uint32_t)offset + wordSize) <= IC_EMUL_MEMORY_SIZE) {
+        IcEmulTransfer();
+        memcpy(read_words, &icEmulMemory[offset], wordSize * sizeof(uint16_t));
+    } else {
+        res = SPI_DRV_FUNC_RES_FAIL_COMM;
+    }
+    return res;
+}
+
+
+FuncResult_e spiCom_Write(const uint16_t offset, const uint16_t wordSize, uint16_t* write_words, const bool patch)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    (void)patch;
+    if (((uint32_t)offset + wordSize) <= IC_EMUL_MEMORY_SIZE) {
+        IcEmulTransfer();
+        memcpy(&icEmulMemory[offset], write_words, wordSize * sizeof(uint16_t));
+        __atomic_add_fetch(&icEmulWrites, 1u, __ATOMIC_SEQ_CST);
+    } else {
+        res = SPI_DRV_FUNC_RES_FAIL_COMM;
+    }
+    return res;
+}
+
+
+FuncResult_e spiDriver_PinResetAsic(void)
+{
+    memset(icEmulMemory, 0, sizeof(icEmulMemory));
+    icEmulResets++;
+    return SPI_DRV_FUNC_RES_OK;
+}
+
+
+void IcEmulResetCounters(void)
+{
+    icEmulWrites = 0u;
+    icEmulResets = 0u;
+    icEmulOverlaps = 0u;
+}
+
+
+uint16_t IcEmulParamOffset(void)
+{
+    return 0u;
+}
+
+
+uint16_t IcEmulLayersAmountOffset(void)
+{
+    return LAYERS_AMOUNT_OFFSET;
+}
+
+
+uint16_t IcEmulLayersOrderOffset(const uint16_t layerIndex)
+{
+    return LAYERS_ORDER_OFFSET + layerIndex;
+}
+
+
+uint16_t IcEmulLayerParamOffset(const uint16_t layerId)
+{
+    return LAYERS_ORDER_OFFSET + fwLayersCount + layerId;
+}
+
+
+/* One word variable, the bit-field given is bit 0 (offsets are counted from MSB) */
+static void WriteFwVariable(FILE* fp, const char* const name, const char* const bitField, const uint16_t offset,
+                            const bool last)
+{
+    fprintf(fp, "\"%s\": {\"address\": %u, \"bit_field\": false, \"bit_offset\": 0, \"bit_size\": 16, "
+            "\"byte_size\": 2, \"reset\": [\"0\"], \"signed\": false, \"word_size\": 1, ", name, offset * 2u);
+    if (bitField != NULL) {
+        fprintf(fp, "\"%s\": {\"bit_field\": true, \"bit_offset\": 15, \"bit_size\": 1, \"byte_size\": 2, "
+                "\"reset\": [\"0\"], \"signed\": false, \"word_size\": 1}, ", bitField);
+    }
+    fprintf(fp, "\"offset\": %u}%s\n", offset, last ? "" : ",");
+}
+
+
+bool IcEmulWriteFwJson(const char* const fileName, const uint16_t layersCount)
+{
+    FILE* fp = fopen(fileName, "w");
+    char name[64];
+    char bitField[64];
+    if (fp != NULL) {
+        fwLayersCount = layersCount;
+        fprintf(fp, "{\n");
+        WriteFwVariable(fp, "param", "continuous_en", IcEmulParamOffset(), false);
+        WriteFwVariable(fp, "scene_layers_amount", NULL, IcEmulLayersAmountOffset(), false);
+        for (uint16_t ind = 0u; ind < layersCount; ind++) {
+            sprintf(name, "scene_layers_order_%u", ind);
+            WriteFwVariable(fp, name, NULL, IcEmulLayersOrderOffset(ind), false);
+        }
+        for (uint16_t ind = 0u; ind < layersCount; ind++) {
+            sprintf(name, "layer_%u_param", ind);
+            sprintf(bitField, "layer_%u_raw_mode_en", ind);
+            WriteFwVariable(fp, name, bitField, IcEmulLayerParamOffset(ind), (ind + 1u) == layersCount);
+        }
+        fprintf(fp, "}\n");
+        fclose(fp);
+    }
+    return fp != NULL;
+}
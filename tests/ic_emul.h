@@ -0,0 +1,61 @@
+/**
+ * @file
+ * @brief Emulated IC memory for the driver tests
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * The test executables define the driver's bus entry points, so the driver library
+ * reads and writes the emulated IC memory instead of the SPI bus.
+ */
+
+#ifndef IC_EMUL_H
+#define IC_EMUL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define IC_EMUL_MEMORY_SIZE 0x1000u /**< Emulated IC memory size, 16-bit words */
+
+/** Emulated IC memory, all values are 0 after the reset */
+extern uint16_t icEmulMemory[IC_EMUL_MEMORY_SIZE];
+
+/** Number of ::spiCom_Write calls since the last ::IcEmulResetCounters */
+extern uint32_t icEmulWrites;
+
+/** Number of ::spiDriver_PinResetAsic calls since the last ::IcEmulResetCounters */
+extern uint32_t icEmulResets;
+
+/** Number of bus transactions which started while another one was in progress */
+extern uint32_t icEmulOverlaps;
+
+/** Duration of each emulated bus transaction, in microseconds. 0 - the transaction is instant */
+extern uint32_t icEmulTransferUs;
+
+/** Clears the calls' counters */
+void IcEmulResetCounters(void);
+
+/** Writes the FW variables' description file for the fields used by the scene's programming.
+ *
+ * @param[in]   fileName    the file to create
+ * @param[in]   layersCount amount of "layer_N_param" variables and the "scene_layers_order_N" ones
+ * @retval  true    the file is written
+ */
+bool IcEmulWriteFwJson(const char* const fileName, const uint16_t layersCount);
+
+/** Returns the offset of the variable in the FW file written by ::IcEmulWriteFwJson */
+uint16_t IcEmulParamOffset(void);
+uint16_t IcEmulLayersAmountOffset(void);
+uint16_t IcEmulLayersOrderOffset(const uint16_t layerIndex);
+uint16_t IcEmulLayerParamOffset(const uint16_t layerId);
+
+#endif /* IC_EMUL_H */
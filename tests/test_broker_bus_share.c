@@ -0,0 +1,121 @@
+/**
+ * @file
+ * @brief Bus shared by the broker and the application owning the sensor
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * While a client's writes are run by the broker, the application writes the same variable by its own calls. The bus
+ * transactions of both should never overlap. The broker's socket and the data plane's shared memory should be
+ * accessible by the owner's user only.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_api.h"
+#include "broker.h"
+#include "broker_client.h"
+#include "scene_shm.h"
+#include "ic_emul.h"
+
+#define TEST_FW_FILE "test_broker_bus_share_fw.json"
+#define TEST_SOCKET "test_broker_bus_share.sock"
+#define TEST_SHM "/test_broker_bus_share"
+#define TEST_CLIENT_WRITES 10u
+
+static uint16_t failures = 0u;
+static bool clientDone = false;
+static uint16_t clientFailures = 0u;
+
+#define TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+
+static void* ClientThread(void* temp)
+{
+    const int conn = spiDriver_BrokerConnect(TEST_SOCKET);
+    (void)temp;
+    if (conn < 0) {
+        clientFailures++;
+    } else {
+        for (uint16_t ind = 0u; ind < TEST_CLIENT_WRITES; ind++) {
+            if (spiDriver_BrokerSet(conn, 0u, "scene_layers_amount", ind, NULL) != SPI_DRV_FUNC_RES_OK) {
+                clientFailures++;
+            }
+        }
+        spiDriver_BrokerDisconnect(conn);
+    }
+    __atomic_store_n(&clientDone, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+
+int main(void)
+{
+    spiDriver_InputConfiguration_t cfg = {NULL, TEST_FW_FILE, NULL, NULL, NULL};
+    pthread_t client;
+    uint32_t ownWrites = 0u;
+    struct stat socketStat;
+    struct stat shmStat;
+    int shmFd;
+
+    TEST_CHECK(IcEmulWriteFwJson(TEST_FW_FILE, 2u));
+    TEST_CHECK(spiDriver_Initialize(&cfg) == SPI_DRV_TRUE);
+    remove(TEST_FW_FILE);
+    TEST_CHECK(spiDriver_StartBroker(TEST_SOCKET, NULL, 0u, 0u) == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(stat(TEST_SOCKET, &socketStat) == 0);
+    TEST_CHECK((socketStat.st_mode & 0777u) == BROKER_SOCKET_MODE);
+
+    TEST_CHECK(spiDriver_SetSceneShmMode(0044u) == SPI_DRV_FUNC_RES_FAIL_INPUT_CFG);
+    TEST_CHECK(spiDriver_OpenSceneShm(TEST_SHM, 64u, 2u) == SPI_DRV_FUNC_RES_OK);
+    shmFd = shm_open(TEST_SHM, O_RDONLY, 0);
+    TEST_CHECK(shmFd >= 0);
+    if (shmFd >= 0) {
+        TEST_CHECK(fstat(shmFd, &shmStat) == 0);
+        TEST_CHECK((shmStat.st_mode & 0777u) == SCENE_SHM_MODE);
+        (void)close(shmFd);
+    }
+    spiDriver_CloseSceneShm();
+
+    IcEmulResetCounters();
+    icEmulTransferUs = 200u;
+    TEST_CHECK(pthread_create(&client, NULL, &ClientThread, NULL) == 0);
+    while (!__atomic_load_n(&clientDone, __ATOMIC_ACQUIRE)) {
+        TEST_CHECK(spiDriver_SetByName("param", ownWrites & 1u, "continuous_en") == SPI_DRV_FUNC_RES_OK);
+        ownWrites++;
+    }
+    (void)pthread_join(client, NULL);
+    spiDriver_StopBroker();
+
+    TEST_CHECK(clientFailures == 0u);
+    TEST_CHECK(ownWrites > 0u);
+    TEST_CHECK(icEmulOverlaps == 0u);
+    printf("%s: %u own writes, %u overlaps\n", __FILE__, ownWrites, icEmulOverlaps);
+
+    printf("%s: %u failure(s)\n", __FILE__, failures);
+    return (failures == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,113 @@
+/**
+ * @file
+ * @brief Continuous mode pull-mode delivery
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * The scenes are fed to the delivery thread the way the continuous mode thread does it. The pull-mode queue should
+ * signal each scene on the eventfd, drop its oldest scene when full, hand the scenes out in order, and refuse to hand
+ * out more scenes than its depth until the application releases the ones it holds.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+#include "cont_mode_lib.h"
+#include "cont_mode_chan.h"
+#include "deliver_data.h"
+
+/** Items kept by the pull-mode queue */
+#define TEST_PULL_DEPTH 2u
+
+static uint16_t failures = 0u;
+
+#define TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+
+/** Hands the scene over to the delivery thread and waits until it's delivered */
+static void TestDeliver(const uint16_t id)
+{
+    contModeInterface_t msg = {.mtype = CONT_MODE_SCENE, .cmd = CONT_MODE_WORK, .chipDataSize = 1u,
+                               .sceneComplete = true};
+    msg.chipData = calloc(1u, sizeof(spiDriver_ChipData_t));
+    TEST_CHECK(msg.chipData != NULL);
+    if (msg.chipData != NULL) {
+        msg.chipData->chip_id = id;
+        msg.chipData->dataFormat = CHIP_DATA_META_ONLY;
+        spiDriver_ContModeSend(&msg);
+        TEST_CHECK(spiDriver_ContModeReceive(CONT_MODE_CREDIT, &msg, true));
+        TEST_CHECK(msg.sceneComplete);
+    }
+}
+
+
+int main(void)
+{
+    spiDriver_ChipData_t* first = NULL;
+    spiDriver_ChipData_t* second = NULL;
+    spiDriver_ChipData_t* third = NULL;
+    uint16_t size = 0u;
+    uint64_t events = 0u;
+    ContModeConsumerStats_t stats;
+    int fd;
+
+    spiDriver_ContModeChanInit();
+    fd = spiDriver_OpenContModePull(TEST_PULL_DEPTH);
+    TEST_CHECK(fd >= 0);
+    TEST_CHECK(spiDriver_OpenContModePull(TEST_PULL_DEPTH) < 0);
+    TEST_CHECK(!spiDriver_TryAcquireScene(&first, &size));
+    spiDriver_InitDeliverData();
+
+    /* Three scenes into the queue of two: the oldest one is dropped, each one is signalled */
+    for (uint16_t id = 0u; id < 3u; id++) {
+        TestDeliver(id);
+    }
+    TEST_CHECK(read(fd, &events, sizeof(events)) == (ssize_t)sizeof(events));
+    TEST_CHECK(events == 3u);
+    TEST_CHECK(spiDriver_TryAcquireScene(&first, &size));
+    TEST_CHECK((first != NULL) && (first->chip_id == 1u) && (size == 1u));
+    TEST_CHECK(spiDriver_TryAcquireScene(&second, &size));
+    TEST_CHECK((second != NULL) && (second->chip_id == 2u));
+    TEST_CHECK(!spiDriver_TryAcquireScene(&third, &size));
+
+    /* The application holds the queue's depth already, the next scene waits for a release */
+    TestDeliver(3u);
+    TEST_CHECK(!spiDriver_TryAcquireScene(&third, &size));
+    spiDriver_ReleaseScene(first);
+    TEST_CHECK(spiDriver_TryAcquireScene(&third, &size));
+    TEST_CHECK((third != NULL) && (third->chip_id == 3u));
+    /* Releasing an item not held is ignored */
+    spiDriver_ReleaseScene(first);
+
+    TEST_CHECK(spiDriver_GetContModePullStats(&stats));
+    TEST_CHECK(stats.delivered == 3u);
+    TEST_CHECK(stats.dropped == 1u);
+
+    spiDriver_CloseContModePull();
+    TEST_CHECK(!spiDriver_GetContModePullStats(&stats));
+    TEST_CHECK(!spiDriver_TryAcquireScene(&first, &size));
+    spiDriver_ExitDeliverData();
+
+    printf("%s: %u failure(s)\n", __FILE__, failures);
+    return (failures == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
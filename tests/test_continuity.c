@@ -0,0 +1,114 @@
+/**
+ * @file
+ * @brief Layer counter continuity tracker
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * The tracker should follow the layer counter through its 16-bit wrap, tag the repeated and the backward layers as
+ * repeated, count the layers skipped by a gap as dropped, and neither trust nor track the layers with failed
+ * communication. The meta-only records inherit the tags of their layer, and the restart keeps the statistics.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_api.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_continuity.h"
+
+/** IC tracked by the test */
+#define TEST_IC 1u
+
+static uint16_t failures = 0u;
+
+#define TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+
+/** Passes the layer with the counter to the tracker and returns the record tagged */
+static spiDriver_ChipData_t TestLayer(const uint16_t counter, const FuncResult_e status)
+{
+    static Metadata_t meta;
+    spiDriver_ChipData_t chipData = {
+        .metaData = &meta, .dataFormat = CHIP_DATA_TRACE, .status = status, .sequence = 0xAAAAu, .continuity = 0xFFu,
+    };
+    meta.layer_counter = counter;
+    spiDriver_ContinuityUpdate(&chipData, TEST_IC);
+    return chipData;
+}
+
+
+int main(void)
+{
+    spiDriver_ContinuityStats_t stats;
+    spiDriver_ChipData_t chipData;
+    spiDriver_ChipData_t metaOnly = {.dataFormat = CHIP_DATA_META_ONLY};
+
+    spiDriver_ResetContinuityStats(IC_ID_BROADCAST);
+
+    chipData = TestLayer(0xFFFEu, SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK((chipData.continuity == CHIP_DATA_CONT_FIRST) && (chipData.sequence == 0xFFFEu));
+    chipData = TestLayer(0xFFFFu, SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK((chipData.continuity == CHIP_DATA_CONT_OK) && (chipData.sequence == 0xFFFFu));
+
+    /* The counter wraps */
+    chipData = TestLayer(0x0000u, SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK((chipData.continuity == CHIP_DATA_CONT_OK) && (chipData.sequence == 0x0000u));
+
+    /* The same layer and the previous one are repeated, and don't move the tracker */
+    chipData = TestLayer(0x0000u, SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(chipData.continuity == CHIP_DATA_CONT_REPEAT);
+    chipData = TestLayer(0xFFFFu, SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(chipData.continuity == CHIP_DATA_CONT_REPEAT);
+
+    /* Two layers dropped. The meta-only record gets the tags of its layer */
+    chipData = TestLayer(0x0003u, SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK((chipData.continuity == CHIP_DATA_CONT_DROP) && (chipData.sequence == 0x0003u));
+    spiDriver_ContinuityUpdate(&metaOnly, TEST_IC);
+    TEST_CHECK((metaOnly.continuity == CHIP_DATA_CONT_DROP) && (metaOnly.sequence == 0x0003u));
+
+    /* The failed layer's counter is not trusted, the next layer still follows the latest good one */
+    chipData = TestLayer(0x1234u, SPI_DRV_FUNC_RES_FAIL_COMM);
+    TEST_CHECK((chipData.continuity == CHIP_DATA_CONT_FAILED) && (chipData.sequence == 0x0004u));
+    chipData = TestLayer(0x0004u, SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(chipData.continuity == CHIP_DATA_CONT_OK);
+
+    /* Restart: the next layer is the first one, the statistics are kept */
+    spiDriver_ContinuityRestart(TEST_IC);
+    chipData = TestLayer(0x0100u, SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(chipData.continuity == CHIP_DATA_CONT_FIRST);
+
+    TEST_CHECK(spiDriver_GetContinuityStats(TEST_IC, &stats) == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(stats.layers == 9u);
+    TEST_CHECK(stats.repeated == 2u);
+    TEST_CHECK(stats.dropped == 2u);
+    TEST_CHECK(stats.gaps == 1u);
+    TEST_CHECK(stats.failed == 1u);
+    TEST_CHECK(spiDriver_GetContinuityStats(IC_ID_BROADCAST, &stats) == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK((stats.layers == 9u) && (stats.dropped == 2u));
+    TEST_CHECK(spiDriver_GetContinuityStats(IC_ID_BROADCAST + 1u, &stats) == SPI_DRV_FUNC_RES_FAIL_INPUT_CFG);
+
+    spiDriver_ResetContinuityStats(TEST_IC);
+    TEST_CHECK(spiDriver_GetContinuityStats(TEST_IC, &stats) == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK((stats.layers == 0u) && (stats.dropped == 0u) && (stats.repeated == 0u));
+
+    printf("%s: %u failure(s)\n", __FILE__, failures);
+    return (failures == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
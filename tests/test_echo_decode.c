@@ -0,0 +1,163 @@
+/**
+ * @file
+ * @brief Columnar echo decoder
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * The compaction should keep only the valid objects, in the order of channels and objects, with all columns of an
+ * object kept together, while the full decoding should place every object at its position. The formats without flags
+ * should treat the objects with zero amplitude as not valid.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_echo_decode.h"
+
+static uint16_t failures = 0u;
+
+#define TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+
+/** The object is valid in the test's layers, every third one is not */
+static bool TestObjValid(const uint16_t ch, const uint16_t obj)
+{
+    return (((ch * ECHO_NUM_OBJS) + obj) % 3u) != 1u;
+}
+
+
+static void TestShort(spiDriver_EchoColumns_t* const columns)
+{
+    static ChannelEchoAll_t echo;
+    EchoShortData_t* data = EchoParseAsShort(&echo);
+    uint16_t expected = 0u;
+    bool match = true;
+
+    for (uint16_t ch = 0u; ch < ECHO_NUM_CHANNEL; ch++) {
+        for (uint16_t obj = 0u; obj < ECHO_NUM_OBJS; obj++) {
+            (*data)[ch][obj].distance = (uint16_t)(1000u + (ch * 10u) + obj);
+            (*data)[ch][obj].amplitude = (uint16_t)(2000u + (ch * 10u) + obj);
+            (*data)[ch][obj].flags = TestObjValid(ch, obj) ? 0x0009u : 0x0008u;
+        }
+    }
+
+    /* Compaction: the valid objects only, in order */
+    TEST_CHECK(spiDriver_DecodeEchoLayer(&echo, FMT_ECHO_SHORT, true, columns) == SPI_DRV_FUNC_RES_OK);
+    for (uint16_t ch = 0u; ch < ECHO_NUM_CHANNEL; ch++) {
+        for (uint16_t obj = 0u; obj < ECHO_NUM_OBJS; obj++) {
+            if (TestObjValid(ch, obj)) {
+                match = match && (expected < columns->count) &&
+                        (columns->channel[expected] == ch) && (columns->object[expected] == obj) &&
+                        (columns->distance[expected] == (*data)[ch][obj].distance) &&
+                        (columns->amplitude[expected] == (*data)[ch][obj].amplitude) &&
+                        (columns->flags[expected] == 0x0009u);
+                expected++;
+            }
+        }
+    }
+    TEST_CHECK(match);
+    TEST_CHECK(columns->count == expected);
+    TEST_CHECK(columns->format == FMT_ECHO_SHORT);
+    TEST_CHECK(columns->distUnit == ECHO_DIST_UNIT_DIST_FORMAT);
+
+    /* No compaction: all objects at their positions, including the invalid ones */
+    TEST_CHECK(spiDriver_DecodeEchoLayer(&echo, FMT_ECHO_SHORT, false, columns) == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(columns->count == ECHO_LAYER_OBJS_MAX);
+    match = true;
+    for (uint16_t ind = 0u; ind < ECHO_LAYER_OBJS_MAX; ind++) {
+        const uint16_t ch = ind / ECHO_NUM_OBJS;
+        const uint16_t obj = ind % ECHO_NUM_OBJS;
+        match = match && (columns->channel[ind] == ch) && (columns->object[ind] == obj) &&
+                (columns->flags[ind] == (*data)[ch][obj].flags);
+    }
+    TEST_CHECK(match);
+
+    /* No valid objects at all */
+    memset(&echo, 0, sizeof(echo));
+    TEST_CHECK(spiDriver_DecodeEchoLayer(&echo, FMT_ECHO_SHORT, true, columns) == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(columns->count == 0u);
+}
+
+
+static void Test9P(spiDriver_EchoColumns_t* const columns)
+{
+    static ChannelEchoAll_t echo;
+    Echo9PData_t* data = EchoParseAs9P(&echo);
+    uint16_t expected = 0u;
+    bool match = true;
+
+    memset(&echo, 0, sizeof(echo));
+    for (uint16_t ch = 0u; ch < ECHO_NUM_CHANNEL; ch++) {
+        for (uint16_t obj = 0u; obj < ECHO_NUM_OBJS; obj++) {
+            if (TestObjValid(ch, obj)) {
+                (*data)[ch][obj].index = (uint16_t)(100u + (ch * 4u) + obj);
+                for (uint16_t ind = 0u; ind < ECHO_9P_SAMPLES; ind++) {
+                    (*data)[ch][obj].data[ind] = (uint16_t)(50u + (ind * 10u));
+                }
+                /* The peak moves along the points */
+                (*data)[ch][obj].data[(ch + obj) % ECHO_9P_SAMPLES] = 500u;
+            }
+        }
+    }
+
+    TEST_CHECK(spiDriver_DecodeEchoLayer(&echo, FMT_ECHO_9P, true, columns) == SPI_DRV_FUNC_RES_OK);
+    for (uint16_t ch = 0u; ch < ECHO_NUM_CHANNEL; ch++) {
+        for (uint16_t obj = 0u; obj < ECHO_NUM_OBJS; obj++) {
+            if (TestObjValid(ch, obj)) {
+                const Echo9PDataItem_t* item = &(*data)[ch][obj];
+                match = match && (expected < columns->count) &&
+                        (columns->channel[expected] == ch) && (columns->object[expected] == obj) &&
+                        (columns->distance[expected] == (item->index + ((ch + obj) % ECHO_9P_SAMPLES))) &&
+                        (columns->amplitude[expected] == 500u) &&
+                        (columns->samplesStart[expected] == item->index) &&
+                        (memcmp(columns->samples[expected], item->data, sizeof(item->data)) == 0);
+                expected++;
+            }
+        }
+    }
+    TEST_CHECK(match);
+    TEST_CHECK(columns->count == expected);
+    TEST_CHECK(columns->distUnit == ECHO_DIST_UNIT_SAMPLES);
+    TEST_CHECK((columns->fields & ECHO_FIELD_PEAK_INDEX) != 0u);
+    TEST_CHECK((columns->fields & ECHO_FIELD_DISTANCE) == 0u);
+}
+
+
+int main(void)
+{
+    spiDriver_EchoColumns_t* columns = malloc(sizeof(spiDriver_EchoColumns_t));
+    static ChannelEchoAll_t echo;
+
+    TEST_CHECK(columns != NULL);
+    if (columns != NULL) {
+        TestShort(columns);
+        Test9P(columns);
+        TEST_CHECK(spiDriver_DecodeEchoLayer(&echo, (EchoFormatSize_e)7u, true, columns) ==
+                   SPI_DRV_FUNC_RES_FAIL_INPUT_DATA);
+        TEST_CHECK(columns->count == 0u);
+    }
+    free(columns);
+
+    printf("%s: %u failure(s)\n", __FILE__, failures);
+    return (failures == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,187 @@
+/**
+ * @file
+ * @brief Host echo extraction against the IC's echoes of a capture
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * The host's echoes extracted from the trace layers of a capture should match the IC's echoes of the same layers.
+ *
+ * A capture is a sequence of layer pairs, in the host's byte order: the header (samples per channel, the layer's
+ * echoThreshold, the trace channel of the echo channel 0, reserved: 4 uint16_t), the trace layer
+ * ([N_CHANNELS][samples] uint16_t) and the IC's echoes of the layer read in ::FMT_ECHO_DETAIL (EchoDetailData_t).
+ * A recorded capture is checked when its path is set by the ECHO_CAPTURE environment variable. The tree has no
+ * recordings, so otherwise the capture is generated: pulses on a flat baseline, with the IC's echoes at their peaks.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_echo_extract.h"
+
+#define TEST_CAPTURE_FILE "echo_capture.bin"
+#define TEST_LAYERS 4u
+#define TEST_SAMPLES 200u
+#define TEST_BASELINE 1000u
+#define TEST_THRESHOLD 50u
+/** Peak position difference accepted between the host and the IC, in samples */
+#define TEST_TOLERANCE 2u
+/** The share of the IC's echoes a recorded capture should match, in percent */
+#define TEST_RECORDED_MATCH_PCT 90u
+
+/** The capture's layer header */
+typedef struct {
+    uint16_t samples;           /**< Samples per channel */
+    uint16_t echoThreshold;     /**< The layer's echoThreshold */
+    uint16_t channelOffset;     /**< Trace channel of the echo channel 0 */
+    uint16_t reserved;          /**< Reserved */
+} TestCaptureHeader_t;
+
+static uint16_t failures = 0u;
+
+#define TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+
+/** Writes the generated capture: each echo channel gets 1 to 3 triangle pulses */
+static bool TestWriteCapture(const char* const path)
+{
+    FILE* file = fopen(path, "wb");
+    uint16_t* trace = malloc(sizeof(uint16_t) * N_CHANNELS * TEST_SAMPLES);
+    EchoDetailData_t* echo = malloc(sizeof(EchoDetailData_t));
+    bool res = (file != NULL) && (trace != NULL) && (echo != NULL);
+    for (uint16_t layer = 0u; res && (layer < TEST_LAYERS); layer++) {
+        const TestCaptureHeader_t header = {TEST_SAMPLES, TEST_THRESHOLD, 0u, 0u};
+        memset(echo, 0, sizeof(EchoDetailData_t));
+        for (uint16_t ch = 0u; ch < N_CHANNELS; ch++) {
+            for (uint16_t ind = 0u; ind < TEST_SAMPLES; ind++) {
+                trace[(ch * TEST_SAMPLES) + ind] = (uint16_t)(TEST_BASELINE + ((ind + ch + layer) % 3u));
+            }
+        }
+        for (uint16_t ch = 0u; ch < ECHO_NUM_CHANNEL; ch++) {
+            const uint16_t pulses = 1u + ((ch + layer) % 3u);
+            for (uint16_t obj = 0u; obj < pulses; obj++) {
+                const uint16_t peak = (uint16_t)(40u + (obj * 50u) + ((ch * 7u + layer * 3u) % 20u));
+                const uint16_t amplitude = (uint16_t)(200u + (ch * 10u) + (obj * 50u));
+                for (uint16_t dist = 0u; dist < 8u; dist++) {
+                    const uint16_t level = (uint16_t)(amplitude - (amplitude * dist / 8u));
+                    trace[(ch * TEST_SAMPLES) + peak - dist] = (uint16_t)(TEST_BASELINE + level);
+                    trace[(ch * TEST_SAMPLES) + peak + dist] = (uint16_t)(TEST_BASELINE + level);
+                }
+                (*echo)[ch][obj].peak = peak;
+                (*echo)[ch][obj].amplitude = (uint16_t)(TEST_BASELINE + amplitude);
+                (*echo)[ch][obj].distance = peak;
+                (*echo)[ch][obj].flags.valid = 1u;
+            }
+        }
+        res = (fwrite(&header, sizeof(header), 1u, file) == 1u) &&
+              (fwrite(trace, sizeof(uint16_t) * N_CHANNELS * TEST_SAMPLES, 1u, file) == 1u) &&
+              (fwrite(echo, sizeof(EchoDetailData_t), 1u, file) == 1u);
+    }
+    if (file != NULL) {
+        res = (fclose(file) == 0) && res;
+    }
+    free(trace);
+    free(echo);
+    return res;
+}
+
+
+/** Extracts the echoes of each trace layer of the capture and compares them with the IC's ones */
+static bool TestCompareCapture(const char* const path, spiDriver_EchoCompareStat_t* const total, uint16_t* const layers)
+{
+    FILE* file = fopen(path, "rb");
+    uint16_t* trace = malloc(sizeof(uint16_t) * N_CHANNELS * MAX_SAMPLES_N);
+    EchoDetailData_t* icEcho = malloc(sizeof(EchoDetailData_t));
+    EchoDetailData_t* hostEcho = malloc(sizeof(EchoDetailData_t));
+    TestCaptureHeader_t header;
+    float errorSum = 0.0f;
+    bool res = (file != NULL) && (trace != NULL) && (icEcho != NULL) && (hostEcho != NULL);
+
+    memset(total, 0, sizeof(*total));
+    *layers = 0u;
+    while (res && (fread(&header, sizeof(header), 1u, file) == 1u)) {
+        spiDriver_EchoExtractCfg_t cfg;
+        spiDriver_EchoCompareStat_t stat;
+        res = (header.samples > 0u) && (header.samples <= MAX_SAMPLES_N) &&
+              (fread(trace, sizeof(uint16_t) * N_CHANNELS * header.samples, 1u, file) == 1u) &&
+              (fread(icEcho, sizeof(EchoDetailData_t), 1u, file) == 1u);
+        if (res) {
+            spiDriver_EchoExtractCfgInit(&cfg, NULL);
+            cfg.echoThreshold = header.echoThreshold;
+            cfg.lowAmplitude = 2u * header.echoThreshold;
+            cfg.channelOffset = header.channelOffset;
+            res = (spiDriver_ExtractEchoLayer(&cfg, trace, header.samples, hostEcho) == SPI_DRV_FUNC_RES_OK);
+        }
+        if (res) {
+            spiDriver_CompareEchoes((const EchoDetailData_t*)hostEcho, (const EchoDetailData_t*)icEcho,
+                                    TEST_TOLERANCE, &stat);
+            total->matched += stat.matched;
+            total->missed += stat.missed;
+            total->extra += stat.extra;
+            errorSum += stat.peakErrorMean * stat.matched;
+            if (stat.peakErrorMax > total->peakErrorMax) {
+                total->peakErrorMax = stat.peakErrorMax;
+            }
+            (*layers)++;
+        }
+    }
+    if (total->matched > 0u) {
+        total->peakErrorMean = errorSum / total->matched;
+    }
+    if (file != NULL) {
+        (void)fclose(file);
+    }
+    free(trace);
+    free(icEcho);
+    free(hostEcho);
+    return res && (*layers > 0u);
+}
+
+
+int main(void)
+{
+    const char* recorded = getenv("ECHO_CAPTURE");
+    spiDriver_EchoCompareStat_t stat;
+    uint16_t layers = 0u;
+
+    if (recorded != NULL) {
+        TEST_CHECK(TestCompareCapture(recorded, &stat, &layers));
+        /* The IC's echoes come from its own processing, a few of them may differ from the host's ones */
+        TEST_CHECK((stat.matched * 100u) >= ((uint32_t)(stat.matched + stat.missed) * TEST_RECORDED_MATCH_PCT));
+    } else {
+        TEST_CHECK(TestWriteCapture(TEST_CAPTURE_FILE));
+        TEST_CHECK(TestCompareCapture(TEST_CAPTURE_FILE, &stat, &layers));
+        remove(TEST_CAPTURE_FILE);
+        TEST_CHECK(layers == TEST_LAYERS);
+        TEST_CHECK(stat.matched > 0u);
+        TEST_CHECK(stat.missed == 0u);
+        TEST_CHECK(stat.extra == 0u);
+        TEST_CHECK(stat.peakErrorMax <= TEST_TOLERANCE);
+    }
+    printf("%s: %u layers, %u echoes matched (peak error mean %.2f, max %u), %u missed, %u extra\n",
+           (recorded != NULL) ? recorded : "generated capture", layers, stat.matched, (double)stat.peakErrorMean,
+           stat.peakErrorMax, stat.missed, stat.extra);
+    printf("%s: %u failure(s)\n", __FILE__, failures);
+    return (failures == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
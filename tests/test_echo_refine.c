@@ -0,0 +1,123 @@
+/**
+ * @file
+ * @brief Echo features refinement
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * The parabolic fit should find the exact vertex of 9P points lying on a parabola, and the Gaussian fit - the center of
+ * a sampled Gaussian pulse, where the parabolic fit is biased. For FAST points forming a triangle pulse, the width and
+ * slopes found by the linear interpolation are exact. The objects with zero amplitude should be skipped.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_echo_refine.h"
+
+static uint16_t failures = 0u;
+
+#define TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+/** Checks the value with the tolerance */
+#define TEST_CHECK_NEAR(value, expected, tolerance) TEST_CHECK(fabsf((value) - (expected)) <= (tolerance))
+
+
+/** 9P: the parabola 10000 - 400 * (x - 4.25)^2 sampled at the points, and a Gaussian pulse centered at 4.3 */
+static void Test9P(spiDriver_RefinedEchoes_t* const refined)
+{
+    static ChannelEchoAll_t echo;
+    Echo9PData_t* data = EchoParseAs9P(&echo);
+    float gaussParabolic;
+
+    memset(&echo, 0, sizeof(echo));
+    (*data)[3u][1u].index = 100u;
+    (*data)[5u][0u].index = 200u;
+    for (uint16_t k = 0u; k < ECHO_9P_SAMPLES; k++) {
+        const float d = (float)k - 4.3f;
+        (*data)[3u][1u].data[k] = (uint16_t)(10000 - (25 * ((4 * (int)k) - 17) * ((4 * (int)k) - 17)));
+        (*data)[5u][0u].data[k] = (uint16_t)lroundf(50.0f + (60000.0f * expf(-0.5f * d * d)));
+    }
+
+    TEST_CHECK(spiDriver_RefineEcho9P(data, ECHO_FIT_PARABOLIC, refined) == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(refined->count == 2u);
+    TEST_CHECK((refined->channel[0u] == 3u) && (refined->object[0u] == 1u));
+    TEST_CHECK((refined->channel[1u] == 5u) && (refined->object[1u] == 0u));
+    /* Baseline is the lowest outer point, 10000 - 25 * 17^2 */
+    TEST_CHECK_NEAR(refined->position[0u], 104.25f, 1e-3f);
+    TEST_CHECK_NEAR(refined->amplitude[0u], 7225.0f, 0.05f);
+    gaussParabolic = refined->position[1u];
+
+    TEST_CHECK(spiDriver_RefineEcho9P(data, ECHO_FIT_GAUSSIAN, refined) == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(refined->count == 2u);
+    TEST_CHECK_NEAR(refined->position[1u], 204.3f, 0.01f);
+    TEST_CHECK_NEAR(refined->amplitude[1u], 60000.0f, 60.0f);
+    TEST_CHECK(fabsf(gaussParabolic - 204.3f) > fabsf(refined->position[1u] - 204.3f));
+}
+
+
+/** FAST: triangle pulse 100 at 10, 700 at 13, 1100 at 14, 600 at 16 and 100 at 18 */
+static void TestFast(spiDriver_RefinedEchoes_t* const refined)
+{
+    static ChannelEchoAll_t echo;
+    EchoFastData_t* data = EchoParseAsFast(&echo);
+    const EchoFastDataItem_t item = {
+        .minLi = 10u, .minL = 100u, .maxSLi = 13u, .maxSL = 700u, .maxi = 14u, .max = 1100u,
+        .maxSRi = 16u, .maxSR = 600u, .minRi = 18u, .minR = 100u,
+    };
+
+    memset(&echo, 0, sizeof(echo));
+    (*data)[ECHO_NUM_CHANNEL - 1u][ECHO_NUM_OBJS - 1u] = item;
+
+    TEST_CHECK(spiDriver_RefineEchoFast(data, ECHO_FIT_PARABOLIC, refined) == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(refined->count == 1u);
+    TEST_CHECK(refined->channel[0u] == (ECHO_NUM_CHANNEL - 1u));
+    TEST_CHECK(refined->object[0u] == (ECHO_NUM_OBJS - 1u));
+    /* Parabola through (-1, 600), (0, 1000), (2, 500) above the baseline: a = -650/3, b = 550/3 */
+    TEST_CHECK_NEAR(refined->position[0u], 14.0f + (11.0f / 26.0f), 1e-3f);
+    TEST_CHECK_NEAR(refined->amplitude[0u], 1000.0f + (3025.0f / 78.0f), 0.01f);
+    /* Half of amplitude 600 is reached at 12.5 and at 16 */
+    TEST_CHECK_NEAR(refined->width[0u], 3.5f, 1e-3f);
+    TEST_CHECK_NEAR(refined->riseSlope[0u], 400.0f, 1e-3f);
+    TEST_CHECK_NEAR(refined->fallSlope[0u], -250.0f, 1e-3f);
+}
+
+
+int main(void)
+{
+    spiDriver_RefinedEchoes_t* refined = malloc(sizeof(spiDriver_RefinedEchoes_t));
+    spiDriver_ChipData_t chipData = {.dataFormat = CHIP_DATA_TRACE};
+
+    TEST_CHECK(refined != NULL);
+    if (refined != NULL) {
+        Test9P(refined);
+        TestFast(refined);
+        TEST_CHECK(spiDriver_RefineChipData(&chipData, ECHO_FIT_PARABOLIC, refined) ==
+                   SPI_DRV_FUNC_RES_FAIL_INPUT_DATA);
+        TEST_CHECK(refined->count == 0u);
+    }
+    free(refined);
+
+    printf("%s: %u failure(s)\n", __FILE__, failures);
+    return (failures == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file
+ * @brief Driver instance handles selection
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * Selecting a handle which isn't created, or is destroyed, should fail and keep the thread's selection.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_handle.h"
+
+static uint16_t failures = 0u;
+
+#define TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+
+int main(void)
+{
+    uint32_t notHandle[4] = {0u};
+    spiDriver_Handle_t* handle = spiDriver_CreateHandle();
+    spiDriver_Handle_t* previous = NULL;
+    uint32_t value;
+
+    TEST_CHECK(handle != NULL);
+    TEST_CHECK(spiDriver_CurrentHandle() == spiDriver_DefaultHandle());
+
+    /* The created handle is selected, the default one is returned as previous */
+    TEST_CHECK(spiDriver_SelectHandle(handle, &previous) == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(previous == spiDriver_DefaultHandle());
+    TEST_CHECK(spiDriver_CurrentHandle() == handle);
+    TEST_CHECK(spiDriver_SelectHandle(NULL, NULL) == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(spiDriver_CurrentHandle() == spiDriver_DefaultHandle());
+
+    /* A pointer which isn't a handle is rejected */
+    previous = NULL;
+    TEST_CHECK(spiDriver_SelectHandle((spiDriver_Handle_t*)notHandle, &previous) == SPI_DRV_FUNC_RES_FAIL_INPUT_DATA);
+    TEST_CHECK(previous == NULL);
+    TEST_CHECK(spiDriver_CurrentHandle() == spiDriver_DefaultHandle());
+
+    /* The destroyed handle is rejected, as well as by the functions taking a handle */
+    TEST_CHECK(spiDriver_DestroyHandle(handle) == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(spiDriver_SelectHandle(handle, NULL) == SPI_DRV_FUNC_RES_FAIL_INPUT_DATA);
+    TEST_CHECK(spiDriver_CurrentHandle() == spiDriver_DefaultHandle());
+    TEST_CHECK(spiDriver_HandleGetByName(handle, "param", &value, NULL) == SPI_DRV_FUNC_RES_FAIL_INPUT_DATA);
+    TEST_CHECK(spiDriver_HandleInitialize(handle, NULL) == SPI_DRV_FALSE);
+
+    printf("%s: %u failure(s)\n", __FILE__, failures);
+    return (failures == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
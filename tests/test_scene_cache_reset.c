@@ -0,0 +1,89 @@
+/**
+ * @file
+ * @brief Scene programming cache versus the IC reset
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * The scene's programming is applied, the ICs get the reset and the same programming
+ * is applied again. The second application skips all writes, while the one after the
+ * reset should write the whole programming back into the IC.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_api.h"
+#include "spi_drv_com.h"
+#include "spi_drv_trace.h"
+#include "ic_emul.h"
+
+#define TEST_LAYERS_COUNT 4u
+#define TEST_FW_FILE "test_scene_cache_reset_fw.json"
+
+static uint16_t failures = 0u;
+
+#define TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+
+static void CheckProgramming(const uint16_t* const order, const uint8_t nLayer)
+{
+    TEST_CHECK(icEmulMemory[IcEmulParamOffset()] == 0u);
+    TEST_CHECK(icEmulMemory[IcEmulLayersAmountOffset()] == nLayer);
+    for (uint16_t ind = 0u; ind < nLayer; ind++) {
+        TEST_CHECK(icEmulMemory[IcEmulLayersOrderOffset(ind)] == order[ind]);
+        TEST_CHECK(icEmulMemory[IcEmulLayerParamOffset(order[ind])] == 1u);
+    }
+}
+
+
+int main(void)
+{
+    const uint16_t order[] = {1u, 3u};
+    const uint8_t nLayer = (uint8_t)(sizeof(order) / sizeof(order[0]));
+    spiDriver_InputConfiguration_t cfg = {NULL, TEST_FW_FILE, NULL, NULL, NULL};
+
+    TEST_CHECK(IcEmulWriteFwJson(TEST_FW_FILE, TEST_LAYERS_COUNT));
+    TEST_CHECK(spiDriver_Initialize(&cfg) == SPI_DRV_TRUE);
+    remove(TEST_FW_FILE);
+
+    /* First programming writes all fields */
+    IcEmulResetCounters();
+    TEST_CHECK(spiDriver_SetLayers(nLayer, order, SPI_DRV_CFG_OUT_TRACE, NULL, false) == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(icEmulWrites > 0u);
+    CheckProgramming(order, nLayer);
+
+    /* The same programming is cached */
+    IcEmulResetCounters();
+    TEST_CHECK(spiDriver_SetLayers(nLayer, order, SPI_DRV_CFG_OUT_TRACE, NULL, false) == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(icEmulWrites == 0u);
+
+    /* The reset drops the IC's programming, the same one should be written again */
+    IcEmulResetCounters();
+    TEST_CHECK(spiCom_ResetASIC() == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(icEmulResets == 1u);
+    TEST_CHECK(icEmulMemory[IcEmulLayersAmountOffset()] == 0u);
+    TEST_CHECK(spiDriver_SetLayers(nLayer, order, SPI_DRV_CFG_OUT_TRACE, NULL, false) == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(icEmulWrites > 0u);
+    CheckProgramming(order, nLayer);
+
+    printf("%s: %u failure(s)\n", __FILE__, failures);
+    return (failures == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,201 @@
+/**
+ * @file
+ * @brief Trace accumulator kernels
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * The vector kernels and their scalar tail should match the plain scalar formulas, for a size which isn't a multiple
+ * of the vector block. The EWMA state should be rounded down (arithmetic shift), also when the trace decreases, and
+ * the boxcar and EWMA outputs should be the rounded means of the binned samples.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_trace_accu.h"
+
+/** Size of the kernels' test, not a multiple of the vector block */
+#define TEST_KERNEL_SIZE 45u
+/** Samples per channel of the accumulator's test, not a multiple of the binning */
+#define TEST_SAMPLES 13u
+/** Amount of frames pushed */
+#define TEST_FRAMES 6u
+
+extern void spiDriver_AccuAddSub(uint32_t* const sum, const uint16_t* const add, const uint16_t* const sub,
+                                 const uint32_t size);
+extern void spiDriver_AccuEwma(uint32_t* const state, const uint16_t* const frame, const uint8_t shift,
+                               const uint32_t size);
+
+static uint16_t failures = 0u;
+
+#define TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+
+/** Deterministic sample of the frame, decreasing from frame to frame in odd samples */
+static uint16_t TestSample(const uint32_t frame, const uint32_t ind)
+{
+    uint32_t value = ((ind * 2654435761u) ^ (frame * 40503u)) & 0x3FFFu;
+    if ((ind & 1u) != 0u) {
+        value = 0xC000u - (frame * 1500u) - (ind * 7u);
+    }
+    return (uint16_t)value;
+}
+
+
+/** EWMA step, with the shift rounded down as a floor division */
+static uint32_t TestEwmaStep(const uint32_t state, const uint16_t sample, const uint8_t shift)
+{
+    const int64_t diff = ((int64_t)sample << TRACE_ACCU_EWMA_FRAC) - (int64_t)state;
+    const int64_t div = (int64_t)1 << shift;
+    int64_t step = diff / div;
+    if ((diff < 0) && ((diff % div) != 0)) {
+        step--;
+    }
+    return (uint32_t)((int64_t)state + step);
+}
+
+
+static void TestKernels(void)
+{
+    uint16_t add[TEST_KERNEL_SIZE];
+    uint16_t sub[TEST_KERNEL_SIZE];
+    uint32_t sum[TEST_KERNEL_SIZE];
+    uint32_t expected[TEST_KERNEL_SIZE];
+    bool match = true;
+
+    for (uint32_t ind = 0u; ind < TEST_KERNEL_SIZE; ind++) {
+        add[ind] = TestSample(1u, ind);
+        sub[ind] = TestSample(2u, ind);
+        sum[ind] = 100000u + ind;
+        expected[ind] = sum[ind] + add[ind];
+    }
+    spiDriver_AccuAddSub(sum, add, NULL, TEST_KERNEL_SIZE);
+    for (uint32_t ind = 0u; ind < TEST_KERNEL_SIZE; ind++) {
+        match = match && (sum[ind] == expected[ind]);
+        expected[ind] = expected[ind] + add[ind] - sub[ind];
+    }
+    TEST_CHECK(match);
+    spiDriver_AccuAddSub(sum, add, sub, TEST_KERNEL_SIZE);
+    for (uint32_t ind = 0u; ind < TEST_KERNEL_SIZE; ind++) {
+        TEST_CHECK(sum[ind] == expected[ind]);
+    }
+
+    for (uint8_t shift = 0u; shift <= TRACE_ACCU_EWMA_SHIFT_MAX; shift += 3u) {
+        match = true;
+        for (uint32_t ind = 0u; ind < TEST_KERNEL_SIZE; ind++) {
+            sum[ind] = ((uint32_t)TestSample(0u, ind) << TRACE_ACCU_EWMA_FRAC) + (ind * 37u);
+            expected[ind] = sum[ind];
+        }
+        for (uint32_t frame = 1u; frame < TEST_FRAMES; frame++) {
+            for (uint32_t ind = 0u; ind < TEST_KERNEL_SIZE; ind++) {
+                add[ind] = TestSample(frame, ind);
+                expected[ind] = TestEwmaStep(expected[ind], add[ind], shift);
+            }
+            spiDriver_AccuEwma(sum, add, shift, TEST_KERNEL_SIZE);
+            for (uint32_t ind = 0u; ind < TEST_KERNEL_SIZE; ind++) {
+                match = match && (sum[ind] == expected[ind]);
+            }
+        }
+        TEST_CHECK(match);
+    }
+}
+
+
+/** Checks the accumulator's output against the scalar reference state */
+static void TestAccuOutput(const spiDriver_TraceAccu_t* const accu, const uint64_t* const state, const uint32_t scale)
+{
+    static uint16_t out[N_CHANNELS * TEST_SAMPLES];
+    const uint16_t outSamples = spiDriver_TraceAccuOutSamples(accu);
+    const uint64_t divisor = (uint64_t)scale * accu->binning;
+    bool match = true;
+
+    TEST_CHECK(outSamples == (TEST_SAMPLES / accu->binning));
+    TEST_CHECK(spiDriver_TraceAccuGet(accu, out) == SPI_DRV_FUNC_RES_OK);
+    for (uint32_t ch = 0u; ch < N_CHANNELS; ch++) {
+        for (uint32_t s = 0u; s < outSamples; s++) {
+            uint64_t acc = 0u;
+            for (uint32_t b = 0u; b < accu->binning; b++) {
+                acc += state[(ch * TEST_SAMPLES) + (s * accu->binning) + b];
+            }
+            match = match && (out[(ch * outSamples) + s] == (uint16_t)((acc + (divisor / 2u)) / divisor));
+        }
+    }
+    TEST_CHECK(match);
+}
+
+
+static void TestAccu(void)
+{
+    static uint16_t frames[TEST_FRAMES][N_CHANNELS * TEST_SAMPLES];
+    static uint64_t state[N_CHANNELS * TEST_SAMPLES];
+    const uint16_t depth = 3u;
+    const uint8_t shift = 2u;
+    spiDriver_TraceAccu_t accu;
+    uint16_t out[N_CHANNELS * TEST_SAMPLES];
+
+    for (uint32_t frame = 0u; frame < TEST_FRAMES; frame++) {
+        for (uint32_t ind = 0u; ind < (N_CHANNELS * TEST_SAMPLES); ind++) {
+            frames[frame][ind] = TestSample(frame, ind);
+        }
+    }
+
+    /* Boxcar: the mean of the latest frames, binned by 3 with the remaining sample dropped */
+    TEST_CHECK(spiDriver_TraceAccuInit(&accu, TRACE_ACCU_BOXCAR, depth, 3u, TEST_SAMPLES) == SPI_DRV_FUNC_RES_OK);
+    TEST_CHECK(spiDriver_TraceAccuGet(&accu, out) == SPI_DRV_FUNC_RES_FAIL_INPUT_DATA);
+    for (uint32_t frame = 0u; frame < TEST_FRAMES; frame++) {
+        const uint32_t first = (frame >= depth) ? (frame + 1u - depth) : 0u;
+        spiDriver_TraceAccuPush(&accu, frames[frame]);
+        for (uint32_t ind = 0u; ind < (N_CHANNELS * TEST_SAMPLES); ind++) {
+            state[ind] = 0u;
+            for (uint32_t used = first; used <= frame; used++) {
+                state[ind] += frames[used][ind];
+            }
+        }
+        TestAccuOutput(&accu, state, frame + 1u - first);
+    }
+    spiDriver_TraceAccuFree(&accu);
+
+    /* EWMA: the first frame initializes the state, the next ones are weighted by 1/2^shift */
+    TEST_CHECK(spiDriver_TraceAccuInit(&accu, TRACE_ACCU_EWMA, shift, 2u, TEST_SAMPLES) == SPI_DRV_FUNC_RES_OK);
+    for (uint32_t frame = 0u; frame < TEST_FRAMES; frame++) {
+        spiDriver_TraceAccuPush(&accu, frames[frame]);
+        for (uint32_t ind = 0u; ind < (N_CHANNELS * TEST_SAMPLES); ind++) {
+            if (frame == 0u) {
+                state[ind] = (uint64_t)frames[frame][ind] << TRACE_ACCU_EWMA_FRAC;
+            } else {
+                state[ind] = TestEwmaStep((uint32_t)state[ind], frames[frame][ind], shift);
+            }
+        }
+        TestAccuOutput(&accu, state, 1u << TRACE_ACCU_EWMA_FRAC);
+    }
+    spiDriver_TraceAccuFree(&accu);
+}
+
+
+int main(void)
+{
+    TestKernels();
+    TestAccu();
+
+    printf("%s: %u failure(s)\n", __FILE__, failures);
+    return (failures == 0u) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
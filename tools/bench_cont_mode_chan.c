@@ -0,0 +1,153 @@
+/**
+ * @file
+ * @brief Continuous mode signalling benchmark: in-process channels against SysV message queues
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * Runs the request/data-ready ping-pong of the continuous mode threads: one thread sends ::CONT_MODE_REQUEST_DATA and
+ * waits for ::CONT_MODE_DATA_READY, the other one answers each request. The round trips are timed through the
+ * channels of @ref spi_cont_chan (the "after") and through a private SysV message queue with msgsnd()/msgrcv(), as
+ * the continuous mode signalled before (the "before").
+ *
+ * Usage: bench_cont_mode_chan [round_trips]
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/ipc.h>
+#include <sys/msg.h>
+#include "spi_drv_common_types.h"
+#include "cont_mode_lib.h"
+#include "cont_mode_chan.h"
+
+/** The message's size passed to msgsnd()/msgrcv(), without its type */
+#define BENCH_MSG_SIZE (sizeof(contModeInterface_t) - sizeof(long))
+
+static uint32_t benchRoundTrips = 0u;
+static int benchMsqId = -1;
+
+
+static uint64_t BenchNowNs(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+
+/** Answers each data request through the channels */
+static void* BenchChanResponder(void* temp)
+{
+    contModeInterface_t msg;
+    (void)temp;
+    for (uint32_t ind = 0u; ind < benchRoundTrips; ind++) {
+        if (spiDriver_ContModeReceive(CONT_MODE_REQUEST_DATA, &msg, true)) {
+            msg.mtype = CONT_MODE_DATA_READY;
+            spiDriver_ContModeSend(&msg);
+        }
+    }
+    return NULL;
+}
+
+
+/** Answers each data request through the message queue */
+static void* BenchMsqResponder(void* temp)
+{
+    contModeInterface_t msg;
+    (void)temp;
+    for (uint32_t ind = 0u; ind < benchRoundTrips; ind++) {
+        if (msgrcv(benchMsqId, &msg, BENCH_MSG_SIZE, CONT_MODE_REQUEST_DATA, 0) >= 0) {
+            msg.mtype = CONT_MODE_DATA_READY;
+            (void)msgsnd(benchMsqId, &msg, BENCH_MSG_SIZE, 0);
+        }
+    }
+    return NULL;
+}
+
+
+/** Runs the ping-pong and returns the time per round trip in nanoseconds, 0 on failure */
+static double BenchRun(const bool useChan)
+{
+    contModeInterface_t msg;
+    pthread_t thread;
+    uint64_t start;
+    uint32_t done = 0u;
+    double res = 0.0;
+    memset(&msg, 0, sizeof(msg));
+    msg.cmd = CONT_MODE_WORK;
+    if (pthread_create(&thread, NULL, useChan ? BenchChanResponder : BenchMsqResponder, NULL) == 0) {
+        start = BenchNowNs();
+        for (uint32_t ind = 0u; ind < benchRoundTrips; ind++) {
+            msg.mtype = CONT_MODE_REQUEST_DATA;
+            if (useChan) {
+                spiDriver_ContModeSend(&msg);
+                done += spiDriver_ContModeReceive(CONT_MODE_DATA_READY, &msg, true) ? 1u : 0u;
+            } else if (msgsnd(benchMsqId, &msg, BENCH_MSG_SIZE, 0) == 0) {
+                done += (msgrcv(benchMsqId, &msg, BENCH_MSG_SIZE, CONT_MODE_DATA_READY, 0) >= 0) ? 1u : 0u;
+            } else {
+                break;
+            }
+        }
+        if (done == benchRoundTrips) {
+            res = (double)(BenchNowNs() - start) / benchRoundTrips;
+        }
+        (void)pthread_join(thread, NULL);
+    }
+    return res;
+}
+
+
+int main(int argc, char* argv[])
+{
+    double chanNs = 0.0;
+    double msqNs = 0.0;
+    ContModeChanStats_t request;
+    ContModeChanStats_t ready;
+    bool res = true;
+
+    benchRoundTrips = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 200000u;
+    if (benchRoundTrips == 0u) {
+        fprintf(stderr, "Usage: %s [round_trips]\n", argv[0]);
+        res = false;
+    }
+    if (res) {
+        spiDriver_ContModeChanInit();
+        chanNs = BenchRun(true);
+        spiDriver_GetContModeChanStats(CONT_MODE_REQUEST_DATA, &request);
+        spiDriver_GetContModeChanStats(CONT_MODE_DATA_READY, &ready);
+        benchMsqId = msgget(IPC_PRIVATE, IPC_CREAT | 0600);
+        if (benchMsqId >= 0) {
+            msqNs = BenchRun(false);
+            (void)msgctl(benchMsqId, IPC_RMID, NULL);
+        }
+        res = (chanNs > 0.0) && (msqNs > 0.0);
+
+        printf("%u request/data-ready round trips\n", benchRoundTrips);
+        printf("  %-28s %8.2f us per round trip\n", "before: SysV message queue", msqNs / 1000.0);
+        printf("  %-28s %8.2f us per round trip\n", "after: channels", chanNs / 1000.0);
+        printf("  %-28s %u wake-ups, %u sleeps, %.2f us average latency\n", "channels: request",
+               request.wakeups, request.sleeps,
+               (request.received != 0u) ? ((double)request.latencyNsSum / request.received / 1000.0) : 0.0);
+        printf("  %-28s %u wake-ups, %u sleeps, %.2f us average latency\n", "channels: data ready",
+               ready.wakeups, ready.sleeps,
+               (ready.received != 0u) ? ((double)ready.latencyNsSum / ready.received / 1000.0) : 0.0);
+    }
+    return res ? EXIT_SUCCESS : EXIT_FAILURE;
+}
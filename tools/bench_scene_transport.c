@@ -0,0 +1,292 @@
+/**
+ * @file
+ * @brief Scene transport benchmark: shared memory against UDP
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * Publishes the same synthetic trace scenes through the shared memory ring (see @ref spi_cont_shm) and through the UDP
+ * export (see ::spiDriver_UdpSend), and reports the sender's cost per scene and the latency seen by a reader.
+ * The sending time is stamped into each record's first data words, the reader compares it against its own clock.
+ *
+ * Usage: bench_scene_transport [scenes [layers [samples [period_us]]]]
+ *
+ * @note    The UDP export sends every second record of a trace scene, so the UDP reader gets one datagram per two
+ *          layers. The shared memory reader gets whole scenes.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+#include "scene_shm.h"
+#include "scene_shm_reader.h"
+#include "udp_callback.h"
+
+#define BENCH_SHM_NAME "/mlx75322_bench"
+#define BENCH_SHM_SLOTS 16u
+#define BENCH_UDP_PORT 8542u
+/** The reader gives up after this time without data */
+#define BENCH_READ_TIMEOUT_MS 200u
+
+/** Time statistics, in nanoseconds */
+typedef struct {
+    uint32_t count;
+    uint64_t sum;
+    uint64_t max;
+} BenchStat_t;
+
+/** The reader's context */
+typedef struct {
+    uint32_t expected;          /**< Items the writer sends */
+    BenchStat_t latency;        /**< Sending to reading latency */
+    uint32_t lost;              /**< Items not read */
+    int sockfd;                 /**< UDP reader's socket */
+} BenchReader_t;
+
+
+static uint64_t BenchNowNs(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+
+static void BenchStatAdd(BenchStat_t* const stat, const uint64_t value)
+{
+    stat->count++;
+    stat->sum += value;
+    if (value > stat->max) {
+        stat->max = value;
+    }
+}
+
+
+static void BenchStatPrint(const char* const name, const BenchStat_t* const stat)
+{
+    printf("  %-22s avg %8.2f us, max %8.2f us (%u samples)\n", name,
+           (stat->count != 0u) ? ((double)stat->sum / stat->count / 1000.0) : 0.0,
+           (double)stat->max / 1000.0, stat->count);
+}
+
+
+/** Stamps the records' data with the current time */
+static void BenchStamp(spiDriver_ChipData_t* const chipData, const uint16_t chipDataSize)
+{
+    const uint64_t now = BenchNowNs();
+    for (uint16_t ind = 0u; ind < chipDataSize; ind++) {
+        memcpy(chipData[ind].data->trace, &now, sizeof(now));
+    }
+}
+
+
+/** Waits until the next period's start */
+static void BenchPace(struct timespec* const next, const uint32_t periodUs)
+{
+    next->tv_nsec += (long)periodUs * 1000l;
+    while (next->tv_nsec >= 1000000000l) {
+        next->tv_nsec -= 1000000000l;
+        next->tv_sec++;
+    }
+    (void)clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, next, NULL);
+}
+
+
+static void* BenchShmReader(void* context)
+{
+    BenchReader_t* reader = context;
+    SceneShmReader_t* shm = spiDriver_SceneShmOpenReader(BENCH_SHM_NAME);
+    uint32_t read = 0u;
+    if (shm != NULL) {
+        while (((read + spiDriver_SceneShmLost(shm)) < reader->expected) &&
+               spiDriver_SceneShmWait(shm, BENCH_READ_TIMEOUT_MS)) {
+            uint32_t size;
+            uint16_t records;
+            const uint8_t* item;
+            while ((item = spiDriver_SceneShmBeginRead(shm, &size, &records, NULL)) != NULL) {
+                const SceneShmRecord_t* record = spiDriver_SceneShmNextRecord(item, size, NULL);
+                uint64_t stamp = 0u;
+                if (record != NULL) {
+                    memcpy(&stamp, SCENE_SHM_RECORD_DATA(record), sizeof(stamp));
+                }
+                if (spiDriver_SceneShmEndRead(shm) && (record != NULL)) {
+                    BenchStatAdd(&reader->latency, BenchNowNs() - stamp);
+                    read++;
+                }
+            }
+        }
+        reader->lost = reader->expected - read;
+        spiDriver_SceneShmCloseReader(shm);
+    } else {
+        reader->lost = reader->expected;
+    }
+    return NULL;
+}
+
+
+static void* BenchUdpReader(void* context)
+{
+    BenchReader_t* reader = context;
+    static uint8_t buffer[65536];
+    uint32_t read = 0u;
+    ssize_t len;
+    /* The datagram starts with the data length, followed by the data */
+    while ((read < reader->expected) &&
+           ((len = recv(reader->sockfd, buffer, sizeof(buffer), 0)) >= (ssize_t)(sizeof(uint16_t) + sizeof(uint64_t)))) {
+        uint64_t stamp;
+        memcpy(&stamp, &buffer[sizeof(uint16_t)], sizeof(stamp));
+        BenchStatAdd(&reader->latency, BenchNowNs() - stamp);
+        read++;
+    }
+    reader->lost = reader->expected - read;
+    return NULL;
+}
+
+
+static int BenchUdpSocket(void)
+{
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr;
+    const struct timeval timeout = {.tv_sec = 0, .tv_usec = BENCH_READ_TIMEOUT_MS * 1000};
+    const int bufSize = 4 * 1024 * 1024;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    addr.sin_port = htons(BENCH_UDP_PORT);
+    if ((sockfd >= 0) &&
+        ((bind(sockfd, (const struct sockaddr*)&addr, sizeof(addr)) != 0) ||
+         (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0))) {
+        (void)close(sockfd);
+        sockfd = -1;
+    } else if (sockfd >= 0) {
+        (void)setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize));
+    }
+    return sockfd;
+}
+
+
+/** Sends the scenes through the shared memory or UDP, and reads them in another thread */
+static bool BenchRun(const bool useShm,
+                     spiDriver_ChipData_t* const chipData,
+                     const uint16_t layers,
+                     const uint32_t scenes,
+                     const uint32_t periodUs)
+{
+    const uint32_t dataSize = (uint32_t)chipData[0].samples * N_CHANNELS * sizeof(uint16_t);
+    BenchReader_t reader = {.expected = useShm ? scenes : (scenes * ((layers + 1u) / 2u)), .sockfd = -1};
+    BenchStat_t send = {0u, 0u, 0u};
+    pthread_t thread;
+    struct timespec next;
+    uint64_t start;
+    uint64_t elapsed;
+    bool res = true;
+
+    if (useShm) {
+        const uint32_t slotSize = layers * (SCENE_SHM_ALIGN(sizeof(SceneShmRecord_t)) + SCENE_SHM_ALIGN(dataSize));
+        res = (spiDriver_OpenSceneShm(BENCH_SHM_NAME, slotSize, BENCH_SHM_SLOTS) == SPI_DRV_FUNC_RES_OK);
+    } else {
+        reader.sockfd = BenchUdpSocket();
+        res = (reader.sockfd >= 0);
+        spiDriver_InitUdpCallback(BENCH_UDP_PORT);
+    }
+    if (res) {
+        res = (pthread_create(&thread, NULL, useShm ? BenchShmReader : BenchUdpReader, &reader) == 0);
+    }
+    if (res) {
+        /* Lets the reader attach */
+        (void)usleep(10000u);
+        (void)clock_gettime(CLOCK_MONOTONIC, &next);
+        start = BenchNowNs();
+        for (uint32_t scene = 0u; scene < scenes; scene++) {
+            uint64_t sent;
+            BenchStamp(chipData, layers);
+            sent = BenchNowNs();
+            if (useShm) {
+                (void)spiDriver_SceneShmPublish(chipData, layers, true);
+            } else {
+                (void)spiDriver_UdpSend(chipData, layers);
+            }
+            BenchStatAdd(&send, BenchNowNs() - sent);
+            if (periodUs != 0u) {
+                BenchPace(&next, periodUs);
+            }
+        }
+        elapsed = BenchNowNs() - start;
+        (void)pthread_join(thread, NULL);
+
+        printf("%s: %u scenes of %u layers, %u bytes of data per layer\n", useShm ? "Shared memory" : "UDP",
+               scenes, layers, dataSize);
+        BenchStatPrint("sending a scene", &send);
+        BenchStatPrint("latency", &reader.latency);
+        printf("  %-22s %u of %u\n", "lost", reader.lost, reader.expected);
+        printf("  %-22s %.1f MB/s of data while sending, %.1f scenes/s\n", "throughput",
+               (send.sum != 0u) ? ((double)dataSize * layers * scenes * 1000.0 / (double)send.sum) : 0.0,
+               (double)scenes * 1e9 / (double)elapsed);
+    } else {
+        printf("%s: can't be set up\n", useShm ? "Shared memory" : "UDP");
+    }
+    if (useShm) {
+        spiDriver_CloseSceneShm();
+    } else if (reader.sockfd >= 0) {
+        (void)close(reader.sockfd);
+    }
+    return res;
+}
+
+
+int main(int argc, char* argv[])
+{
+    const uint32_t scenes = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 2000u;
+    const uint16_t layers = (argc > 2) ? (uint16_t)strtoul(argv[2], NULL, 0) : 2u;
+    const uint16_t samples = (argc > 3) ? (uint16_t)strtoul(argv[3], NULL, 0) : 256u;
+    const uint32_t periodUs = (argc > 4) ? (uint32_t)strtoul(argv[4], NULL, 0) : 500u;
+    spiDriver_ChipData_t* chipData = calloc(layers, sizeof(spiDriver_ChipData_t));
+    Metadata_t metaData;
+    bool res = true;
+
+    if ((scenes == 0u) || (layers == 0u) || (samples < 4u) || (samples > MAX_SAMPLES_N) || (chipData == NULL)) {
+        fprintf(stderr, "Usage: %s [scenes [layers [samples(4..%u) [period_us]]]]\n", argv[0], MAX_SAMPLES_N);
+        res = false;
+    }
+    memset(&metaData, 0, sizeof(metaData));
+    for (uint16_t ind = 0u; res && (ind < layers); ind++) {
+        chipData[ind].data = calloc(1u, sizeof(spiDriver_Data_t));
+        chipData[ind].samples = samples;
+        chipData[ind].metaData = &metaData;
+        chipData[ind].dataFormat = CHIP_DATA_TRACE;
+        chipData[ind].status = SPI_DRV_FUNC_RES_OK;
+        chipData[ind].sceneComplete = (ind == (layers - 1u));
+        res = res && (chipData[ind].data != NULL);
+    }
+    if (res) {
+        res = BenchRun(true, chipData, layers, scenes, periodUs);
+        res = BenchRun(false, chipData, layers, scenes, periodUs) && res;
+    }
+    for (uint16_t ind = 0u; (chipData != NULL) && (ind < layers); ind++) {
+        free(chipData[ind].data);
+    }
+    free(chipData);
+    return res ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,169 @@
+/**
+ * @file
+ * @brief Raw trace conversion benchmark
+ * @internal
+ *
+ * @copyright (C) 2019 Melexis N.V.
+ *
+ * Melexis N.V. is supplying this code for use with Melexis N.V. processor based microcontrollers only.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS".  NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY,
+ * INCLUDING, BUT NOT LIMITED TO, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE APPLY TO THIS SOFTWARE.  MELEXIS N.V. SHALL NOT IN ANY CIRCUMSTANCES,
+ * BE LIABLE FOR SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, FOR ANY REASON WHATSOEVER.
+ *
+ * @endinternal
+ *
+ * Converts synthetic trace scenes of 16 layers of N_CHANNELS x MAX_SAMPLES_N samples. It times the plain per-sample
+ * loop the consumers used before @ref spi_trace_conv against its float32 and Q-format kernels, with and without a
+ * dark frame. The kernel used (AVX2, SSE2, NEON or plain C) depends on the library's compiler flags.
+ *
+ * Usage: bench_trace_conv [scenes]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include "spi_drv_common_types.h"
+#include "spi_drv_trace.h"
+#include "spi_drv_trace_conv.h"
+
+/** Layers per scene */
+#define BENCH_LAYERS 16u
+/** Samples per layer */
+#define BENCH_LAYER_SAMPLES (N_CHANNELS * MAX_SAMPLES_N)
+
+typedef enum {
+    BENCH_SCALAR = 0,           /**< The consumers' per-sample loop */
+    BENCH_F32,                  /**< ::spiDriver_ConvertTraceF32 */
+    BENCH_Q,                    /**< ::spiDriver_ConvertTraceQ */
+} BenchConv_e;
+
+
+static uint64_t BenchNowNs(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+
+/** The conversion as the consumers wrote it, sample by sample */
+static void BenchConvertScalar(const spiDriver_TraceCalib_t* const calib, const uint16_t* const trace, float* const out)
+{
+    for (uint16_t ch = 0u; ch < N_CHANNELS; ch++) {
+        const uint32_t base = (uint32_t)ch * MAX_SAMPLES_N;
+        for (uint16_t ind = 0u; ind < MAX_SAMPLES_N; ind++) {
+            int32_t value = trace[base + ind];
+            if (calib->darkFrame != NULL) {
+                value -= calib->darkFrame[base + ind];
+            }
+            out[base + ind] = ((float)value - calib->offset[ch]) * calib->gain[ch];
+        }
+    }
+}
+
+
+/** Converts the scenes and prints the time per scene */
+static bool BenchRun(const char* const name,
+                     const BenchConv_e conv,
+                     const spiDriver_TraceCalib_t* const calib,
+                     const uint16_t* const scene,
+                     float* const outF32,
+                     int16_t* const outQ,
+                     const uint32_t scenes)
+{
+    FuncResult_e res = SPI_DRV_FUNC_RES_OK;
+    const uint64_t start = BenchNowNs();
+    uint64_t elapsed;
+    for (uint32_t ind = 0u; ind < scenes; ind++) {
+        for (uint16_t layer = 0u; layer < BENCH_LAYERS; layer++) {
+            const uint32_t offs = (uint32_t)layer * BENCH_LAYER_SAMPLES;
+            if (conv == BENCH_SCALAR) {
+                BenchConvertScalar(calib, &scene[offs], &outF32[offs]);
+            } else if (conv == BENCH_F32) {
+                res |= spiDriver_ConvertTraceF32(calib, &scene[offs], MAX_SAMPLES_N, &outF32[offs]);
+            } else {
+                res |= spiDriver_ConvertTraceQ(calib, &scene[offs], MAX_SAMPLES_N, &outQ[offs]);
+            }
+        }
+    }
+    elapsed = BenchNowNs() - start;
+    printf("  %-26s %9.1f us per scene, %7.1f Msamples/s\n", name, (double)elapsed / scenes / 1000.0,
+           (double)BENCH_LAYERS * BENCH_LAYER_SAMPLES * scenes * 1000.0 / (double)elapsed);
+    return res == SPI_DRV_FUNC_RES_OK;
+}
+
+
+/** Returns the largest difference of the kernel's output from the scalar one */
+static float BenchMaxDiff(const spiDriver_TraceCalib_t* const calib,
+                          const uint16_t* const scene,
+                          float* const outScalar,
+                          float* const outF32)
+{
+    float maxDiff = 0.0f;
+    BenchConvertScalar(calib, scene, outScalar);
+    (void)spiDriver_ConvertTraceF32(calib, scene, MAX_SAMPLES_N, outF32);
+    for (uint32_t ind = 0u; ind < BENCH_LAYER_SAMPLES; ind++) {
+        const float diff = fabsf(outScalar[ind] - outF32[ind]);
+        if (diff > maxDiff) {
+            maxDiff = diff;
+        }
+    }
+    return maxDiff;
+}
+
+
+int main(int argc, char* argv[])
+{
+    const uint32_t scenes = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 200u;
+    uint16_t* scene = malloc(sizeof(uint16_t) * BENCH_LAYERS * BENCH_LAYER_SAMPLES);
+    uint16_t* dark = malloc(sizeof(uint16_t) * BENCH_LAYER_SAMPLES);
+    float* outF32 = malloc(sizeof(float) * BENCH_LAYERS * BENCH_LAYER_SAMPLES);
+    float* outScalar = malloc(sizeof(float) * BENCH_LAYER_SAMPLES);
+    int16_t* outQ = malloc(sizeof(int16_t) * BENCH_LAYERS * BENCH_LAYER_SAMPLES);
+    spiDriver_TraceCalib_t calib;
+    bool res = (scene != NULL) && (dark != NULL) && (outF32 != NULL) && (outScalar != NULL) && (outQ != NULL);
+
+    if (scenes == 0u) {
+        fprintf(stderr, "Usage: %s [scenes]\n", argv[0]);
+        res = false;
+    }
+    if (res) {
+        srand(1u);
+        for (uint32_t ind = 0u; ind < BENCH_LAYERS * BENCH_LAYER_SAMPLES; ind++) {
+            scene[ind] = (uint16_t)(rand() & 0x3FFF);
+        }
+        for (uint32_t ind = 0u; ind < BENCH_LAYER_SAMPLES; ind++) {
+            dark[ind] = (uint16_t)(rand() & 0x3F);
+        }
+        spiDriver_TraceCalibInit(&calib, TRACE_CONV_OUT_F32);
+        for (uint16_t ch = 0u; ch < N_CHANNELS; ch++) {
+            calib.offset[ch] = 100.0f + ch;
+            calib.gain[ch] = 1.0f + (float)ch / 64.0f;
+        }
+        calib.qFracBits = 1u;
+
+        printf("%u scenes of %u layers, %u channels x %u samples\n", scenes, BENCH_LAYERS, N_CHANNELS, MAX_SAMPLES_N);
+        res = BenchRun("before: per-sample loop", BENCH_SCALAR, &calib, scene, outF32, outQ, scenes) && res;
+        res = BenchRun("after: float32", BENCH_F32, &calib, scene, outF32, outQ, scenes) && res;
+        res = BenchRun("after: Q-format", BENCH_Q, &calib, scene, outF32, outQ, scenes) && res;
+        calib.darkFrame = dark;
+        calib.darkSamples = MAX_SAMPLES_N;
+        res = BenchRun("before: loop, dark frame", BENCH_SCALAR, &calib, scene, outF32, outQ, scenes) && res;
+        res = BenchRun("after: float32, dark frame", BENCH_F32, &calib, scene, outF32, outQ, scenes) && res;
+        res = BenchRun("after: Q-format, dark frame", BENCH_Q, &calib, scene, outF32, outQ, scenes) && res;
+        printf("  %-26s %g\n", "float32 max difference", (double)BenchMaxDiff(&calib, scene, outScalar, outF32));
+    }
+    free(scene);
+    free(dark);
+    free(outF32);
+    free(outScalar);
+    free(outQ);
+    return res ? EXIT_SUCCESS : EXIT_FAILURE;
+}